@@ -0,0 +1,1627 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <ansic3d/matrix3d.h>
+#include <ansic3d/vector3d.h>
+#include <ansic3d/vectorlist.h>
+#include <ansic3d/vectorlistsoa.h>
+#include <ansic3d/cpu.h>
+#include <ansic3d/parallel.h>
+#include <ansic3d/quaternion.h>
+#include <ansic3d/trig.h>
+#include <ansic3d/allocator.h>
+#include <ansic3d/pointcloud.h>
+#include <ansic3d/bounds.h>
+#include <ansic3d/kdtree.h>
+#include <ansic3d/spatialhash.h>
+#include <ansic3d/octree.h>
+#include <ansic3d/frustum.h>
+#include <ansic3d/hierarchy.h>
+#include <ansic3d/ray.h>
+#include <ansic3d/bvh.h>
+#include <ansic3d/mesh.h>
+
+// Every benchmark is run REPEATS times over its batch, the first run is
+// a warm up and is not counted
+#define REPEATS 7
+#define MAX_BATCH (1 << 20)
+#define MAX_MATRICES (1 << 16)
+#define MAX_RESULTS 128
+
+typedef struct _Bench
+{
+	const char *name;
+	void (*run)(unsigned int n);
+	unsigned int n;
+} Bench;
+
+typedef struct _BenchResult
+{
+	const char *name;
+	unsigned int n;
+	double ns_per_op;
+	double min_ns_per_op;
+	double stddev;
+	double ops_per_second;
+} BenchResult;
+
+// Inputs shared by all benchmarks, filled once in SetupData
+Vector3D *vectors;
+Vector3D *vectors_out;
+Matrix3D *matrices;
+Matrix3D *matrices_out;
+float *floats;
+float *floats_out;
+float *floats_out2;
+VectorList list;
+VectorList list_out;
+VectorListSoA soa;
+VectorListSoA soa_out;
+FrameArena arena;
+Matrix3D matrix;
+Quaternion q1, q2;
+
+// Results are written here so the compiler can not drop the work
+volatile float sink;
+
+double Now()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1E9 + t.tv_nsec;
+}
+
+void SetupData()
+{
+	unsigned int i;
+	Vector3D axis;
+	vectors = malloc(MAX_BATCH * sizeof(Vector3D));
+	vectors_out = malloc(MAX_BATCH * sizeof(Vector3D));
+	matrices = malloc(MAX_MATRICES * sizeof(Matrix3D));
+	matrices_out = malloc(MAX_MATRICES * sizeof(Matrix3D));
+	floats = malloc(MAX_BATCH * sizeof(float));
+	floats_out = malloc(MAX_BATCH * sizeof(float));
+	floats_out2 = malloc(MAX_BATCH * sizeof(float));
+	srand(42);
+	for (i = 0; i < MAX_BATCH; i++)
+	{
+		SetVector(rand() / (float)RAND_MAX * 100 - 50,
+				rand() / (float)RAND_MAX * 100 - 50,
+				rand() / (float)RAND_MAX * 100 - 50, 1, &vectors[i]);
+		floats[i] = rand() / (float)RAND_MAX * 20 - 10;
+	}
+	SetVector(1, 2, 3, 0, &axis);
+	CreateRotationMatrix(axis, 0.7, &matrix);
+	SetVector(4, 5, 6, 1, &matrix.W);
+	for (i = 0; i < MAX_MATRICES; i++)
+	{
+		CreateRotationMatrix(vectors[i], floats[i], &matrices[i]);
+		CloneVector(vectors[i + 1], &matrices[i].W);
+		matrices[i].W.w = 1;
+	}
+	InitVectorList(&list, MAX_BATCH);
+	InitVectorList(&list_out, MAX_BATCH);
+	PushVectors(vectors, MAX_BATCH, &list);
+	InitVectorListSoA(&soa, MAX_BATCH, 0);
+	InitVectorListSoA(&soa_out, MAX_BATCH, 0);
+	VectorListToSoA(&list, &soa);
+	VectorListToSoA(&list, &soa_out);
+	AxisAngleQuaternion(axis, 0.3, &q1);
+	AxisAngleQuaternion(vectors[0], 2.1, &q2);
+	InitFrameArena(&arena, 16 << 20);
+}
+
+// Vector3D
+
+void BenchAddVector(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		AddVector(vectors[i], vectors[i + 1], &vectors_out[i]);
+	}
+}
+
+void BenchCrossProduct(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CrossProduct(vectors[i], vectors[i + 1], &vectors_out[i]);
+	}
+}
+
+void BenchDotProduct(unsigned int n)
+{
+	unsigned int i;
+	float sum = 0;
+	for (i = 0; i < n; i++)
+	{
+		sum += DotProduct(vectors[i], vectors[i + 1]);
+	}
+	sink = sum;
+}
+
+void BenchNormalizeVector(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		vectors_out[i] = vectors[i];
+		NormalizeVector(&vectors_out[i]);
+	}
+}
+
+void BenchVectorLength(unsigned int n)
+{
+	unsigned int i;
+	float sum = 0;
+	for (i = 0; i < n; i++)
+	{
+		sum += VectorLength(vectors[i]);
+	}
+	sink = sum;
+}
+
+void BenchVectorDistance(unsigned int n)
+{
+	unsigned int i;
+	float sum = 0;
+	for (i = 0; i < n; i++)
+	{
+		sum += VectorDistance(vectors[i], vectors[i + 1]);
+	}
+	sink = sum;
+}
+
+void BenchRotateAroundX(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		vectors_out[i] = vectors[i];
+		RotateAroundX(&vectors_out[i], floats[i]);
+	}
+}
+
+void BenchPlaneNormal(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		PlaneNormal(vectors[i], vectors[i + 1], vectors[i + 2],
+				&vectors_out[i]);
+	}
+}
+
+void BenchSubVector(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		SubVector(vectors[i], vectors[i + 1], &vectors_out[i]);
+	}
+}
+
+void BenchScaleVector(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		vectors_out[i] = vectors[i];
+		ScaleVector(&vectors_out[i], floats[i]);
+	}
+}
+
+void BenchDivideVector(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		vectors_out[i] = vectors[i];
+		DivideVector(&vectors_out[i], vectors[i + 1]);
+	}
+}
+
+void BenchVectorNorm(unsigned int n)
+{
+	unsigned int i;
+	float sum = 0;
+	for (i = 0; i < n; i++)
+	{
+		sum += VectorNorm(vectors[i]);
+	}
+	sink = sum;
+}
+
+void BenchPerpendicularVector(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		PerpendicularVector(vectors[i], vectors[i + 1], &vectors_out[i]);
+	}
+}
+
+void BenchRotateAroundY(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		vectors_out[i] = vectors[i];
+		RotateAroundY(&vectors_out[i], floats[i]);
+	}
+}
+
+void BenchRotateAroundZ(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		vectors_out[i] = vectors[i];
+		RotateAroundZ(&vectors_out[i], floats[i]);
+	}
+}
+
+// Equal vectors, every component is compared
+void BenchVectorEquals(unsigned int n)
+{
+	unsigned int i;
+	int equal = 0;
+	for (i = 0; i < n; i++)
+	{
+		equal += VectorEquals(vectors[i], vectors[i]);
+	}
+	sink = equal;
+}
+
+// Matrix3D
+
+void BenchMultiplyMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		MultiplyMatrix(&matrices[i], &matrix, &matrices_out[i]);
+	}
+}
+
+void BenchMultiplyMatrixRestrict(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		MultiplyMatrixRestrict(&matrices[i], &matrix, &matrices_out[i]);
+	}
+}
+
+void BenchMultiplyMatrixArray(unsigned int n)
+{
+	MultiplyMatrixArray(matrices, matrices, matrices_out, n);
+}
+
+void BenchMultiplyMatrixBroadcastRight(unsigned int n)
+{
+	MultiplyMatrixBroadcastRight(matrices, &matrix, matrices_out, n);
+}
+
+void BenchVectorTransform(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		vectors_out[i] = vectors[i];
+		VectorTransform(&matrix, &vectors_out[i]);
+	}
+}
+
+void BenchTransformVectors(unsigned int n)
+{
+	TransformVectors(&matrix, vectors, vectors_out, n);
+}
+
+void BenchMatrixDeterminant(unsigned int n)
+{
+	unsigned int i;
+	float sum = 0;
+	for (i = 0; i < n; i++)
+	{
+		sum += MatrixDeterminant(&matrices[i]);
+	}
+	sink = sum;
+}
+
+void BenchInvertMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		matrices_out[i] = matrices[i];
+		InvertMatrix(&matrices_out[i]);
+	}
+}
+
+void BenchInvertAffineMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		matrices_out[i] = matrices[i];
+		InvertAffineMatrix(&matrices_out[i]);
+	}
+}
+
+void BenchInvertRigidMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		matrices_out[i] = matrices[i];
+		InvertRigidMatrix(&matrices_out[i]);
+	}
+}
+
+void BenchInvertMatrixFast(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		matrices_out[i] = matrices[i];
+		InvertMatrixFast(&matrices_out[i]);
+	}
+}
+
+void BenchTransposeMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		matrices_out[i] = matrices[i];
+		TransposeMatrix(&matrices_out[i]);
+	}
+}
+
+void BenchCreateRotationMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CreateRotationMatrix(vectors[i], floats[i], &matrices_out[i]);
+	}
+}
+
+void BenchCreateRotationMatrixFastTrig(unsigned int n)
+{
+	int enabled = GetFastTrig();
+	SetFastTrig(1);
+	BenchCreateRotationMatrix(n);
+	SetFastTrig(enabled);
+}
+
+void BenchLookAtMatrix(unsigned int n)
+{
+	unsigned int i;
+	Vector3D up;
+	SetVector(0, 0, 1, 0, &up);
+	for (i = 0; i < n; i++)
+	{
+		LookAtMatrix(vectors[i], vectors[i + 1], up, &matrices_out[i]);
+	}
+}
+
+void BenchHomogeneousMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		matrices_out[i] = matrices[i];
+		HomogeneousMatrix(&matrices_out[i]);
+	}
+}
+
+void BenchCreateScaleMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CreateScaleMatrix(vectors[i], &matrices_out[i]);
+	}
+}
+
+void BenchCreateTranslationMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CreateTranslationMatrix(vectors[i], &matrices_out[i]);
+	}
+}
+
+void BenchCreateScaleAndTranslationMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CreateScaleAndTranslationMatrix(vectors[i], vectors[i + 1],
+				&matrices_out[i]);
+	}
+}
+
+void BenchCreateRotationMatrixX(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CreateRotationMatrixX(floats[i], &matrices_out[i]);
+	}
+}
+
+void BenchCreateRotationMatrixY(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CreateRotationMatrixY(floats[i], &matrices_out[i]);
+	}
+}
+
+void BenchCreateRotationMatrixZ(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CreateRotationMatrixZ(floats[i], &matrices_out[i]);
+	}
+}
+
+void BenchAdjointMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		matrices_out[i] = matrices[i];
+		AdjointMatrix(&matrices_out[i]);
+	}
+}
+
+void BenchScaleMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		matrices_out[i] = matrices[i];
+		ScaleMatrix(&matrices_out[i], floats[i]);
+	}
+}
+
+// Equal matrices, every element is compared
+void BenchMatrixEquals(unsigned int n)
+{
+	unsigned int i;
+	int equal = 0;
+	for (i = 0; i < n; i++)
+	{
+		equal += MatrixEquals(&matrices[i], &matrices[i]);
+	}
+	sink = equal;
+}
+
+void BenchCastFloat(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CastFloat(&matrices[i], &floats_out[16 * i]);
+	}
+}
+
+void BenchCreateRotationMatrixXSinCos(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CreateRotationMatrixXSinCos(floats[i], floats[i + 1],
+				&matrices_out[i]);
+	}
+}
+
+void BenchCreateRotationMatrixYSinCos(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CreateRotationMatrixYSinCos(floats[i], floats[i + 1],
+				&matrices_out[i]);
+	}
+}
+
+void BenchCreateRotationMatrixZSinCos(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CreateRotationMatrixZSinCos(floats[i], floats[i + 1],
+				&matrices_out[i]);
+	}
+}
+
+void BenchMultiplyMatrixBroadcastLeft(unsigned int n)
+{
+	MultiplyMatrixBroadcastLeft(&matrix, matrices, matrices_out, n);
+}
+
+void BenchIsAffineMatrix(unsigned int n)
+{
+	unsigned int i;
+	int affine = 0;
+	for (i = 0; i < n; i++)
+	{
+		affine += IsAffineMatrix(&matrices[i]);
+	}
+	sink = affine;
+}
+
+void BenchIsRigidMatrix(unsigned int n)
+{
+	unsigned int i;
+	int rigid = 0;
+	for (i = 0; i < n; i++)
+	{
+		rigid += IsRigidMatrix(&matrices[i]);
+	}
+	sink = rigid;
+}
+
+void BenchCreatePerspectiveMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CreatePerspectiveMatrix(0.5f + fabsf(floats[i]) * 0.1f, 1.5f, 0.1f,
+				100, &matrices_out[i]);
+	}
+}
+
+void BenchCreateInfinitePerspectiveMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CreateInfinitePerspectiveMatrix(0.5f + fabsf(floats[i]) * 0.1f, 1.5f,
+				0.1f, &matrices_out[i]);
+	}
+}
+
+void BenchCreateReversedZPerspectiveMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		CreateReversedZPerspectiveMatrix(0.5f + fabsf(floats[i]) * 0.1f,
+				1.5f, 0.1f, 100, &matrices_out[i]);
+	}
+}
+
+void BenchCreateOrthographicMatrix(unsigned int n)
+{
+	unsigned int i;
+	float size;
+	for (i = 0; i < n; i++)
+	{
+		size = 1 + fabsf(floats[i]);
+		CreateOrthographicMatrix(-size, size, -size, size, 0.1f, 100,
+				&matrices_out[i]);
+	}
+}
+
+void BenchCreateReversedZOrthographicMatrix(unsigned int n)
+{
+	unsigned int i;
+	float size;
+	for (i = 0; i < n; i++)
+	{
+		size = 1 + fabsf(floats[i]);
+		CreateReversedZOrthographicMatrix(-size, size, -size, size, 0.1f, 100,
+				&matrices_out[i]);
+	}
+}
+
+// VectorList
+
+void BenchPushVector(unsigned int n)
+{
+	VectorList l;
+	unsigned int i;
+	InitVectorList(&l, 1);
+	for (i = 0; i < n; i++)
+	{
+		PushVector(vectors[i], &l);
+	}
+	FreeVectorList(&l);
+}
+
+void BenchPushVectors(unsigned int n)
+{
+	VectorList l;
+	unsigned int i;
+	InitVectorList(&l, 1);
+	// Sensor sized chunks of 256 vectors
+	for (i = 0; i + 256 <= n; i += 256)
+	{
+		PushVectors(&vectors[i], 256, &l);
+	}
+	FreeVectorList(&l);
+}
+
+// n short lived lists of 16 vectors, as built per frame
+void BenchTemporaryListsHeap(unsigned int n)
+{
+	VectorList l;
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		InitVectorList(&l, 4);
+		PushVectors(&vectors[i], 16, &l);
+		FreeVectorList(&l);
+	}
+}
+
+void BenchTemporaryListsArena(unsigned int n)
+{
+	VectorList l;
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		InitVectorListAllocator(&l, 4, &arena.allocator);
+		PushVectors(&vectors[i], 16, &l);
+	}
+	ResetFrameArena(&arena);
+}
+
+void BenchRemoveVectorIndex(unsigned int n)
+{
+	VectorList l;
+	unsigned int i;
+	InitVectorList(&l, 2 * n);
+	PushVectors(vectors, 2 * n, &l);
+	for (i = 0; i < n; i++)
+	{
+		RemoveVectorIndex(&l, i);
+	}
+	FreeVectorList(&l);
+}
+
+void BenchSwapRemoveVectorIndex(unsigned int n)
+{
+	VectorList l;
+	unsigned int i;
+	InitVectorList(&l, 2 * n);
+	PushVectors(vectors, 2 * n, &l);
+	for (i = 0; i < n; i++)
+	{
+		SwapRemoveVectorIndex(&l, i);
+	}
+	FreeVectorList(&l);
+}
+
+void BenchPopVector(unsigned int n)
+{
+	VectorList l;
+	Vector3D v;
+	unsigned int i;
+	InitVectorList(&l, n);
+	PushVectors(vectors, n, &l);
+	for (i = 0; i < n; i++)
+	{
+		PopVector(&l, &v);
+	}
+	FreeVectorList(&l);
+}
+
+void BenchRemoveLastVector(unsigned int n)
+{
+	VectorList l;
+	unsigned int i;
+	InitVectorList(&l, n);
+	PushVectors(vectors, n, &l);
+	for (i = 0; i < n; i++)
+	{
+		RemoveLastVector(&l);
+	}
+	FreeVectorList(&l);
+}
+
+// n lists of 16 vectors trimmed from a capacity of 64
+void BenchTrimVectorList(unsigned int n)
+{
+	VectorList l;
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		InitVectorList(&l, 64);
+		PushVectors(&vectors[i], 16, &l);
+		TrimVectorList(&l);
+		FreeVectorList(&l);
+	}
+}
+
+// Every other vector of 2n removed in one pass
+void BenchRemoveVectorIndices(unsigned int n)
+{
+	static unsigned int *indices = NULL;
+	VectorList l;
+	unsigned int i;
+	if (indices == NULL)
+	{
+		indices = malloc(n * sizeof(unsigned int));
+		for (i = 0; i < n; i++)
+		{
+			indices[i] = 2 * i;
+		}
+	}
+	InitVectorList(&l, 2 * n);
+	PushVectors(vectors, 2 * n, &l);
+	RemoveVectorIndices(&l, indices, n);
+	FreeVectorList(&l);
+}
+
+int IsNegativeX(Vector3D *v, void *context)
+{
+	(void)context;
+	return v->x < 0;
+}
+
+void BenchRemoveVectorsIf(unsigned int n)
+{
+	list_out.count = 0;
+	list_out.index = -1;
+	PushVectors(vectors, n, &list_out);
+	RemoveVectorsIf(&list_out, IsNegativeX, NULL);
+}
+
+void BenchTransformVectorList(unsigned int n)
+{
+	list.count = n;
+	list.index = n - 1;
+	TransformVectorList(&matrix, &list, &list_out);
+	list.count = MAX_BATCH;
+	list.index = MAX_BATCH - 1;
+}
+
+// In place on a copy of the vectors, kept between runs
+static VectorList *InPlaceList(unsigned int n)
+{
+	static VectorList l;
+	if (l.vectors == NULL)
+	{
+		InitVectorList(&l, n);
+		PushVectors(vectors, n, &l);
+	}
+	return &l;
+}
+
+void BenchTransformVectorListInPlace(unsigned int n)
+{
+	TransformVectorListInPlace(&matrix, InPlaceList(n));
+}
+
+// Alternating sign keeps the values where they started
+void BenchScaleVectorList(unsigned int n)
+{
+	ScaleVectorList(InPlaceList(n), -1);
+}
+
+void BenchNormalizeVectorList(unsigned int n)
+{
+	list_out.count = n;
+	NormalizeVectorList(&list_out);
+}
+
+void BenchVectorListBounds(unsigned int n)
+{
+	Vector3D min, max;
+	list.count = n;
+	VectorListBounds(&list, &min, &max);
+	list.count = MAX_BATCH;
+	sink = max.x - min.x;
+}
+
+void BenchComputeBoundingSphere(unsigned int n)
+{
+	BoundingSphere sphere;
+	list.count = n;
+	ComputeBoundingSphere(&list, &sphere);
+	list.count = MAX_BATCH;
+	sink = sphere.radius;
+}
+
+void BenchComputeOBB(unsigned int n)
+{
+	OBB box;
+	list.count = n;
+	ComputeOBB(&list, &box);
+	list.count = MAX_BATCH;
+	sink = box.extents.x;
+}
+
+// Spatial indices over the first SPATIAL_POINTS vectors
+
+#define SPATIAL_POINTS (1 << 18)
+
+void BenchBuildKDTree(unsigned int n)
+{
+	KDTree tree;
+	list.count = n;
+	BuildKDTree(&list, &tree);
+	list.count = MAX_BATCH;
+	FreeKDTree(&tree);
+}
+
+void BenchKDTreeNearest(unsigned int n)
+{
+	static KDTree tree;
+	static int built = 0;
+	unsigned int indices[8];
+	float distances[8];
+	unsigned int i;
+	if (!built)
+	{
+		list.count = SPATIAL_POINTS;
+		BuildKDTree(&list, &tree);
+		list.count = MAX_BATCH;
+		built = 1;
+	}
+	for (i = 0; i < n; i++)
+	{
+		KDTreeNearest(&tree, vectors[SPATIAL_POINTS + i], 8, indices,
+				distances);
+	}
+	sink = distances[0];
+}
+
+void BenchRebuildSpatialHash(unsigned int n)
+{
+	static SpatialHash hash;
+	static int init = 0;
+	if (!init)
+	{
+		InitSpatialHash(&hash, 2, 0);
+		init = 1;
+	}
+	list.count = n;
+	RebuildSpatialHash(&hash, &list);
+	list.count = MAX_BATCH;
+	sink = hash.start[1];
+}
+
+void BenchSpatialHashRadius(unsigned int n)
+{
+	static SpatialHash hash;
+	static int built = 0;
+	static VectorList points;
+	unsigned int indices[64];
+	unsigned int i, found = 0;
+	if (!built)
+	{
+		points = list;
+		points.count = SPATIAL_POINTS;
+		InitSpatialHash(&hash, 2, 0);
+		RebuildSpatialHash(&hash, &points);
+		built = 1;
+	}
+	for (i = 0; i < n; i++)
+	{
+		found += SpatialHashRadius(&hash, vectors[SPATIAL_POINTS + i], 2,
+				indices, 64);
+	}
+	sink = found;
+}
+
+// Loose octree of OCTREE_OBJECTS small boxes around the first vectors
+
+#define OCTREE_OBJECTS 100000
+
+Octree *BenchOctree()
+{
+	static Octree tree;
+	static int built = 0;
+	VectorList points;
+	Vector3D center;
+	if (!built)
+	{
+		SetVector(0, 0, 0, 1, &center);
+		InitOctree(&tree, center, 64, 10);
+		points = list;
+		points.count = OCTREE_OBJECTS;
+		InsertOctreeList(&tree, &points, 0.5f, NULL);
+		built = 1;
+	}
+	return &tree;
+}
+
+void BenchMoveOctree(unsigned int n)
+{
+	Octree *tree = BenchOctree();
+	static float t = 0;
+	AABB box;
+	unsigned int i;
+	float d, s = sinf(t += 0.1f);
+	// Objects drift around their start, a few cells away at most
+	for (i = 0; i < n; i++)
+	{
+		d = floats[i] * 0.2f * s;
+		SetVector(vectors[i].x + d - 0.5f, vectors[i].y - 0.5f,
+				vectors[i].z - d - 0.5f, 1, &box.min);
+		SetVector(vectors[i].x + d + 0.5f, vectors[i].y + 0.5f,
+				vectors[i].z - d + 0.5f, 1, &box.max);
+		MoveOctree(tree, i, box);
+	}
+}
+
+void BenchOctreeQuerySphere(unsigned int n)
+{
+	Octree *tree = BenchOctree();
+	unsigned int handles[64];
+	unsigned int i, found = 0;
+	for (i = 0; i < n; i++)
+	{
+		found += OctreeQuerySphere(tree, vectors[OCTREE_OBJECTS + i], 3,
+				handles, 64);
+	}
+	sink = found;
+}
+
+// Frustum of a 90 degree perspective camera at the origin looking down -z
+
+void BenchFrustum(Frustum *frustum)
+{
+	Matrix3D projection;
+	EmptyMatrix(&projection);
+	projection.X.x = 1;
+	projection.Y.y = 1;
+	projection.Z.z = -1.01f;
+	projection.Z.w = -1;
+	projection.W.z = -1.01f;
+	ExtractFrustum(&projection, FRUSTUM_DEPTH_NEGATIVE_ONE, frustum);
+}
+
+void BenchCullAABBs(unsigned int n)
+{
+	Frustum frustum;
+	BenchFrustum(&frustum);
+	soa.count = soa_out.count = n;
+	sink = CullAABBs(&frustum, &soa, &soa_out, (unsigned int *) floats_out,
+			(unsigned int *) floats_out2);
+	soa.count = soa_out.count = MAX_BATCH;
+}
+
+void BenchCullSpheres(unsigned int n)
+{
+	Frustum frustum;
+	BenchFrustum(&frustum);
+	soa.count = n;
+	sink = CullSpheres(&frustum, &soa, (unsigned int *) floats_out,
+			(unsigned int *) floats_out2);
+	soa.count = MAX_BATCH;
+}
+
+// Scene of HIERARCHY_NODES transforms, every node has one of the
+// earlier nodes as parent
+
+#define HIERARCHY_NODES 200000
+
+TransformHierarchy *BenchHierarchy()
+{
+	static TransformHierarchy hierarchy;
+	static int built = 0;
+	unsigned int *parents, i;
+	Matrix3D *locals;
+	if (!built)
+	{
+		parents = malloc(HIERARCHY_NODES * sizeof(unsigned int));
+		locals = malloc(HIERARCHY_NODES * sizeof(Matrix3D));
+		for (i = 0; i < HIERARCHY_NODES; i++)
+		{
+			parents[i] = i < 16 ? TRANSFORM_NONE : rand() % (i / 4);
+			locals[i] = matrices[i % MAX_MATRICES];
+		}
+		BuildTransformHierarchy(&hierarchy, parents, locals, HIERARCHY_NODES,
+				NULL);
+		free(parents);
+		free(locals);
+		built = 1;
+	}
+	return &hierarchy;
+}
+
+// n of the nodes move every frame
+void BenchUpdateTransforms(unsigned int n)
+{
+	TransformHierarchy *h = BenchHierarchy();
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		MarkTransformDirty(h, (i * 7919U) % HIERARCHY_NODES);
+	}
+	sink = UpdateTransforms(h);
+}
+
+// n rays from the -z side against 256 triangles around the first vectors
+
+#define RAY_TRIANGLES 256
+
+void BenchIntersectRays(unsigned int n)
+{
+	static Ray *rays = NULL;
+	static Vector3D *vertices;
+	static RayHit *hits;
+	unsigned int i;
+	if (rays == NULL)
+	{
+		rays = malloc(n * sizeof(Ray));
+		hits = malloc(n * sizeof(RayHit));
+		vertices = malloc(3 * RAY_TRIANGLES * sizeof(Vector3D));
+		for (i = 0; i < 3 * RAY_TRIANGLES; i++)
+		{
+			SetVector(vectors[i / 3].x + floats[i], vectors[i / 3].y +
+					floats[i + 1], vectors[i / 3].z, 1, &vertices[i]);
+		}
+		for (i = 0; i < n; i++)
+		{
+			SetVector(vectors[i].x, vectors[i].y, -100, 1, &rays[i].origin);
+			SetVector(floats[i] * 0.01f, floats[i + 1] * 0.01f, 1, 0,
+					&rays[i].direction);
+			rays[i].t_max = INFINITY;
+		}
+	}
+	sink = IntersectRays(rays, n, vertices, NULL, RAY_TRIANGLES, hits);
+}
+
+// BVH over small triangles around the first vectors, rays cross the box
+
+#define BVH_TRIANGLES 100000
+
+static VectorList bvh_vertices;
+
+static void InitBVHVertices(void)
+{
+	Vector3D v;
+	unsigned int i;
+	if (bvh_vertices.vectors != NULL)
+	{
+		return;
+	}
+	InitVectorList(&bvh_vertices, 3 * BVH_TRIANGLES);
+	for (i = 0; i < 3 * BVH_TRIANGLES; i++)
+	{
+		SetVector(vectors[i / 3].x + floats[i] * 0.1f, vectors[i / 3].y +
+				floats[i + 1] * 0.1f, vectors[i / 3].z + floats[i + 2] * 0.1f,
+				1, &v);
+		PushVector(v, &bvh_vertices);
+	}
+}
+
+void BenchBuildBVH(unsigned int n)
+{
+	BVH bvh;
+	InitBVHVertices();
+	BuildBVH(&bvh_vertices, NULL, n, &bvh);
+	sink = bvh.node_count;
+	FreeBVH(&bvh);
+}
+
+void BenchRefitBVH(unsigned int n)
+{
+	static BVH bvh;
+	InitBVHVertices();
+	if (bvh.nodes == NULL)
+	{
+		BuildBVH(&bvh_vertices, NULL, n, &bvh);
+	}
+	RefitBVH(&bvh);
+}
+
+void BenchBVHClosestHit(unsigned int n)
+{
+	static BVH bvh;
+	static Ray *rays = NULL;
+	static RayHit *hits;
+	unsigned int i;
+	if (rays == NULL)
+	{
+		InitBVHVertices();
+		BuildBVH(&bvh_vertices, NULL, BVH_TRIANGLES, &bvh);
+		rays = malloc(n * sizeof(Ray));
+		hits = malloc(n * sizeof(RayHit));
+		for (i = 0; i < n; i++)
+		{
+			SetVector(vectors[i].x, vectors[i].y, -100, 1, &rays[i].origin);
+			SetVector(floats[i] * 0.01f, floats[i + 1] * 0.01f, 1, 0,
+					&rays[i].direction);
+			rays[i].t_max = INFINITY;
+		}
+	}
+	sink = BVHClosestHitBatch(&bvh, rays, n, hits);
+}
+
+// Height field of MESH_SIDE * MESH_SIDE vertices, n is the vertex count
+
+#define MESH_SIDE 512
+
+static Mesh *BenchMesh(void)
+{
+	static Mesh mesh;
+	static int ready = 0;
+	Vector3D *positions;
+	unsigned int *indices, x, y, a, t = 0;
+	if (ready)
+	{
+		return &mesh;
+	}
+	positions = malloc(MESH_SIDE * MESH_SIDE * sizeof(Vector3D));
+	indices = malloc(6 * (MESH_SIDE - 1) * (MESH_SIDE - 1) *
+			sizeof(unsigned int));
+	for (y = 0; y < MESH_SIDE; y++)
+	{
+		for (x = 0; x < MESH_SIDE; x++)
+		{
+			SetVector(x, y, floats[y * MESH_SIDE + x] * 0.1f, 1,
+					&positions[y * MESH_SIDE + x]);
+		}
+	}
+	for (y = 0; y + 1 < MESH_SIDE; y++)
+	{
+		for (x = 0; x + 1 < MESH_SIDE; x++)
+		{
+			a = y * MESH_SIDE + x;
+			indices[t++] = a;
+			indices[t++] = a + 1;
+			indices[t++] = a + MESH_SIDE;
+			indices[t++] = a + 1;
+			indices[t++] = a + MESH_SIDE + 1;
+			indices[t++] = a + MESH_SIDE;
+		}
+	}
+	InitMesh(&mesh);
+	SetMesh(&mesh, positions, MESH_SIDE * MESH_SIDE, indices, t / 3);
+	free(positions);
+	free(indices);
+	ready = 1;
+	return &mesh;
+}
+
+void BenchComputeMeshFaceNormals(unsigned int n)
+{
+	sink = ComputeMeshFaceNormals(BenchMesh());
+	(void)n;
+}
+
+void BenchComputeMeshNormalsArea(unsigned int n)
+{
+	sink = ComputeMeshNormals(BenchMesh(), MESH_WEIGHT_AREA);
+	(void)n;
+}
+
+void BenchComputeMeshNormalsAngle(unsigned int n)
+{
+	sink = ComputeMeshNormals(BenchMesh(), MESH_WEIGHT_ANGLE);
+	(void)n;
+}
+
+void BenchComputeMeshTangents(unsigned int n)
+{
+	static float *uvs = NULL;
+	unsigned int i;
+	if (uvs == NULL)
+	{
+		uvs = malloc(2 * n * sizeof(float));
+		for (i = 0; i < n; i++)
+		{
+			uvs[2 * i] = (float) (i % MESH_SIDE) / MESH_SIDE;
+			uvs[2 * i + 1] = (float) (i / MESH_SIDE) / MESH_SIDE;
+		}
+	}
+	sink = ComputeMeshTangents(BenchMesh(), uvs);
+}
+
+// Point cloud import, the files are written on first use and removed
+// at exit
+
+#define BENCH_XYZ "bench_points.xyz"
+#define BENCH_PLY "bench_points.ply"
+
+void WriteBenchPointClouds(unsigned int n)
+{
+	static unsigned int written = 0;
+	unsigned int i;
+	FILE *f;
+	if (written == n)
+	{
+		return;
+	}
+	f = fopen(BENCH_XYZ, "w");
+	for (i = 0; i < n; i++)
+	{
+		fprintf(f, "%.6f %.6f %.6f\n", vectors[i].x, vectors[i].y,
+				vectors[i].z);
+	}
+	fclose(f);
+	f = fopen(BENCH_PLY, "wb");
+	fprintf(f, "ply\nformat binary_little_endian 1.0\nelement vertex %u\n"
+			"property float x\nproperty float y\nproperty float z\n"
+			"end_header\n", n);
+	for (i = 0; i < n; i++)
+	{
+		fwrite(&vectors[i], sizeof(float), 3, f);
+	}
+	fclose(f);
+	written = n;
+}
+
+void BenchLoadPointCloudXYZ(unsigned int n)
+{
+	WriteBenchPointClouds(n);
+	list_out.count = 0;
+	list_out.index = -1;
+	LoadPointCloud(BENCH_XYZ, &list_out);
+}
+
+void BenchLoadPointCloudPLY(unsigned int n)
+{
+	WriteBenchPointClouds(n);
+	list_out.count = 0;
+	list_out.index = -1;
+	LoadPointCloud(BENCH_PLY, &list_out);
+}
+
+// VectorListSoA
+
+void BenchVectorListToSoA(unsigned int n)
+{
+	list.count = n;
+	VectorListToSoA(&list, &soa_out);
+	list.count = MAX_BATCH;
+}
+
+void BenchTransformVectorSoA(unsigned int n)
+{
+	soa.count = n;
+	TransformVectorSoA(&matrix, &soa, &soa_out);
+	soa.count = MAX_BATCH;
+}
+
+void BenchNormalizeVectorSoA(unsigned int n)
+{
+	soa_out.count = n;
+	NormalizeVectorSoA(&soa_out);
+}
+
+void BenchDotProductSoA(unsigned int n)
+{
+	soa.count = n;
+	DotProductSoA(&soa, &soa, floats_out);
+	soa.count = MAX_BATCH;
+}
+
+// Quaternion
+
+void BenchMultiplyQuaternion(unsigned int n)
+{
+	unsigned int i;
+	Quaternion q = q1;
+	for (i = 0; i < n; i++)
+	{
+		MultiplyQuaternion(q, q2, &q);
+	}
+	sink = q.w;
+}
+
+void BenchSlerpQuaternion(unsigned int n)
+{
+	unsigned int i;
+	Quaternion q;
+	float sum = 0;
+	for (i = 0; i < n; i++)
+	{
+		SlerpQuaternion(q1, q2, i / (float)n, &q);
+		sum += q.w;
+	}
+	sink = sum;
+}
+
+void BenchQuaternionToMatrix(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		QuaternionToMatrix(q1, &matrices_out[i]);
+	}
+}
+
+void BenchQuaternionRotateVectorList(unsigned int n)
+{
+	list_out.count = 0;
+	list_out.index = -1;
+	PushVectors(vectors, n, &list_out);
+	QuaternionRotateVectorList(q1, &list_out);
+}
+
+// Trigonometry
+
+void BenchLibmSinCos(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		floats_out[i] = sinf(floats[i]);
+		floats_out2[i] = cosf(floats[i]);
+	}
+}
+
+void BenchFastSinCos(unsigned int n)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++)
+	{
+		FastSinCos(floats[i], &floats_out[i], &floats_out2[i]);
+	}
+}
+
+void BenchFastSinCosArray(unsigned int n)
+{
+	FastSinCosArray(floats, floats_out, floats_out2, n);
+}
+
+Bench benches[] = {
+	{"AddVector", BenchAddVector, 1 << 16},
+	{"CrossProduct", BenchCrossProduct, 1 << 16},
+	{"DotProduct", BenchDotProduct, 1 << 16},
+	{"NormalizeVector", BenchNormalizeVector, 1 << 16},
+	{"VectorLength", BenchVectorLength, 1 << 16},
+	{"VectorDistance", BenchVectorDistance, 1 << 16},
+	{"RotateAroundX", BenchRotateAroundX, 1 << 16},
+	{"PlaneNormal", BenchPlaneNormal, 1 << 16},
+	{"VectorEquals", BenchVectorEquals, 1 << 16},
+	{"SubVector", BenchSubVector, 1 << 16},
+	{"ScaleVector", BenchScaleVector, 1 << 16},
+	{"DivideVector", BenchDivideVector, 1 << 16},
+	{"VectorNorm", BenchVectorNorm, 1 << 16},
+	{"PerpendicularVector", BenchPerpendicularVector, 1 << 16},
+	{"RotateAroundY", BenchRotateAroundY, 1 << 16},
+	{"RotateAroundZ", BenchRotateAroundZ, 1 << 16},
+	{"MultiplyMatrix", BenchMultiplyMatrix, 1 << 14},
+	{"MultiplyMatrixRestrict", BenchMultiplyMatrixRestrict, 1 << 14},
+	{"MultiplyMatrixArray", BenchMultiplyMatrixArray, 1 << 16},
+	{"MultiplyMatrixBroadcastRight", BenchMultiplyMatrixBroadcastRight,
+		1 << 16},
+	{"MultiplyMatrixBroadcastLeft", BenchMultiplyMatrixBroadcastLeft,
+		1 << 16},
+	{"VectorTransform", BenchVectorTransform, 1 << 20},
+	{"TransformVectors", BenchTransformVectors, 1 << 20},
+	{"MatrixDeterminant", BenchMatrixDeterminant, 1 << 14},
+	{"InvertMatrix", BenchInvertMatrix, 1 << 14},
+	{"InvertAffineMatrix", BenchInvertAffineMatrix, 1 << 14},
+	{"InvertRigidMatrix", BenchInvertRigidMatrix, 1 << 14},
+	{"InvertMatrixFast", BenchInvertMatrixFast, 1 << 14},
+	{"TransposeMatrix", BenchTransposeMatrix, 1 << 14},
+	{"CreateRotationMatrix", BenchCreateRotationMatrix, 1 << 14},
+	{"CreateRotationMatrix/FastTrig", BenchCreateRotationMatrixFastTrig,
+		1 << 14},
+	{"LookAtMatrix", BenchLookAtMatrix, 1 << 14},
+	{"HomogeneousMatrix", BenchHomogeneousMatrix, 1 << 14},
+	{"CreateScaleMatrix", BenchCreateScaleMatrix, 1 << 14},
+	{"CreateTranslationMatrix", BenchCreateTranslationMatrix, 1 << 14},
+	{"CreateScaleAndTranslationMatrix",
+		BenchCreateScaleAndTranslationMatrix, 1 << 14},
+	{"CreateRotationMatrixX", BenchCreateRotationMatrixX, 1 << 14},
+	{"CreateRotationMatrixY", BenchCreateRotationMatrixY, 1 << 14},
+	{"CreateRotationMatrixZ", BenchCreateRotationMatrixZ, 1 << 14},
+	{"CreateRotationMatrixXSinCos", BenchCreateRotationMatrixXSinCos,
+		1 << 14},
+	{"CreateRotationMatrixYSinCos", BenchCreateRotationMatrixYSinCos,
+		1 << 14},
+	{"CreateRotationMatrixZSinCos", BenchCreateRotationMatrixZSinCos,
+		1 << 14},
+	{"CreatePerspectiveMatrix", BenchCreatePerspectiveMatrix, 1 << 14},
+	{"CreateInfinitePerspectiveMatrix",
+		BenchCreateInfinitePerspectiveMatrix, 1 << 14},
+	{"CreateReversedZPerspectiveMatrix",
+		BenchCreateReversedZPerspectiveMatrix, 1 << 14},
+	{"CreateOrthographicMatrix", BenchCreateOrthographicMatrix, 1 << 14},
+	{"CreateReversedZOrthographicMatrix",
+		BenchCreateReversedZOrthographicMatrix, 1 << 14},
+	{"AdjointMatrix", BenchAdjointMatrix, 1 << 14},
+	{"ScaleMatrix", BenchScaleMatrix, 1 << 14},
+	{"MatrixEquals", BenchMatrixEquals, 1 << 14},
+	{"CastFloat", BenchCastFloat, 1 << 14},
+	{"IsAffineMatrix", BenchIsAffineMatrix, 1 << 14},
+	{"IsRigidMatrix", BenchIsRigidMatrix, 1 << 14},
+	{"PushVector", BenchPushVector, 1 << 20},
+	{"PushVectors", BenchPushVectors, 1 << 20},
+	{"TemporaryLists/Heap", BenchTemporaryListsHeap, 1 << 14},
+	{"TemporaryLists/Arena", BenchTemporaryListsArena, 1 << 14},
+	{"RemoveVectorIndex", BenchRemoveVectorIndex, 1 << 10},
+	{"SwapRemoveVectorIndex", BenchSwapRemoveVectorIndex, 1 << 16},
+	{"PopVector", BenchPopVector, 1 << 20},
+	{"RemoveLastVector", BenchRemoveLastVector, 1 << 20},
+	{"TrimVectorList", BenchTrimVectorList, 1 << 14},
+	{"RemoveVectorIndices", BenchRemoveVectorIndices, 1 << 16},
+	{"RemoveVectorsIf", BenchRemoveVectorsIf, 1 << 20},
+	{"TransformVectorList", BenchTransformVectorList, 1 << 20},
+	{"TransformVectorListInPlace", BenchTransformVectorListInPlace,
+		1 << 20},
+	{"ScaleVectorList", BenchScaleVectorList, 1 << 20},
+	{"NormalizeVectorList", BenchNormalizeVectorList, 1 << 20},
+	{"VectorListBounds", BenchVectorListBounds, 1 << 20},
+	{"ComputeBoundingSphere", BenchComputeBoundingSphere, 1 << 20},
+	{"ComputeOBB", BenchComputeOBB, 1 << 20},
+	{"BuildKDTree", BenchBuildKDTree, SPATIAL_POINTS},
+	{"KDTreeNearest/k8", BenchKDTreeNearest, 1 << 14},
+	{"RebuildSpatialHash", BenchRebuildSpatialHash, SPATIAL_POINTS},
+	{"SpatialHashRadius/r2", BenchSpatialHashRadius, 1 << 14},
+	{"MoveOctree", BenchMoveOctree, OCTREE_OBJECTS},
+	{"OctreeQuerySphere/r3", BenchOctreeQuerySphere, 1 << 14},
+	{"CullAABBs", BenchCullAABBs, 500000},
+	{"CullSpheres", BenchCullSpheres, 500000},
+	{"UpdateTransforms/1%", BenchUpdateTransforms, HIERARCHY_NODES / 100},
+	{"UpdateTransforms/All", BenchUpdateTransforms, HIERARCHY_NODES},
+	{"IntersectRays/256", BenchIntersectRays, 4096},
+	{"BuildBVH", BenchBuildBVH, 100000},
+	{"RefitBVH", BenchRefitBVH, 100000},
+	{"BVHClosestHit/100k", BenchBVHClosestHit, 65536},
+	{"ComputeMeshFaceNormals", BenchComputeMeshFaceNormals, 262144},
+	{"ComputeMeshNormals/Area", BenchComputeMeshNormalsArea, 262144},
+	{"ComputeMeshNormals/Angle", BenchComputeMeshNormalsAngle, 262144},
+	{"ComputeMeshTangents", BenchComputeMeshTangents, 262144},
+	{"LoadPointCloud/XYZ", BenchLoadPointCloudXYZ, 1 << 18},
+	{"LoadPointCloud/PLY", BenchLoadPointCloudPLY, 1 << 18},
+	{"VectorListToSoA", BenchVectorListToSoA, 1 << 20},
+	{"TransformVectorSoA", BenchTransformVectorSoA, 1 << 20},
+	{"NormalizeVectorSoA", BenchNormalizeVectorSoA, 1 << 20},
+	{"DotProductSoA", BenchDotProductSoA, 1 << 20},
+	{"MultiplyQuaternion", BenchMultiplyQuaternion, 1 << 16},
+	{"SlerpQuaternion", BenchSlerpQuaternion, 1 << 16},
+	{"QuaternionToMatrix", BenchQuaternionToMatrix, 1 << 16},
+	{"QuaternionRotateVectorList", BenchQuaternionRotateVectorList, 1 << 20},
+	{"LibmSinCos", BenchLibmSinCos, 1 << 20},
+	{"FastSinCos", BenchFastSinCos, 1 << 20},
+	{"FastSinCosArray", BenchFastSinCosArray, 1 << 20},
+	{NULL, NULL, 0}
+};
+
+void RunBench(Bench *bench, BenchResult *result)
+{
+	double times[REPEATS];
+	double start, sum = 0, min, variance = 0;
+	unsigned int i;
+	for (i = 0; i < REPEATS; i++)
+	{
+		start = Now();
+		bench->run(bench->n);
+		times[i] = (Now() - start) / bench->n;
+	}
+	// times[0] is the warm up
+	min = times[1];
+	for (i = 1; i < REPEATS; i++)
+	{
+		sum += times[i];
+		if (times[i] < min)
+		{
+			min = times[i];
+		}
+	}
+	result->name = bench->name;
+	result->n = bench->n;
+	result->ns_per_op = sum / (REPEATS - 1);
+	for (i = 1; i < REPEATS; i++)
+	{
+		variance += (times[i] - result->ns_per_op) *
+			(times[i] - result->ns_per_op);
+	}
+	result->stddev = sqrt(variance / (REPEATS - 1));
+	result->min_ns_per_op = min;
+	result->ops_per_second = 1E9 / result->ns_per_op;
+}
+
+void WriteJSON(FILE *f, BenchResult *results, unsigned int count)
+{
+	unsigned int i;
+	fprintf(f, "{\n");
+	fprintf(f, "  \"timestamp\": %ld,\n", (long)time(NULL));
+#ifdef __VERSION__
+	fprintf(f, "  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+	// Flags of this file, the library may be built with others
+#ifdef ANSIC3D_BENCH_CFLAGS
+	fprintf(f, "  \"cflags\": \"%s\",\n", ANSIC3D_BENCH_CFLAGS);
+#endif
+#ifdef __OPTIMIZE__
+	fprintf(f, "  \"optimize\": 1,\n");
+#else
+	fprintf(f, "  \"optimize\": 0,\n");
+#endif
+#ifdef __OPTIMIZE_SIZE__
+	fprintf(f, "  \"optimize_size\": 1,\n");
+#else
+	fprintf(f, "  \"optimize_size\": 0,\n");
+#endif
+	fprintf(f, "  \"simd\": \"%s\",\n", SIMDLevelName(GetSIMDLevel()));
+	fprintf(f, "  \"threads\": %d,\n", GetThreadCount());
+	fprintf(f, "  \"fast_trig\": %d,\n", GetFastTrig());
+	fprintf(f, "  \"repeats\": %d,\n", REPEATS - 1);
+	fprintf(f, "  \"results\": [\n");
+	for (i = 0; i < count; i++)
+	{
+		fprintf(f, "    {\"name\": \"%s\", \"n\": %u, \"ns_per_op\": %.4f, "
+				"\"min_ns_per_op\": %.4f, \"stddev_ns\": %.4f, "
+				"\"ops_per_second\": %.1f}%s\n", results[i].name,
+				results[i].n, results[i].ns_per_op, results[i].min_ns_per_op,
+				results[i].stddev, results[i].ops_per_second,
+				i + 1 < count ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+}
+
+/**
+ * Usage: bench [output.json|-] [name filter]
+ * Results are printed as a table and written as JSON to output.json
+ * (bench_results.json by default). With - the JSON goes to stdout and
+ * the table to stderr.
+ */
+int main(int argc, char **argv)
+{
+	BenchResult results[MAX_RESULTS];
+	const char *output = "bench_results.json";
+	const char *filter = NULL;
+	unsigned int i, count = 0;
+	FILE *f, *table = stdout;
+	if (argc > 1)
+	{
+		output = argv[1];
+	}
+	if (argc > 2)
+	{
+		filter = argv[2];
+	}
+	if (strcmp(output, "-") == 0)
+	{
+		table = stderr;
+	}
+	SetupData();
+	fprintf(table, "SIMD: %s, threads: %d\n", SIMDLevelName(GetSIMDLevel()),
+			GetThreadCount());
+	fprintf(table, "%-32s %10s %12s %12s %10s %14s\n", "name", "n", "ns/op",
+			"min ns/op", "stddev", "ops/s");
+	for (i = 0; benches[i].name != NULL && count < MAX_RESULTS; i++)
+	{
+		if (filter != NULL && strstr(benches[i].name, filter) == NULL)
+		{
+			continue;
+		}
+		RunBench(&benches[i], &results[count]);
+		fprintf(table, "%-32s %10u %12.3f %12.3f %10.3f %14.0f\n",
+				results[count].name, results[count].n,
+				results[count].ns_per_op, results[count].min_ns_per_op,
+				results[count].stddev, results[count].ops_per_second);
+		count++;
+	}
+	remove(BENCH_XYZ);
+	remove(BENCH_PLY);
+	if (strcmp(output, "-") == 0)
+	{
+		WriteJSON(stdout, results, count);
+		return 0;
+	}
+	f = fopen(output, "w");
+	if (f == NULL)
+	{
+		printf("Can not write %s\n", output);
+		return 1;
+	}
+	WriteJSON(f, results, count);
+	fclose(f);
+	printf("Results written to %s\n", output);
+	return 0;
+}
@@ -0,0 +1,106 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _allocator_h
+#define _allocator_h
+
+#include <stddef.h>
+#include <ansic3d/config.h>
+
+/**
+ * Every FrameArena allocation is aligned to this many bytes
+ */
+#define ARENA_ALIGNMENT 32
+
+/**
+ * Memory allocator used by the containers of the library.
+ * The previous size of a block is passed to realloc and free so simple
+ * allocators (like FrameArena) do not have to keep a header per block.
+ * context is passed back to every call.
+ */
+typedef struct _Allocator
+{
+	void *(*alloc)(size_t size, void *context);
+	void *(*realloc)(void *p, size_t old_size, size_t size, void *context);
+	void (*free)(void *p, size_t size, void *context);
+	void *context;
+} Allocator;
+
+/**
+ * Bump allocator for short lived (per frame) data.
+ * Allocations take a slice of a single fixed buffer, free only gives the
+ * memory back when it was the latest allocation and ResetFrameArena
+ * releases everything at once in O(1).
+ * An arena is not thread safe, use one arena per thread.
+ */
+typedef struct _FrameArena
+{
+	Allocator allocator;
+	unsigned char *buffer;
+	size_t size;
+	size_t offset;
+	size_t last;
+} FrameArena;
+
+/**
+ * malloc/realloc/free based allocator, used when a container is given
+ * no allocator
+ */
+Allocator *HeapAllocator(void);
+
+/**
+ * Allocate size bytes with allocator, NULL allocator uses the heap
+ * Return the memory, NULL if fails
+ */
+void *AllocatorAlloc(Allocator *allocator, size_t size);
+
+/**
+ * Resize the block p of old_size bytes to size bytes.
+ * Return the memory, NULL if fails (p is still valid then)
+ */
+void *AllocatorRealloc(Allocator *allocator, void *p, size_t old_size,
+		size_t size);
+
+/**
+ * Give the block p of size bytes back to allocator
+ */
+void AllocatorFree(Allocator *allocator, void *p, size_t size);
+
+/**
+ * Init the arena with a buffer of size bytes from the heap.
+ * arena->allocator can be given to the containers after this.
+ * Return 1 on success, 0 if fails
+ */
+int InitFrameArena(FrameArena *arena, size_t size);
+
+/**
+ * Release every allocation made from the arena in O(1).
+ * Containers using the arena must not be used after this.
+ */
+void ResetFrameArena(FrameArena *arena);
+
+/**
+ * Bytes allocated from the arena since the last reset
+ */
+size_t FrameArenaUsed(FrameArena *arena);
+
+/**
+ * Free the buffer of the arena
+ */
+void FreeFrameArena(FrameArena *arena);
+
+#endif
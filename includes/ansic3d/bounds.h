@@ -0,0 +1,85 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _bounds_h
+#define _bounds_h
+
+#include <ansic3d/vector3d.h>
+#include <ansic3d/vectorlist.h>
+#include <ansic3d/config.h>
+
+/**
+ * Axis aligned bounding box
+ */
+typedef struct _AABB
+{
+	Vector3D min;
+	Vector3D max;
+} AABB;
+
+typedef struct _BoundingSphere
+{
+	Vector3D center;
+	float radius;
+} BoundingSphere;
+
+/**
+ * Oriented bounding box. axis are orthonormal, extents are the half
+ * sizes of the box along them.
+ */
+typedef struct _OBB
+{
+	Vector3D center;
+	Vector3D axis[3];
+	Vector3D extents;
+} OBB;
+
+/**
+ * Six planes facing inwards (left, right, bottom, top, near, far), xyz
+ * is the plane normal and w the distance. A point p is on the inner side
+ * of a plane when dot(xyz, p) + w >= 0.
+ */
+typedef struct _Frustum
+{
+	Vector3D planes[6];
+} Frustum;
+
+/**
+ * Bounding box of the vectors in list (w = 1 for min and max).
+ * SIMD min/max reduction, split across threads for large lists.
+ * Return count of items in list, 0 if the list is empty
+ */
+int ComputeAABB(VectorList *list, AABB *box);
+
+/**
+ * Bounding sphere of the vectors in list.
+ * Ritter's algorithm seeded with the most distant pair of the points at
+ * the box extremes, the sphere around the box center is used instead if
+ * it is smaller. Within about 5% of the minimal sphere for most inputs.
+ * Return count of items in list, 0 if the list is empty
+ */
+int ComputeBoundingSphere(VectorList *list, BoundingSphere *sphere);
+
+/**
+ * Oriented bounding box of the vectors in list, the axes are the
+ * principal components (eigenvectors of the covariance matrix) sorted by
+ * decreasing variance.
+ * Return count of items in list, 0 if the list is empty
+ */
+int ComputeOBB(VectorList *list, OBB *box);
+
+#endif
@@ -0,0 +1,113 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _bvh_h
+#define _bvh_h
+
+#include <ansic3d/vector3d.h>
+#include <ansic3d/vectorlist.h>
+#include <ansic3d/ray.h>
+#include <ansic3d/config.h>
+
+/**
+ * Maximum number of triangles in a leaf
+ */
+#define BVH_LEAF_SIZE 4
+
+/**
+ * Number of centroid bins the SAH is evaluated on per axis
+ */
+#define BVH_BINS 16
+
+/**
+ * Maximum depth of a BVH. Below half of it nodes are split at the middle
+ * of the triangle range so any input stays within it.
+ */
+#define BVH_MAX_DEPTH 64
+
+/**
+ * Node of a BVH, 32 bytes. Leaves have count triangles starting at
+ * bvh->triangles[first]. Inner nodes have count = 0, their left child
+ * follows them in the node array and first is the index of the right
+ * child.
+ */
+typedef struct _BVHNode
+{
+	float min[3];
+	unsigned int first;
+	float max[3];
+	unsigned int count;
+} BVHNode;
+
+/**
+ * Bounding volume hierarchy over the triangles of an index buffer into
+ * a VectorList. The vertices and indices are not copied, they must stay
+ * alive; after moving vertices call RefitBVH. triangles is the triangle
+ * order of the leaves.
+ */
+typedef struct _BVH
+{
+	BVHNode *nodes;
+	unsigned int node_count;
+	unsigned int *triangles;
+	unsigned int triangle_count;
+	VectorList *vertices;
+	const unsigned int *indices;
+} BVH;
+
+/**
+ * Build the BVH with binned SAH splits. Triangle i is vertices[indices[3i]],
+ * vertices[indices[3i + 1]], vertices[indices[3i + 2]], or vertices 3i,
+ * 3i + 1 and 3i + 2 if indices is NULL. Subtrees are built in parallel,
+ * the tree does not depend on the thread count.
+ * Return count of triangles, 0 if fails
+ */
+int BuildBVH(VectorList *vertices, const unsigned int *indices,
+		unsigned int triangle_count, BVH *bvh);
+
+/**
+ * Recompute the node bounds from the current vertex positions, keeping
+ * the tree. Cheap but the tree degrades as the mesh deforms further from
+ * the shape it was built on.
+ */
+void RefitBVH(BVH *bvh);
+
+/**
+ * Nearest hit of ray, see RayHit.
+ * Return 1 if the ray hits a triangle, 0 if not
+ */
+int BVHClosestHit(BVH *bvh, const Ray *ray, RayHit *hit);
+
+/**
+ * Stop at the first triangle hit, e.g. for shadow and occlusion rays.
+ * Return 1 if the ray hits any triangle before t_max, 0 if not
+ */
+int BVHAnyHit(BVH *bvh, const Ray *ray);
+
+/**
+ * BVHClosestHit for n rays, split across threads.
+ * Return count of rays that hit a triangle
+ */
+unsigned int BVHClosestHitBatch(BVH *bvh, const Ray *rays, unsigned int n,
+		RayHit *hits);
+
+/**
+ * Free the BVH, the vertices and indices are left alone
+ */
+void FreeBVH(BVH *bvh);
+
+#endif
@@ -0,0 +1,133 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _camera_h
+#define _camera_h
+
+#include <ansic3d/vector3d.h>
+#include <ansic3d/matrix3d.h>
+#include <ansic3d/bounds.h>
+#include <ansic3d/config.h>
+
+/**
+ * Projection modes of a Camera
+ */
+#define CAMERA_PERSPECTIVE 0
+#define CAMERA_ORTHOGRAPHIC 1
+
+/**
+ * Dirty bits of the matrices a Camera caches
+ */
+#define CAMERA_VIEW 1
+#define CAMERA_PROJECTION 2
+#define CAMERA_VIEW_PROJECTION 4
+#define CAMERA_INVERSE_VIEW 8
+#define CAMERA_INVERSE_PROJECTION 16
+#define CAMERA_INVERSE_VIEW_PROJECTION 32
+#define CAMERA_ALL 63
+
+/**
+ * Camera with lazily computed matrices. Setters only mark the matrices
+ * that depend on them dirty, getters recompute a matrix the first time
+ * it is read after a change. Use the setters instead of writing the
+ * fields so the cache stays valid.
+ * size is the height of the view volume of an orthographic camera, the
+ * width is size * aspect.
+ */
+typedef struct _Camera
+{
+	Vector3D eye;
+	Vector3D target;
+	Vector3D up;
+	int mode;
+	int reversed_z;
+	float fov_y;
+	float size;
+	float aspect;
+	float near;
+	float far;
+	unsigned int dirty;
+	Matrix3D view;
+	Matrix3D projection;
+	Matrix3D view_projection;
+	Matrix3D inverse_view;
+	Matrix3D inverse_projection;
+	Matrix3D inverse_view_projection;
+} Camera;
+
+/**
+ * Init a perspective camera at the origin looking down -z, 60 degrees
+ * vertical field of view, near 0.1 and far 1000
+ */
+void InitCamera(Camera *camera);
+
+/**
+ * Place the camera, see LookAtMatrix
+ */
+void SetCameraLookAt(Camera *camera, Vector3D eye, Vector3D target,
+		Vector3D up);
+
+/**
+ * Use view as the view matrix instead of a look at, e.g. the inverse of
+ * a node transform. eye, target and up are left unchanged.
+ */
+void SetCameraView(Camera *camera, Matrix3D *view);
+
+/**
+ * Switch to a perspective projection, far can be INFINITY.
+ * reversed_z: map depth to 1 at near and 0 at far
+ */
+void SetCameraPerspective(Camera *camera, float fov_y, float aspect,
+		float near, float far, int reversed_z);
+
+/**
+ * Switch to an orthographic projection centered on the view axis,
+ * size is the height of the view volume.
+ */
+void SetCameraOrthographic(Camera *camera, float size, float aspect,
+		float near, float far, int reversed_z);
+
+/**
+ * Change the aspect ratio only, e.g. when the viewport is resized
+ */
+void SetCameraAspect(Camera *camera, float aspect);
+
+/**
+ * Cached matrices of the camera, the pointers stay valid as long as the
+ * camera does. Row vectors: clip = world * view_projection.
+ */
+const Matrix3D *CameraView(Camera *camera);
+const Matrix3D *CameraProjection(Camera *camera);
+const Matrix3D *CameraViewProjection(Camera *camera);
+const Matrix3D *CameraInverseView(Camera *camera);
+const Matrix3D *CameraInverseProjection(Camera *camera);
+const Matrix3D *CameraInverseViewProjection(Camera *camera);
+
+/**
+ * Planes of the view volume in world space, see ExtractFrustum
+ */
+void CameraFrustum(Camera *camera, Frustum *frustum);
+
+/**
+ * World space ray through a point of the viewport for picking.
+ * x, y: normalized device coordinates in [-1, 1], y up
+ * origin is on the near plane, direction is normalized (w = 0)
+ */
+void CameraRay(Camera *camera, float x, float y, Vector3D *origin,
+		Vector3D *direction);
+
+#endif
@@ -21,4 +21,36 @@
 // If defined, debug messages from ANSIC3D will be printed to stdio
 #define ANSIC3D_DEBUG
 
+// SIMD kernels (SSE/AVX2) are compiled in when building for x86 with gcc or
+// clang. The widest kernel the CPU supports is picked at runtime (see cpu.h)
+// Define ANSIC3D_NO_SIMD to build the scalar code paths only.
+// #define ANSIC3D_NO_SIMD
+
+// If defined, rotation builders use the polynomial FastSinCos instead of
+// libm sinf/cosf by default (see trig.h, can be toggled with SetFastTrig)
+// #define ANSIC3D_FAST_TRIG
+
+// Bulk operations split their work across threads above a size threshold
+// (see parallel.h). Define ANSIC3D_NO_THREADS to build without pthreads.
+// #define ANSIC3D_NO_THREADS
+
+// Default factor a VectorList capacity is multiplied by when it is full.
+// Can be changed at runtime with SetVectorListGrowthFactor
+#define VECTORLIST_GROWTH_FACTOR 2.0f
+
+// restrict qualifier for the no-alias variants of the API, also usable
+// from C89 and C++ code through the compiler extension
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#define ANSIC3D_RESTRICT restrict
+#elif defined(__GNUC__)
+#define ANSIC3D_RESTRICT __restrict__
+#else
+#define ANSIC3D_RESTRICT
+#endif
+
+#if !defined(ANSIC3D_NO_SIMD) && defined(__GNUC__) && \
+	(defined(__x86_64__) || defined(__i386__))
+#define ANSIC3D_X86_SIMD
+#endif
+
 #endif
@@ -0,0 +1,66 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _cpu_h
+#define _cpu_h
+
+#include <ansic3d/config.h>
+
+/**
+ * SIMD levels used to pick the kernel for bulk operations.
+ * A higher level implies all the lower ones.
+ * SIMD_AVX2 also requires FMA.
+ */
+#define SIMD_SCALAR 0
+#define SIMD_SSE 1
+#define SIMD_SSE41 2
+#define SIMD_AVX 3
+#define SIMD_AVX2 4
+
+/**
+ * Environment variable to force a SIMD level at startup.
+ * Accepts scalar, sse, sse4.1, avx or avx2. Levels above the one the CPU
+ * supports are clamped down.
+ */
+#define SIMD_ENV "ANSIC3D_SIMD"
+
+/**
+ * Query the CPU (cpuid) for the widest SIMD level it supports.
+ * Always returns SIMD_SCALAR if the library is built without SIMD kernels.
+ */
+int DetectSIMDLevel(void);
+
+/**
+ * SIMD level currently used by the bulk operations.
+ * Selected when the library is loaded from the CPU features and the
+ * SIMD_ENV environment variable.
+ */
+int GetSIMDLevel(void);
+
+/**
+ * Force the SIMD level used by the bulk operations. Levels above the one
+ * the CPU supports are clamped down.
+ * Return the level actually set
+ */
+int SetSIMDLevel(int level);
+
+/**
+ * Name of the SIMD level as accepted by SIMD_ENV
+ */
+const char *SIMDLevelName(int level);
+
+#endif
@@ -0,0 +1,79 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _frustum_h
+#define _frustum_h
+
+#include <ansic3d/vector3d.h>
+#include <ansic3d/matrix3d.h>
+#include <ansic3d/vectorlistsoa.h>
+#include <ansic3d/bounds.h>
+#include <ansic3d/config.h>
+
+/**
+ * Clip space depth of the projection, -w <= z <= w (OpenGL)
+ */
+#define FRUSTUM_DEPTH_NEGATIVE_ONE 0
+
+/**
+ * Clip space depth of the projection, 0 <= z <= w (Direct3D, Vulkan and
+ * reversed-Z projections)
+ */
+#define FRUSTUM_DEPTH_ZERO_ONE 1
+
+/**
+ * Extract the planes of the frustum of a view-projection matrix (row
+ * vectors, clip = v * matrix), normalized so plane distances are in
+ * world units. Degenerate planes, e.g. the far plane of an infinite
+ * projection, never cull.
+ * depth_range: FRUSTUM_DEPTH_NEGATIVE_ONE or FRUSTUM_DEPTH_ZERO_ONE
+ */
+void ExtractFrustum(Matrix3D *view_projection, int depth_range,
+		Frustum *frustum);
+
+/**
+ * Return 1 if box is not completely outside of a frustum plane, 0 if it
+ * can be culled
+ */
+int AABBInFrustum(const Frustum *frustum, const AABB *box);
+
+/**
+ * Return 1 if sphere is not completely outside of a frustum plane, 0 if
+ * it can be culled
+ */
+int SphereInFrustum(const Frustum *frustum, const BoundingSphere *sphere);
+
+/**
+ * Cull the boxes min[i], max[i] against frustum, see AABBInFrustum.
+ * Bit i % 32 of mask[i / 32] is set for every visible box, mask must
+ * hold (count + 31) / 32 words. The indices of the visible boxes are
+ * written to indices in increasing order. mask and indices can be NULL.
+ * SIMD kernels, split across threads for large lists.
+ * Return count of visible boxes
+ */
+unsigned int CullAABBs(const Frustum *frustum, VectorListSoA *min,
+		VectorListSoA *max, unsigned int *mask, unsigned int *indices);
+
+/**
+ * Cull spheres against frustum, the radius of sphere i is spheres->w[i]
+ * (0 if the list has no w). See CullAABBs for mask and indices.
+ * Return count of visible spheres
+ */
+unsigned int CullSpheres(const Frustum *frustum, VectorListSoA *spheres,
+		unsigned int *mask, unsigned int *indices);
+
+#endif
@@ -0,0 +1,87 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _hierarchy_h
+#define _hierarchy_h
+
+#include <ansic3d/matrix3d.h>
+#include <ansic3d/config.h>
+
+/**
+ * Parent of a root node, also marks a hierarchy without dirty nodes
+ */
+#define TRANSFORM_NONE ((unsigned int) -1)
+
+/**
+ * Flat transform tree in breadth first order: every parent comes before
+ * its children and the nodes of depth d are [level_start[d],
+ * level_start[d + 1]). world[i] = local[i] * world[parent[i]] (row
+ * vectors), world[i] = local[i] for roots.
+ * Nodes whose local matrix changed are flagged dirty, UpdateTransforms
+ * recomputes the world matrices of the dirty nodes and their subtrees
+ * only, one depth level after the other.
+ */
+typedef struct _TransformHierarchy
+{
+	unsigned int *parent;
+	Matrix3D *local;
+	Matrix3D *world;
+	unsigned char *dirty;
+	unsigned int *level_start;
+	unsigned int *partial;
+	unsigned int level_count;
+	unsigned int count;
+	unsigned int first_dirty;
+} TransformHierarchy;
+
+/**
+ * Build the hierarchy of n nodes given in any order, parents[i] is the
+ * index of the parent of node i or TRANSFORM_NONE. The nodes are
+ * reordered breadth first, order[j] receives the input index of node j
+ * (can be NULL). Every node is dirty after the build.
+ * Return count of nodes, 0 if fails (bad parent index or a cycle)
+ */
+int BuildTransformHierarchy(TransformHierarchy *hierarchy,
+		const unsigned int *parents, const Matrix3D *locals, unsigned int n,
+		unsigned int *order);
+
+/**
+ * Set the local matrix of a node (index in breadth first order) and flag
+ * it dirty
+ */
+void SetLocalTransform(TransformHierarchy *hierarchy, unsigned int index,
+		const Matrix3D *local);
+
+/**
+ * Flag a node dirty after writing its local matrix directly
+ */
+void MarkTransformDirty(TransformHierarchy *hierarchy, unsigned int index);
+
+/**
+ * Recompute the world matrices of the dirty nodes and their descendants.
+ * Levels before the first dirty node are skipped, the nodes of a level
+ * are split across threads. Does nothing if no node is dirty.
+ * Return count of world matrices recomputed
+ */
+unsigned int UpdateTransforms(TransformHierarchy *hierarchy);
+
+/**
+ * Free the hierarchy
+ */
+void FreeTransformHierarchy(TransformHierarchy *hierarchy);
+
+#endif
@@ -0,0 +1,415 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _inline_h
+#define _inline_h
+
+#include <math.h>
+#include <ansic3d/config.h>
+#include <ansic3d/vector3d.h>
+#include <ansic3d/matrix3d.h>
+#include <ansic3d/trig.h>
+
+/**
+ * Header only versions of the small Vector3D and Matrix3D functions.
+ * The library ships as a static archive, so the compiled functions can
+ * not be inlined into the caller's loops. Every function here does the
+ * same as the compiled one without the Inline suffix (which is built on
+ * top of it) but takes its arguments by pointer.
+ * Pointers are restrict qualified: a target must not overlap the inputs.
+ */
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#define ANSIC3D_INLINE static inline
+#elif defined(__GNUC__)
+#define ANSIC3D_INLINE static __inline__
+#else
+#define ANSIC3D_INLINE static
+#endif
+
+// Vector3D
+
+ANSIC3D_INLINE void SetVectorInline(float x, float y, float z, float w,
+		Vector3D *ANSIC3D_RESTRICT target)
+{
+	target->x = x;
+	target->y = y;
+	target->z = z;
+	target->w = w;
+}
+
+ANSIC3D_INLINE void CloneVectorInline(const Vector3D *ANSIC3D_RESTRICT from,
+		Vector3D *ANSIC3D_RESTRICT to)
+{
+	*to = *from;
+}
+
+ANSIC3D_INLINE void AddVectorInline(const Vector3D *ANSIC3D_RESTRICT p1,
+		const Vector3D *ANSIC3D_RESTRICT p2,
+		Vector3D *ANSIC3D_RESTRICT target)
+{
+	target->x = p1->x + p2->x;
+	target->y = p1->y + p2->y;
+	target->z = p1->z + p2->z;
+}
+
+ANSIC3D_INLINE void SubVectorInline(const Vector3D *ANSIC3D_RESTRICT p1,
+		const Vector3D *ANSIC3D_RESTRICT p2,
+		Vector3D *ANSIC3D_RESTRICT target)
+{
+	target->x = p1->x - p2->x;
+	target->y = p1->y - p2->y;
+	target->z = p1->z - p2->z;
+}
+
+ANSIC3D_INLINE void ScaleVectorInline(Vector3D *ANSIC3D_RESTRICT target,
+		float factor)
+{
+	target->x *= factor;
+	target->y *= factor;
+	target->z *= factor;
+	target->w *= factor;
+}
+
+ANSIC3D_INLINE void CrossProductInline(const Vector3D *ANSIC3D_RESTRICT v1,
+		const Vector3D *ANSIC3D_RESTRICT v2,
+		Vector3D *ANSIC3D_RESTRICT target)
+{
+	target->x = v1->y * v2->z - v1->z * v2->y;
+	target->y = v1->z * v2->x - v1->x * v2->z;
+	target->z = v1->x * v2->y - v1->y * v2->x;
+}
+
+ANSIC3D_INLINE float DotProductInline(const Vector3D *ANSIC3D_RESTRICT v1,
+		const Vector3D *ANSIC3D_RESTRICT v2)
+{
+	return (v1->x * v2->x) + (v1->y * v2->y) + (v1->z * v2->z);
+}
+
+ANSIC3D_INLINE float VectorLengthInline(const Vector3D *ANSIC3D_RESTRICT v)
+{
+	return sqrtf((v->x * v->x) + (v->y * v->y) + (v->z * v->z));
+}
+
+ANSIC3D_INLINE float VectorNormInline(const Vector3D *ANSIC3D_RESTRICT v)
+{
+	return VectorLengthInline(v);
+}
+
+ANSIC3D_INLINE void NormalizeVectorInline(Vector3D *ANSIC3D_RESTRICT target)
+{
+	float invlen;
+	float vn = VectorNormInline(target);
+	if (vn != 0)
+	{
+		invlen = 1 / vn;
+		target->x = target->x * invlen;
+		target->y = target->y * invlen;
+		target->z = target->z * invlen;
+		target->w = 0;
+	}
+}
+
+ANSIC3D_INLINE void DivideVectorInline(Vector3D *ANSIC3D_RESTRICT vector,
+		const Vector3D *ANSIC3D_RESTRICT divider)
+{
+	vector->x = vector->x / divider->x;
+	vector->y = vector->y / divider->y;
+	vector->z = vector->z / divider->z;
+}
+
+ANSIC3D_INLINE void PerpendicularVectorInline(
+		const Vector3D *ANSIC3D_RESTRICT v1,
+		const Vector3D *ANSIC3D_RESTRICT v2,
+		Vector3D *ANSIC3D_RESTRICT target)
+{
+	float dot = DotProductInline(v1, v2);
+	target->x = v1->x - dot * v2->x;
+	target->y = v1->y - dot * v2->y;
+	target->z = v1->z - dot * v2->z;
+}
+
+ANSIC3D_INLINE void RotateAroundXInline(Vector3D *ANSIC3D_RESTRICT target,
+		float angle)
+{
+	float s, c, y, z;
+	SinCos(angle, &s, &c);
+	y = target->y;
+	z = target->z;
+	target->y = c * y + s * z;
+	target->z = c * z - s * y;
+}
+
+ANSIC3D_INLINE void RotateAroundYInline(Vector3D *ANSIC3D_RESTRICT target,
+		float angle)
+{
+	float s, c, x, z;
+	SinCos(angle, &s, &c);
+	x = target->x;
+	z = target->z;
+	target->x = c * x + s * z;
+	target->z = c * z - s * x;
+}
+
+ANSIC3D_INLINE void RotateAroundZInline(Vector3D *ANSIC3D_RESTRICT target,
+		float angle)
+{
+	float s, c, x, y;
+	SinCos(angle, &s, &c);
+	x = target->x;
+	y = target->y;
+	target->x = c * x + s * y;
+	target->y = c * y - s * x;
+}
+
+ANSIC3D_INLINE float VectorDistanceSquaredInline(
+		const Vector3D *ANSIC3D_RESTRICT v1,
+		const Vector3D *ANSIC3D_RESTRICT v2)
+{
+	float x, y, z;
+	x = v2->x - v1->x;
+	y = v2->y - v1->y;
+	z = v2->z - v1->z;
+	return x * x + y * y + z * z;
+}
+
+ANSIC3D_INLINE float VectorDistanceInline(const Vector3D *ANSIC3D_RESTRICT v1,
+		const Vector3D *ANSIC3D_RESTRICT v2)
+{
+	return sqrtf(VectorDistanceSquaredInline(v1, v2));
+}
+
+ANSIC3D_INLINE int VectorEqualsInline(const Vector3D *ANSIC3D_RESTRICT v1,
+		const Vector3D *ANSIC3D_RESTRICT v2)
+{
+	return fabsf(v1->x - v2->x) < PRECISION &&
+		fabsf(v1->y - v2->y) < PRECISION &&
+		fabsf(v1->z - v2->z) < PRECISION;
+}
+
+ANSIC3D_INLINE void PlaneNormalInline(const Vector3D *ANSIC3D_RESTRICT v1,
+		const Vector3D *ANSIC3D_RESTRICT v2,
+		const Vector3D *ANSIC3D_RESTRICT v3,
+		Vector3D *ANSIC3D_RESTRICT result)
+{
+	Vector3D t1, t2;
+	SubVectorInline(v2, v1, &t1);
+	SubVectorInline(v3, v1, &t2);
+	CrossProductInline(&t1, &t2, result);
+	NormalizeVectorInline(result);
+}
+
+// Matrix3D
+
+ANSIC3D_INLINE void HomogeneousMatrixInline(Matrix3D *ANSIC3D_RESTRICT matrix)
+{
+	SetVectorInline(1, 0, 0, 0, &matrix->X);
+	SetVectorInline(0, 1, 0, 0, &matrix->Y);
+	SetVectorInline(0, 0, 1, 0, &matrix->Z);
+	SetVectorInline(0, 0, 0, 1, &matrix->W);
+}
+
+ANSIC3D_INLINE void EmptyMatrixInline(Matrix3D *ANSIC3D_RESTRICT matrix)
+{
+	SetVectorInline(0, 0, 0, 0, &matrix->X);
+	SetVectorInline(0, 0, 0, 0, &matrix->Y);
+	SetVectorInline(0, 0, 0, 0, &matrix->Z);
+	SetVectorInline(0, 0, 0, 0, &matrix->W);
+}
+
+ANSIC3D_INLINE void CreateScaleAndTranslationMatrixInline(
+		const Vector3D *ANSIC3D_RESTRICT scale,
+		const Vector3D *ANSIC3D_RESTRICT offset,
+		Matrix3D *ANSIC3D_RESTRICT target)
+{
+	SetVectorInline(scale->x, 0, 0, 0, &target->X);
+	SetVectorInline(0, scale->y, 0, 0, &target->Y);
+	SetVectorInline(0, 0, scale->z, 0, &target->Z);
+	SetVectorInline(offset->x, offset->y, offset->z, 1, &target->W);
+}
+
+ANSIC3D_INLINE void CreateRotationMatrixXSinCosInline(float sin, float cos,
+		Matrix3D *ANSIC3D_RESTRICT target)
+{
+	SetVectorInline(1, 0, 0, 0, &target->X);
+	SetVectorInline(0, cos, sin, 0, &target->Y);
+	SetVectorInline(0, -sin, cos, 0, &target->Z);
+	SetVectorInline(0, 0, 0, 1, &target->W);
+}
+
+ANSIC3D_INLINE void CreateRotationMatrixYSinCosInline(float sin, float cos,
+		Matrix3D *ANSIC3D_RESTRICT target)
+{
+	SetVectorInline(cos, 0, -sin, 0, &target->X);
+	SetVectorInline(0, 1, 0, 0, &target->Y);
+	SetVectorInline(sin, 0, cos, 0, &target->Z);
+	SetVectorInline(0, 0, 0, 1, &target->W);
+}
+
+ANSIC3D_INLINE void CreateRotationMatrixZSinCosInline(float sin, float cos,
+		Matrix3D *ANSIC3D_RESTRICT target)
+{
+	SetVectorInline(cos, sin, 0, 0, &target->X);
+	SetVectorInline(-sin, cos, 0, 0, &target->Y);
+	SetVectorInline(0, 0, 1, 0, &target->Z);
+	SetVectorInline(0, 0, 0, 1, &target->W);
+}
+
+ANSIC3D_INLINE void MultiplyMatrixInline(const Matrix3D *ANSIC3D_RESTRICT m1,
+		const Matrix3D *ANSIC3D_RESTRICT m2,
+		Matrix3D *ANSIC3D_RESTRICT target)
+{
+	target->X.x = (m1->X.x * m2->X.x + m1->X.y * m2->Y.x +
+			m1->X.z * m2->Z.x + m1->X.w * m2->W.x);
+	target->X.y = (m1->X.x * m2->X.y + m1->X.y * m2->Y.y +
+			m1->X.z * m2->Z.y + m1->X.w * m2->W.y);
+	target->X.z = (m1->X.x * m2->X.z + m1->X.y * m2->Y.z +
+			m1->X.z * m2->Z.z + m1->X.w * m2->W.z);
+	target->X.w = (m1->X.x * m2->X.w + m1->X.y * m2->Y.w +
+			m1->X.z * m2->Z.w + m1->X.w * m2->W.w);
+	target->Y.x = (m1->Y.x * m2->X.x + m1->Y.y * m2->Y.x +
+			m1->Y.z * m2->Z.x + m1->Y.w * m2->W.x);
+	target->Y.y = (m1->Y.x * m2->X.y + m1->Y.y * m2->Y.y +
+			m1->Y.z * m2->Z.y + m1->Y.w * m2->W.y);
+	target->Y.z = (m1->Y.x * m2->X.z + m1->Y.y * m2->Y.z +
+			m1->Y.z * m2->Z.z + m1->Y.w * m2->W.z);
+	target->Y.w = (m1->Y.x * m2->X.w + m1->Y.y * m2->Y.w +
+			m1->Y.z * m2->Z.w + m1->Y.w * m2->W.w);
+	target->Z.x = (m1->Z.x * m2->X.x + m1->Z.y * m2->Y.x +
+			m1->Z.z * m2->Z.x + m1->Z.w * m2->W.x);
+	target->Z.y = (m1->Z.x * m2->X.y + m1->Z.y * m2->Y.y +
+			m1->Z.z * m2->Z.y + m1->Z.w * m2->W.y);
+	target->Z.z = (m1->Z.x * m2->X.z + m1->Z.y * m2->Y.z +
+			m1->Z.z * m2->Z.z + m1->Z.w * m2->W.z);
+	target->Z.w = (m1->Z.x * m2->X.w + m1->Z.y * m2->Y.w +
+			m1->Z.z * m2->Z.w + m1->Z.w * m2->W.w);
+	target->W.x = (m1->W.x * m2->X.x + m1->W.y * m2->Y.x +
+			m1->W.z * m2->Z.x + m1->W.w * m2->W.x);
+	target->W.y = (m1->W.x * m2->X.y + m1->W.y * m2->Y.y +
+			m1->W.z * m2->Z.y + m1->W.w * m2->W.y);
+	target->W.z = (m1->W.x * m2->X.z + m1->W.y * m2->Y.z +
+			m1->W.z * m2->Z.z + m1->W.w * m2->W.z);
+	target->W.w = (m1->W.x * m2->X.w + m1->W.y * m2->Y.w +
+			m1->W.z * m2->Z.w + m1->W.w * m2->W.w);
+}
+
+/**
+ * target = v * matrix, see VectorTransform
+ */
+ANSIC3D_INLINE void VectorTransformInline(
+		const Matrix3D *ANSIC3D_RESTRICT matrix,
+		const Vector3D *ANSIC3D_RESTRICT v,
+		Vector3D *ANSIC3D_RESTRICT target)
+{
+	target->x = v->x * matrix->X.x + v->y * matrix->Y.x +
+		v->z * matrix->Z.x + v->w * matrix->W.x;
+	target->y = v->x * matrix->X.y + v->y * matrix->Y.y +
+		v->z * matrix->Z.y + v->w * matrix->W.y;
+	target->z = v->x * matrix->X.z + v->y * matrix->Y.z +
+		v->z * matrix->Z.z + v->w * matrix->W.z;
+	target->w = v->x * matrix->X.w + v->y * matrix->Y.w +
+		v->z * matrix->Z.w + v->w * matrix->W.w;
+}
+
+ANSIC3D_INLINE float MatrixDetInternalInline(float a1, float a2, float a3,
+		float b1, float b2, float b3, float c1, float c2, float c3)
+{
+	return (a1 * ((b2 * c3) - (b3 * c2))) - (b1 * ((a2 * c3) - (a3 * c2))) +
+		(c1 * ((a2 * b3) - (a3 * b2)));
+}
+
+ANSIC3D_INLINE float MatrixDeterminantInline(
+		const Matrix3D *ANSIC3D_RESTRICT m)
+{
+	return m->X.x * MatrixDetInternalInline(m->Y.y, m->Z.y, m->W.y,
+			m->Y.z, m->Z.z, m->W.z, m->Y.w, m->Z.w, m->W.w) -
+		m->X.y * MatrixDetInternalInline(m->Y.x, m->Z.x, m->W.x,
+			m->Y.z, m->Z.z, m->W.z, m->Y.w, m->Z.w, m->W.w) +
+		m->X.z * MatrixDetInternalInline(m->Y.x, m->Z.x, m->W.x,
+			m->Y.y, m->Z.y, m->W.y, m->Y.w, m->Z.w, m->W.w) -
+		m->X.w * MatrixDetInternalInline(m->Y.x, m->Z.x, m->W.x,
+			m->Y.y, m->Z.y, m->W.y, m->Y.z, m->Z.z, m->W.z);
+}
+
+ANSIC3D_INLINE void ScaleMatrixInline(Matrix3D *ANSIC3D_RESTRICT target,
+		float factor)
+{
+	ScaleVectorInline(&target->X, factor);
+	ScaleVectorInline(&target->Y, factor);
+	ScaleVectorInline(&target->Z, factor);
+	ScaleVectorInline(&target->W, factor);
+}
+
+ANSIC3D_INLINE void TransposeMatrixInline(Matrix3D *ANSIC3D_RESTRICT matrix)
+{
+	float f;
+	f = matrix->X.y;
+	matrix->X.y = matrix->Y.x;
+	matrix->Y.x = f;
+
+	f = matrix->X.z;
+	matrix->X.z = matrix->Z.x;
+	matrix->Z.x = f;
+
+	f = matrix->X.w;
+	matrix->X.w = matrix->W.x;
+	matrix->W.x = f;
+
+	f = matrix->Y.z;
+	matrix->Y.z = matrix->Z.y;
+	matrix->Z.y = f;
+
+	f = matrix->Y.w;
+	matrix->Y.w = matrix->W.y;
+	matrix->W.y = f;
+
+	f = matrix->Z.w;
+	matrix->Z.w = matrix->W.z;
+	matrix->W.z = f;
+}
+
+ANSIC3D_INLINE int MatrixEqualsInline(const Matrix3D *ANSIC3D_RESTRICT m1,
+		const Matrix3D *ANSIC3D_RESTRICT m2)
+{
+	return VectorEqualsInline(&m1->X, &m2->X) &&
+		VectorEqualsInline(&m1->Y, &m2->Y) &&
+		VectorEqualsInline(&m1->Z, &m2->Z) &&
+		VectorEqualsInline(&m1->W, &m2->W);
+}
+
+ANSIC3D_INLINE void CastFloatInline(const Matrix3D *ANSIC3D_RESTRICT m,
+		float *ANSIC3D_RESTRICT f)
+{
+	f[0] = m->X.x;
+	f[1] = m->X.y;
+	f[2] = m->X.z;
+	f[3] = m->X.w;
+	f[4] = m->Y.x;
+	f[5] = m->Y.y;
+	f[6] = m->Y.z;
+	f[7] = m->Y.w;
+	f[8] = m->Z.x;
+	f[9] = m->Z.y;
+	f[10] = m->Z.z;
+	f[11] = m->Z.w;
+	f[12] = m->W.x;
+	f[13] = m->W.y;
+	f[14] = m->W.z;
+	f[15] = m->W.w;
+}
+
+#endif
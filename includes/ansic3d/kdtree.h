@@ -0,0 +1,109 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _kdtree_h
+#define _kdtree_h
+
+#include <ansic3d/vector3d.h>
+#include <ansic3d/vectorlist.h>
+#include <ansic3d/config.h>
+
+/**
+ * Maximum number of points in a leaf
+ */
+#define KDTREE_LEAF_SIZE 8
+
+/**
+ * Maximum depth of a tree, enough for any unsigned int point count
+ */
+#define KDTREE_MAX_DEPTH 64
+
+/**
+ * Index reported for the missing neighbours of a batched query
+ */
+#define KDTREE_NONE ((unsigned int) -1)
+
+/**
+ * Node of a KDTree, 16 bytes. The left child of an inner node follows it
+ * in the node array and right is the index of the right child, leaves
+ * have right = 0. Points [begin, end) are under the node.
+ */
+typedef struct _KDNode
+{
+	float split;
+	unsigned int axis : 2;
+	unsigned int right : 30;
+	unsigned int begin;
+	unsigned int end;
+} KDNode;
+
+/**
+ * Static kd-tree over a copy of the points of a VectorList.
+ * The points are stored in tree order so every leaf is a contiguous
+ * block, indices maps them back to their index in the list.
+ */
+typedef struct _KDTree
+{
+	KDNode *nodes;
+	Vector3D *points;
+	unsigned int *indices;
+	unsigned int count;
+	unsigned int node_count;
+} KDTree;
+
+/**
+ * Build the tree over the vectors of list, splitting at the median of
+ * the widest axis. Subtrees are built in parallel for large lists, the
+ * tree does not depend on the thread count. The list is copied, it can
+ * change after the build.
+ * Return count of points in the tree, 0 if fails or the list is empty
+ */
+int BuildKDTree(VectorList *list, KDTree *tree);
+
+/**
+ * Free the tree
+ */
+void FreeKDTree(KDTree *tree);
+
+/**
+ * Find the k points nearest to query. indices (list indices) and
+ * distances (squared) are filled nearest first, equal distances are
+ * ordered by index.
+ * Return count of neighbours found, less than k only if the tree has
+ * less than k points
+ */
+unsigned int KDTreeNearest(KDTree *tree, Vector3D query, unsigned int k,
+		unsigned int *indices, float *distances);
+
+/**
+ * Find the points within radius of query. The first max of them are
+ * written to indices and distances (squared, can be NULL) in tree order.
+ * Return count of points within radius, can be more than max
+ */
+unsigned int KDTreeRadius(KDTree *tree, Vector3D query, float radius,
+		unsigned int *indices, float *distances, unsigned int max);
+
+/**
+ * KDTreeNearest for n queries, in parallel for large batches.
+ * indices and distances hold k entries per query, the missing ones are
+ * set to KDTREE_NONE and INFINITY.
+ */
+void KDTreeNearestBatch(KDTree *tree, const Vector3D *queries,
+		unsigned int n, unsigned int k, unsigned int *indices,
+		float *distances);
+
+#endif
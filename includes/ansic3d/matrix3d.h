@@ -21,8 +21,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <ansic3d/vector3d.h>
+#include <ansic3d/config.h>
 #define EPSILON 1E-40
 
+/**
+ * Allowed error for IsRigidMatrix to consider the rotation part of a
+ * matrix orthonormal. Rotations built with floats never are exactly.
+ */
+#define ORTHONORMAL_TOLERANCE 1E-5
+
+/**
+ * Matrix array operations are split across threads in chunks of at least
+ * this many matrices (see parallel.h)
+ */
+#define MATRIX_ARRAY_GRAIN 2048
+
 typedef struct _Matrix3D
 {
 	Vector3D X, Y, Z, W;
@@ -104,14 +117,53 @@ void CreateRotationMatrix(Vector3D axis, float angle, Matrix3D *target);
 
 /**
  * Multiply two 4x4 matrices.
+ * target can be the same matrix as m1 or m2.
+ * Uses the widest SIMD kernel the CPU supports (see cpu.h).
  */
 void MultiplyMatrix(Matrix3D *m1, Matrix3D *m2, Matrix3D *target);
 
+/**
+ * MultiplyMatrix for matrices known not to overlap.
+ * target must not be m1 or m2.
+ */
+void MultiplyMatrixRestrict(const Matrix3D *ANSIC3D_RESTRICT m1,
+		const Matrix3D *ANSIC3D_RESTRICT m2,
+		Matrix3D *ANSIC3D_RESTRICT target);
+
+/**
+ * out[i] = a[i] * b[i] for n matrices.
+ * out can be a or b, large arrays are split across threads.
+ */
+void MultiplyMatrixArray(const Matrix3D *a, const Matrix3D *b, Matrix3D *out,
+		unsigned int n);
+
+/**
+ * out[i] = m * b[i] for n matrices, e.g. parent * local
+ * out can be b, large arrays are split across threads.
+ */
+void MultiplyMatrixBroadcastLeft(const Matrix3D *m, const Matrix3D *b,
+		Matrix3D *out, unsigned int n);
+
+/**
+ * out[i] = a[i] * m for n matrices, e.g. model * view-projection
+ * out can be a, large arrays are split across threads.
+ */
+void MultiplyMatrixBroadcastRight(const Matrix3D *a, const Matrix3D *m,
+		Matrix3D *out, unsigned int n);
+
 /**
  * Vector Transform for given matrix
  */
 void VectorTransform(Matrix3D *matrix, Vector3D *target);
 
+/**
+ * VectorTransform for an array of n vectors, dst[i] = src[i] * matrix
+ * The matrix is kept in registers and the widest SIMD kernel the CPU
+ * supports is used (see cpu.h). src and dst may be the same array.
+ */
+void TransformVectors(Matrix3D *matrix, const Vector3D *src, Vector3D *dst,
+		unsigned int n);
+
 /**
  * Calculate the scaling factor of the linear transformation described by the 
  * matrix. (https://en.wikipedia.org/wiki/Determinant)
@@ -147,6 +199,40 @@ void PrintMatrix(Matrix3D *matrix);
  */
 void InvertMatrix(Matrix3D *matrix);
 
+/**
+ * Check if the matrix is affine, last column is (0, 0, 0, 1).
+ * Scale, rotation and translation matrices are affine.
+ * returns 1 if True, 0 if False
+ */
+int IsAffineMatrix(Matrix3D *matrix);
+
+/**
+ * Check if the matrix is a rigid body transformation, an affine matrix
+ * with an orthonormal rotation part (rotation and translation only).
+ * returns 1 if True, 0 if False
+ */
+int IsRigidMatrix(Matrix3D *matrix);
+
+/**
+ * Invert an affine matrix (see IsAffineMatrix) with a 3x3 inverse of the
+ * rotation/scale part and the translation moved back through it.
+ * The result is wrong for matrices that are not affine.
+ */
+void InvertAffineMatrix(Matrix3D *matrix);
+
+/**
+ * Invert a rigid body matrix (see IsRigidMatrix) by transposing the
+ * rotation part and moving the translation back through it.
+ * The result is wrong for matrices that are not rigid.
+ */
+void InvertRigidMatrix(Matrix3D *matrix);
+
+/**
+ * Invert the given matrix through the cheapest valid path,
+ * InvertRigidMatrix, InvertAffineMatrix or InvertMatrix.
+ */
+void InvertMatrixFast(Matrix3D *matrix);
+
 /**
  * The transpose of a matrix is an operator which flips a matrix over its
  * diagonal. (https://en.wikipedia.org/wiki/Transpose)
@@ -159,6 +245,45 @@ void TransposeMatrix(Matrix3D *matrix);
 void LookAtMatrix(Vector3D eye,
 		Vector3D target,
 		Vector3D up, Matrix3D *matrix);
+
+/**
+ * Create a perspective projection for a camera looking down -z (see
+ * LookAtMatrix). Depth is mapped to -1 at near and 1 at far (OpenGL).
+ * fov_y: vertical field of view in radians
+ * aspect: width / height of the viewport
+ */
+void CreatePerspectiveMatrix(float fov_y, float aspect, float near,
+		float far, Matrix3D *target);
+
+/**
+ * CreatePerspectiveMatrix with the far plane at infinity, depth reaches 1
+ * only at infinite distance.
+ */
+void CreateInfinitePerspectiveMatrix(float fov_y, float aspect, float near,
+		Matrix3D *target);
+
+/**
+ * Perspective projection with reversed depth, 1 at near and 0 at far
+ * (Direct3D / Vulkan clip depth). Spreads float depth precision evenly
+ * over the distance. far can be INFINITY.
+ */
+void CreateReversedZPerspectiveMatrix(float fov_y, float aspect, float near,
+		float far, Matrix3D *target);
+
+/**
+ * Create an orthographic projection of the box [left, right] x
+ * [bottom, top] x [-near, -far] in view space. Depth is mapped to -1 at
+ * near and 1 at far (OpenGL).
+ */
+void CreateOrthographicMatrix(float left, float right, float bottom,
+		float top, float near, float far, Matrix3D *target);
+
+/**
+ * CreateOrthographicMatrix with reversed depth, 1 at near and 0 at far
+ */
+void CreateReversedZOrthographicMatrix(float left, float right,
+		float bottom, float top, float near, float far, Matrix3D *target);
+
 /**
  * Check if two matrixes are equal
  */
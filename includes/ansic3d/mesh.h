@@ -0,0 +1,103 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _mesh_h
+#define _mesh_h
+
+#include <ansic3d/vector3d.h>
+#include <ansic3d/vectorlist.h>
+#include <ansic3d/config.h>
+
+/**
+ * Vertex normals weighted by the area of the faces around the vertex
+ */
+#define MESH_WEIGHT_AREA 0
+
+/**
+ * Vertex normals weighted by the face angle at the vertex, independent
+ * of how the faces around it are triangulated
+ */
+#define MESH_WEIGHT_ANGLE 1
+
+/**
+ * Indexed triangle mesh. Triangle i is positions[indices[3i]],
+ * positions[indices[3i + 1]] and positions[indices[3i + 2]].
+ * normals and tangents have one vector per position once computed,
+ * tangents carry the bitangent handedness (1 or -1) in w.
+ * face_normals are unit length with the triangle area in w.
+ * The remaining fields are caches of the normal and tangent passes.
+ */
+typedef struct _Mesh
+{
+	VectorList positions;
+	unsigned int *indices;
+	unsigned int triangle_count;
+	VectorList normals;
+	VectorList tangents;
+	Vector3D *face_normals;
+	Vector3D *face_tangents;
+	unsigned int *vertex_start;
+	unsigned int *vertex_corners;
+	unsigned int adjacency_count;
+} Mesh;
+
+/**
+ * Init an empty mesh
+ */
+void InitMesh(Mesh *mesh);
+
+/**
+ * Copy vertex_count positions and 3 * triangle_count indices into the
+ * mesh. Positions can be moved in place afterwards, call this again when
+ * the triangles change.
+ * Return count of triangles, 0 if fails or an index is out of range
+ */
+int SetMesh(Mesh *mesh, const Vector3D *positions, unsigned int vertex_count,
+		const unsigned int *indices, unsigned int triangle_count);
+
+/**
+ * Compute face_normals from the current positions, degenerate triangles
+ * get a zero normal.
+ * Return count of triangles, 0 if fails
+ */
+int ComputeMeshFaceNormals(Mesh *mesh);
+
+/**
+ * Compute face_normals and the vertex normals, weighting is
+ * MESH_WEIGHT_AREA or MESH_WEIGHT_ANGLE. Every vertex gathers the faces
+ * around it so vertices are split across threads without shared writes,
+ * and the result does not depend on the thread count. Vertices without
+ * faces get a zero normal.
+ * Return count of vertices, 0 if fails
+ */
+int ComputeMeshNormals(Mesh *mesh, int weighting);
+
+/**
+ * Compute tangents from uvs, two floats (u, v) per position, and the
+ * vertex normals. Area weighted normals are computed first if there are
+ * none. Tangents are orthogonal to the normal, vertices whose uvs do not
+ * give a direction get an arbitrary one.
+ * Return count of vertices, 0 if fails
+ */
+int ComputeMeshTangents(Mesh *mesh, const float *uvs);
+
+/**
+ * Free the mesh
+ */
+void FreeMesh(Mesh *mesh);
+
+#endif
@@ -0,0 +1,150 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _octree_h
+#define _octree_h
+
+#include <ansic3d/vector3d.h>
+#include <ansic3d/vectorlist.h>
+#include <ansic3d/bounds.h>
+#include <ansic3d/config.h>
+
+/**
+ * Marks a missing child, an empty list and a failed insert
+ */
+#define OCTREE_NONE ((unsigned int) -1)
+
+/**
+ * Maximum depth of a tree, the root is depth 0
+ */
+#define OCTREE_MAX_DEPTH 16
+
+/**
+ * Node of an Octree, 64 bytes. center.w is the half size of the cell,
+ * objects of the node have their center in the cell and are at most
+ * twice as large, so they are inside center +- 2 * center.w.
+ * first is the first object of the node.
+ */
+typedef struct _OctreeNode
+{
+	Vector3D center;
+	unsigned int children[8];
+	unsigned int parent;
+	unsigned int first;
+	unsigned int count;
+	unsigned int depth;
+} OctreeNode;
+
+/**
+ * Object of an Octree, linked to the other objects of its node
+ */
+typedef struct _OctreeObject
+{
+	AABB box;
+	unsigned int node;
+	unsigned int prev;
+	unsigned int next;
+	unsigned int reserved;
+} OctreeObject;
+
+/**
+ * Loose octree (loose factor 2) of axis aligned boxes. An object is
+ * stored in the deepest node at least as large as the object, picked in
+ * O(depth) from its size and center, so inserts, removes and moves never
+ * touch other objects. Nodes and objects come from pools with free lists,
+ * empty nodes go back to the pool. Objects with their center outside of
+ * the root cell are kept in the root. The root is node 0.
+ */
+typedef struct _Octree
+{
+	OctreeNode *nodes;
+	unsigned int node_capacity;
+	unsigned int node_used;
+	unsigned int node_free;
+	unsigned int node_count;
+	OctreeObject *objects;
+	unsigned int object_capacity;
+	unsigned int object_used;
+	unsigned int object_free;
+	unsigned int count;
+	unsigned int max_depth;
+} Octree;
+
+/**
+ * Init an empty tree whose root cell is center +- half_size.
+ * max_depth is clamped to OCTREE_MAX_DEPTH.
+ * Return 1 if success, 0 if fails
+ */
+int InitOctree(Octree *tree, Vector3D center, float half_size,
+		unsigned int max_depth);
+
+/**
+ * Add an object with bounds box.
+ * Return handle of the object, OCTREE_NONE if fails
+ */
+unsigned int InsertOctree(Octree *tree, AABB box);
+
+/**
+ * Add every vector of list as a box of vector +- radius, the handles
+ * are written to handles (can be NULL).
+ * Return count of objects added, less than the list count if fails
+ */
+unsigned int InsertOctreeList(Octree *tree, VectorList *list, float radius,
+		unsigned int *handles);
+
+/**
+ * Change the bounds of an object. The object stays in its node if it
+ * still fits there, otherwise it is relinked to its new node.
+ * Return 1 if success, 0 if handle is not in the tree
+ */
+int MoveOctree(Octree *tree, unsigned int handle, AABB box);
+
+/**
+ * Remove an object, its handle can be reused by a later insert.
+ * Return 1 if success, 0 if handle is not in the tree
+ */
+int RemoveOctree(Octree *tree, unsigned int handle);
+
+/**
+ * Find the objects overlapping box. The first max handles are written
+ * to handles. Return count of objects found, can be more than max
+ */
+unsigned int OctreeQueryAABB(Octree *tree, AABB box, unsigned int *handles,
+		unsigned int max);
+
+/**
+ * Find the objects whose box is within radius of center.
+ * Return count of objects found, can be more than max
+ */
+unsigned int OctreeQuerySphere(Octree *tree, Vector3D center, float radius,
+		unsigned int *handles, unsigned int max);
+
+/**
+ * Find the objects whose box is not completely outside of a frustum
+ * plane. Subtrees completely inside the frustum are added without
+ * testing their objects.
+ * Return count of objects found, can be more than max
+ */
+unsigned int OctreeQueryFrustum(Octree *tree, const Frustum *frustum,
+		unsigned int *handles, unsigned int max);
+
+/**
+ * Free the tree
+ */
+void FreeOctree(Octree *tree);
+
+#endif
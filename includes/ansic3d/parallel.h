@@ -0,0 +1,97 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _parallel_h
+#define _parallel_h
+
+#include <ansic3d/config.h>
+
+/**
+ * Environment variable to set the thread count at startup
+ */
+#define THREADS_ENV "ANSIC3D_THREADS"
+
+/**
+ * Work function for ParallelFor, processes the items [begin, end)
+ */
+typedef void (*ParallelBody)(unsigned int begin, unsigned int end,
+		void *context);
+
+/**
+ * A set of worker threads that stay alive between ParallelFor calls.
+ * Workers sleep while the pool has no work.
+ */
+typedef struct _ThreadPool ThreadPool;
+
+/**
+ * Start a pool running jobs on threads threads, the thread calling
+ * ParallelForPool included (threads - 1 workers are started).
+ * Return the pool, NULL if fails
+ */
+ThreadPool *CreateThreadPool(int threads);
+
+/**
+ * Stop the workers of the pool and free it. The pool must be idle.
+ */
+void DestroyThreadPool(ThreadPool *pool);
+
+/**
+ * Count of threads running the jobs of the pool, the caller included
+ */
+int ThreadPoolSize(ThreadPool *pool);
+
+/**
+ * Pool used by ParallelFor and the bulk operations of the library.
+ * Created on first use with GetThreadCount() threads.
+ */
+ThreadPool *GetDefaultThreadPool(void);
+
+/**
+ * Maximum number of threads bulk operations use, the calling thread
+ * included. Defaults to the online CPU count or THREADS_ENV.
+ */
+int GetThreadCount(void);
+
+/**
+ * Set the maximum number of threads bulk operations use.
+ * 1 makes every operation serial. The default pool is restarted with
+ * the new count, so this must not be called while it is running a job.
+ * Return the count actually set
+ */
+int SetThreadCount(int count);
+
+/**
+ * Run body over [0, n) on the threads of pool.
+ * The items are split into the chunks [k * grain, (k + 1) * grain) which
+ * idle threads take one at a time until all are done, so uneven chunks
+ * are balanced. Every item is processed exactly once and the chunks only
+ * depend on n and grain: per chunk results (index begin / grain) can be
+ * combined in a deterministic order.
+ * Runs serially as a single body(0, n) call when n is below 2 * grain,
+ * when the pool has a single thread, when called from inside a body or
+ * when the pool is busy with a job of another thread.
+ */
+void ParallelForPool(ThreadPool *pool, unsigned int n, unsigned int grain,
+		ParallelBody body, void *context);
+
+/**
+ * ParallelForPool on the default pool
+ */
+void ParallelFor(unsigned int n, unsigned int grain, ParallelBody body,
+		void *context);
+
+#endif
@@ -0,0 +1,72 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _pointcloud_h
+#define _pointcloud_h
+
+#include <ansic3d/vector3d.h>
+#include <ansic3d/vectorlist.h>
+#include <ansic3d/config.h>
+
+/**
+ * Size of the read buffer in bytes, a text line must fit in it
+ */
+#define POINTCLOUD_BUFFER_SIZE (1 << 20)
+
+/**
+ * Maximum number of points handed to a PointCloudCallback at once
+ */
+#define POINTCLOUD_CHUNK 4096
+
+/**
+ * Maximum number of properties of a PLY element
+ */
+#define PLY_MAX_PROPERTIES 64
+
+/**
+ * Receives the next n points of the file (w = 1).
+ * points is only valid during the call.
+ * Return non-zero to continue reading, 0 to stop
+ */
+typedef int (*PointCloudCallback)(const Vector3D *points, unsigned int n,
+		void *context);
+
+/**
+ * Read the point cloud at path in chunks of POINTCLOUD_CHUNK points and
+ * pass every chunk to callback, only a fixed size buffer is held in
+ * memory. Supported formats:
+ * - PLY, ascii or binary (either byte order), x/y/z of the vertex element
+ *   can be of any scalar type, other properties and elements are skipped
+ * - XYZ text, a point per line as "x y z" separated by spaces, tabs or
+ *   commas, extra columns are ignored and lines not starting with three
+ *   numbers (headers, comments) are skipped
+ * The format is detected from the "ply" magic at the start of the file.
+ * Return count of points read, -1 if the file can not be read or has an
+ * invalid header
+ */
+long StreamPointCloud(const char *path, PointCloudCallback callback,
+		void *context);
+
+/**
+ * Append every point of the point cloud at path to list, see
+ * StreamPointCloud for the formats. Points are pushed a chunk at a time
+ * and the list is grown once when the file tells the point count.
+ * Return count of points read, -1 if fails
+ */
+long LoadPointCloud(const char *path, VectorList *list);
+
+#endif
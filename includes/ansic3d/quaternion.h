@@ -0,0 +1,111 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _quaternion_h
+#define _quaternion_h
+
+#include <ansic3d/vector3d.h>
+#include <ansic3d/matrix3d.h>
+#include <ansic3d/vectorlist.h>
+
+/**
+ * Rotation quaternion, x y z is the imaginary (axis) part and w the real
+ * part. Rotations follow the same convention as CreateRotationMatrix, so
+ * QuaternionToMatrix(AxisAngleQuaternion(axis, angle)) equals
+ * CreateRotationMatrix(axis, angle).
+ */
+typedef struct _Quaternion
+{
+	float x, y, z, w;
+} Quaternion;
+
+/**
+ * Identity rotation (0, 0, 0, 1)
+ */
+void IdentityQuaternion(Quaternion *target);
+
+/**
+ * Rotation around a given axis Vector by a given angle
+ */
+void AxisAngleQuaternion(Vector3D axis, float angle, Quaternion *target);
+
+/**
+ * target = q1 * q2, applying target is applying q1 first and q2 after,
+ * the same order as MultiplyMatrix of the matching matrices.
+ * 16 multiplications instead of 64 for the matrices.
+ */
+void MultiplyQuaternion(Quaternion q1, Quaternion q2, Quaternion *target);
+
+/**
+ * Normalize the quaternion to unit length
+ */
+void NormalizeQuaternion(Quaternion *target);
+
+/**
+ * Conjugate of the quaternion, the inverse rotation of a unit quaternion
+ */
+void ConjugateQuaternion(Quaternion *target);
+
+/**
+ * Dot product of two quaternions
+ */
+float QuaternionDot(Quaternion q1, Quaternion q2);
+
+/**
+ * Spherical linear interpolation from q1 (t = 0) to q2 (t = 1) along the
+ * shortest arc with constant angular velocity.
+ */
+void SlerpQuaternion(Quaternion q1, Quaternion q2, float t,
+		Quaternion *target);
+
+/**
+ * Normalized linear interpolation from q1 (t = 0) to q2 (t = 1) along the
+ * shortest arc. Cheaper than SlerpQuaternion but the angular velocity
+ * is not constant.
+ */
+void NlerpQuaternion(Quaternion q1, Quaternion q2, float t,
+		Quaternion *target);
+
+/**
+ * Rotation matrix of a unit quaternion
+ */
+void QuaternionToMatrix(Quaternion q, Matrix3D *target);
+
+/**
+ * Rotation part of the matrix as a quaternion.
+ * The upper 3x3 of the matrix must be a rotation.
+ */
+void MatrixToQuaternion(Matrix3D *matrix, Quaternion *target);
+
+/**
+ * Rotate the vector by a unit quaternion, w is kept.
+ * Same result as VectorTransform with QuaternionToMatrix(q).
+ */
+void QuaternionRotateVector(Quaternion q, Vector3D *target);
+
+/**
+ * Rotate every vector of the list by a unit quaternion
+ */
+void QuaternionRotateVectorList(Quaternion q, VectorList *list);
+
+/**
+ * q1 == q2 within PRECISION
+ * returns 1 if True, 0 if False
+ */
+int QuaternionEquals(Quaternion q1, Quaternion q2);
+
+#endif
@@ -0,0 +1,128 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _ray_h
+#define _ray_h
+
+#include <ansic3d/vector3d.h>
+#include <ansic3d/config.h>
+
+/**
+ * Triangle index of a ray without a hit
+ */
+#define RAY_NO_HIT ((unsigned int) -1)
+
+/**
+ * Rays tested together by the packet kernels, one AVX register
+ */
+#define RAY_PACKET_SIZE 8
+
+/**
+ * Triangles whose determinant against the ray is below this are
+ * parallel to it and never hit
+ */
+#define RAY_EPSILON 1E-12f
+
+/**
+ * Ray origin + t * direction, hits are searched for 0 < t < t_max.
+ * direction does not need to be normalized, t is in units of its length.
+ */
+typedef struct _Ray
+{
+	Vector3D origin;
+	Vector3D direction;
+	float t_max;
+} Ray;
+
+/**
+ * Nearest hit of a ray. Hit point is v0 + u * (v1 - v0) + v * (v2 - v0),
+ * triangle is RAY_NO_HIT and t is the t_max of the ray if nothing was hit.
+ */
+typedef struct _RayHit
+{
+	float t;
+	float u;
+	float v;
+	unsigned int triangle;
+} RayHit;
+
+/**
+ * Up to RAY_PACKET_SIZE rays in SoA layout and their nearest hits so
+ * far. t starts at the t_max of every ray and shrinks with every hit.
+ */
+typedef struct _RayPacket
+{
+	float ox[RAY_PACKET_SIZE];
+	float oy[RAY_PACKET_SIZE];
+	float oz[RAY_PACKET_SIZE];
+	float dx[RAY_PACKET_SIZE];
+	float dy[RAY_PACKET_SIZE];
+	float dz[RAY_PACKET_SIZE];
+	float t[RAY_PACKET_SIZE];
+	float u[RAY_PACKET_SIZE];
+	float v[RAY_PACKET_SIZE];
+	unsigned int triangle[RAY_PACKET_SIZE];
+	unsigned int count;
+} RayPacket;
+
+/**
+ * Set a ray with t_max = INFINITY
+ */
+void SetRay(Vector3D origin, Vector3D direction, Ray *ray);
+
+/**
+ * Moller-Trumbore intersection of a ray and a triangle, both sides of
+ * the triangle are hit.
+ * Return 1 and the hit distance and barycentrics if 0 < t < t_max,
+ * 0 if the ray misses
+ */
+int IntersectRayTriangle(const Ray *ray, Vector3D v0, Vector3D v1,
+		Vector3D v2, float *t, float *u, float *v);
+
+/**
+ * Load count (at most RAY_PACKET_SIZE) rays into a packet, the unused
+ * lanes never hit.
+ */
+void LoadRayPacket(const Ray *rays, unsigned int count, RayPacket *packet);
+
+/**
+ * Store the hits of the rays of a packet
+ */
+void StoreRayPacket(const RayPacket *packet, RayHit *hits);
+
+/**
+ * Test every ray of a packet against one triangle and keep the hits
+ * nearer than the current ones. 8 (AVX) or 2 x 4 (SSE) rays at a time,
+ * the same hits as IntersectRayTriangle.
+ * Return mask of the rays the triangle is now the nearest hit of
+ */
+unsigned int IntersectRayPacketTriangle(RayPacket *packet, Vector3D v0,
+		Vector3D v1, Vector3D v2, unsigned int triangle);
+
+/**
+ * Nearest hit of every ray against a triangle soup. Triangle i is
+ * vertices[indices[3i]], vertices[indices[3i + 1]], vertices[indices[3i + 2]]
+ * or vertices[3i], vertices[3i + 1], vertices[3i + 2] if indices is NULL.
+ * Rays are tested in packets against every triangle, packets are split
+ * across threads. Ties go to the lower triangle index.
+ * Return count of rays that hit a triangle, 0 if fails
+ */
+unsigned int IntersectRays(const Ray *rays, unsigned int ray_count,
+		const Vector3D *vertices, const unsigned int *indices,
+		unsigned int triangle_count, RayHit *hits);
+
+#endif
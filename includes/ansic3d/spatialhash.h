@@ -0,0 +1,122 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _spatialhash_h
+#define _spatialhash_h
+
+#include <ansic3d/vector3d.h>
+#include <ansic3d/vectorlist.h>
+#include <ansic3d/config.h>
+
+/**
+ * Marks the end of a bucket chain
+ */
+#define SPATIALHASH_NONE ((unsigned int) -1)
+
+/**
+ * Queries covering more cells than this scan every bucket instead
+ */
+#define SPATIALHASH_MAX_QUERY_CELLS 512
+
+/**
+ * Maximum number of chunks a rebuild is split into, every chunk keeps a
+ * histogram of table_size counters
+ */
+#define SPATIALHASH_MAX_CHUNKS 8
+
+/**
+ * Uniform grid of cubic cells hashed into a power of two bucket table.
+ * RebuildSpatialHash sorts the point indices by bucket with a counting
+ * sort (entries, bucket b is [start[b], start[b + 1])). Points added
+ * after the rebuild with InsertSpatialHash are chained per bucket until
+ * the next rebuild. The hash keeps a pointer to the list and reads the
+ * positions from it, rebuild after moving the points.
+ */
+typedef struct _SpatialHash
+{
+	float cell_size;
+	float inv_cell_size;
+	unsigned int table_size;
+	unsigned int fixed_size;
+	unsigned int *start;
+	unsigned int *entries;
+	unsigned int *keys;
+	unsigned int *histogram;
+	unsigned int capacity;
+	unsigned int histogram_capacity;
+	unsigned int *pending_head;
+	unsigned int *pending_index;
+	unsigned int *pending_next;
+	unsigned int pending_count;
+	unsigned int pending_capacity;
+	unsigned int built;
+	unsigned int count;
+	VectorList *list;
+} SpatialHash;
+
+/**
+ * Visits a pair of points closer than the radius of SpatialHashPairs,
+ * a < b, distance is squared
+ */
+typedef void (*SpatialPairCallback)(unsigned int a, unsigned int b,
+		float distance, void *context);
+
+/**
+ * Init an empty hash. Query radius around cell_size is the sweet spot.
+ * table_size: bucket count, rounded up to a power of two, 0 sizes the
+ * table to the point count on every rebuild.
+ */
+void InitSpatialHash(SpatialHash *hash, float cell_size,
+		unsigned int table_size);
+
+/**
+ * Hash every vector of list from scratch, the buffers of the previous
+ * rebuild are reused. Keys, histograms and the scatter run in parallel
+ * for large lists; the result does not depend on the thread count.
+ * Return count of points in the hash, 0 if fails
+ */
+int RebuildSpatialHash(SpatialHash *hash, VectorList *list);
+
+/**
+ * Add the vector at index of the list of the last rebuild in O(1)
+ * (amortized), e.g. after pushing a vector to the list.
+ * Return count of points in the hash, 0 if fails
+ */
+int InsertSpatialHash(SpatialHash *hash, unsigned int index);
+
+/**
+ * Find the points within radius of query, squared distance comparisons.
+ * The first max list indices are written to indices.
+ * Return count of points within radius, can be more than max
+ */
+unsigned int SpatialHashRadius(SpatialHash *hash, Vector3D query,
+		float radius, unsigned int *indices, unsigned int max);
+
+/**
+ * Call callback once for every pair of points closer than radius,
+ * ordered by the first index.
+ * Return count of pairs
+ */
+unsigned int SpatialHashPairs(SpatialHash *hash, float radius,
+		SpatialPairCallback callback, void *context);
+
+/**
+ * Free the hash
+ */
+void FreeSpatialHash(SpatialHash *hash);
+
+#endif
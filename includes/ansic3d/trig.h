@@ -0,0 +1,63 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _trig_h
+#define _trig_h
+
+#include <ansic3d/config.h>
+
+/**
+ * FastSinCos is valid for |angle| up to this value, larger angles fall
+ * back to libm as the range reduction loses precision.
+ */
+#define FAST_TRIG_RANGE 8192.0f
+
+/**
+ * Sine and cosine of the angle (radians) in one call with a minimax
+ * polynomial after a Cody-Waite reduction to [-pi/4, pi/4].
+ * Within FAST_TRIG_RANGE, results of magnitude 2^-8 and above are within
+ * 1 ULP of libm sinf/cosf (2 ULP of the exact value). Smaller results,
+ * near a zero of sin or cos, carry the absolute error of the argument
+ * reduction, at most 1E-7.
+ */
+void FastSinCos(float angle, float *s, float *c);
+
+/**
+ * FastSinCos for n angles, 4 (SSE) or 8 (AVX2) at a time.
+ * s[i] = sin(angles[i]), c[i] = cos(angles[i])
+ */
+void FastSinCosArray(const float *angles, float *s, float *c, unsigned int n);
+
+/**
+ * Sine and cosine used by the rotation builders (CreateRotationMatrix*,
+ * RotateAround*, AxisAngleQuaternion). FastSinCos when fast trigonometry
+ * is enabled, libm sinf/cosf otherwise.
+ */
+void SinCos(float angle, float *s, float *c);
+
+/**
+ * Enable (1) or disable (0) fast trigonometry for SinCos.
+ * Defaults to enabled when the library is built with ANSIC3D_FAST_TRIG.
+ */
+void SetFastTrig(int enable);
+
+/**
+ * Return 1 if SinCos uses FastSinCos, 0 otherwise
+ */
+int GetFastTrig(void);
+
+#endif
@@ -0,0 +1,103 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _vectorfile_h
+#define _vectorfile_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ansic3d/vector3d.h>
+#include <ansic3d/vectorlist.h>
+#include <ansic3d/config.h>
+
+#define VECTORFILE_MAGIC "AC3DVECS"
+#define VECTORFILE_VERSION 1
+
+/**
+ * Written into the header in native byte order, a file from a machine
+ * with the other byte order does not match it
+ */
+#define VECTORFILE_ENDIAN 0x01020304
+
+/**
+ * Vectors are stored as Vector3D {x, y, z, w} floats
+ */
+#define VECTORFILE_LAYOUT_XYZW 1
+
+/**
+ * Size of the header, vector data starts at this offset. Keeps the data
+ * aligned for SIMD loads in the mapped pages.
+ */
+#define VECTORFILE_HEADER_SIZE 64
+
+/**
+ * Header of a vector list file, VECTORFILE_HEADER_SIZE bytes followed
+ * by count * stride bytes of vector data. Bounds are the min/max x, y,
+ * z of the vectors, all zero for an empty list.
+ */
+typedef struct _VectorFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t endian;
+	uint32_t layout;
+	uint32_t stride;
+	uint64_t count;
+	float min[3];
+	float max[3];
+	uint32_t reserved[2];
+} VectorFileHeader;
+
+// Fails to compile if the header struct drifts from the on-disk size
+typedef char VectorFileHeaderSizeCheck[
+	sizeof(VectorFileHeader) == VECTORFILE_HEADER_SIZE ? 1 : -1];
+
+/**
+ * A vector list file mapped into memory.
+ * list.vectors points directly at the mapped pages. The mapping is
+ * private: the list can be changed in place (copy on write) but never
+ * writes back to the file, and it can not grow, PushVector and the
+ * other growing functions fail on it. FreeVectorList does nothing,
+ * release it with UnmapVectorListFile.
+ */
+typedef struct _VectorFile
+{
+	VectorList list;
+	VectorFileHeader header;
+	void *map;
+	size_t size;
+} VectorFile;
+
+/**
+ * Write the list to path in the vector list file format
+ * Return 1 on success, 0 if fails
+ */
+int SaveVectorListFile(VectorList *list, const char *path);
+
+/**
+ * Map the vector list file at path into memory without copying it.
+ * Return 1 on success, 0 if the file can not be mapped or is not a
+ * valid vector list file of this version
+ */
+int MapVectorListFile(const char *path, VectorFile *file);
+
+/**
+ * Unmap a file mapped by MapVectorListFile, file->list is invalid after
+ */
+void UnmapVectorListFile(VectorFile *file);
+
+#endif
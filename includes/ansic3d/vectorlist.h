@@ -22,30 +22,73 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ansic3d/vector3d.h>
+#include <ansic3d/matrix3d.h>
+#include <ansic3d/allocator.h>
 #include <ansic3d/config.h>
 
+/**
+ * Vectors per chunk when bulk list operations are split across threads,
+ * 256 KiB of Vector3D
+ */
+#define VECTORLIST_GRAIN 16384
+
 typedef struct _VectorList
 {
 	Vector3D *vectors;
 	unsigned int count;
 	unsigned int capacity;
 	int index;
+	Allocator *allocator;
 } VectorList;
 
 /**
  * Init the vectorlist.
- * Vector still can get over this capacity but in each PushVector
- * it will create a copy and swap the memory. SetCapacity 
- * pre-allocates a memory upto given vector count.
+ * Vector still can get over this capacity, when the list is full the
+ * capacity grows by the growth factor (see SetVectorListGrowthFactor)
+ * so pushing N vectors costs amortized O(N).
  */
 void InitVectorList(VectorList *list, int capacity);
 
+/**
+ * Init the vectorlist taking its memory from allocator instead of the
+ * heap. allocator must outlive the list, NULL uses the heap.
+ */
+void InitVectorListAllocator(VectorList *list, int capacity,
+		Allocator *allocator);
+
+/**
+ * Set the factor the capacity is multiplied with when a full list grows.
+ * Factor must be greater than 1, defaults to VECTORLIST_GROWTH_FACTOR.
+ * Return the factor in use
+ */
+float SetVectorListGrowthFactor(float factor);
+
+/**
+ * Make sure the list can hold at least capacity vectors without
+ * re-allocating. Never shrinks the list.
+ * Return capacity of the list, 0 if fails
+ */
+int ReserveVectorList(VectorList *list, unsigned int capacity);
+
+/**
+ * Release the memory above max(count, capacity) vectors.
+ * Return capacity of the list, 0 if fails
+ */
+int ShrinkVectorList(VectorList *list, unsigned int capacity);
+
 /**
  * Add a vector to the end of the list
  * Return count of items in list, 0 if fails
  */
 int PushVector(Vector3D v, VectorList *list);
 
+/**
+ * Add n vectors to the end of the list with a single copy. v may point
+ * into the list itself, e.g. to append the list to itself.
+ * Return count of items in list, 0 if fails
+ */
+int PushVectors(const Vector3D *v, unsigned int n, VectorList *list);
+
 /**
  * Pop out the latest item in the list
  * Return count of items in list, 0 if fails
@@ -53,12 +96,42 @@ int PushVector(Vector3D v, VectorList *list);
 int PopVector(VectorList *list, Vector3D *target);
 
 /**
- * Remove the vector at given index
- * Please note that, this is a memory-heavy operation.
+ * Remove the vector at given index, keeping the order of the rest.
+ * The following vectors are moved one step back in place, use
+ * SwapRemoveVectorIndex if the order does not matter.
  * Return count of items in list, 0 if fails
  */
 int RemoveVectorIndex(VectorList *list, int index);
 
+/**
+ * Remove the vector at given index by moving the last vector into its
+ * place. O(1) but does not keep the order.
+ * Return count of items in list, 0 if fails
+ */
+int SwapRemoveVectorIndex(VectorList *list, int index);
+
+/**
+ * Remove the vectors at the given indices in a single pass, keeping the
+ * order of the rest. indices must be sorted ascending, duplicates,
+ * out of order entries and indices out of range are ignored.
+ * Return count of items in list
+ */
+int RemoveVectorIndices(VectorList *list, const unsigned int *indices,
+		unsigned int n);
+
+/**
+ * Predicate for RemoveVectorsIf, returns non-zero to remove the vector
+ */
+typedef int (*VectorPredicate)(Vector3D *v, void *context);
+
+/**
+ * Remove every vector the predicate returns non-zero for in a single
+ * pass, keeping the order of the rest. context is passed to predicate.
+ * Return count of items in list
+ */
+int RemoveVectorsIf(VectorList *list, VectorPredicate predicate,
+		void *context);
+
 /**
  * Remove the last element in the vector list
  */
@@ -76,4 +149,36 @@ void FreeVectorList(VectorList *list);
  */
 int TrimVectorList(VectorList *list);
 
+/**
+ * Transform every vector in src by the given matrix and write the results
+ * into dst. Large lists are transformed in parallel (see parallel.h).
+ * dst is grown if it can not hold src->count vectors and its previous
+ * content is replaced. src and dst can be the same list.
+ * Return count of items in dst, 0 if fails
+ */
+int TransformVectorList(Matrix3D *matrix, VectorList *src, VectorList *dst);
+
+/**
+ * Transform every vector in the list by the given matrix, in place.
+ */
+void TransformVectorListInPlace(Matrix3D *matrix, VectorList *list);
+
+/**
+ * NormalizeVector every vector in the list, in parallel for large lists
+ */
+void NormalizeVectorList(VectorList *list);
+
+/**
+ * ScaleVector every vector in the list, in parallel for large lists
+ */
+void ScaleVectorList(VectorList *list, float factor);
+
+/**
+ * Component wise minimum and maximum x, y, z of the vectors in the list
+ * (w is set to 1), computed in parallel for large lists.
+ * Return count of items in list, 0 if the list is empty (min and max
+ * are not changed then)
+ */
+int VectorListBounds(VectorList *list, Vector3D *min, Vector3D *max);
+
 #endif
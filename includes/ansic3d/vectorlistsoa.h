@@ -0,0 +1,148 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#ifndef _vectorlistsoa_h
+#define _vectorlistsoa_h
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ansic3d/vector3d.h>
+#include <ansic3d/matrix3d.h>
+#include <ansic3d/vectorlist.h>
+#include <ansic3d/config.h>
+
+/**
+ * Every component array is aligned to this many bytes
+ */
+#define SOA_ALIGNMENT 32
+
+/**
+ * Structure of arrays variant of VectorList.
+ * x, y and z hold one component of every vector, w is optional and NULL
+ * when the list was created without it. Vectors of a list without w are
+ * treated as points (w = 1).
+ * Bulk operations on this layout read only the components they need,
+ * which makes them a better fit for SIMD than the Vector3D array.
+ */
+typedef struct _VectorListSoA
+{
+	float *x;
+	float *y;
+	float *z;
+	float *w;
+	unsigned int count;
+	unsigned int capacity;
+} VectorListSoA;
+
+/**
+ * Init the list with aligned component arrays for capacity vectors.
+ * with_w: allocate the w component array too
+ * Return 1 on success, 0 if fails
+ */
+int InitVectorListSoA(VectorListSoA *list, unsigned int capacity, int with_w);
+
+/**
+ * Grow the component arrays to hold at least capacity vectors.
+ * Return 1 on success, 0 if fails
+ */
+int ReserveVectorListSoA(VectorListSoA *list, unsigned int capacity);
+
+/**
+ * Free the component arrays
+ */
+void FreeVectorListSoA(VectorListSoA *list);
+
+/**
+ * Add a vector to the end of the list
+ * Return count of items in list, 0 if fails
+ */
+int PushVectorSoA(Vector3D v, VectorListSoA *list);
+
+/**
+ * Read the vector at the given index
+ */
+void GetVectorSoA(VectorListSoA *list, unsigned int index, Vector3D *target);
+
+/**
+ * Convert a VectorList to the SoA layout. target must be initialized and
+ * its content is replaced.
+ * Return count of items in target, 0 if fails
+ */
+int VectorListToSoA(VectorList *list, VectorListSoA *target);
+
+/**
+ * Convert a SoA list back to a VectorList. target must be initialized and
+ * its content is replaced.
+ * Return count of items in target, 0 if fails
+ */
+int SoAToVectorList(VectorListSoA *list, VectorList *target);
+
+/**
+ * target[i] = a[i] + b[i]
+ * a and b must have the same count, target can be a or b.
+ * Return count of items in target, 0 if fails
+ */
+int AddVectorSoA(VectorListSoA *a, VectorListSoA *b, VectorListSoA *target);
+
+/**
+ * target[i] = a[i] - b[i]
+ * a and b must have the same count, target can be a or b.
+ * Return count of items in target, 0 if fails
+ */
+int SubVectorSoA(VectorListSoA *a, VectorListSoA *b, VectorListSoA *target);
+
+/**
+ * Scale every vector in the list by factor (w included, like ScaleVector)
+ */
+void ScaleVectorSoA(VectorListSoA *target, float factor);
+
+/**
+ * target[i] = DotProduct(a[i], b[i])
+ * target must hold a->count floats.
+ * Return count of products, 0 if fails
+ */
+int DotProductSoA(VectorListSoA *a, VectorListSoA *b, float *target);
+
+/**
+ * target[i] = CrossProduct(a[i], b[i])
+ * a and b must have the same count, target can be a or b.
+ * Return count of items in target, 0 if fails
+ */
+int CrossProductSoA(VectorListSoA *a, VectorListSoA *b,
+		VectorListSoA *target);
+
+/**
+ * Normalize every vector in the list, see NormalizeVector
+ */
+void NormalizeVectorSoA(VectorListSoA *target);
+
+/**
+ * target[i] = VectorLength(list[i])
+ * target must hold list->count floats.
+ */
+void VectorLengthSoA(VectorListSoA *list, float *target);
+
+/**
+ * dst[i] = src[i] * matrix, see VectorTransform
+ * src and dst can be the same list.
+ * Return count of items in dst, 0 if fails
+ */
+int TransformVectorSoA(Matrix3D *matrix, VectorListSoA *src,
+		VectorListSoA *dst);
+
+#endif
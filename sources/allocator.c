@@ -0,0 +1,191 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <stdlib.h>
+#include <string.h>
+#include <ansic3d/allocator.h>
+
+static void *HeapAlloc(size_t size, void *context)
+{
+	(void) context;
+	return malloc(size);
+}
+
+static void *HeapRealloc(void *p, size_t old_size, size_t size,
+		void *context)
+{
+	(void) old_size;
+	(void) context;
+	return realloc(p, size);
+}
+
+static void HeapFree(void *p, size_t size, void *context)
+{
+	(void) size;
+	(void) context;
+	free(p);
+}
+
+static Allocator heap_allocator = {HeapAlloc, HeapRealloc, HeapFree, NULL};
+
+Allocator *HeapAllocator(void)
+{
+	return &heap_allocator;
+}
+
+void *AllocatorAlloc(Allocator *allocator, size_t size)
+{
+	if (allocator == NULL)
+	{
+		return malloc(size);
+	}
+	return allocator->alloc(size, allocator->context);
+}
+
+void *AllocatorRealloc(Allocator *allocator, void *p, size_t old_size,
+		size_t size)
+{
+	if (allocator == NULL)
+	{
+		return realloc(p, size);
+	}
+	return allocator->realloc(p, old_size, size, allocator->context);
+}
+
+void AllocatorFree(Allocator *allocator, void *p, size_t size)
+{
+	if (p == NULL)
+	{
+		return;
+	}
+	if (allocator == NULL)
+	{
+		free(p);
+		return;
+	}
+	allocator->free(p, size, allocator->context);
+}
+
+static size_t AlignArenaOffset(size_t offset)
+{
+	return (offset + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1);
+}
+
+static void *ArenaAlloc(size_t size, void *context)
+{
+	FrameArena *arena = context;
+	size_t start = AlignArenaOffset(arena->offset);
+	// Empty blocks still take a byte so no two live blocks share an
+	// address, the in place growth below relies on that
+	if (size == 0)
+	{
+		size = 1;
+	}
+	if (start > arena->size || size > arena->size - start)
+	{
+		return NULL;
+	}
+	arena->last = start;
+	arena->offset = start + size;
+	return arena->buffer + start;
+}
+
+static void *ArenaRealloc(void *p, size_t old_size, size_t size,
+		void *context)
+{
+	FrameArena *arena = context;
+	unsigned char *q;
+	if (p == NULL)
+	{
+		return ArenaAlloc(size, context);
+	}
+	// The latest allocation grows or shrinks in place
+	if ((unsigned char *) p == arena->buffer + arena->last)
+	{
+		if (size == 0)
+		{
+			size = 1;
+		}
+		if (size > arena->size - arena->last)
+		{
+			return NULL;
+		}
+		arena->offset = arena->last + size;
+		return p;
+	}
+	if (size <= old_size)
+	{
+		return p;
+	}
+	q = ArenaAlloc(size, context);
+	if (q == NULL)
+	{
+		return NULL;
+	}
+	memcpy(q, p, old_size);
+	return q;
+}
+
+static void ArenaFree(void *p, size_t size, void *context)
+{
+	FrameArena *arena = context;
+	(void) size;
+	// Only the latest allocation can be given back, the rest waits for
+	// the reset
+	if ((unsigned char *) p == arena->buffer + arena->last)
+	{
+		arena->offset = arena->last;
+	}
+}
+
+int InitFrameArena(FrameArena *arena, size_t size)
+{
+	void *p = NULL;
+	if (posix_memalign(&p, ARENA_ALIGNMENT, size > 0 ? size : 1) != 0)
+	{
+		return 0;
+	}
+	arena->buffer = p;
+	arena->size = size;
+	arena->offset = 0;
+	arena->last = 0;
+	arena->allocator.alloc = ArenaAlloc;
+	arena->allocator.realloc = ArenaRealloc;
+	arena->allocator.free = ArenaFree;
+	arena->allocator.context = arena;
+	return 1;
+}
+
+void ResetFrameArena(FrameArena *arena)
+{
+	arena->offset = 0;
+	arena->last = 0;
+}
+
+size_t FrameArenaUsed(FrameArena *arena)
+{
+	return arena->offset;
+}
+
+void FreeFrameArena(FrameArena *arena)
+{
+	free(arena->buffer);
+	arena->buffer = NULL;
+	arena->size = 0;
+	arena->offset = 0;
+	arena->last = 0;
+}
@@ -0,0 +1,277 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <math.h>
+#include <ansic3d/bounds.h>
+#include <ansic3d/inline.h>
+
+int ComputeAABB(VectorList *list, AABB *box)
+{
+	return VectorListBounds(list, &box->min, &box->max);
+}
+
+// Grow the sphere to contain every vector (Ritter's second pass)
+static void GrowSphere(VectorList *list, Vector3D *center, float *radius)
+{
+	Vector3D *v;
+	unsigned int i;
+	float d, r2, grow;
+	r2 = *radius * *radius;
+	for (i = 0; i < list->count; i++)
+	{
+		v = &list->vectors[i];
+		d = VectorDistanceSquaredInline(v, center);
+		if (d <= r2)
+		{
+			continue;
+		}
+		d = sqrtf(d);
+		grow = (d - *radius) * 0.5f;
+		*radius += grow;
+		r2 = *radius * *radius;
+		grow /= d;
+		center->x += (v->x - center->x) * grow;
+		center->y += (v->y - center->y) * grow;
+		center->z += (v->z - center->z) * grow;
+	}
+}
+
+int ComputeBoundingSphere(VectorList *list, BoundingSphere *sphere)
+{
+	AABB box;
+	Vector3D center, *v, *lo[3], *hi[3];
+	unsigned int i, k, best;
+	float d, r2, radius, spread, best_spread = -1;
+
+	if (ComputeAABB(list, &box) == 0)
+	{
+		return 0;
+	}
+	// The points at the minimum and maximum of every axis
+	for (k = 0; k < 3; k++)
+	{
+		lo[k] = hi[k] = &list->vectors[0];
+	}
+	for (i = 1; i < list->count; i++)
+	{
+		v = &list->vectors[i];
+		lo[0] = v->x < lo[0]->x ? v : lo[0];
+		lo[1] = v->y < lo[1]->y ? v : lo[1];
+		lo[2] = v->z < lo[2]->z ? v : lo[2];
+		hi[0] = v->x > hi[0]->x ? v : hi[0];
+		hi[1] = v->y > hi[1]->y ? v : hi[1];
+		hi[2] = v->z > hi[2]->z ? v : hi[2];
+	}
+	// Ritter's sphere seeded with the most distant pair
+	best = 0;
+	for (k = 0; k < 3; k++)
+	{
+		spread = VectorDistanceSquaredInline(lo[k], hi[k]);
+		if (spread > best_spread)
+		{
+			best_spread = spread;
+			best = k;
+		}
+	}
+	SetVector((lo[best]->x + hi[best]->x) * 0.5f,
+			(lo[best]->y + hi[best]->y) * 0.5f,
+			(lo[best]->z + hi[best]->z) * 0.5f, 1, &sphere->center);
+	sphere->radius = sqrtf(best_spread) * 0.5f;
+	GrowSphere(list, &sphere->center, &sphere->radius);
+
+	// Sphere around the box center, better for box like inputs
+	SetVector((box.min.x + box.max.x) * 0.5f, (box.min.y + box.max.y) * 0.5f,
+			(box.min.z + box.max.z) * 0.5f, 1, &center);
+	r2 = 0;
+	for (i = 0; i < list->count; i++)
+	{
+		d = VectorDistanceSquaredInline(&list->vectors[i], &center);
+		r2 = d > r2 ? d : r2;
+	}
+	radius = sqrtf(r2);
+	if (radius < sphere->radius)
+	{
+		sphere->center = center;
+		sphere->radius = radius;
+	}
+	return list->count;
+}
+
+// Eigen decomposition of the symmetric matrix a with cyclic Jacobi
+// rotations. a is diagonalized in place, the eigenvectors are the
+// columns of v.
+static void JacobiEigen(double a[3][3], double v[3][3])
+{
+	double theta, t, c, s, x, y;
+	int sweep, p, q, k;
+	for (p = 0; p < 3; p++)
+	{
+		for (q = 0; q < 3; q++)
+		{
+			v[p][q] = p == q;
+		}
+	}
+	for (sweep = 0; sweep < 50; sweep++)
+	{
+		if (fabs(a[0][1]) + fabs(a[0][2]) + fabs(a[1][2]) <=
+				1E-15 * (fabs(a[0][0]) + fabs(a[1][1]) + fabs(a[2][2])))
+		{
+			return;
+		}
+		for (p = 0; p < 2; p++)
+		{
+			for (q = p + 1; q < 3; q++)
+			{
+				if (a[p][q] == 0)
+				{
+					continue;
+				}
+				theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+				t = (theta >= 0 ? 1 : -1) /
+					(fabs(theta) + sqrt(theta * theta + 1));
+				c = 1 / sqrt(t * t + 1);
+				s = t * c;
+				for (k = 0; k < 3; k++)
+				{
+					x = a[k][p];
+					y = a[k][q];
+					a[k][p] = c * x - s * y;
+					a[k][q] = s * x + c * y;
+				}
+				for (k = 0; k < 3; k++)
+				{
+					x = a[p][k];
+					y = a[q][k];
+					a[p][k] = c * x - s * y;
+					a[q][k] = s * x + c * y;
+				}
+				for (k = 0; k < 3; k++)
+				{
+					x = v[k][p];
+					y = v[k][q];
+					v[k][p] = c * x - s * y;
+					v[k][q] = s * x + c * y;
+				}
+			}
+		}
+	}
+}
+
+int ComputeOBB(VectorList *list, OBB *box)
+{
+	double mean[3] = {0, 0, 0}, cov[3][3], vec[3][3], d[3];
+	float lo[3], hi[3], p;
+	unsigned int i, order[3], k, j, t;
+	Vector3D *v, offset;
+
+	if (list->count == 0)
+	{
+		return 0;
+	}
+	for (i = 0; i < list->count; i++)
+	{
+		v = &list->vectors[i];
+		mean[0] += v->x;
+		mean[1] += v->y;
+		mean[2] += v->z;
+	}
+	for (k = 0; k < 3; k++)
+	{
+		mean[k] /= list->count;
+		for (j = 0; j < 3; j++)
+		{
+			cov[k][j] = 0;
+		}
+	}
+	for (i = 0; i < list->count; i++)
+	{
+		v = &list->vectors[i];
+		d[0] = v->x - mean[0];
+		d[1] = v->y - mean[1];
+		d[2] = v->z - mean[2];
+		for (k = 0; k < 3; k++)
+		{
+			for (j = k; j < 3; j++)
+			{
+				cov[k][j] += d[k] * d[j];
+			}
+		}
+	}
+	cov[1][0] = cov[0][1];
+	cov[2][0] = cov[0][2];
+	cov[2][1] = cov[1][2];
+	JacobiEigen(cov, vec);
+
+	// Axes by decreasing variance, the third one completes a right handed
+	// basis
+	order[0] = 0;
+	order[1] = 1;
+	order[2] = 2;
+	for (k = 0; k < 2; k++)
+	{
+		for (j = k + 1; j < 3; j++)
+		{
+			if (cov[order[j]][order[j]] > cov[order[k]][order[k]])
+			{
+				t = order[k];
+				order[k] = order[j];
+				order[j] = t;
+			}
+		}
+	}
+	for (k = 0; k < 2; k++)
+	{
+		SetVector(vec[0][order[k]], vec[1][order[k]], vec[2][order[k]], 0,
+				&box->axis[k]);
+		NormalizeVectorInline(&box->axis[k]);
+	}
+	SetVector(0, 0, 0, 0, &box->axis[2]);
+	CrossProductInline(&box->axis[0], &box->axis[1], &box->axis[2]);
+	NormalizeVectorInline(&box->axis[2]);
+
+	// Extents along the axes around the mean
+	SetVector(mean[0], mean[1], mean[2], 1, &offset);
+	for (i = 0; i < list->count; i++)
+	{
+		v = &list->vectors[i];
+		for (k = 0; k < 3; k++)
+		{
+			p = (v->x - offset.x) * box->axis[k].x +
+				(v->y - offset.y) * box->axis[k].y +
+				(v->z - offset.z) * box->axis[k].z;
+			if (i == 0 || p < lo[k])
+			{
+				lo[k] = p;
+			}
+			if (i == 0 || p > hi[k])
+			{
+				hi[k] = p;
+			}
+		}
+	}
+	box->center = offset;
+	for (k = 0; k < 3; k++)
+	{
+		p = (lo[k] + hi[k]) * 0.5f;
+		box->center.x += box->axis[k].x * p;
+		box->center.y += box->axis[k].y * p;
+		box->center.z += box->axis[k].z * p;
+	}
+	SetVector((hi[0] - lo[0]) * 0.5f, (hi[1] - lo[1]) * 0.5f,
+			(hi[2] - lo[2]) * 0.5f, 0, &box->extents);
+	return list->count;
+}
@@ -0,0 +1,641 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ansic3d/bvh.h>
+#include <ansic3d/parallel.h>
+
+/**
+ * Subtrees of at most this many triangles are built by a single thread
+ */
+#define BVH_MIN_JOB 1024
+
+/**
+ * Triangles per chunk when computing their bounds, nodes per chunk of
+ * the leaf refit
+ */
+#define BVH_GRAIN 4096
+
+/**
+ * Rays per chunk of BVHClosestHitBatch
+ */
+#define BVH_BATCH_GRAIN 64
+
+typedef struct _BVHBuildJob
+{
+	unsigned int node;
+	unsigned int begin;
+	unsigned int end;
+	unsigned int depth;
+} BVHBuildJob;
+
+typedef struct _BVHBuild
+{
+	BVH *bvh;
+	BVHNode *nodes;
+	Vector3D *tri_min;
+	Vector3D *tri_max;
+	Vector3D *centroids;
+	BVHBuildJob *jobs;
+	unsigned int job_count;
+	unsigned int job_capacity;
+	unsigned int job_size;
+} BVHBuild;
+
+typedef struct _BVHBin
+{
+	float min[3];
+	float max[3];
+	unsigned int count;
+} BVHBin;
+
+typedef struct _BVHStackEntry
+{
+	unsigned int node;
+	float t_near;
+} BVHStackEntry;
+
+typedef struct _BVHBatchJob
+{
+	BVH *bvh;
+	const Ray *rays;
+	RayHit *hits;
+} BVHBatchJob;
+
+#define COORD(v, axis) (((const float *) &(v)->x)[axis])
+
+static void TriangleVertices(const BVH *bvh, unsigned int triangle,
+		const Vector3D **v0, const Vector3D **v1, const Vector3D **v2)
+{
+	const Vector3D *vectors = bvh->vertices->vectors;
+	if (bvh->indices != NULL)
+	{
+		*v0 = &vectors[bvh->indices[3 * triangle]];
+		*v1 = &vectors[bvh->indices[3 * triangle + 1]];
+		*v2 = &vectors[bvh->indices[3 * triangle + 2]];
+	}
+	else
+	{
+		*v0 = &vectors[3 * triangle];
+		*v1 = &vectors[3 * triangle + 1];
+		*v2 = &vectors[3 * triangle + 2];
+	}
+}
+
+static void TriangleBounds(const BVH *bvh, unsigned int triangle,
+		float *min, float *max)
+{
+	const Vector3D *v0, *v1, *v2;
+	int axis;
+	float a, b, c;
+	TriangleVertices(bvh, triangle, &v0, &v1, &v2);
+	for (axis = 0; axis < 3; axis++)
+	{
+		a = COORD(v0, axis);
+		b = COORD(v1, axis);
+		c = COORD(v2, axis);
+		min[axis] = a < b ? (a < c ? a : c) : (b < c ? b : c);
+		max[axis] = a > b ? (a > c ? a : c) : (b > c ? b : c);
+	}
+}
+
+static void BuildTriangleBounds(unsigned int begin, unsigned int end,
+		void *context)
+{
+	BVHBuild *b = context;
+	unsigned int i;
+	for (i = begin; i < end; i++)
+	{
+		TriangleBounds(b->bvh, i, &b->tri_min[i].x, &b->tri_max[i].x);
+		b->centroids[i].x = (b->tri_min[i].x + b->tri_max[i].x) * 0.5f;
+		b->centroids[i].y = (b->tri_min[i].y + b->tri_max[i].y) * 0.5f;
+		b->centroids[i].z = (b->tri_min[i].z + b->tri_max[i].z) * 0.5f;
+		b->centroids[i].w = 0;
+	}
+}
+
+static void GrowBounds(float *min, float *max, const float *add_min,
+		const float *add_max)
+{
+	int axis;
+	for (axis = 0; axis < 3; axis++)
+	{
+		min[axis] = add_min[axis] < min[axis] ? add_min[axis] : min[axis];
+		max[axis] = add_max[axis] > max[axis] ? add_max[axis] : max[axis];
+	}
+}
+
+static float HalfArea(const float *min, const float *max)
+{
+	float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+	return dx * dy + dy * dz + dz * dx;
+}
+
+static unsigned int BinOf(float c, float min, float scale)
+{
+	float bin = (c - min) * scale;
+	// Clamped before the cast, also catches inf and NaN from tiny extents
+	return bin < BVH_BINS - 1 ? (unsigned int) bin : BVH_BINS - 1;
+}
+
+// Best SAH split of [begin, end) over centroid bins, all three axes are
+// binned in one pass. Return the number of triangles on the left side, 0
+// if the centroids do not spread
+static unsigned int SplitSAH(BVHBuild *b, unsigned int begin,
+		unsigned int end)
+{
+	BVHBin bins[3][BVH_BINS], *bin;
+	float cmin[3], cmax[3], scale[3], left_min[3], left_max[3];
+	float right_min[3], right_max[3], left_area[BVH_BINS], cost, best_cost;
+	unsigned int *tri = b->bvh->triangles;
+	unsigned int i, j, k, left_count, right_count, best_axis = 3;
+	unsigned int best_bin = 0;
+	int axis;
+	for (axis = 0; axis < 3; axis++)
+	{
+		cmin[axis] = cmax[axis] = COORD(&b->centroids[tri[begin]], axis);
+	}
+	for (i = begin + 1; i < end; i++)
+	{
+		GrowBounds(cmin, cmax, &b->centroids[tri[i]].x,
+				&b->centroids[tri[i]].x);
+	}
+	for (axis = 0; axis < 3; axis++)
+	{
+		// Flat axes end up in bin 0 and never give a split
+		scale[axis] = cmax[axis] > cmin[axis] ?
+			BVH_BINS / (cmax[axis] - cmin[axis]) : 0;
+		for (k = 0; k < BVH_BINS; k++)
+		{
+			bin = &bins[axis][k];
+			bin->count = 0;
+			bin->min[0] = bin->min[1] = bin->min[2] = INFINITY;
+			bin->max[0] = bin->max[1] = bin->max[2] = -INFINITY;
+		}
+	}
+	for (i = begin; i < end; i++)
+	{
+		for (axis = 0; axis < 3; axis++)
+		{
+			bin = &bins[axis][BinOf(COORD(&b->centroids[tri[i]], axis),
+					cmin[axis], scale[axis])];
+			bin->count++;
+			GrowBounds(bin->min, bin->max, &b->tri_min[tri[i]].x,
+					&b->tri_max[tri[i]].x);
+		}
+	}
+	best_cost = INFINITY;
+	for (axis = 0; axis < 3; axis++)
+	{
+		// Sweep from the left storing the areas, then from the right
+		// evaluating the cost of splitting after bin k
+		left_count = 0;
+		left_min[0] = left_min[1] = left_min[2] = INFINITY;
+		left_max[0] = left_max[1] = left_max[2] = -INFINITY;
+		for (k = 0; k < BVH_BINS - 1; k++)
+		{
+			left_count += bins[axis][k].count;
+			GrowBounds(left_min, left_max, bins[axis][k].min,
+					bins[axis][k].max);
+			left_area[k] = left_count > 0 ?
+				HalfArea(left_min, left_max) * left_count : 0;
+		}
+		right_count = 0;
+		right_min[0] = right_min[1] = right_min[2] = INFINITY;
+		right_max[0] = right_max[1] = right_max[2] = -INFINITY;
+		for (j = BVH_BINS - 1; j > 0; j--)
+		{
+			right_count += bins[axis][j].count;
+			GrowBounds(right_min, right_max, bins[axis][j].min,
+					bins[axis][j].max);
+			if (right_count == 0 || right_count == end - begin)
+			{
+				continue;
+			}
+			cost = left_area[j - 1] +
+				HalfArea(right_min, right_max) * right_count;
+			if (cost < best_cost)
+			{
+				best_cost = cost;
+				best_axis = axis;
+				best_bin = j - 1;
+			}
+		}
+	}
+	if (best_axis == 3)
+	{
+		return 0;
+	}
+	// Partition on the same bin computation as above
+	i = begin;
+	j = end;
+	while (i < j)
+	{
+		if (BinOf(COORD(&b->centroids[tri[i]], best_axis), cmin[best_axis],
+					scale[best_axis]) <= best_bin)
+		{
+			i++;
+		}
+		else
+		{
+			j--;
+			k = tri[i];
+			tri[i] = tri[j];
+			tri[j] = k;
+		}
+	}
+	return i - begin;
+}
+
+// Subtree over triangles [begin, end) at node, using at most
+// 2 * (end - begin) - 1 nodes from there on
+static void BuildNode(BVHBuild *b, unsigned int node, unsigned int begin,
+		unsigned int end, unsigned int depth)
+{
+	BVHNode *n = &b->nodes[node];
+	BVHBuildJob *jobs;
+	unsigned int *tri = b->bvh->triangles;
+	unsigned int i, left = 0;
+	if (b->jobs != NULL && end - begin <= b->job_size)
+	{
+		if (b->job_count == b->job_capacity)
+		{
+			jobs = realloc(b->jobs, 2 * b->job_capacity *
+					sizeof(BVHBuildJob));
+			if (jobs != NULL)
+			{
+				b->jobs = jobs;
+				b->job_capacity *= 2;
+			}
+		}
+		if (b->job_count < b->job_capacity)
+		{
+			b->jobs[b->job_count].node = node;
+			b->jobs[b->job_count].begin = begin;
+			b->jobs[b->job_count].end = end;
+			b->jobs[b->job_count].depth = depth;
+			b->job_count++;
+			return;
+		}
+	}
+	memcpy(n->min, &b->tri_min[tri[begin]].x, sizeof(n->min));
+	memcpy(n->max, &b->tri_max[tri[begin]].x, sizeof(n->max));
+	for (i = begin + 1; i < end; i++)
+	{
+		GrowBounds(n->min, n->max, &b->tri_min[tri[i]].x,
+				&b->tri_max[tri[i]].x);
+	}
+	if (end - begin <= BVH_LEAF_SIZE)
+	{
+		n->first = begin;
+		n->count = end - begin;
+		return;
+	}
+	if (depth < BVH_MAX_DEPTH / 2)
+	{
+		left = SplitSAH(b, begin, end);
+	}
+	if (left == 0)
+	{
+		// Halving keeps the depth bounded whatever the input
+		left = (end - begin) / 2;
+	}
+	n->first = node + 2 * left;
+	n->count = 0;
+	BuildNode(b, node + 1, begin, begin + left, depth + 1);
+	BuildNode(b, n->first, begin + left, end, depth + 1);
+}
+
+static void BuildJobs(unsigned int begin, unsigned int end, void *context)
+{
+	BVHBuild b = *(BVHBuild *) context;
+	unsigned int i;
+	BVHBuildJob *job;
+	b.jobs = NULL;
+	for (i = begin; i < end; i++)
+	{
+		job = &((BVHBuild *) context)->jobs[i];
+		BuildNode(&b, job->node, job->begin, job->end, job->depth);
+	}
+}
+
+// Move the subtree at node s to d in depth first order, closing the gaps
+// the build leaves. Nodes are visited in increasing order and d <= s, so
+// nothing is overwritten before it is read. Return the next free index
+static unsigned int CompactNode(BVHNode *nodes, unsigned int s,
+		unsigned int d)
+{
+	unsigned int right = nodes[s].first, next;
+	nodes[d] = nodes[s];
+	if (nodes[d].count > 0)
+	{
+		return d + 1;
+	}
+	next = CompactNode(nodes, s + 1, d + 1);
+	nodes[d].first = next;
+	return CompactNode(nodes, right, next);
+}
+
+int BuildBVH(VectorList *vertices, const unsigned int *indices,
+		unsigned int triangle_count, BVH *bvh)
+{
+	BVHBuild b;
+	unsigned int i, threads;
+	bvh->nodes = NULL;
+	bvh->node_count = 0;
+	bvh->triangles = NULL;
+	bvh->triangle_count = 0;
+	bvh->vertices = vertices;
+	bvh->indices = indices;
+	if (triangle_count == 0)
+	{
+		return 0;
+	}
+	b.bvh = bvh;
+	b.nodes = malloc((2 * (size_t) triangle_count - 1) * sizeof(BVHNode));
+	b.tri_min = malloc(3 * (size_t) triangle_count * sizeof(Vector3D));
+	bvh->triangles = malloc(triangle_count * sizeof(unsigned int));
+	if (b.nodes == NULL || b.tri_min == NULL || bvh->triangles == NULL)
+	{
+		free(b.nodes);
+		free(b.tri_min);
+		free(bvh->triangles);
+		bvh->triangles = NULL;
+		return 0;
+	}
+	b.tri_max = b.tri_min + triangle_count;
+	b.centroids = b.tri_max + triangle_count;
+	for (i = 0; i < triangle_count; i++)
+	{
+		bvh->triangles[i] = i;
+	}
+	ParallelFor(triangle_count, BVH_GRAIN, BuildTriangleBounds, &b);
+
+	// The top of the tree is split here, subtrees of at most job_size
+	// triangles are queued and built over the pool
+	b.job_count = 0;
+	b.job_capacity = 0;
+	b.jobs = NULL;
+	threads = GetThreadCount();
+	b.job_size = triangle_count / (threads * 4);
+	if (threads > 1 && b.job_size >= BVH_MIN_JOB)
+	{
+		b.job_capacity = threads * 8;
+		b.jobs = malloc(b.job_capacity * sizeof(BVHBuildJob));
+	}
+	BuildNode(&b, 0, 0, triangle_count, 0);
+	if (b.jobs != NULL)
+	{
+		ParallelFor(b.job_count, 1, BuildJobs, &b);
+		free(b.jobs);
+	}
+	free(b.tri_min);
+
+	// Subtrees reserve room for their worst case, pack them together
+	bvh->node_count = CompactNode(b.nodes, 0, 0);
+	bvh->nodes = realloc(b.nodes, bvh->node_count * sizeof(BVHNode));
+	if (bvh->nodes == NULL)
+	{
+		bvh->nodes = b.nodes;
+	}
+	bvh->triangle_count = triangle_count;
+	return triangle_count;
+}
+
+static void RefitLeaves(unsigned int begin, unsigned int end, void *context)
+{
+	BVH *bvh = context;
+	BVHNode *n;
+	float min[3], max[3];
+	unsigned int i, j;
+	for (i = begin; i < end; i++)
+	{
+		n = &bvh->nodes[i];
+		if (n->count == 0)
+		{
+			continue;
+		}
+		TriangleBounds(bvh, bvh->triangles[n->first], n->min, n->max);
+		for (j = 1; j < n->count; j++)
+		{
+			TriangleBounds(bvh, bvh->triangles[n->first + j], min, max);
+			GrowBounds(n->min, n->max, min, max);
+		}
+	}
+}
+
+void RefitBVH(BVH *bvh)
+{
+	BVHNode *n;
+	unsigned int i;
+	ParallelFor(bvh->node_count, BVH_GRAIN, RefitLeaves, bvh);
+	// Children come after their parent, walking backwards merges them in
+	// before the parent is reached
+	for (i = bvh->node_count; i-- > 0;)
+	{
+		n = &bvh->nodes[i];
+		if (n->count > 0)
+		{
+			continue;
+		}
+		memcpy(n->min, bvh->nodes[i + 1].min, sizeof(n->min));
+		memcpy(n->max, bvh->nodes[i + 1].max, sizeof(n->max));
+		GrowBounds(n->min, n->max, bvh->nodes[n->first].min,
+				bvh->nodes[n->first].max);
+	}
+}
+
+// Slab test against the node box. Return the entry distance, INFINITY if
+// the ray misses it before t_max
+static float RayNode(const BVHNode *n, const float *origin,
+		const float *inv, float t_max)
+{
+	float t0, t1, t, t_near = 0, t_far = t_max;
+	int axis;
+	for (axis = 0; axis < 3; axis++)
+	{
+		t0 = (n->min[axis] - origin[axis]) * inv[axis];
+		t1 = (n->max[axis] - origin[axis]) * inv[axis];
+		// NaN from 0 * inf falls through both comparisons
+		if (t0 > t1)
+		{
+			t = t0;
+			t0 = t1;
+			t1 = t;
+		}
+		t_near = t0 > t_near ? t0 : t_near;
+		t_far = t1 < t_far ? t1 : t_far;
+	}
+	return t_near <= t_far ? t_near : INFINITY;
+}
+
+static void RaySetup(const Ray *ray, float *origin, float *inv)
+{
+	origin[0] = ray->origin.x;
+	origin[1] = ray->origin.y;
+	origin[2] = ray->origin.z;
+	inv[0] = 1 / ray->direction.x;
+	inv[1] = 1 / ray->direction.y;
+	inv[2] = 1 / ray->direction.z;
+}
+
+int BVHClosestHit(BVH *bvh, const Ray *ray, RayHit *hit)
+{
+	BVHStackEntry stack[BVH_MAX_DEPTH + 1], near, far, swap;
+	const BVHNode *n;
+	const Vector3D *v0, *v1, *v2;
+	Ray r = *ray;
+	float origin[3], inv[3], t, u, v;
+	unsigned int top = 0, i, tri;
+	hit->t = ray->t_max;
+	hit->u = hit->v = 0;
+	hit->triangle = RAY_NO_HIT;
+	if (bvh->node_count == 0)
+	{
+		return 0;
+	}
+	RaySetup(ray, origin, inv);
+	stack[top].node = 0;
+	stack[top].t_near = RayNode(&bvh->nodes[0], origin, inv, r.t_max);
+	top += stack[top].t_near != INFINITY;
+	while (top > 0)
+	{
+		top--;
+		// A closer hit may have been found since this node was pushed
+		if (!(stack[top].t_near < r.t_max))
+		{
+			continue;
+		}
+		n = &bvh->nodes[stack[top].node];
+		if (n->count > 0)
+		{
+			for (i = 0; i < n->count; i++)
+			{
+				tri = bvh->triangles[n->first + i];
+				TriangleVertices(bvh, tri, &v0, &v1, &v2);
+				if (IntersectRayTriangle(&r, *v0, *v1, *v2, &t, &u, &v))
+				{
+					r.t_max = t;
+					hit->t = t;
+					hit->u = u;
+					hit->v = v;
+					hit->triangle = tri;
+				}
+			}
+			continue;
+		}
+		near.node = stack[top].node + 1;
+		near.t_near = RayNode(&bvh->nodes[near.node], origin, inv, r.t_max);
+		far.node = n->first;
+		far.t_near = RayNode(&bvh->nodes[far.node], origin, inv, r.t_max);
+		if (far.t_near < near.t_near)
+		{
+			swap = near;
+			near = far;
+			far = swap;
+		}
+		// The nearer child goes on top
+		if (far.t_near != INFINITY)
+		{
+			stack[top++] = far;
+		}
+		if (near.t_near != INFINITY)
+		{
+			stack[top++] = near;
+		}
+	}
+	return hit->triangle != RAY_NO_HIT;
+}
+
+int BVHAnyHit(BVH *bvh, const Ray *ray)
+{
+	unsigned int stack[BVH_MAX_DEPTH + 1];
+	const BVHNode *n;
+	const Vector3D *v0, *v1, *v2;
+	float origin[3], inv[3], t, u, v;
+	unsigned int top = 0, node, i;
+	if (bvh->node_count == 0)
+	{
+		return 0;
+	}
+	RaySetup(ray, origin, inv);
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		node = stack[--top];
+		n = &bvh->nodes[node];
+		if (RayNode(n, origin, inv, ray->t_max) == INFINITY)
+		{
+			continue;
+		}
+		if (n->count > 0)
+		{
+			for (i = 0; i < n->count; i++)
+			{
+				TriangleVertices(bvh, bvh->triangles[n->first + i], &v0, &v1,
+						&v2);
+				if (IntersectRayTriangle(ray, *v0, *v1, *v2, &t, &u, &v))
+				{
+					return 1;
+				}
+			}
+			continue;
+		}
+		stack[top++] = n->first;
+		stack[top++] = node + 1;
+	}
+	return 0;
+}
+
+static void ClosestHitRange(unsigned int begin, unsigned int end,
+		void *context)
+{
+	BVHBatchJob *job = context;
+	unsigned int i;
+	for (i = begin; i < end; i++)
+	{
+		BVHClosestHit(job->bvh, &job->rays[i], &job->hits[i]);
+	}
+}
+
+unsigned int BVHClosestHitBatch(BVH *bvh, const Ray *rays, unsigned int n,
+		RayHit *hits)
+{
+	BVHBatchJob job;
+	unsigned int i, hit_count = 0;
+	job.bvh = bvh;
+	job.rays = rays;
+	job.hits = hits;
+	ParallelFor(n, BVH_BATCH_GRAIN, ClosestHitRange, &job);
+	for (i = 0; i < n; i++)
+	{
+		hit_count += hits[i].triangle != RAY_NO_HIT;
+	}
+	return hit_count;
+}
+
+void FreeBVH(BVH *bvh)
+{
+	free(bvh->nodes);
+	free(bvh->triangles);
+	bvh->nodes = NULL;
+	bvh->triangles = NULL;
+	bvh->node_count = 0;
+	bvh->triangle_count = 0;
+}
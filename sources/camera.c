@@ -0,0 +1,216 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <math.h>
+#include <ansic3d/camera.h>
+#include <ansic3d/frustum.h>
+#include <ansic3d/inline.h>
+
+#define CAMERA_DEPENDS_ON_VIEW (CAMERA_VIEW | CAMERA_VIEW_PROJECTION | \
+		CAMERA_INVERSE_VIEW | CAMERA_INVERSE_VIEW_PROJECTION)
+
+#define CAMERA_DEPENDS_ON_PROJECTION (CAMERA_PROJECTION | \
+		CAMERA_VIEW_PROJECTION | CAMERA_INVERSE_PROJECTION | \
+		CAMERA_INVERSE_VIEW_PROJECTION)
+
+void InitCamera(Camera *camera)
+{
+	SetVector(0, 0, 0, 1, &camera->eye);
+	SetVector(0, 0, -1, 1, &camera->target);
+	SetVector(0, 1, 0, 0, &camera->up);
+	camera->mode = CAMERA_PERSPECTIVE;
+	camera->reversed_z = 0;
+	camera->fov_y = degtorad(60);
+	camera->size = 1;
+	camera->aspect = 1;
+	camera->near = 0.1f;
+	camera->far = 1000;
+	camera->dirty = CAMERA_ALL;
+}
+
+void SetCameraLookAt(Camera *camera, Vector3D eye, Vector3D target,
+		Vector3D up)
+{
+	camera->eye = eye;
+	camera->target = target;
+	camera->up = up;
+	camera->dirty |= CAMERA_DEPENDS_ON_VIEW;
+}
+
+void SetCameraView(Camera *camera, Matrix3D *view)
+{
+	camera->view = *view;
+	camera->dirty |= CAMERA_DEPENDS_ON_VIEW;
+	camera->dirty &= ~CAMERA_VIEW;
+}
+
+void SetCameraPerspective(Camera *camera, float fov_y, float aspect,
+		float near, float far, int reversed_z)
+{
+	camera->mode = CAMERA_PERSPECTIVE;
+	camera->fov_y = fov_y;
+	camera->aspect = aspect;
+	camera->near = near;
+	camera->far = far;
+	camera->reversed_z = reversed_z;
+	camera->dirty |= CAMERA_DEPENDS_ON_PROJECTION;
+}
+
+void SetCameraOrthographic(Camera *camera, float size, float aspect,
+		float near, float far, int reversed_z)
+{
+	camera->mode = CAMERA_ORTHOGRAPHIC;
+	camera->size = size;
+	camera->aspect = aspect;
+	camera->near = near;
+	camera->far = far;
+	camera->reversed_z = reversed_z;
+	camera->dirty |= CAMERA_DEPENDS_ON_PROJECTION;
+}
+
+void SetCameraAspect(Camera *camera, float aspect)
+{
+	camera->aspect = aspect;
+	camera->dirty |= CAMERA_DEPENDS_ON_PROJECTION;
+}
+
+const Matrix3D *CameraView(Camera *camera)
+{
+	if (camera->dirty & CAMERA_VIEW)
+	{
+		LookAtMatrix(camera->eye, camera->target, camera->up, &camera->view);
+		camera->dirty &= ~CAMERA_VIEW;
+	}
+	return &camera->view;
+}
+
+const Matrix3D *CameraProjection(Camera *camera)
+{
+	float h = camera->size * 0.5f, w = h * camera->aspect;
+	if (!(camera->dirty & CAMERA_PROJECTION))
+	{
+		return &camera->projection;
+	}
+	if (camera->mode == CAMERA_ORTHOGRAPHIC)
+	{
+		if (camera->reversed_z)
+		{
+			CreateReversedZOrthographicMatrix(-w, w, -h, h, camera->near,
+					camera->far, &camera->projection);
+		}
+		else
+		{
+			CreateOrthographicMatrix(-w, w, -h, h, camera->near, camera->far,
+					&camera->projection);
+		}
+	}
+	else if (camera->reversed_z)
+	{
+		CreateReversedZPerspectiveMatrix(camera->fov_y, camera->aspect,
+				camera->near, camera->far, &camera->projection);
+	}
+	else if (isinf(camera->far))
+	{
+		CreateInfinitePerspectiveMatrix(camera->fov_y, camera->aspect,
+				camera->near, &camera->projection);
+	}
+	else
+	{
+		CreatePerspectiveMatrix(camera->fov_y, camera->aspect, camera->near,
+				camera->far, &camera->projection);
+	}
+	camera->dirty &= ~CAMERA_PROJECTION;
+	return &camera->projection;
+}
+
+const Matrix3D *CameraViewProjection(Camera *camera)
+{
+	if (camera->dirty & CAMERA_VIEW_PROJECTION)
+	{
+		MultiplyMatrixRestrict(CameraView(camera), CameraProjection(camera),
+				&camera->view_projection);
+		camera->dirty &= ~CAMERA_VIEW_PROJECTION;
+	}
+	return &camera->view_projection;
+}
+
+const Matrix3D *CameraInverseView(Camera *camera)
+{
+	if (camera->dirty & CAMERA_INVERSE_VIEW)
+	{
+		camera->inverse_view = *CameraView(camera);
+		InvertMatrixFast(&camera->inverse_view);
+		camera->dirty &= ~CAMERA_INVERSE_VIEW;
+	}
+	return &camera->inverse_view;
+}
+
+const Matrix3D *CameraInverseProjection(Camera *camera)
+{
+	if (camera->dirty & CAMERA_INVERSE_PROJECTION)
+	{
+		camera->inverse_projection = *CameraProjection(camera);
+		InvertMatrixFast(&camera->inverse_projection);
+		camera->dirty &= ~CAMERA_INVERSE_PROJECTION;
+	}
+	return &camera->inverse_projection;
+}
+
+const Matrix3D *CameraInverseViewProjection(Camera *camera)
+{
+	if (camera->dirty & CAMERA_INVERSE_VIEW_PROJECTION)
+	{
+		// (view * projection)^-1 = projection^-1 * view^-1
+		MultiplyMatrixRestrict(CameraInverseProjection(camera),
+				CameraInverseView(camera), &camera->inverse_view_projection);
+		camera->dirty &= ~CAMERA_INVERSE_VIEW_PROJECTION;
+	}
+	return &camera->inverse_view_projection;
+}
+
+void CameraFrustum(Camera *camera, Frustum *frustum)
+{
+	Matrix3D m = *CameraViewProjection(camera);
+	ExtractFrustum(&m, camera->reversed_z ? FRUSTUM_DEPTH_ZERO_ONE :
+			FRUSTUM_DEPTH_NEGATIVE_ONE, frustum);
+}
+
+// Clip space point (x, y, z, 1) back to world space
+static void Unproject(const Matrix3D *inverse, float x, float y, float z,
+		Vector3D *target)
+{
+	Vector3D clip;
+	SetVector(x, y, z, 1, &clip);
+	VectorTransformInline(inverse, &clip, target);
+	target->x /= target->w;
+	target->y /= target->w;
+	target->z /= target->w;
+	target->w = 1;
+}
+
+void CameraRay(Camera *camera, float x, float y, Vector3D *origin,
+		Vector3D *direction)
+{
+	const Matrix3D *inverse = CameraInverseViewProjection(camera);
+	Vector3D deeper;
+	// The second point stays at a finite depth for infinite projections
+	Unproject(inverse, x, y, camera->reversed_z ? 1 : -1, origin);
+	Unproject(inverse, x, y, camera->reversed_z ? 0.5f : 0, &deeper);
+	SubVectorInline(&deeper, origin, direction);
+	NormalizeVectorInline(direction);
+	direction->w = 0;
+}
@@ -0,0 +1,117 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <ansic3d/cpu.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *level_names[] = {"scalar", "sse", "sse4.1", "avx", "avx2"};
+
+// -1 until selected. Selection is idempotent so a race on the first call
+// only results in the same value being written twice.
+static int simd_level = -1;
+
+int DetectSIMDLevel(void)
+{
+#ifdef ANSIC3D_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	{
+		return SIMD_AVX2;
+	}
+	if (__builtin_cpu_supports("avx"))
+	{
+		return SIMD_AVX;
+	}
+	if (__builtin_cpu_supports("sse4.1"))
+	{
+		return SIMD_SSE41;
+	}
+	if (__builtin_cpu_supports("sse2"))
+	{
+		return SIMD_SSE;
+	}
+#endif
+	return SIMD_SCALAR;
+}
+
+static void SelectSIMDLevel(void)
+{
+	int level;
+	const char *env = getenv(SIMD_ENV);
+	if (env != NULL)
+	{
+		for (level = SIMD_SCALAR; level <= SIMD_AVX2; level++)
+		{
+			if (strcmp(env, level_names[level]) == 0)
+			{
+				SetSIMDLevel(level);
+				return;
+			}
+		}
+#ifdef ANSIC3D_DEBUG
+		fprintf(stderr, "ANSIC3D: unknown %s=%s, using the detected level\n",
+				SIMD_ENV, env);
+#endif
+	}
+	simd_level = DetectSIMDLevel();
+}
+
+#ifdef __GNUC__
+__attribute__((constructor))
+static void InitSIMDLevel(void)
+{
+	if (simd_level < 0)
+	{
+		SelectSIMDLevel();
+	}
+}
+#endif
+
+int GetSIMDLevel(void)
+{
+	if (simd_level < 0)
+	{
+		SelectSIMDLevel();
+	}
+	return simd_level;
+}
+
+int SetSIMDLevel(int level)
+{
+	int detected = DetectSIMDLevel();
+	if (level < SIMD_SCALAR)
+	{
+		level = SIMD_SCALAR;
+	}
+	if (level > detected)
+	{
+		level = detected;
+	}
+	simd_level = level;
+	return simd_level;
+}
+
+const char *SIMDLevelName(int level)
+{
+	if (level < SIMD_SCALAR || level > SIMD_AVX2)
+	{
+		return "unknown";
+	}
+	return level_names[level];
+}
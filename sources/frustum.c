@@ -0,0 +1,374 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <math.h>
+#include <stdlib.h>
+#include <ansic3d/frustum.h>
+#include <ansic3d/vectorlist.h>
+#include <ansic3d/parallel.h>
+#include <ansic3d/cpu.h>
+
+#ifdef ANSIC3D_X86_SIMD
+#include <immintrin.h>
+#endif
+
+typedef struct _CullJob CullJob;
+
+typedef unsigned int (*CullWord)(const CullJob *job, unsigned int i,
+		unsigned int n);
+
+/**
+ * Boxes are x0..z0 (min) and x1..z1 (max), spheres are centers x0..z0
+ * and radius w (NULL for points)
+ */
+struct _CullJob
+{
+	const Frustum *frustum;
+	const float *x0, *y0, *z0;
+	const float *x1, *y1, *z1;
+	const float *w;
+	int spheres;
+	unsigned int *mask;
+	CullWord word;
+};
+
+// plane = w_scale * column 3 + scale * column j of the row major
+// elements m, normalized
+static void ColumnPlane(const float *m, int j, float scale, float w_scale,
+		Vector3D *plane)
+{
+	float length;
+	plane->x = w_scale * m[3] + scale * m[j];
+	plane->y = w_scale * m[7] + scale * m[4 + j];
+	plane->z = w_scale * m[11] + scale * m[8 + j];
+	plane->w = w_scale * m[15] + scale * m[12 + j];
+	length = sqrtf(plane->x * plane->x + plane->y * plane->y +
+			plane->z * plane->z);
+	if (length > 1E-20f)
+	{
+		plane->x /= length;
+		plane->y /= length;
+		plane->z /= length;
+		plane->w /= length;
+	}
+	else
+	{
+		SetVector(0, 0, 0, 1, plane);
+	}
+}
+
+// Gribb and Hartmann: with clip = v * m, -w <= x is
+// dot(v, column 3 + column 0) >= 0 and so on
+void ExtractFrustum(Matrix3D *view_projection, int depth_range,
+		Frustum *frustum)
+{
+	float m[16];
+	CastFloat(view_projection, m);
+	ColumnPlane(m, 0, 1, 1, &frustum->planes[0]);
+	ColumnPlane(m, 0, -1, 1, &frustum->planes[1]);
+	ColumnPlane(m, 1, 1, 1, &frustum->planes[2]);
+	ColumnPlane(m, 1, -1, 1, &frustum->planes[3]);
+	ColumnPlane(m, 2, 1, depth_range == FRUSTUM_DEPTH_ZERO_ONE ? 0 : 1,
+			&frustum->planes[4]);
+	ColumnPlane(m, 2, -1, 1, &frustum->planes[5]);
+}
+
+static int BoxVisible(const Frustum *f, float min_x, float min_y,
+		float min_z, float max_x, float max_y, float max_z)
+{
+	const Vector3D *p;
+	float cx, cy, cz, ex, ey, ez;
+	int k;
+	cx = (min_x + max_x) * 0.5f;
+	cy = (min_y + max_y) * 0.5f;
+	cz = (min_z + max_z) * 0.5f;
+	ex = (max_x - min_x) * 0.5f;
+	ey = (max_y - min_y) * 0.5f;
+	ez = (max_z - min_z) * 0.5f;
+	for (k = 0; k < 6; k++)
+	{
+		p = &f->planes[k];
+		if (p->x * cx + p->y * cy + p->z * cz + p->w +
+				(fabsf(p->x) * ex + fabsf(p->y) * ey + fabsf(p->z) * ez) < 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int SphereVisible(const Frustum *f, float x, float y, float z,
+		float radius)
+{
+	const Vector3D *p;
+	int k;
+	for (k = 0; k < 6; k++)
+	{
+		p = &f->planes[k];
+		if (p->x * x + p->y * y + p->z * z + p->w + radius < 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int AABBInFrustum(const Frustum *frustum, const AABB *box)
+{
+	return BoxVisible(frustum, box->min.x, box->min.y, box->min.z,
+			box->max.x, box->max.y, box->max.z);
+}
+
+int SphereInFrustum(const Frustum *frustum, const BoundingSphere *sphere)
+{
+	return SphereVisible(frustum, sphere->center.x, sphere->center.y,
+			sphere->center.z, sphere->radius);
+}
+
+static unsigned int CullWordScalar(const CullJob *job, unsigned int i,
+		unsigned int n)
+{
+	unsigned int j, k, bits = 0;
+	for (j = 0; j < n; j++)
+	{
+		k = i + j;
+		if (job->spheres ?
+				SphereVisible(job->frustum, job->x0[k], job->y0[k], job->z0[k],
+					job->w != NULL ? job->w[k] : 0) :
+				BoxVisible(job->frustum, job->x0[k], job->y0[k], job->z0[k],
+					job->x1[k], job->y1[k], job->z1[k]))
+		{
+			bits |= 1U << j;
+		}
+	}
+	return bits;
+}
+
+#ifdef ANSIC3D_X86_SIMD
+// 4 objects per iteration, same operation order as the scalar tests so
+// both give the same bits
+__attribute__((target("sse2")))
+static unsigned int CullWordSSE(const CullJob *job, unsigned int i,
+		unsigned int n)
+{
+	const Vector3D *p;
+	__m128 cx, cy, cz, ex, ey, ez, r, d, out, a, b;
+	__m128 half = _mm_set1_ps(0.5f), zero = _mm_setzero_ps();
+	unsigned int j, k, bits = 0;
+	ex = ey = ez = r = zero;
+	for (j = 0; j + 4 <= n; j += 4)
+	{
+		k = i + j;
+		if (job->spheres)
+		{
+			cx = _mm_load_ps(&job->x0[k]);
+			cy = _mm_load_ps(&job->y0[k]);
+			cz = _mm_load_ps(&job->z0[k]);
+			r = job->w != NULL ? _mm_load_ps(&job->w[k]) : zero;
+		}
+		else
+		{
+			a = _mm_load_ps(&job->x0[k]);
+			b = _mm_load_ps(&job->x1[k]);
+			cx = _mm_mul_ps(_mm_add_ps(a, b), half);
+			ex = _mm_mul_ps(_mm_sub_ps(b, a), half);
+			a = _mm_load_ps(&job->y0[k]);
+			b = _mm_load_ps(&job->y1[k]);
+			cy = _mm_mul_ps(_mm_add_ps(a, b), half);
+			ey = _mm_mul_ps(_mm_sub_ps(b, a), half);
+			a = _mm_load_ps(&job->z0[k]);
+			b = _mm_load_ps(&job->z1[k]);
+			cz = _mm_mul_ps(_mm_add_ps(a, b), half);
+			ez = _mm_mul_ps(_mm_sub_ps(b, a), half);
+		}
+		out = zero;
+		for (k = 0; k < 6; k++)
+		{
+			p = &job->frustum->planes[k];
+			d = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+							_mm_mul_ps(_mm_set1_ps(p->x), cx),
+							_mm_mul_ps(_mm_set1_ps(p->y), cy)),
+						_mm_mul_ps(_mm_set1_ps(p->z), cz)), _mm_set1_ps(p->w));
+			if (!job->spheres)
+			{
+				r = _mm_add_ps(_mm_add_ps(
+							_mm_mul_ps(_mm_set1_ps(fabsf(p->x)), ex),
+							_mm_mul_ps(_mm_set1_ps(fabsf(p->y)), ey)),
+						_mm_mul_ps(_mm_set1_ps(fabsf(p->z)), ez));
+			}
+			out = _mm_or_ps(out, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+		}
+		bits |= (unsigned int) (~_mm_movemask_ps(out) & 0xF) << j;
+	}
+	if (j < n)
+	{
+		bits |= CullWordScalar(job, i + j, n - j) << j;
+	}
+	return bits;
+}
+
+// 8 objects per iteration, see CullWordSSE
+__attribute__((target("avx")))
+static unsigned int CullWordAVX(const CullJob *job, unsigned int i,
+		unsigned int n)
+{
+	const Vector3D *p;
+	__m256 cx, cy, cz, ex, ey, ez, r, d, out, a, b;
+	__m256 half = _mm256_set1_ps(0.5f), zero = _mm256_setzero_ps();
+	unsigned int j, k, bits = 0;
+	ex = ey = ez = r = zero;
+	for (j = 0; j + 8 <= n; j += 8)
+	{
+		k = i + j;
+		if (job->spheres)
+		{
+			cx = _mm256_load_ps(&job->x0[k]);
+			cy = _mm256_load_ps(&job->y0[k]);
+			cz = _mm256_load_ps(&job->z0[k]);
+			r = job->w != NULL ? _mm256_load_ps(&job->w[k]) : zero;
+		}
+		else
+		{
+			a = _mm256_load_ps(&job->x0[k]);
+			b = _mm256_load_ps(&job->x1[k]);
+			cx = _mm256_mul_ps(_mm256_add_ps(a, b), half);
+			ex = _mm256_mul_ps(_mm256_sub_ps(b, a), half);
+			a = _mm256_load_ps(&job->y0[k]);
+			b = _mm256_load_ps(&job->y1[k]);
+			cy = _mm256_mul_ps(_mm256_add_ps(a, b), half);
+			ey = _mm256_mul_ps(_mm256_sub_ps(b, a), half);
+			a = _mm256_load_ps(&job->z0[k]);
+			b = _mm256_load_ps(&job->z1[k]);
+			cz = _mm256_mul_ps(_mm256_add_ps(a, b), half);
+			ez = _mm256_mul_ps(_mm256_sub_ps(b, a), half);
+		}
+		out = zero;
+		for (k = 0; k < 6; k++)
+		{
+			p = &job->frustum->planes[k];
+			d = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+							_mm256_mul_ps(_mm256_set1_ps(p->x), cx),
+							_mm256_mul_ps(_mm256_set1_ps(p->y), cy)),
+						_mm256_mul_ps(_mm256_set1_ps(p->z), cz)),
+					_mm256_set1_ps(p->w));
+			if (!job->spheres)
+			{
+				r = _mm256_add_ps(_mm256_add_ps(
+							_mm256_mul_ps(_mm256_set1_ps(fabsf(p->x)), ex),
+							_mm256_mul_ps(_mm256_set1_ps(fabsf(p->y)), ey)),
+						_mm256_mul_ps(_mm256_set1_ps(fabsf(p->z)), ez));
+			}
+			out = _mm256_or_ps(out,
+					_mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_LT_OQ));
+		}
+		bits |= (unsigned int) (~_mm256_movemask_ps(out) & 0xFF) << j;
+	}
+	_mm256_zeroupper();
+	if (j < n)
+	{
+		bits |= CullWordScalar(job, i + j, n - j) << j;
+	}
+	return bits;
+}
+#endif
+
+// One mask word per 32 objects, chunks start at multiples of the grain
+// so threads never share a word
+static void CullRange(unsigned int begin, unsigned int end, void *context)
+{
+	CullJob *job = context;
+	unsigned int i;
+	for (i = begin; i < end; i += 32)
+	{
+		job->mask[i / 32] = job->word(job, i, end - i < 32 ? end - i : 32);
+	}
+}
+
+static unsigned int Cull(CullJob *job, unsigned int count,
+		unsigned int *mask, unsigned int *indices)
+{
+	unsigned int words = (count + 31) / 32, visible = 0, i, j, bits;
+	unsigned int *owned = NULL;
+	if (mask == NULL)
+	{
+		owned = mask = malloc((words > 0 ? words : 1) * sizeof(unsigned int));
+		if (mask == NULL)
+		{
+			return 0;
+		}
+	}
+	job->mask = mask;
+	job->word = CullWordScalar;
+#ifdef ANSIC3D_X86_SIMD
+	if (GetSIMDLevel() >= SIMD_AVX)
+	{
+		job->word = CullWordAVX;
+	}
+	else if (GetSIMDLevel() >= SIMD_SSE)
+	{
+		job->word = CullWordSSE;
+	}
+#endif
+	ParallelFor(count, VECTORLIST_GRAIN, CullRange, job);
+	for (i = 0; i < words; i++)
+	{
+		for (bits = mask[i], j = 0; bits != 0; bits >>= 1, j++)
+		{
+			if (bits & 1)
+			{
+				if (indices != NULL)
+				{
+					indices[visible] = i * 32 + j;
+				}
+				visible++;
+			}
+		}
+	}
+	free(owned);
+	return visible;
+}
+
+unsigned int CullAABBs(const Frustum *frustum, VectorListSoA *min,
+		VectorListSoA *max, unsigned int *mask, unsigned int *indices)
+{
+	CullJob job;
+	job.frustum = frustum;
+	job.x0 = min->x;
+	job.y0 = min->y;
+	job.z0 = min->z;
+	job.x1 = max->x;
+	job.y1 = max->y;
+	job.z1 = max->z;
+	job.w = NULL;
+	job.spheres = 0;
+	return Cull(&job, min->count < max->count ? min->count : max->count,
+			mask, indices);
+}
+
+unsigned int CullSpheres(const Frustum *frustum, VectorListSoA *spheres,
+		unsigned int *mask, unsigned int *indices)
+{
+	CullJob job;
+	job.frustum = frustum;
+	job.x0 = spheres->x;
+	job.y0 = spheres->y;
+	job.z0 = spheres->z;
+	job.x1 = job.y1 = job.z1 = NULL;
+	job.w = spheres->w;
+	job.spheres = 1;
+	return Cull(&job, spheres->count, mask, indices);
+}
@@ -0,0 +1,259 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <stdlib.h>
+#include <string.h>
+#include <ansic3d/hierarchy.h>
+#include <ansic3d/parallel.h>
+
+typedef struct _HierarchyJob
+{
+	TransformHierarchy *hierarchy;
+	unsigned int offset;
+} HierarchyJob;
+
+static void FreeBuild(unsigned int *child_start, unsigned int *children,
+		unsigned int *queue, unsigned int *remap)
+{
+	free(child_start);
+	free(children);
+	free(queue);
+	free(remap);
+}
+
+int BuildTransformHierarchy(TransformHierarchy *hierarchy,
+		const unsigned int *parents, const Matrix3D *locals, unsigned int n,
+		unsigned int *order)
+{
+	TransformHierarchy *h = hierarchy;
+	unsigned int *child_start, *children, *queue, *remap;
+	unsigned int i, j, p, head, tail, level_end, widest = 0;
+	memset(h, 0, sizeof(TransformHierarchy));
+	h->first_dirty = TRANSFORM_NONE;
+	if (n == 0)
+	{
+		return 0;
+	}
+	for (i = 0; i < n; i++)
+	{
+		if (parents[i] != TRANSFORM_NONE && parents[i] >= n)
+		{
+			return 0;
+		}
+	}
+	// Children of every node grouped by parent (counting sort)
+	child_start = calloc(n + 1, sizeof(unsigned int));
+	children = malloc(n * sizeof(unsigned int));
+	queue = malloc(n * sizeof(unsigned int));
+	remap = malloc(n * sizeof(unsigned int));
+	h->level_start = malloc((n + 1) * sizeof(unsigned int));
+	if (child_start == NULL || children == NULL || queue == NULL ||
+			remap == NULL || h->level_start == NULL)
+	{
+		FreeBuild(child_start, children, queue, remap);
+		FreeTransformHierarchy(h);
+		return 0;
+	}
+	for (i = 0; i < n; i++)
+	{
+		if (parents[i] != TRANSFORM_NONE)
+		{
+			child_start[parents[i] + 1]++;
+		}
+	}
+	for (i = 0; i < n; i++)
+	{
+		child_start[i + 1] += child_start[i];
+	}
+	for (i = 0; i < n; i++)
+	{
+		if (parents[i] != TRANSFORM_NONE)
+		{
+			children[child_start[parents[i]]++] = i;
+		}
+	}
+	for (i = n; i > 0; i--)
+	{
+		child_start[i] = child_start[i - 1];
+	}
+	child_start[0] = 0;
+
+	// Breadth first from the roots, a level ends where the queue ended
+	// when its first node was taken
+	tail = 0;
+	for (i = 0; i < n; i++)
+	{
+		if (parents[i] == TRANSFORM_NONE)
+		{
+			queue[tail++] = i;
+		}
+	}
+	h->level_start[0] = 0;
+	level_end = tail;
+	for (head = 0; head < tail; head++)
+	{
+		if (head == level_end)
+		{
+			h->level_start[++h->level_count] = head;
+			level_end = tail;
+		}
+		i = queue[head];
+		remap[i] = head;
+		for (j = child_start[i]; j < child_start[i + 1]; j++)
+		{
+			queue[tail++] = children[j];
+		}
+	}
+	h->level_start[++h->level_count] = tail;
+	if (tail < n)
+	{
+		// Nodes not reachable from a root are part of a cycle
+		FreeBuild(child_start, children, queue, remap);
+		FreeTransformHierarchy(h);
+		return 0;
+	}
+	for (i = 0; i < h->level_count; i++)
+	{
+		if (h->level_start[i + 1] - h->level_start[i] > widest)
+		{
+			widest = h->level_start[i + 1] - h->level_start[i];
+		}
+	}
+
+	h->parent = malloc(n * sizeof(unsigned int));
+	h->local = malloc(n * sizeof(Matrix3D));
+	h->world = malloc(n * sizeof(Matrix3D));
+	h->dirty = malloc(n);
+	h->partial = malloc((widest / MATRIX_ARRAY_GRAIN + 1) *
+			sizeof(unsigned int));
+	if (h->parent == NULL || h->local == NULL || h->world == NULL ||
+			h->dirty == NULL || h->partial == NULL)
+	{
+		FreeBuild(child_start, children, queue, remap);
+		FreeTransformHierarchy(h);
+		return 0;
+	}
+	for (j = 0; j < n; j++)
+	{
+		i = queue[j];
+		p = parents[i];
+		h->parent[j] = p == TRANSFORM_NONE ? TRANSFORM_NONE : remap[p];
+		h->local[j] = locals[i];
+		if (order != NULL)
+		{
+			order[j] = i;
+		}
+	}
+	memset(h->dirty, 1, n);
+	h->count = n;
+	h->first_dirty = 0;
+	FreeBuild(child_start, children, queue, remap);
+	return n;
+}
+
+void MarkTransformDirty(TransformHierarchy *hierarchy, unsigned int index)
+{
+	hierarchy->dirty[index] = 1;
+	if (hierarchy->first_dirty == TRANSFORM_NONE ||
+			index < hierarchy->first_dirty)
+	{
+		hierarchy->first_dirty = index;
+	}
+}
+
+void SetLocalTransform(TransformHierarchy *hierarchy, unsigned int index,
+		const Matrix3D *local)
+{
+	hierarchy->local[index] = *local;
+	MarkTransformDirty(hierarchy, index);
+}
+
+// A node is recomputed if it or its parent is dirty, it stays flagged so
+// its children see it on the next level
+static void UpdateRange(unsigned int begin, unsigned int end, void *context)
+{
+	HierarchyJob *job = context;
+	TransformHierarchy *h = job->hierarchy;
+	unsigned int k, i, p, count = 0;
+	for (k = begin; k < end; k++)
+	{
+		i = job->offset + k;
+		p = h->parent[i];
+		if (p == TRANSFORM_NONE)
+		{
+			if (!h->dirty[i])
+			{
+				continue;
+			}
+			h->world[i] = h->local[i];
+		}
+		else
+		{
+			if (!h->dirty[i] && !h->dirty[p])
+			{
+				continue;
+			}
+			h->dirty[i] = 1;
+			MultiplyMatrixRestrict(&h->local[i], &h->world[p], &h->world[i]);
+		}
+		count++;
+	}
+	h->partial[begin / MATRIX_ARRAY_GRAIN] = count;
+}
+
+unsigned int UpdateTransforms(TransformHierarchy *hierarchy)
+{
+	TransformHierarchy *h = hierarchy;
+	HierarchyJob job;
+	unsigned int level, n, chunks, k, total = 0;
+	if (h->first_dirty == TRANSFORM_NONE)
+	{
+		return 0;
+	}
+	// Parents come first, the levels before the first dirty node are clean
+	for (level = 0; h->level_start[level + 1] <= h->first_dirty; level++)
+	{
+	}
+	job.hierarchy = h;
+	for (; level < h->level_count; level++)
+	{
+		job.offset = h->level_start[level];
+		n = h->level_start[level + 1] - job.offset;
+		chunks = (n + MATRIX_ARRAY_GRAIN - 1) / MATRIX_ARRAY_GRAIN;
+		memset(h->partial, 0, chunks * sizeof(unsigned int));
+		ParallelFor(n, MATRIX_ARRAY_GRAIN, UpdateRange, &job);
+		for (k = 0; k < chunks; k++)
+		{
+			total += h->partial[k];
+		}
+	}
+	memset(h->dirty + h->first_dirty, 0, h->count - h->first_dirty);
+	h->first_dirty = TRANSFORM_NONE;
+	return total;
+}
+
+void FreeTransformHierarchy(TransformHierarchy *hierarchy)
+{
+	free(hierarchy->parent);
+	free(hierarchy->local);
+	free(hierarchy->world);
+	free(hierarchy->dirty);
+	free(hierarchy->level_start);
+	free(hierarchy->partial);
+	memset(hierarchy, 0, sizeof(TransformHierarchy));
+	hierarchy->first_dirty = TRANSFORM_NONE;
+}
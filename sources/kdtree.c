@@ -0,0 +1,490 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <math.h>
+#include <stdlib.h>
+#include <ansic3d/kdtree.h>
+#include <ansic3d/parallel.h>
+#include <ansic3d/inline.h>
+
+/**
+ * Subtrees of at most this many points are built by a single thread
+ */
+#define KDTREE_MIN_JOB 4096
+
+/**
+ * Queries per chunk of KDTreeNearestBatch
+ */
+#define KDTREE_BATCH_GRAIN 256
+
+typedef struct _KDBuildJob
+{
+	unsigned int node;
+	unsigned int begin;
+	unsigned int end;
+} KDBuildJob;
+
+typedef struct _KDBuild
+{
+	KDTree *tree;
+	const Vector3D *points;
+	KDBuildJob *jobs;
+	unsigned int job_count;
+	unsigned int job_size;
+} KDBuild;
+
+typedef struct _KDStackEntry
+{
+	unsigned int node;
+	float bound;
+} KDStackEntry;
+
+#define COORD(v, axis) (((const float *) &(v)->x)[axis])
+
+// Node count of a subtree over n points, the same split rule as BuildNode
+static unsigned int KDNodeCount(unsigned int n)
+{
+	if (n <= KDTREE_LEAF_SIZE)
+	{
+		return 1;
+	}
+	return 1 + KDNodeCount(n / 2) + KDNodeCount(n - n / 2);
+}
+
+static int WidestAxis(KDBuild *b, unsigned int begin, unsigned int end)
+{
+	Vector3D min, max;
+	const Vector3D *v;
+	unsigned int i;
+	min = max = b->points[b->tree->indices[begin]];
+	for (i = begin + 1; i < end; i++)
+	{
+		v = &b->points[b->tree->indices[i]];
+		min.x = v->x < min.x ? v->x : min.x;
+		min.y = v->y < min.y ? v->y : min.y;
+		min.z = v->z < min.z ? v->z : min.z;
+		max.x = v->x > max.x ? v->x : max.x;
+		max.y = v->y > max.y ? v->y : max.y;
+		max.z = v->z > max.z ? v->z : max.z;
+	}
+	max.x -= min.x;
+	max.y -= min.y;
+	max.z -= min.z;
+	if (max.x >= max.y && max.x >= max.z)
+	{
+		return 0;
+	}
+	return max.y >= max.z ? 1 : 2;
+}
+
+// Reorder indices [begin, end) so the nth is in its sorted place along
+// axis, with the smaller ones before and the larger ones after it
+static void SelectNth(KDBuild *b, unsigned int begin, unsigned int end,
+		unsigned int nth, int axis)
+{
+	unsigned int *idx = b->tree->indices;
+	unsigned int lo = begin, hi = end - 1, i, j, t;
+	float pivot, a, c, m;
+	while (hi > lo)
+	{
+		// Median of three pivot
+		a = COORD(&b->points[idx[lo]], axis);
+		m = COORD(&b->points[idx[lo + (hi - lo) / 2]], axis);
+		c = COORD(&b->points[idx[hi]], axis);
+		pivot = a < m ? (m < c ? m : (a < c ? c : a)) :
+			(a < c ? a : (m < c ? c : m));
+		i = lo;
+		j = hi;
+		while (i <= j)
+		{
+			while (COORD(&b->points[idx[i]], axis) < pivot)
+			{
+				i++;
+			}
+			while (COORD(&b->points[idx[j]], axis) > pivot)
+			{
+				j--;
+			}
+			if (i <= j)
+			{
+				t = idx[i];
+				idx[i] = idx[j];
+				idx[j] = t;
+				i++;
+				if (j == 0)
+				{
+					break;
+				}
+				j--;
+			}
+		}
+		if (nth <= j)
+		{
+			hi = j;
+		}
+		else if (nth >= i)
+		{
+			lo = i;
+		}
+		else
+		{
+			return;
+		}
+	}
+}
+
+static void BuildNode(KDBuild *b, unsigned int node, unsigned int begin,
+		unsigned int end)
+{
+	KDNode *n = &b->tree->nodes[node];
+	unsigned int mid;
+	int axis;
+	// Small enough subtrees are left to the parallel pass
+	if (b->jobs != NULL && end - begin <= b->job_size)
+	{
+		b->jobs[b->job_count].node = node;
+		b->jobs[b->job_count].begin = begin;
+		b->jobs[b->job_count].end = end;
+		b->job_count++;
+		return;
+	}
+	n->begin = begin;
+	n->end = end;
+	if (end - begin <= KDTREE_LEAF_SIZE)
+	{
+		n->split = 0;
+		n->axis = 0;
+		n->right = 0;
+		return;
+	}
+	axis = WidestAxis(b, begin, end);
+	mid = begin + (end - begin) / 2;
+	SelectNth(b, begin, end, mid, axis);
+	n->axis = axis;
+	n->split = COORD(&b->points[b->tree->indices[mid]], axis);
+	n->right = node + 1 + KDNodeCount(mid - begin);
+	BuildNode(b, node + 1, begin, mid);
+	BuildNode(b, n->right, mid, end);
+}
+
+static void BuildJobs(unsigned int begin, unsigned int end, void *context)
+{
+	KDBuild b = *(KDBuild *) context;
+	unsigned int i;
+	KDBuildJob *job;
+	b.jobs = NULL;
+	for (i = begin; i < end; i++)
+	{
+		job = &((KDBuild *) context)->jobs[i];
+		BuildNode(&b, job->node, job->begin, job->end);
+	}
+}
+
+int BuildKDTree(VectorList *list, KDTree *tree)
+{
+	KDBuild b;
+	unsigned int i, threads;
+	tree->count = list->count;
+	tree->node_count = KDNodeCount(list->count);
+	tree->nodes = malloc(tree->node_count * sizeof(KDNode));
+	tree->points = malloc(list->count * sizeof(Vector3D));
+	tree->indices = malloc(list->count * sizeof(unsigned int));
+	if (list->count == 0 || tree->nodes == NULL || tree->points == NULL ||
+			tree->indices == NULL)
+	{
+		FreeKDTree(tree);
+		return 0;
+	}
+	for (i = 0; i < list->count; i++)
+	{
+		tree->indices[i] = i;
+	}
+	b.tree = tree;
+	b.points = list->vectors;
+	b.job_count = 0;
+	b.jobs = NULL;
+	// The top of the tree is split on this thread, the subtrees below
+	// job_size points are spread over the pool
+	threads = GetThreadCount();
+	b.job_size = list->count / (threads * 4);
+	if (threads > 1 && b.job_size >= KDTREE_MIN_JOB)
+	{
+		b.jobs = malloc((2 * (list->count / b.job_size) + 2) *
+				sizeof(KDBuildJob));
+	}
+	BuildNode(&b, 0, 0, list->count);
+	if (b.jobs != NULL)
+	{
+		ParallelFor(b.job_count, 1, BuildJobs, &b);
+		free(b.jobs);
+	}
+	for (i = 0; i < list->count; i++)
+	{
+		tree->points[i] = list->vectors[tree->indices[i]];
+	}
+	return tree->count;
+}
+
+void FreeKDTree(KDTree *tree)
+{
+	free(tree->nodes);
+	free(tree->points);
+	free(tree->indices);
+	tree->nodes = NULL;
+	tree->points = NULL;
+	tree->indices = NULL;
+	tree->count = 0;
+	tree->node_count = 0;
+}
+
+// (d1, i1) > (d2, i2), farther first then higher index
+static int HitAfter(float d1, unsigned int i1, float d2, unsigned int i2)
+{
+	return d1 > d2 || (d1 == d2 && i1 > i2);
+}
+
+// Max heap of n hits with the farthest at 0
+static void SiftDown(unsigned int *indices, float *distances, unsigned int n,
+		unsigned int i)
+{
+	unsigned int child, ti;
+	float td;
+	for (;;)
+	{
+		child = 2 * i + 1;
+		if (child >= n)
+		{
+			return;
+		}
+		if (child + 1 < n && HitAfter(distances[child + 1],
+					indices[child + 1], distances[child], indices[child]))
+		{
+			child++;
+		}
+		if (!HitAfter(distances[child], indices[child], distances[i],
+					indices[i]))
+		{
+			return;
+		}
+		td = distances[i];
+		ti = indices[i];
+		distances[i] = distances[child];
+		indices[i] = indices[child];
+		distances[child] = td;
+		indices[child] = ti;
+		i = child;
+	}
+}
+
+static void SiftUp(unsigned int *indices, float *distances, unsigned int i)
+{
+	unsigned int parent, ti;
+	float td;
+	while (i > 0)
+	{
+		parent = (i - 1) / 2;
+		if (!HitAfter(distances[i], indices[i], distances[parent],
+					indices[parent]))
+		{
+			return;
+		}
+		td = distances[i];
+		ti = indices[i];
+		distances[i] = distances[parent];
+		indices[i] = indices[parent];
+		distances[parent] = td;
+		indices[parent] = ti;
+		i = parent;
+	}
+}
+
+unsigned int KDTreeNearest(KDTree *tree, Vector3D query, unsigned int k,
+		unsigned int *indices, float *distances)
+{
+	KDStackEntry stack[KDTREE_MAX_DEPTH];
+	const KDNode *node;
+	unsigned int top = 0, found = 0, i, near, far, ti;
+	float diff, d, td;
+
+	if (k == 0 || tree->count == 0)
+	{
+		return 0;
+	}
+	stack[top].node = 0;
+	stack[top].bound = 0;
+	top++;
+	while (top > 0)
+	{
+		top--;
+		if (found == k && stack[top].bound > distances[0])
+		{
+			continue;
+		}
+		node = &tree->nodes[stack[top].node];
+		// Down to the leaf on the query side, the other sides are kept
+		// with the squared distance to their split plane
+		while (node->right != 0)
+		{
+			diff = COORD(&query, node->axis) - node->split;
+			near = node - tree->nodes + 1;
+			far = node->right;
+			if (diff >= 0)
+			{
+				far = near;
+				near = node->right;
+			}
+			stack[top].node = far;
+			stack[top].bound = diff * diff;
+			top++;
+			node = &tree->nodes[near];
+		}
+		for (i = node->begin; i < node->end; i++)
+		{
+			d = VectorDistanceSquaredInline(&tree->points[i], &query);
+			if (found < k)
+			{
+				distances[found] = d;
+				indices[found] = tree->indices[i];
+				SiftUp(indices, distances, found);
+				found++;
+			}
+			else if (HitAfter(distances[0], indices[0], d, tree->indices[i]))
+			{
+				distances[0] = d;
+				indices[0] = tree->indices[i];
+				SiftDown(indices, distances, found, 0);
+			}
+		}
+	}
+	// Heap sort, nearest first
+	for (i = found; i > 1; i--)
+	{
+		td = distances[0];
+		ti = indices[0];
+		distances[0] = distances[i - 1];
+		indices[0] = indices[i - 1];
+		distances[i - 1] = td;
+		indices[i - 1] = ti;
+		SiftDown(indices, distances, i - 1, 0);
+	}
+	return found;
+}
+
+unsigned int KDTreeRadius(KDTree *tree, Vector3D query, float radius,
+		unsigned int *indices, float *distances, unsigned int max)
+{
+	KDStackEntry stack[KDTREE_MAX_DEPTH];
+	const KDNode *node;
+	unsigned int top = 0, found = 0, i, near, far;
+	float diff, d, r2 = radius * radius;
+
+	if (tree->count == 0)
+	{
+		return 0;
+	}
+	stack[top].node = 0;
+	stack[top].bound = 0;
+	top++;
+	while (top > 0)
+	{
+		top--;
+		if (stack[top].bound > r2)
+		{
+			continue;
+		}
+		node = &tree->nodes[stack[top].node];
+		while (node->right != 0)
+		{
+			diff = COORD(&query, node->axis) - node->split;
+			near = node - tree->nodes + 1;
+			far = node->right;
+			if (diff >= 0)
+			{
+				far = near;
+				near = node->right;
+			}
+			if (diff * diff <= r2)
+			{
+				stack[top].node = far;
+				stack[top].bound = diff * diff;
+				top++;
+			}
+			node = &tree->nodes[near];
+		}
+		for (i = node->begin; i < node->end; i++)
+		{
+			d = VectorDistanceSquaredInline(&tree->points[i], &query);
+			if (d > r2)
+			{
+				continue;
+			}
+			if (found < max)
+			{
+				indices[found] = tree->indices[i];
+				if (distances != NULL)
+				{
+					distances[found] = d;
+				}
+			}
+			found++;
+		}
+	}
+	return found;
+}
+
+typedef struct _KDBatchJob
+{
+	KDTree *tree;
+	const Vector3D *queries;
+	unsigned int k;
+	unsigned int *indices;
+	float *distances;
+} KDBatchJob;
+
+static void NearestBatchRange(unsigned int begin, unsigned int end,
+		void *context)
+{
+	KDBatchJob *job = context;
+	unsigned int i, j, found;
+	unsigned int *indices;
+	float *distances;
+	for (i = begin; i < end; i++)
+	{
+		indices = &job->indices[(size_t) i * job->k];
+		distances = &job->distances[(size_t) i * job->k];
+		found = KDTreeNearest(job->tree, job->queries[i], job->k, indices,
+				distances);
+		for (j = found; j < job->k; j++)
+		{
+			indices[j] = KDTREE_NONE;
+			distances[j] = INFINITY;
+		}
+	}
+}
+
+void KDTreeNearestBatch(KDTree *tree, const Vector3D *queries,
+		unsigned int n, unsigned int k, unsigned int *indices,
+		float *distances)
+{
+	KDBatchJob job;
+	job.tree = tree;
+	job.queries = queries;
+	job.k = k;
+	job.indices = indices;
+	job.distances = distances;
+	ParallelFor(n, KDTREE_BATCH_GRAIN, NearestBatchRange, &job);
+}
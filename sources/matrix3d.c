@@ -17,21 +17,23 @@
    */
 #include <ansic3d/vector3d.h>
 #include <ansic3d/matrix3d.h>
+#include <ansic3d/cpu.h>
+#include <ansic3d/parallel.h>
+#include <ansic3d/trig.h>
+#include <ansic3d/inline.h>
+
+#ifdef ANSIC3D_X86_SIMD
+#include <immintrin.h>
+#endif
 
 void HomogeneousMatrix(Matrix3D *matrix)
 {
-	SetVector(1, 0, 0, 0, &matrix->X);
-	SetVector(0, 1, 0, 0, &matrix->Y);
-	SetVector(0, 0, 1, 0, &matrix->Z);
-	SetVector(0, 0, 0, 1, &matrix->W);
+	HomogeneousMatrixInline(matrix);
 }
 
 void EmptyMatrix(Matrix3D *matrix)
 {
-	SetVector(0, 0, 0, 0, &matrix->X);
-	SetVector(0, 0, 0, 0, &matrix->Y);
-	SetVector(0, 0, 0, 0, &matrix->Z);
-	SetVector(0, 0, 0, 0, &matrix->W);
+	EmptyMatrixInline(matrix);
 }
 
 void CreateScaleMatrix(Vector3D v, Matrix3D *target)
@@ -53,77 +55,49 @@ void CreateTranslationMatrix(Vector3D v, Matrix3D *target)
 void CreateScaleAndTranslationMatrix(Vector3D scale, Vector3D offset,
 		Matrix3D *target)
 {
-	HomogeneousMatrix(target);
-	target->X.x = scale.x;
-	target->Y.y = scale.y;
-	target->Z.z = scale.z;
-	target->W.x = offset.x;
-	target->W.y = offset.y;
-	target->W.z = offset.z;
+	CreateScaleAndTranslationMatrixInline(&scale, &offset, target);
 }
 
 void CreateRotationMatrixXSinCos(float sin, float cos, Matrix3D *target)
 {
-	EmptyMatrix(target);
-	target->X.x = 1;
-	target->Y.y = cos;
-	target->Y.z = sin;
-	target->Z.y = -1 * sin;
-	target->Z.z = cos;
-	target->W.w = 1;
+	CreateRotationMatrixXSinCosInline(sin, cos, target);
 }
 
 void CreateRotationMatrixX(float angle, Matrix3D *target)
 {
 	float c, s;
-	c = cosf(angle);
-	s = sinf(angle);
+	SinCos(angle, &s, &c);
 	CreateRotationMatrixXSinCos(s, c, target);
 }
 
 void CreateRotationMatrixYSinCos(float sin, float cos, Matrix3D *target)
 {
-	EmptyMatrix(target);
-	target->X.x = cos;
-	target->X.z = -1 * sin;
-	target->Y.y = 1;
-	target->Z.x = sin;
-	target->Z.z = cos;
-	target->W.w = 1;
+	CreateRotationMatrixYSinCosInline(sin, cos, target);
 }
 
 void CreateRotationMatrixY(float angle, Matrix3D *target)
 {
 	float c, s;
-	c = cosf(angle);
-	s = sinf(angle);
+	SinCos(angle, &s, &c);
 	CreateRotationMatrixYSinCos(s, c, target);
 }
 
 void CreateRotationMatrixZSinCos(float sin, float cos, Matrix3D *target)
 {
-	EmptyMatrix(target);
-	target->X.x = cos;
-	target->X.y = sin;
-	target->Y.x = -1 * sin;
-	target->Y.y = cos;
-	target->Z.z = 1;
-	target->W.w = 1;
+	CreateRotationMatrixZSinCosInline(sin, cos, target);
 }
 
 void CreateRotationMatrixZ(float angle, Matrix3D *target)
 {
 	float c, s;
-	c = cosf(angle);
-	s = sinf(angle);
+	SinCos(angle, &s, &c);
 	CreateRotationMatrixZSinCos(s, c, target);
 }
 
 void CreateRotationMatrix(Vector3D axis, float angle, Matrix3D *target)
 {
 	float cosine, sine, one_minus_cos;
-	sine = sinf(angle);
-	cosine = cosf(angle);
+	SinCos(angle, &sine, &cosine);
 	NormalizeVector(&axis);
 	one_minus_cos = 1 - cosine;
 
@@ -148,78 +122,378 @@ void CreateRotationMatrix(Vector3D axis, float angle, Matrix3D *target)
 	target->W.w = 1;
 }
 
-void MultiplyMatrix(Matrix3D *m1, Matrix3D *m2, Matrix3D *target)
+static void MultiplyMatrixScalar(const Matrix3D *ANSIC3D_RESTRICT m1,
+		const Matrix3D *ANSIC3D_RESTRICT m2,
+		Matrix3D *ANSIC3D_RESTRICT target)
 {
-	target->X.x = (m1->X.x * m2->X.x + m1->X.y * m2->Y.x +
-			m1->X.z * m2->Z.x + m1->X.w * m2->W.x);
-	target->X.y = (m1->X.x * m2->X.y + m1->X.y * m2->Y.y +
-			m1->X.z * m2->Z.y + m1->X.w * m2->W.y);
-	target->X.z = (m1->X.x * m2->X.z + m1->X.y * m2->Y.z +
-			m1->X.z * m2->Z.z + m1->X.w * m2->W.z);
-	target->X.w = (m1->X.x * m2->X.w + m1->X.y * m2->Y.w +
-			m1->X.z * m2->Z.w + m1->X.w * m2->W.w);
-	target->Y.x = (m1->Y.x * m2->X.x + m1->Y.y * m2->Y.x +
-			m1->Y.z * m2->Z.x + m1->Y.w * m2->W.x);
-	target->Y.y = (m1->Y.x * m2->X.y + m1->Y.y * m2->Y.y +
-			m1->Y.z * m2->Z.y + m1->Y.w * m2->W.y);
-	target->Y.z = (m1->Y.x * m2->X.z + m1->Y.y * m2->Y.z +
-			m1->Y.z * m2->Z.z + m1->Y.w * m2->W.z);
-	target->Y.w = (m1->Y.x * m2->X.w + m1->Y.y * m2->Y.w +
-			m1->Y.z * m2->Z.w + m1->Y.w * m2->W.w);
-	target->Z.x = (m1->Z.x * m2->X.x + m1->Z.y * m2->Y.x +
-			m1->Z.z * m2->Z.x + m1->Z.w * m2->W.x);
-	target->Z.y = (m1->Z.x * m2->X.y + m1->Z.y * m2->Y.y +
-			m1->Z.z * m2->Z.y + m1->Z.w * m2->W.y);
-	target->Z.z = (m1->Z.x * m2->X.z + m1->Z.y * m2->Y.z +
-			m1->Z.z * m2->Z.z + m1->Z.w * m2->W.z);
-	target->Z.w = (m1->Z.x * m2->X.w + m1->Z.y * m2->Y.w +
-			m1->Z.z * m2->Z.w + m1->Z.w * m2->W.w);
-	target->W.x = (m1->W.x * m2->X.x + m1->W.y * m2->Y.x +
-			m1->W.z * m2->Z.x + m1->W.w * m2->W.x);
-	target->W.y = (m1->W.x * m2->X.y + m1->W.y * m2->Y.y +
-			m1->W.z * m2->Z.y + m1->W.w * m2->W.y);
-	target->W.z = (m1->W.x * m2->X.z + m1->W.y * m2->Y.z +
-			m1->W.z * m2->Z.z + m1->W.w * m2->W.z);
-	target->W.w = (m1->W.x * m2->X.w + m1->W.y * m2->Y.w +
-			m1->W.z * m2->Z.w + m1->W.w * m2->W.w);
+	MultiplyMatrixInline(m1, m2, target);
 }
 
 void VectorTransform(Matrix3D *matrix, Vector3D *target)
 {
-	Vector3D org;
-	org.x = target->x;
-	org.y = target->y;
-	org.z = target->z;
-	org.w = target->w;
-	target->x = org.x * matrix->X.x + org.y * matrix->Y.x + org.z * matrix->Z.x + org.w * matrix->W.x;
-	target->y = org.x * matrix->X.y + org.y * matrix->Y.y + org.z * matrix->Z.y + org.w * matrix->W.y;
-	target->z = org.x * matrix->X.z + org.y * matrix->Y.z + org.z * matrix->Z.z + org.w * matrix->W.z;
-	target->w = org.x * matrix->X.w + org.y * matrix->Y.w + org.z * matrix->Z.w + org.w * matrix->W.w;
+	Vector3D org = *target;
+	VectorTransformInline(matrix, &org, target);
+}
+
+static void TransformVectorsScalar(Matrix3D *matrix, const Vector3D *src,
+		Vector3D *dst, unsigned int n)
+{
+	unsigned int i;
+	float x, y, z, w;
+	Matrix3D m = *matrix;
+	for (i = 0; i < n; i++)
+	{
+		x = src[i].x;
+		y = src[i].y;
+		z = src[i].z;
+		w = src[i].w;
+		dst[i].x = x * m.X.x + y * m.Y.x + z * m.Z.x + w * m.W.x;
+		dst[i].y = x * m.X.y + y * m.Y.y + z * m.Z.y + w * m.W.y;
+		dst[i].z = x * m.X.z + y * m.Y.z + z * m.Z.z + w * m.W.z;
+		dst[i].w = x * m.X.w + y * m.Y.w + z * m.Z.w + w * m.W.w;
+	}
+}
+
+#ifdef ANSIC3D_X86_SIMD
+// One vector per __m128, each component is broadcast and multiplied with
+// the matching matrix row.
+__attribute__((target("sse2")))
+static __m128 TransformSSE(__m128 v, __m128 r0, __m128 r1, __m128 r2,
+		__m128 r3)
+{
+	__m128 t;
+	t = _mm_mul_ps(_mm_shuffle_ps(v, v, 0x00), r0);
+	t = _mm_add_ps(t, _mm_mul_ps(_mm_shuffle_ps(v, v, 0x55), r1));
+	t = _mm_add_ps(t, _mm_mul_ps(_mm_shuffle_ps(v, v, 0xAA), r2));
+	return _mm_add_ps(t, _mm_mul_ps(_mm_shuffle_ps(v, v, 0xFF), r3));
+}
+
+__attribute__((target("sse2")))
+static void TransformVectorsSSE(Matrix3D *matrix, const Vector3D *src,
+		Vector3D *dst, unsigned int n)
+{
+	unsigned int i;
+	__m128 r0, r1, r2, r3, a, b, c, d;
+	r0 = _mm_loadu_ps(&matrix->X.x);
+	r1 = _mm_loadu_ps(&matrix->Y.x);
+	r2 = _mm_loadu_ps(&matrix->Z.x);
+	r3 = _mm_loadu_ps(&matrix->W.x);
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		a = _mm_loadu_ps(&src[i].x);
+		b = _mm_loadu_ps(&src[i + 1].x);
+		c = _mm_loadu_ps(&src[i + 2].x);
+		d = _mm_loadu_ps(&src[i + 3].x);
+		_mm_storeu_ps(&dst[i].x, TransformSSE(a, r0, r1, r2, r3));
+		_mm_storeu_ps(&dst[i + 1].x, TransformSSE(b, r0, r1, r2, r3));
+		_mm_storeu_ps(&dst[i + 2].x, TransformSSE(c, r0, r1, r2, r3));
+		_mm_storeu_ps(&dst[i + 3].x, TransformSSE(d, r0, r1, r2, r3));
+	}
+	for (; i < n; i++)
+	{
+		a = _mm_loadu_ps(&src[i].x);
+		_mm_storeu_ps(&dst[i].x, TransformSSE(a, r0, r1, r2, r3));
+	}
+}
+
+// Two vectors per __m256, the matrix rows are duplicated in both lanes.
+__attribute__((target("avx2,fma")))
+static __m256 TransformAVX2(__m256 v, __m256 r0, __m256 r1, __m256 r2,
+		__m256 r3)
+{
+	__m256 t;
+	t = _mm256_mul_ps(_mm256_permute_ps(v, 0x00), r0);
+	t = _mm256_fmadd_ps(_mm256_permute_ps(v, 0x55), r1, t);
+	t = _mm256_fmadd_ps(_mm256_permute_ps(v, 0xAA), r2, t);
+	return _mm256_fmadd_ps(_mm256_permute_ps(v, 0xFF), r3, t);
+}
+
+__attribute__((target("avx2,fma")))
+static void TransformVectorsAVX2(Matrix3D *matrix, const Vector3D *src,
+		Vector3D *dst, unsigned int n)
+{
+	unsigned int i;
+	__m256 r0, r1, r2, r3, a, b, c, d;
+	r0 = _mm256_broadcast_ps((const __m128 *)&matrix->X);
+	r1 = _mm256_broadcast_ps((const __m128 *)&matrix->Y);
+	r2 = _mm256_broadcast_ps((const __m128 *)&matrix->Z);
+	r3 = _mm256_broadcast_ps((const __m128 *)&matrix->W);
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		a = _mm256_loadu_ps(&src[i].x);
+		b = _mm256_loadu_ps(&src[i + 2].x);
+		c = _mm256_loadu_ps(&src[i + 4].x);
+		d = _mm256_loadu_ps(&src[i + 6].x);
+		_mm256_storeu_ps(&dst[i].x, TransformAVX2(a, r0, r1, r2, r3));
+		_mm256_storeu_ps(&dst[i + 2].x, TransformAVX2(b, r0, r1, r2, r3));
+		_mm256_storeu_ps(&dst[i + 4].x, TransformAVX2(c, r0, r1, r2, r3));
+		_mm256_storeu_ps(&dst[i + 6].x, TransformAVX2(d, r0, r1, r2, r3));
+	}
+	for (; i + 2 <= n; i += 2)
+	{
+		a = _mm256_loadu_ps(&src[i].x);
+		_mm256_storeu_ps(&dst[i].x, TransformAVX2(a, r0, r1, r2, r3));
+	}
+	// Without -O GCC leaves the upper halves dirty, which makes every later
+	// SSE instruction (libm included) pay an AVX-SSE transition
+	_mm256_zeroupper();
+	if (i < n)
+	{
+		TransformVectorsScalar(matrix, &src[i], &dst[i], n - i);
+	}
+}
+#endif
+
+void TransformVectors(Matrix3D *matrix, const Vector3D *src, Vector3D *dst,
+		unsigned int n)
+{
+#ifdef ANSIC3D_X86_SIMD
+	int level = GetSIMDLevel();
+	if (level >= SIMD_AVX2)
+	{
+		TransformVectorsAVX2(matrix, src, dst, n);
+		return;
+	}
+	if (level >= SIMD_SSE)
+	{
+		TransformVectorsSSE(matrix, src, dst, n);
+		return;
+	}
+#endif
+	TransformVectorsScalar(matrix, src, dst, n);
+}
+
+#ifdef ANSIC3D_X86_SIMD
+// Row i of the result is m1[i].x * m2.X + m1[i].y * m2.Y + m1[i].z * m2.Z +
+// m1[i].w * m2.W. All rows are loaded before anything is stored so target
+// may overlap m1 or m2. SSE4.1 has nothing to add over SSE2 here (dpps is
+// slower than broadcast and multiply) so the SSE kernel serves both.
+__attribute__((target("sse2")))
+static void MultiplyMatrixSSE(const Matrix3D *m1, const Matrix3D *m2,
+		Matrix3D *target)
+{
+	__m128 b0, b1, b2, b3, t0, t1, t2, t3;
+	b0 = _mm_loadu_ps(&m2->X.x);
+	b1 = _mm_loadu_ps(&m2->Y.x);
+	b2 = _mm_loadu_ps(&m2->Z.x);
+	b3 = _mm_loadu_ps(&m2->W.x);
+	t0 = TransformSSE(_mm_loadu_ps(&m1->X.x), b0, b1, b2, b3);
+	t1 = TransformSSE(_mm_loadu_ps(&m1->Y.x), b0, b1, b2, b3);
+	t2 = TransformSSE(_mm_loadu_ps(&m1->Z.x), b0, b1, b2, b3);
+	t3 = TransformSSE(_mm_loadu_ps(&m1->W.x), b0, b1, b2, b3);
+	_mm_storeu_ps(&target->X.x, t0);
+	_mm_storeu_ps(&target->Y.x, t1);
+	_mm_storeu_ps(&target->Z.x, t2);
+	_mm_storeu_ps(&target->W.x, t3);
+}
+
+// Two rows per __m256, m2 rows are duplicated in both lanes
+__attribute__((target("avx")))
+static void MultiplyMatrixAVX(const Matrix3D *m1, const Matrix3D *m2,
+		Matrix3D *target)
+{
+	__m256 b0, b1, b2, b3, a01, a23, t01, t23;
+	b0 = _mm256_broadcast_ps((const __m128 *)&m2->X);
+	b1 = _mm256_broadcast_ps((const __m128 *)&m2->Y);
+	b2 = _mm256_broadcast_ps((const __m128 *)&m2->Z);
+	b3 = _mm256_broadcast_ps((const __m128 *)&m2->W);
+	a01 = _mm256_loadu_ps(&m1->X.x);
+	a23 = _mm256_loadu_ps(&m1->Z.x);
+	t01 = _mm256_add_ps(
+			_mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(a01, 0x00), b0),
+				_mm256_mul_ps(_mm256_permute_ps(a01, 0x55), b1)),
+			_mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(a01, 0xAA), b2),
+				_mm256_mul_ps(_mm256_permute_ps(a01, 0xFF), b3)));
+	t23 = _mm256_add_ps(
+			_mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(a23, 0x00), b0),
+				_mm256_mul_ps(_mm256_permute_ps(a23, 0x55), b1)),
+			_mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(a23, 0xAA), b2),
+				_mm256_mul_ps(_mm256_permute_ps(a23, 0xFF), b3)));
+	_mm256_storeu_ps(&target->X.x, t01);
+	_mm256_storeu_ps(&target->Z.x, t23);
+	_mm256_zeroupper();
+}
+
+__attribute__((target("avx,fma")))
+static void MultiplyMatrixFMA(const Matrix3D *m1, const Matrix3D *m2,
+		Matrix3D *target)
+{
+	__m256 b0, b1, b2, b3, a01, a23, t01, t23;
+	b0 = _mm256_broadcast_ps((const __m128 *)&m2->X);
+	b1 = _mm256_broadcast_ps((const __m128 *)&m2->Y);
+	b2 = _mm256_broadcast_ps((const __m128 *)&m2->Z);
+	b3 = _mm256_broadcast_ps((const __m128 *)&m2->W);
+	a01 = _mm256_loadu_ps(&m1->X.x);
+	a23 = _mm256_loadu_ps(&m1->Z.x);
+	t01 = _mm256_mul_ps(_mm256_permute_ps(a01, 0x00), b0);
+	t23 = _mm256_mul_ps(_mm256_permute_ps(a23, 0x00), b0);
+	t01 = _mm256_fmadd_ps(_mm256_permute_ps(a01, 0x55), b1, t01);
+	t23 = _mm256_fmadd_ps(_mm256_permute_ps(a23, 0x55), b1, t23);
+	t01 = _mm256_fmadd_ps(_mm256_permute_ps(a01, 0xAA), b2, t01);
+	t23 = _mm256_fmadd_ps(_mm256_permute_ps(a23, 0xAA), b2, t23);
+	t01 = _mm256_fmadd_ps(_mm256_permute_ps(a01, 0xFF), b3, t01);
+	t23 = _mm256_fmadd_ps(_mm256_permute_ps(a23, 0xFF), b3, t23);
+	_mm256_storeu_ps(&target->X.x, t01);
+	_mm256_storeu_ps(&target->Z.x, t23);
+	_mm256_zeroupper();
+}
+#endif
+
+typedef void (*MultiplyMatrixKernel)(const Matrix3D *m1, const Matrix3D *m2,
+		Matrix3D *target);
+
+// Scalar kernel working on copies, safe when target overlaps m1 or m2
+static void MultiplyMatrixCopy(const Matrix3D *m1, const Matrix3D *m2,
+		Matrix3D *target)
+{
+	Matrix3D a, b;
+	a = *m1;
+	b = *m2;
+	MultiplyMatrixScalar(&a, &b, target);
+}
+
+// Widest SIMD kernel for the current level, NULL if scalar
+static MultiplyMatrixKernel SelectMultiplyKernel(void)
+{
+#ifdef ANSIC3D_X86_SIMD
+	int level = GetSIMDLevel();
+	if (level >= SIMD_AVX2)
+	{
+		return MultiplyMatrixFMA;
+	}
+	if (level >= SIMD_AVX)
+	{
+		return MultiplyMatrixAVX;
+	}
+	if (level >= SIMD_SSE)
+	{
+		return MultiplyMatrixSSE;
+	}
+#endif
+	return NULL;
+}
+
+void MultiplyMatrix(Matrix3D *m1, Matrix3D *m2, Matrix3D *target)
+{
+	MultiplyMatrixKernel kernel = SelectMultiplyKernel();
+	if (kernel == NULL)
+	{
+		kernel = MultiplyMatrixCopy;
+	}
+	kernel(m1, m2, target);
+}
+
+void MultiplyMatrixRestrict(const Matrix3D *ANSIC3D_RESTRICT m1,
+		const Matrix3D *ANSIC3D_RESTRICT m2,
+		Matrix3D *ANSIC3D_RESTRICT target)
+{
+	MultiplyMatrixKernel kernel = SelectMultiplyKernel();
+	if (kernel == NULL)
+	{
+		MultiplyMatrixScalar(m1, m2, target);
+		return;
+	}
+	kernel(m1, m2, target);
+}
+
+typedef struct _MatrixArrayJob
+{
+	MultiplyMatrixKernel kernel;
+	const Matrix3D *a;
+	const Matrix3D *b;
+	Matrix3D *out;
+	// 1 to walk the array, 0 to use the same matrix for every item
+	unsigned int a_step;
+	unsigned int b_step;
+} MatrixArrayJob;
+
+static void MultiplyMatrixRange(unsigned int begin, unsigned int end,
+		void *context)
+{
+	MatrixArrayJob *job = context;
+	unsigned int i;
+	for (i = begin; i < end; i++)
+	{
+		job->kernel(&job->a[i * job->a_step], &job->b[i * job->b_step],
+				&job->out[i]);
+	}
+}
+
+static void MultiplyMatrixJob(const Matrix3D *a, unsigned int a_step,
+		const Matrix3D *b, unsigned int b_step, Matrix3D *out,
+		unsigned int n)
+{
+	MatrixArrayJob job;
+	job.kernel = SelectMultiplyKernel();
+	if (job.kernel == NULL)
+	{
+		job.kernel = MultiplyMatrixCopy;
+	}
+	job.a = a;
+	job.b = b;
+	job.out = out;
+	job.a_step = a_step;
+	job.b_step = b_step;
+	ParallelFor(n, MATRIX_ARRAY_GRAIN, MultiplyMatrixRange, &job);
+}
+
+void MultiplyMatrixArray(const Matrix3D *a, const Matrix3D *b, Matrix3D *out,
+		unsigned int n)
+{
+	MultiplyMatrixJob(a, 1, b, 1, out, n);
+}
+
+void MultiplyMatrixBroadcastLeft(const Matrix3D *m, const Matrix3D *b,
+		Matrix3D *out, unsigned int n)
+{
+	MultiplyMatrixJob(m, 0, b, 1, out, n);
+}
+
+typedef struct _TransformJob
+{
+	Matrix3D *matrix;
+	const Vector3D *src;
+	Vector3D *dst;
+} TransformJob;
+
+// Matrices begin to end, 4 rows each. The rows are transformed in grain
+// sized steps so their count stays within unsigned int for any n.
+static void TransformRowsRange(unsigned int begin, unsigned int end,
+		void *context)
+{
+	TransformJob *job = context;
+	unsigned int i, count;
+	for (i = begin; i < end; i += count)
+	{
+		count = end - i < MATRIX_ARRAY_GRAIN ? end - i : MATRIX_ARRAY_GRAIN;
+		TransformVectors(job->matrix, &job->src[4 * (size_t) i],
+				&job->dst[4 * (size_t) i], 4 * count);
+	}
+}
+
+void MultiplyMatrixBroadcastRight(const Matrix3D *a, const Matrix3D *m,
+		Matrix3D *out, unsigned int n)
+{
+	TransformJob job;
+	Matrix3D matrix = *m;
+	// Every row of a[i] * m is that row transformed by m, so the whole
+	// array is a vector transform over 4 * n rows with m kept in registers
+	job.matrix = &matrix;
+	job.src = &a->X;
+	job.dst = &out->X;
+	ParallelFor(n, MATRIX_ARRAY_GRAIN, TransformRowsRange, &job);
 }
 
 float MatrixDeterminant(Matrix3D *matrix)
 {
-	float a, b, c, d;
-	a = matrix->X.x * MatrixDetInternal(matrix->Y.y, matrix->Z.y, matrix->W.y,
-			matrix->Y.z, matrix->Z.z, matrix->W.z,
-			matrix->Y.w, matrix->Z.w, matrix->W.w);
-	b = matrix->X.y * MatrixDetInternal(matrix->Y.x, matrix->Z.x, matrix->W.x,
-			matrix->Y.z, matrix->Z.z, matrix->W.z,
-			matrix->Y.w, matrix->Z.w, matrix->W.w);
-	c = matrix->X.z * MatrixDetInternal(matrix->Y.x, matrix->Z.x, matrix->W.x,
-			matrix->Y.y, matrix->Z.y, matrix->W.y,
-			matrix->Y.w, matrix->Z.w, matrix->W.w);
-	d = matrix->X.w * MatrixDetInternal(matrix->Y.x, matrix->Z.x, matrix->W.x,
-			matrix->Y.y, matrix->Z.y, matrix->W.y,
-			matrix->Y.z, matrix->Z.z, matrix->W.z);
-	return a - b + c - d;
+	return MatrixDeterminantInline(matrix);
 }
 
 float MatrixDetInternal(float a1, float a2, float a3, float b1,
 		float b2, float b3, float c1, float c2,
 		float c3)
 {
-	return (a1 * ((b2 * c3) - (b3 * c2))) - (b1 * ((a2 * c3) - (a3 * c2))) + (c1 * ((a2 * b3) - (a3 * b2)));
+	return MatrixDetInternalInline(a1, a2, a3, b1, b2, b3, c1, c2, c3);
 }
 
 void AdjointMatrix(Matrix3D *matrix)
@@ -268,10 +542,7 @@ void AdjointMatrix(Matrix3D *matrix)
 
 void ScaleMatrix(Matrix3D *target, float factor)
 {
-	ScaleVector(&target->X, factor);
-	ScaleVector(&target->Y, factor);
-	ScaleVector(&target->Z, factor);
-	ScaleVector(&target->W, factor);
+	ScaleMatrixInline(target, factor);
 }
 
 void PrintMatrix(Matrix3D *matrix)
@@ -309,8 +580,69 @@ void InvertMatrix(Matrix3D *matrix)
 	}
 }
 
-void TransposeMatrix(Matrix3D *matrix)
+int IsAffineMatrix(Matrix3D *matrix)
 {
+	return fabsf(matrix->X.w) < PRECISION && fabsf(matrix->Y.w) < PRECISION &&
+		fabsf(matrix->Z.w) < PRECISION && fabsf(matrix->W.w - 1) < PRECISION;
+}
+
+int IsRigidMatrix(Matrix3D *matrix)
+{
+	if (!IsAffineMatrix(matrix))
+	{
+		return 0;
+	}
+	return fabsf(DotProduct(matrix->X, matrix->X) - 1) < ORTHONORMAL_TOLERANCE &&
+		fabsf(DotProduct(matrix->Y, matrix->Y) - 1) < ORTHONORMAL_TOLERANCE &&
+		fabsf(DotProduct(matrix->Z, matrix->Z) - 1) < ORTHONORMAL_TOLERANCE &&
+		fabsf(DotProduct(matrix->X, matrix->Y)) < ORTHONORMAL_TOLERANCE &&
+		fabsf(DotProduct(matrix->X, matrix->Z)) < ORTHONORMAL_TOLERANCE &&
+		fabsf(DotProduct(matrix->Y, matrix->Z)) < ORTHONORMAL_TOLERANCE;
+}
+
+// Set the translation of an affine inverse, -t * R where R is the already
+// inverted rotation/scale part and t the original translation
+static void InvertTranslation(Matrix3D *matrix, Vector3D t)
+{
+	matrix->W.x = -(t.x * matrix->X.x + t.y * matrix->Y.x + t.z * matrix->Z.x);
+	matrix->W.y = -(t.x * matrix->X.y + t.y * matrix->Y.y + t.z * matrix->Z.y);
+	matrix->W.z = -(t.x * matrix->X.z + t.y * matrix->Y.z + t.z * matrix->Z.z);
+	matrix->W.w = 1;
+}
+
+void InvertAffineMatrix(Matrix3D *matrix)
+{
+	Matrix3D m = *matrix;
+	float det, invdet;
+	// Cofactors of the 3x3 part, first row
+	matrix->X.x = m.Y.y * m.Z.z - m.Y.z * m.Z.y;
+	matrix->Y.x = m.Y.z * m.Z.x - m.Y.x * m.Z.z;
+	matrix->Z.x = m.Y.x * m.Z.y - m.Y.y * m.Z.x;
+	det = m.X.x * matrix->X.x + m.X.y * matrix->Y.x + m.X.z * matrix->Z.x;
+	if (fabs(det) < EPSILON)
+	{
+		HomogeneousMatrix(matrix);
+		return;
+	}
+	invdet = 1 / det;
+	matrix->X.x *= invdet;
+	matrix->Y.x *= invdet;
+	matrix->Z.x *= invdet;
+	matrix->X.y = (m.X.z * m.Z.y - m.X.y * m.Z.z) * invdet;
+	matrix->Y.y = (m.X.x * m.Z.z - m.X.z * m.Z.x) * invdet;
+	matrix->Z.y = (m.X.y * m.Z.x - m.X.x * m.Z.y) * invdet;
+	matrix->X.z = (m.X.y * m.Y.z - m.X.z * m.Y.y) * invdet;
+	matrix->Y.z = (m.X.z * m.Y.x - m.X.x * m.Y.z) * invdet;
+	matrix->Z.z = (m.X.x * m.Y.y - m.X.y * m.Y.x) * invdet;
+	matrix->X.w = 0;
+	matrix->Y.w = 0;
+	matrix->Z.w = 0;
+	InvertTranslation(matrix, m.W);
+}
+
+void InvertRigidMatrix(Matrix3D *matrix)
+{
+	Vector3D t = matrix->W;
 	float f;
 	f = matrix->X.y;
 	matrix->X.y = matrix->Y.x;
@@ -320,21 +652,35 @@ void TransposeMatrix(Matrix3D *matrix)
 	matrix->X.z = matrix->Z.x;
 	matrix->Z.x = f;
 
-	f = matrix->X.w;
-	matrix->X.w = matrix->W.x;
-	matrix->W.x = f;
-
 	f = matrix->Y.z;
 	matrix->Y.z = matrix->Z.y;
 	matrix->Z.y = f;
 
-	f = matrix->Y.w;
-	matrix->Y.w = matrix->W.y;
-	matrix->W.y = f;
+	matrix->X.w = 0;
+	matrix->Y.w = 0;
+	matrix->Z.w = 0;
+	InvertTranslation(matrix, t);
+}
 
-	f = matrix->Z.w;
-	matrix->Z.w = matrix->W.z;
-	matrix->W.z = f;
+void InvertMatrixFast(Matrix3D *matrix)
+{
+	if (IsRigidMatrix(matrix))
+	{
+		InvertRigidMatrix(matrix);
+	}
+	else if (IsAffineMatrix(matrix))
+	{
+		InvertAffineMatrix(matrix);
+	}
+	else
+	{
+		InvertMatrix(matrix);
+	}
+}
+
+void TransposeMatrix(Matrix3D *matrix)
+{
+	TransposeMatrixInline(matrix);
 }
 
 void LookAtMatrix(Vector3D eye,
@@ -349,6 +695,7 @@ void LookAtMatrix(Vector3D eye,
 	NormalizeVector(&x_axis);
 
 	CrossProduct(x_axis, z_axis, &y_axis);
+	x_axis.w = y_axis.w = z_axis.w = 0;
 
 	CloneVector(x_axis, &matrix->X);
 	CloneVector(y_axis, &matrix->Y);
@@ -367,28 +714,77 @@ void LookAtMatrix(Vector3D eye,
 	CloneVector(neg_eye, &matrix->W);
 }
 
+void CreatePerspectiveMatrix(float fov_y, float aspect, float near,
+		float far, Matrix3D *target)
+{
+	float f = 1 / tanf(fov_y * 0.5f);
+	EmptyMatrix(target);
+	target->X.x = f / aspect;
+	target->Y.y = f;
+	target->Z.z = (far + near) / (near - far);
+	target->Z.w = -1;
+	target->W.z = 2 * far * near / (near - far);
+}
+
+void CreateInfinitePerspectiveMatrix(float fov_y, float aspect, float near,
+		Matrix3D *target)
+{
+	float f = 1 / tanf(fov_y * 0.5f);
+	EmptyMatrix(target);
+	target->X.x = f / aspect;
+	target->Y.y = f;
+	target->Z.z = -1;
+	target->Z.w = -1;
+	target->W.z = -2 * near;
+}
+
+void CreateReversedZPerspectiveMatrix(float fov_y, float aspect, float near,
+		float far, Matrix3D *target)
+{
+	float f = 1 / tanf(fov_y * 0.5f);
+	EmptyMatrix(target);
+	target->X.x = f / aspect;
+	target->Y.y = f;
+	target->Z.w = -1;
+	if (isinf(far))
+	{
+		target->W.z = near;
+	}
+	else
+	{
+		target->Z.z = near / (far - near);
+		target->W.z = far * near / (far - near);
+	}
+}
+
+void CreateOrthographicMatrix(float left, float right, float bottom,
+		float top, float near, float far, Matrix3D *target)
+{
+	HomogeneousMatrix(target);
+	target->X.x = 2 / (right - left);
+	target->Y.y = 2 / (top - bottom);
+	target->Z.z = -2 / (far - near);
+	SetVector(-(right + left) / (right - left), -(top + bottom) / (top - bottom),
+			-(far + near) / (far - near), 1, &target->W);
+}
+
+void CreateReversedZOrthographicMatrix(float left, float right,
+		float bottom, float top, float near, float far, Matrix3D *target)
+{
+	HomogeneousMatrix(target);
+	target->X.x = 2 / (right - left);
+	target->Y.y = 2 / (top - bottom);
+	target->Z.z = 1 / (far - near);
+	SetVector(-(right + left) / (right - left), -(top + bottom) / (top - bottom),
+			far / (far - near), 1, &target->W);
+}
+
 int MatrixEquals(Matrix3D *m1, Matrix3D *m2)
 {
-	return VectorEquals(m1->X, m2->X) && VectorEquals(m1->Y, m2->Y) &&
-		VectorEquals(m1->Z, m2->Z) && VectorEquals(m1->W, m2->W);
+	return MatrixEqualsInline(m1, m2);
 }
 
 void CastFloat(Matrix3D *m, float *f)
 {
-	f[0] = m->X.x;
-	f[1] = m->X.y;
-	f[2] = m->X.z;
-	f[3] = m->X.w;
-	f[4] = m->Y.x;
-	f[5] = m->Y.y;
-	f[6] = m->Y.z;
-	f[7] = m->Y.w;
-	f[8] = m->Z.x;
-	f[9] = m->Z.y;
-	f[10] = m->Z.z;
-	f[11] = m->Z.w;
-	f[12] = m->W.x;
-	f[13] = m->W.y;
-	f[14] = m->W.z;
-	f[15] = m->W.w;
+	CastFloatInline(m, f);
 }
@@ -0,0 +1,597 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ansic3d/mesh.h>
+#include <ansic3d/parallel.h>
+#include <ansic3d/cpu.h>
+
+#ifdef ANSIC3D_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/**
+ * Triangles or vertices per parallel chunk
+ */
+#define MESH_GRAIN 4096
+
+typedef struct _MeshJob MeshJob;
+
+typedef void (*FaceNormalKernel)(Mesh *mesh, unsigned int begin,
+		unsigned int end);
+
+struct _MeshJob
+{
+	Mesh *mesh;
+	int weighting;
+	const float *uvs;
+	FaceNormalKernel kernel;
+};
+
+// Resize the list to count vectors, the old contents are not kept
+static int SizeVectorList(VectorList *list, unsigned int count)
+{
+	if (!ReserveVectorList(list, count > 0 ? count : 1))
+	{
+		return 0;
+	}
+	list->count = count;
+	list->index = count - 1;
+	return 1;
+}
+
+static void FreeMeshCaches(Mesh *mesh)
+{
+	free(mesh->face_normals);
+	free(mesh->face_tangents);
+	free(mesh->vertex_start);
+	free(mesh->vertex_corners);
+	mesh->face_normals = NULL;
+	mesh->face_tangents = NULL;
+	mesh->vertex_start = NULL;
+	mesh->vertex_corners = NULL;
+	mesh->adjacency_count = 0;
+}
+
+void InitMesh(Mesh *mesh)
+{
+	InitVectorList(&mesh->positions, 1);
+	InitVectorList(&mesh->normals, 1);
+	InitVectorList(&mesh->tangents, 1);
+	mesh->indices = NULL;
+	mesh->triangle_count = 0;
+	mesh->face_normals = NULL;
+	mesh->face_tangents = NULL;
+	mesh->vertex_start = NULL;
+	mesh->vertex_corners = NULL;
+	mesh->adjacency_count = 0;
+}
+
+int SetMesh(Mesh *mesh, const Vector3D *positions, unsigned int vertex_count,
+		const unsigned int *indices, unsigned int triangle_count)
+{
+	unsigned int *copy, i;
+	for (i = 0; i < 3 * triangle_count; i++)
+	{
+		if (indices[i] >= vertex_count)
+		{
+			return 0;
+		}
+	}
+	copy = malloc((triangle_count > 0 ? 3 * triangle_count : 1) *
+			sizeof(unsigned int));
+	if (copy == NULL || !SizeVectorList(&mesh->positions, vertex_count))
+	{
+		free(copy);
+		return 0;
+	}
+	memcpy(mesh->positions.vectors, positions,
+			vertex_count * sizeof(Vector3D));
+	memcpy(copy, indices, 3 * triangle_count * sizeof(unsigned int));
+	free(mesh->indices);
+	mesh->indices = copy;
+	mesh->triangle_count = triangle_count;
+	mesh->normals.count = mesh->tangents.count = 0;
+	mesh->normals.index = mesh->tangents.index = -1;
+	FreeMeshCaches(mesh);
+	return triangle_count;
+}
+
+// Corners (3 * triangle + k) around every vertex, vertex v has
+// vertex_corners[vertex_start[v]] up to vertex_start[v + 1] in increasing
+// order
+static int BuildAdjacency(Mesh *mesh)
+{
+	unsigned int n = mesh->positions.count, i, *start, *corners;
+	free(mesh->vertex_start);
+	free(mesh->vertex_corners);
+	mesh->vertex_start = NULL;
+	mesh->vertex_corners = NULL;
+	mesh->adjacency_count = 0;
+	for (i = 0; i < 3 * mesh->triangle_count; i++)
+	{
+		// Positions may have been removed since SetMesh
+		if (mesh->indices[i] >= n)
+		{
+			return 0;
+		}
+	}
+	start = calloc(n + 1, sizeof(unsigned int));
+	corners = malloc((mesh->triangle_count > 0 ?
+				3 * mesh->triangle_count : 1) * sizeof(unsigned int));
+	if (start == NULL || corners == NULL)
+	{
+		free(start);
+		free(corners);
+		return 0;
+	}
+	for (i = 0; i < 3 * mesh->triangle_count; i++)
+	{
+		start[mesh->indices[i] + 1]++;
+	}
+	for (i = 0; i < n; i++)
+	{
+		start[i + 1] += start[i];
+	}
+	// start[v] is used as the cursor of v, shifted back afterwards
+	for (i = 0; i < 3 * mesh->triangle_count; i++)
+	{
+		corners[start[mesh->indices[i]]++] = i;
+	}
+	for (i = n; i > 0; i--)
+	{
+		start[i] = start[i - 1];
+	}
+	start[0] = 0;
+	mesh->vertex_start = start;
+	mesh->vertex_corners = corners;
+	mesh->adjacency_count = n;
+	return 1;
+}
+
+// Cross product of the edges, the SIMD kernels repeat every operation in
+// this order
+static void FaceNormal(const Vector3D *p0, const Vector3D *p1,
+		const Vector3D *p2, Vector3D *result)
+{
+	float e1x, e1y, e1z, e2x, e2y, e2z, cx, cy, cz, len;
+	e1x = p1->x - p0->x;
+	e1y = p1->y - p0->y;
+	e1z = p1->z - p0->z;
+	e2x = p2->x - p0->x;
+	e2y = p2->y - p0->y;
+	e2z = p2->z - p0->z;
+	cx = e1y * e2z - e1z * e2y;
+	cy = e1z * e2x - e1x * e2z;
+	cz = e1x * e2y - e1y * e2x;
+	len = sqrtf(cx * cx + cy * cy + cz * cz);
+	result->x = len > 0 ? cx / len : 0;
+	result->y = len > 0 ? cy / len : 0;
+	result->z = len > 0 ? cz / len : 0;
+	result->w = len * 0.5f;
+}
+
+static void FaceNormalsScalar(Mesh *mesh, unsigned int begin,
+		unsigned int end)
+{
+	const Vector3D *p = mesh->positions.vectors;
+	const unsigned int *idx;
+	unsigned int i;
+	for (i = begin; i < end; i++)
+	{
+		idx = &mesh->indices[3 * i];
+		FaceNormal(&p[idx[0]], &p[idx[1]], &p[idx[2]],
+				&mesh->face_normals[i]);
+	}
+}
+
+#ifdef ANSIC3D_X86_SIMD
+
+// 4 triangles per iteration. Whole vertices are loaded and transposed
+// into x, y, z lanes, results are transposed back into face_normals
+__attribute__((target("sse2")))
+static void FaceNormalsSSE(Mesh *mesh, unsigned int begin, unsigned int end)
+{
+	const Vector3D *p = mesh->positions.vectors;
+	const unsigned int *idx = &mesh->indices[3 * begin];
+	__m128 ax, ay, az, bx, by, bz, cx, cy, cz, len, mask, area;
+	unsigned int i;
+	for (i = begin; i + 4 <= end; i += 4, idx += 12)
+	{
+		ax = _mm_loadu_ps(&p[idx[0]].x);
+		ay = _mm_loadu_ps(&p[idx[3]].x);
+		az = _mm_loadu_ps(&p[idx[6]].x);
+		area = _mm_loadu_ps(&p[idx[9]].x);
+		_MM_TRANSPOSE4_PS(ax, ay, az, area);
+		bx = _mm_loadu_ps(&p[idx[1]].x);
+		by = _mm_loadu_ps(&p[idx[4]].x);
+		bz = _mm_loadu_ps(&p[idx[7]].x);
+		area = _mm_loadu_ps(&p[idx[10]].x);
+		_MM_TRANSPOSE4_PS(bx, by, bz, area);
+		cx = _mm_loadu_ps(&p[idx[2]].x);
+		cy = _mm_loadu_ps(&p[idx[5]].x);
+		cz = _mm_loadu_ps(&p[idx[8]].x);
+		area = _mm_loadu_ps(&p[idx[11]].x);
+		_MM_TRANSPOSE4_PS(cx, cy, cz, area);
+		// Edges into b and c
+		bx = _mm_sub_ps(bx, ax);
+		by = _mm_sub_ps(by, ay);
+		bz = _mm_sub_ps(bz, az);
+		cx = _mm_sub_ps(cx, ax);
+		cy = _mm_sub_ps(cy, ay);
+		cz = _mm_sub_ps(cz, az);
+		ax = _mm_sub_ps(_mm_mul_ps(by, cz), _mm_mul_ps(bz, cy));
+		ay = _mm_sub_ps(_mm_mul_ps(bz, cx), _mm_mul_ps(bx, cz));
+		az = _mm_sub_ps(_mm_mul_ps(bx, cy), _mm_mul_ps(by, cx));
+		len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, ax),
+						_mm_mul_ps(ay, ay)), _mm_mul_ps(az, az)));
+		// Degenerate lanes divide by zero and are masked off
+		mask = _mm_cmpgt_ps(len, _mm_setzero_ps());
+		ax = _mm_and_ps(mask, _mm_div_ps(ax, len));
+		ay = _mm_and_ps(mask, _mm_div_ps(ay, len));
+		az = _mm_and_ps(mask, _mm_div_ps(az, len));
+		area = _mm_mul_ps(len, _mm_set1_ps(0.5f));
+		_MM_TRANSPOSE4_PS(ax, ay, az, area);
+		_mm_storeu_ps(&mesh->face_normals[i].x, ax);
+		_mm_storeu_ps(&mesh->face_normals[i + 1].x, ay);
+		_mm_storeu_ps(&mesh->face_normals[i + 2].x, az);
+		_mm_storeu_ps(&mesh->face_normals[i + 3].x, area);
+	}
+	FaceNormalsScalar(mesh, i, end);
+}
+
+// Two vertices per 256 bit register, each 128 bit half is transposed as
+// in _MM_TRANSPOSE4_PS
+#define LOAD_PAIR(p, lo, hi) _mm256_insertf128_ps( \
+		_mm256_castps128_ps256(_mm_loadu_ps(&(p)[lo].x)), \
+		_mm_loadu_ps(&(p)[hi].x), 1)
+
+#define TRANSPOSE_LANES(r0, r1, r2, r3) do { \
+	__m256 t0_ = _mm256_unpacklo_ps(r0, r1); \
+	__m256 t1_ = _mm256_unpacklo_ps(r2, r3); \
+	__m256 t2_ = _mm256_unpackhi_ps(r0, r1); \
+	__m256 t3_ = _mm256_unpackhi_ps(r2, r3); \
+	(r0) = _mm256_shuffle_ps(t0_, t1_, 0x44); \
+	(r1) = _mm256_shuffle_ps(t0_, t1_, 0xEE); \
+	(r2) = _mm256_shuffle_ps(t2_, t3_, 0x44); \
+	(r3) = _mm256_shuffle_ps(t2_, t3_, 0xEE); \
+} while (0)
+
+// 8 triangles per iteration, see FaceNormalsSSE. Lanes hold triangles
+// i, i + 1, i + 2, i + 3 in the low half and i + 4 to i + 7 in the high
+__attribute__((target("avx")))
+static void FaceNormalsAVX(Mesh *mesh, unsigned int begin, unsigned int end)
+{
+	const Vector3D *p = mesh->positions.vectors;
+	const unsigned int *idx = &mesh->indices[3 * begin];
+	__m256 ax, ay, az, bx, by, bz, cx, cy, cz, len, mask, area;
+	unsigned int i;
+	for (i = begin; i + 8 <= end; i += 8, idx += 24)
+	{
+		ax = LOAD_PAIR(p, idx[0], idx[12]);
+		ay = LOAD_PAIR(p, idx[3], idx[15]);
+		az = LOAD_PAIR(p, idx[6], idx[18]);
+		area = LOAD_PAIR(p, idx[9], idx[21]);
+		TRANSPOSE_LANES(ax, ay, az, area);
+		bx = LOAD_PAIR(p, idx[1], idx[13]);
+		by = LOAD_PAIR(p, idx[4], idx[16]);
+		bz = LOAD_PAIR(p, idx[7], idx[19]);
+		area = LOAD_PAIR(p, idx[10], idx[22]);
+		TRANSPOSE_LANES(bx, by, bz, area);
+		cx = LOAD_PAIR(p, idx[2], idx[14]);
+		cy = LOAD_PAIR(p, idx[5], idx[17]);
+		cz = LOAD_PAIR(p, idx[8], idx[20]);
+		area = LOAD_PAIR(p, idx[11], idx[23]);
+		TRANSPOSE_LANES(cx, cy, cz, area);
+		bx = _mm256_sub_ps(bx, ax);
+		by = _mm256_sub_ps(by, ay);
+		bz = _mm256_sub_ps(bz, az);
+		cx = _mm256_sub_ps(cx, ax);
+		cy = _mm256_sub_ps(cy, ay);
+		cz = _mm256_sub_ps(cz, az);
+		ax = _mm256_sub_ps(_mm256_mul_ps(by, cz), _mm256_mul_ps(bz, cy));
+		ay = _mm256_sub_ps(_mm256_mul_ps(bz, cx), _mm256_mul_ps(bx, cz));
+		az = _mm256_sub_ps(_mm256_mul_ps(bx, cy), _mm256_mul_ps(by, cx));
+		len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(
+						_mm256_mul_ps(ax, ax), _mm256_mul_ps(ay, ay)),
+					_mm256_mul_ps(az, az)));
+		mask = _mm256_cmp_ps(len, _mm256_setzero_ps(), _CMP_GT_OQ);
+		ax = _mm256_and_ps(mask, _mm256_div_ps(ax, len));
+		ay = _mm256_and_ps(mask, _mm256_div_ps(ay, len));
+		az = _mm256_and_ps(mask, _mm256_div_ps(az, len));
+		area = _mm256_mul_ps(len, _mm256_set1_ps(0.5f));
+		TRANSPOSE_LANES(ax, ay, az, area);
+		_mm_storeu_ps(&mesh->face_normals[i].x, _mm256_castps256_ps128(ax));
+		_mm_storeu_ps(&mesh->face_normals[i + 1].x,
+				_mm256_castps256_ps128(ay));
+		_mm_storeu_ps(&mesh->face_normals[i + 2].x,
+				_mm256_castps256_ps128(az));
+		_mm_storeu_ps(&mesh->face_normals[i + 3].x,
+				_mm256_castps256_ps128(area));
+		_mm_storeu_ps(&mesh->face_normals[i + 4].x,
+				_mm256_extractf128_ps(ax, 1));
+		_mm_storeu_ps(&mesh->face_normals[i + 5].x,
+				_mm256_extractf128_ps(ay, 1));
+		_mm_storeu_ps(&mesh->face_normals[i + 6].x,
+				_mm256_extractf128_ps(az, 1));
+		_mm_storeu_ps(&mesh->face_normals[i + 7].x,
+				_mm256_extractf128_ps(area, 1));
+	}
+	_mm256_zeroupper();
+	FaceNormalsScalar(mesh, i, end);
+}
+
+#endif
+
+static void FaceNormalRange(unsigned int begin, unsigned int end,
+		void *context)
+{
+	MeshJob *job = context;
+	job->kernel(job->mesh, begin, end);
+}
+
+int ComputeMeshFaceNormals(Mesh *mesh)
+{
+	MeshJob job;
+	if (mesh->triangle_count == 0)
+	{
+		return 0;
+	}
+	if (mesh->face_normals == NULL)
+	{
+		mesh->face_normals = malloc(mesh->triangle_count * sizeof(Vector3D));
+		if (mesh->face_normals == NULL)
+		{
+			return 0;
+		}
+	}
+	job.mesh = mesh;
+	job.kernel = FaceNormalsScalar;
+#ifdef ANSIC3D_X86_SIMD
+	if (GetSIMDLevel() >= SIMD_AVX)
+	{
+		job.kernel = FaceNormalsAVX;
+	}
+	else if (GetSIMDLevel() >= SIMD_SSE)
+	{
+		job.kernel = FaceNormalsSSE;
+	}
+#endif
+	ParallelFor(mesh->triangle_count, MESH_GRAIN, FaceNormalRange, &job);
+	return mesh->triangle_count;
+}
+
+// Angle of corner c of its triangle, the cross product length is twice
+// the area so no acos and its clamping are needed
+static float CornerAngle(const Mesh *mesh, unsigned int c)
+{
+	const Vector3D *pos = mesh->positions.vectors, *p, *a, *b;
+	unsigned int base = c - c % 3;
+	p = &pos[mesh->indices[c]];
+	a = &pos[mesh->indices[base + (c + 1) % 3]];
+	b = &pos[mesh->indices[base + (c + 2) % 3]];
+	return atan2f(2 * mesh->face_normals[c / 3].w,
+			(a->x - p->x) * (b->x - p->x) + (a->y - p->y) * (b->y - p->y) +
+			(a->z - p->z) * (b->z - p->z));
+}
+
+static void VertexNormalRange(unsigned int begin, unsigned int end,
+		void *context)
+{
+	MeshJob *job = context;
+	Mesh *mesh = job->mesh;
+	const Vector3D *n;
+	float x, y, z, w, len;
+	unsigned int v, c;
+	for (v = begin; v < end; v++)
+	{
+		x = y = z = 0;
+		for (c = mesh->vertex_start[v]; c < mesh->vertex_start[v + 1]; c++)
+		{
+			n = &mesh->face_normals[mesh->vertex_corners[c] / 3];
+			w = job->weighting == MESH_WEIGHT_ANGLE ?
+				CornerAngle(mesh, mesh->vertex_corners[c]) : n->w;
+			x += n->x * w;
+			y += n->y * w;
+			z += n->z * w;
+		}
+		len = sqrtf(x * x + y * y + z * z);
+		if (len > 0)
+		{
+			SetVector(x / len, y / len, z / len, 0, &mesh->normals.vectors[v]);
+		}
+		else
+		{
+			SetVector(0, 0, 0, 0, &mesh->normals.vectors[v]);
+		}
+	}
+}
+
+// Adjacency for the current positions, rebuilt when their count changed
+static int MeshAdjacency(Mesh *mesh)
+{
+	if (mesh->vertex_start != NULL &&
+			mesh->adjacency_count == mesh->positions.count)
+	{
+		return 1;
+	}
+	return BuildAdjacency(mesh);
+}
+
+int ComputeMeshNormals(Mesh *mesh, int weighting)
+{
+	MeshJob job;
+	if (mesh->positions.count == 0 || !ComputeMeshFaceNormals(mesh) ||
+			!MeshAdjacency(mesh) ||
+			!SizeVectorList(&mesh->normals, mesh->positions.count))
+	{
+		return 0;
+	}
+	job.mesh = mesh;
+	job.weighting = weighting;
+	ParallelFor(mesh->positions.count, MESH_GRAIN, VertexNormalRange, &job);
+	return mesh->positions.count;
+}
+
+// Tangent and bitangent of every triangle from its uv gradients,
+// unnormalized so larger triangles in uv space count less
+static void FaceTangentRange(unsigned int begin, unsigned int end,
+		void *context)
+{
+	MeshJob *job = context;
+	Mesh *mesh = job->mesh;
+	const Vector3D *pos = mesh->positions.vectors, *p0, *p1, *p2;
+	const unsigned int *idx;
+	const float *uvs = job->uvs;
+	float e1x, e1y, e1z, e2x, e2y, e2z, du1, dv1, du2, dv2, r;
+	unsigned int i;
+	for (i = begin; i < end; i++)
+	{
+		idx = &mesh->indices[3 * i];
+		p0 = &pos[idx[0]];
+		p1 = &pos[idx[1]];
+		p2 = &pos[idx[2]];
+		e1x = p1->x - p0->x;
+		e1y = p1->y - p0->y;
+		e1z = p1->z - p0->z;
+		e2x = p2->x - p0->x;
+		e2y = p2->y - p0->y;
+		e2z = p2->z - p0->z;
+		du1 = uvs[2 * idx[1]] - uvs[2 * idx[0]];
+		dv1 = uvs[2 * idx[1] + 1] - uvs[2 * idx[0] + 1];
+		du2 = uvs[2 * idx[2]] - uvs[2 * idx[0]];
+		dv2 = uvs[2 * idx[2] + 1] - uvs[2 * idx[0] + 1];
+		r = du1 * dv2 - du2 * dv1;
+		if (!(fabsf(r) > 0))
+		{
+			SetVector(0, 0, 0, 0, &mesh->face_tangents[2 * i]);
+			SetVector(0, 0, 0, 0, &mesh->face_tangents[2 * i + 1]);
+			continue;
+		}
+		r = 1 / r;
+		SetVector((e1x * dv2 - e2x * dv1) * r, (e1y * dv2 - e2y * dv1) * r,
+				(e1z * dv2 - e2z * dv1) * r, 0, &mesh->face_tangents[2 * i]);
+		SetVector((e2x * du1 - e1x * du2) * r, (e2y * du1 - e1y * du2) * r,
+				(e2z * du1 - e1z * du2) * r, 0,
+				&mesh->face_tangents[2 * i + 1]);
+	}
+}
+
+static void VertexTangentRange(unsigned int begin, unsigned int end,
+		void *context)
+{
+	MeshJob *job = context;
+	Mesh *mesh = job->mesh;
+	const Vector3D *n, *ft;
+	float tx, ty, tz, bx, by, bz, d, len;
+	unsigned int v, c;
+	for (v = begin; v < end; v++)
+	{
+		tx = ty = tz = bx = by = bz = 0;
+		for (c = mesh->vertex_start[v]; c < mesh->vertex_start[v + 1]; c++)
+		{
+			ft = &mesh->face_tangents[2 * (mesh->vertex_corners[c] / 3)];
+			tx += ft[0].x;
+			ty += ft[0].y;
+			tz += ft[0].z;
+			bx += ft[1].x;
+			by += ft[1].y;
+			bz += ft[1].z;
+		}
+		// Gram-Schmidt against the normal
+		n = &mesh->normals.vectors[v];
+		d = n->x * tx + n->y * ty + n->z * tz;
+		tx -= n->x * d;
+		ty -= n->y * d;
+		tz -= n->z * d;
+		len = sqrtf(tx * tx + ty * ty + tz * tz);
+		if (!(len > 0))
+		{
+			// Any direction orthogonal to the normal
+			if (fabsf(n->x) < 0.9f)
+			{
+				tx = 0;
+				ty = n->z;
+				tz = -n->y;
+			}
+			else
+			{
+				tx = -n->z;
+				ty = 0;
+				tz = n->x;
+			}
+			len = sqrtf(tx * tx + ty * ty + tz * tz);
+			if (!(len > 0))
+			{
+				tx = len = 1;
+			}
+		}
+		tx /= len;
+		ty /= len;
+		tz /= len;
+		// Handedness of (normal x tangent) against the bitangent
+		d = (n->y * tz - n->z * ty) * bx + (n->z * tx - n->x * tz) * by +
+			(n->x * ty - n->y * tx) * bz;
+		SetVector(tx, ty, tz, d < 0 ? -1 : 1, &mesh->tangents.vectors[v]);
+	}
+}
+
+int ComputeMeshTangents(Mesh *mesh, const float *uvs)
+{
+	MeshJob job;
+	if (mesh->positions.count == 0 || mesh->triangle_count == 0)
+	{
+		return 0;
+	}
+	if (mesh->normals.count != mesh->positions.count &&
+			!ComputeMeshNormals(mesh, MESH_WEIGHT_AREA))
+	{
+		return 0;
+	}
+	if (!MeshAdjacency(mesh) ||
+			!SizeVectorList(&mesh->tangents, mesh->positions.count))
+	{
+		return 0;
+	}
+	if (mesh->face_tangents == NULL)
+	{
+		mesh->face_tangents = malloc(2 * mesh->triangle_count *
+				sizeof(Vector3D));
+		if (mesh->face_tangents == NULL)
+		{
+			return 0;
+		}
+	}
+	job.mesh = mesh;
+	job.uvs = uvs;
+	ParallelFor(mesh->triangle_count, MESH_GRAIN, FaceTangentRange, &job);
+	ParallelFor(mesh->positions.count, MESH_GRAIN, VertexTangentRange, &job);
+	return mesh->positions.count;
+}
+
+void FreeMesh(Mesh *mesh)
+{
+	FreeVectorList(&mesh->positions);
+	FreeVectorList(&mesh->normals);
+	FreeVectorList(&mesh->tangents);
+	free(mesh->indices);
+	mesh->indices = NULL;
+	mesh->triangle_count = 0;
+	FreeMeshCaches(mesh);
+}
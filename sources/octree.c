@@ -0,0 +1,513 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ansic3d/octree.h>
+
+#define OCTREE_OUTSIDE 0
+#define OCTREE_INTERSECT 1
+#define OCTREE_INSIDE 2
+
+/**
+ * Enough for a depth first walk pushing up to 8 children per level
+ */
+#define OCTREE_STACK_SIZE (8 * (OCTREE_MAX_DEPTH + 1))
+
+typedef int (*ClassifyBox)(const AABB *box, const void *context);
+
+typedef struct _SphereQuery
+{
+	Vector3D center;
+	float radius;
+} SphereQuery;
+
+static unsigned int AllocNode(Octree *tree, unsigned int parent,
+		unsigned int child)
+{
+	OctreeNode *n, *p;
+	void *q;
+	unsigned int i, k, capacity;
+	float h;
+	if (tree->node_free != OCTREE_NONE)
+	{
+		i = tree->node_free;
+		tree->node_free = tree->nodes[i].parent;
+	}
+	else
+	{
+		if (tree->node_used == tree->node_capacity)
+		{
+			capacity = tree->node_capacity > 0 ? tree->node_capacity * 2 : 64;
+			q = realloc(tree->nodes, capacity * sizeof(OctreeNode));
+			if (q == NULL)
+			{
+				return OCTREE_NONE;
+			}
+			tree->nodes = q;
+			tree->node_capacity = capacity;
+		}
+		i = tree->node_used++;
+	}
+	n = &tree->nodes[i];
+	for (k = 0; k < 8; k++)
+	{
+		n->children[k] = OCTREE_NONE;
+	}
+	n->parent = parent;
+	n->first = OCTREE_NONE;
+	n->count = 0;
+	if (parent == OCTREE_NONE)
+	{
+		n->depth = 0;
+	}
+	else
+	{
+		p = &tree->nodes[parent];
+		h = p->center.w * 0.5f;
+		n->center.x = p->center.x + (child & 1 ? h : -h);
+		n->center.y = p->center.y + (child & 2 ? h : -h);
+		n->center.z = p->center.z + (child & 4 ? h : -h);
+		n->center.w = h;
+		n->depth = p->depth + 1;
+		p->children[child] = i;
+	}
+	tree->node_count++;
+	return i;
+}
+
+// Give empty leaves back to the pool, walking up while the parents
+// become empty leaves too
+static void PruneNode(Octree *tree, unsigned int i)
+{
+	OctreeNode *n;
+	unsigned int k, parent;
+	while (i != 0)
+	{
+		n = &tree->nodes[i];
+		if (n->count > 0)
+		{
+			return;
+		}
+		for (k = 0; k < 8; k++)
+		{
+			if (n->children[k] != OCTREE_NONE)
+			{
+				return;
+			}
+		}
+		parent = n->parent;
+		for (k = 0; k < 8; k++)
+		{
+			if (tree->nodes[parent].children[k] == i)
+			{
+				tree->nodes[parent].children[k] = OCTREE_NONE;
+			}
+		}
+		n->parent = tree->node_free;
+		n->depth = OCTREE_NONE;
+		tree->node_free = i;
+		tree->node_count--;
+		i = parent;
+	}
+}
+
+int InitOctree(Octree *tree, Vector3D center, float half_size,
+		unsigned int max_depth)
+{
+	memset(tree, 0, sizeof(Octree));
+	tree->node_free = OCTREE_NONE;
+	tree->object_free = OCTREE_NONE;
+	tree->max_depth = max_depth < OCTREE_MAX_DEPTH ? max_depth :
+		OCTREE_MAX_DEPTH;
+	if (AllocNode(tree, OCTREE_NONE, 0) == OCTREE_NONE)
+	{
+		return 0;
+	}
+	tree->nodes[0].center = center;
+	tree->nodes[0].center.w = half_size;
+	return 1;
+}
+
+// Depth of the deepest node the box fits in, 0 if its center is outside
+// of the root cell
+static unsigned int TargetDepth(Octree *tree, const AABB *box,
+		Vector3D *center)
+{
+	const Vector3D *root = &tree->nodes[0].center;
+	float h = root->w, e;
+	unsigned int depth = 0;
+	center->x = (box->min.x + box->max.x) * 0.5f;
+	center->y = (box->min.y + box->max.y) * 0.5f;
+	center->z = (box->min.z + box->max.z) * 0.5f;
+	if (fabsf(center->x - root->x) > h || fabsf(center->y - root->y) > h ||
+			fabsf(center->z - root->z) > h)
+	{
+		return 0;
+	}
+	e = fmaxf(box->max.x - box->min.x,
+			fmaxf(box->max.y - box->min.y, box->max.z - box->min.z));
+	while (depth < tree->max_depth && e <= h)
+	{
+		h *= 0.5f;
+		depth++;
+	}
+	return depth;
+}
+
+// Node at depth containing center, missing nodes on the way are created.
+// Return OCTREE_NONE if fails
+static unsigned int LocateNode(Octree *tree, const Vector3D *center,
+		unsigned int depth)
+{
+	unsigned int i = 0, d, child, next;
+	const Vector3D *c;
+	for (d = 0; d < depth; d++)
+	{
+		c = &tree->nodes[i].center;
+		child = (center->x >= c->x) | (center->y >= c->y) << 1 |
+			(center->z >= c->z) << 2;
+		next = tree->nodes[i].children[child];
+		if (next == OCTREE_NONE)
+		{
+			next = AllocNode(tree, i, child);
+			if (next == OCTREE_NONE)
+			{
+				PruneNode(tree, i);
+				return OCTREE_NONE;
+			}
+		}
+		i = next;
+	}
+	return i;
+}
+
+static void LinkObject(Octree *tree, unsigned int handle, unsigned int node)
+{
+	OctreeObject *o = &tree->objects[handle];
+	OctreeNode *n = &tree->nodes[node];
+	o->node = node;
+	o->prev = OCTREE_NONE;
+	o->next = n->first;
+	if (n->first != OCTREE_NONE)
+	{
+		tree->objects[n->first].prev = handle;
+	}
+	n->first = handle;
+	n->count++;
+}
+
+static void UnlinkObject(Octree *tree, unsigned int handle)
+{
+	OctreeObject *o = &tree->objects[handle];
+	OctreeNode *n = &tree->nodes[o->node];
+	if (o->prev != OCTREE_NONE)
+	{
+		tree->objects[o->prev].next = o->next;
+	}
+	else
+	{
+		n->first = o->next;
+	}
+	if (o->next != OCTREE_NONE)
+	{
+		tree->objects[o->next].prev = o->prev;
+	}
+	n->count--;
+}
+
+unsigned int InsertOctree(Octree *tree, AABB box)
+{
+	Vector3D center;
+	unsigned int handle, node, capacity;
+	void *q;
+	node = LocateNode(tree, &center, TargetDepth(tree, &box, &center));
+	if (node == OCTREE_NONE)
+	{
+		return OCTREE_NONE;
+	}
+	if (tree->object_free != OCTREE_NONE)
+	{
+		handle = tree->object_free;
+		tree->object_free = tree->objects[handle].next;
+	}
+	else
+	{
+		if (tree->object_used == tree->object_capacity)
+		{
+			capacity = tree->object_capacity > 0 ?
+				tree->object_capacity * 2 : 64;
+			q = realloc(tree->objects, capacity * sizeof(OctreeObject));
+			if (q == NULL)
+			{
+				PruneNode(tree, node);
+				return OCTREE_NONE;
+			}
+			tree->objects = q;
+			tree->object_capacity = capacity;
+		}
+		handle = tree->object_used++;
+	}
+	tree->objects[handle].box = box;
+	tree->objects[handle].reserved = 0;
+	LinkObject(tree, handle, node);
+	tree->count++;
+	return handle;
+}
+
+unsigned int InsertOctreeList(Octree *tree, VectorList *list, float radius,
+		unsigned int *handles)
+{
+	AABB box;
+	unsigned int i, handle;
+	for (i = 0; i < list->count; i++)
+	{
+		SetVector(list->vectors[i].x - radius, list->vectors[i].y - radius,
+				list->vectors[i].z - radius, 1, &box.min);
+		SetVector(list->vectors[i].x + radius, list->vectors[i].y + radius,
+				list->vectors[i].z + radius, 1, &box.max);
+		handle = InsertOctree(tree, box);
+		if (handle == OCTREE_NONE)
+		{
+			return i;
+		}
+		if (handles != NULL)
+		{
+			handles[i] = handle;
+		}
+	}
+	return list->count;
+}
+
+static int ValidHandle(Octree *tree, unsigned int handle)
+{
+	return handle < tree->object_used &&
+		tree->objects[handle].node != OCTREE_NONE;
+}
+
+int MoveOctree(Octree *tree, unsigned int handle, AABB box)
+{
+	Vector3D center;
+	const Vector3D *c;
+	unsigned int depth, old, node;
+	if (!ValidHandle(tree, handle))
+	{
+		return 0;
+	}
+	depth = TargetDepth(tree, &box, &center);
+	old = tree->objects[handle].node;
+	c = &tree->nodes[old].center;
+	tree->objects[handle].box = box;
+	if (depth == tree->nodes[old].depth && (depth == 0 ||
+			(fabsf(center.x - c->x) <= c->w && fabsf(center.y - c->y) <= c->w &&
+			 fabsf(center.z - c->z) <= c->w)))
+	{
+		return 1;
+	}
+	// Create the new path before pruning the old one
+	UnlinkObject(tree, handle);
+	node = LocateNode(tree, &center, depth);
+	if (node == OCTREE_NONE)
+	{
+		// Out of memory, the root takes any box
+		node = 0;
+	}
+	LinkObject(tree, handle, node);
+	PruneNode(tree, old);
+	return 1;
+}
+
+int RemoveOctree(Octree *tree, unsigned int handle)
+{
+	unsigned int node;
+	if (!ValidHandle(tree, handle))
+	{
+		return 0;
+	}
+	node = tree->objects[handle].node;
+	UnlinkObject(tree, handle);
+	PruneNode(tree, node);
+	tree->objects[handle].node = OCTREE_NONE;
+	tree->objects[handle].next = tree->object_free;
+	tree->object_free = handle;
+	tree->count--;
+	return 1;
+}
+
+// Depth first walk. The root is always entered as it can hold objects
+// outside of its cell, below it the loose bounds of every node are
+// classified and subtrees inside the query are taken without tests.
+static unsigned int QueryOctree(Octree *tree, ClassifyBox classify,
+		const void *context, unsigned int *handles, unsigned int max)
+{
+	unsigned int stack[OCTREE_STACK_SIZE];
+	unsigned char inside[OCTREE_STACK_SIZE];
+	unsigned int top = 0, found = 0, i, k, o;
+	unsigned char all;
+	const OctreeNode *n;
+	AABB loose;
+	float h;
+	if (handles == NULL)
+	{
+		max = 0;
+	}
+	stack[top] = 0;
+	inside[top++] = 0;
+	while (top > 0)
+	{
+		top--;
+		i = stack[top];
+		all = inside[top];
+		n = &tree->nodes[i];
+		if (!all && i != 0)
+		{
+			h = n->center.w * 2;
+			SetVector(n->center.x - h, n->center.y - h, n->center.z - h, 1,
+					&loose.min);
+			SetVector(n->center.x + h, n->center.y + h, n->center.z + h, 1,
+					&loose.max);
+			k = classify(&loose, context);
+			if (k == OCTREE_OUTSIDE)
+			{
+				continue;
+			}
+			all = k == OCTREE_INSIDE;
+		}
+		for (o = n->first; o != OCTREE_NONE; o = tree->objects[o].next)
+		{
+			if (all || classify(&tree->objects[o].box, context) !=
+					OCTREE_OUTSIDE)
+			{
+				if (found < max)
+				{
+					handles[found] = o;
+				}
+				found++;
+			}
+		}
+		for (k = 0; k < 8; k++)
+		{
+			if (n->children[k] != OCTREE_NONE)
+			{
+				stack[top] = n->children[k];
+				inside[top++] = all;
+			}
+		}
+	}
+	return found;
+}
+
+static int ClassifyAABB(const AABB *box, const void *context)
+{
+	const AABB *q = context;
+	if (box->min.x > q->max.x || box->max.x < q->min.x ||
+			box->min.y > q->max.y || box->max.y < q->min.y ||
+			box->min.z > q->max.z || box->max.z < q->min.z)
+	{
+		return OCTREE_OUTSIDE;
+	}
+	if (box->min.x >= q->min.x && box->max.x <= q->max.x &&
+			box->min.y >= q->min.y && box->max.y <= q->max.y &&
+			box->min.z >= q->min.z && box->max.z <= q->max.z)
+	{
+		return OCTREE_INSIDE;
+	}
+	return OCTREE_INTERSECT;
+}
+
+static float AxisDistance(float c, float min, float max)
+{
+	return c < min ? min - c : (c > max ? c - max : 0);
+}
+
+static int ClassifySphere(const AABB *box, const void *context)
+{
+	const SphereQuery *q = context;
+	float dx, dy, dz, r2 = q->radius * q->radius;
+	dx = AxisDistance(q->center.x, box->min.x, box->max.x);
+	dy = AxisDistance(q->center.y, box->min.y, box->max.y);
+	dz = AxisDistance(q->center.z, box->min.z, box->max.z);
+	if (dx * dx + dy * dy + dz * dz > r2)
+	{
+		return OCTREE_OUTSIDE;
+	}
+	dx = fmaxf(q->center.x - box->min.x, box->max.x - q->center.x);
+	dy = fmaxf(q->center.y - box->min.y, box->max.y - q->center.y);
+	dz = fmaxf(q->center.z - box->min.z, box->max.z - q->center.z);
+	return dx * dx + dy * dy + dz * dz <= r2 ? OCTREE_INSIDE :
+		OCTREE_INTERSECT;
+}
+
+static int ClassifyFrustum(const AABB *box, const void *context)
+{
+	const Frustum *f = context;
+	const Vector3D *p;
+	float cx, cy, cz, ex, ey, ez, d, r;
+	int k, result = OCTREE_INSIDE;
+	cx = (box->min.x + box->max.x) * 0.5f;
+	cy = (box->min.y + box->max.y) * 0.5f;
+	cz = (box->min.z + box->max.z) * 0.5f;
+	ex = (box->max.x - box->min.x) * 0.5f;
+	ey = (box->max.y - box->min.y) * 0.5f;
+	ez = (box->max.z - box->min.z) * 0.5f;
+	for (k = 0; k < 6; k++)
+	{
+		p = &f->planes[k];
+		d = p->x * cx + p->y * cy + p->z * cz + p->w;
+		r = fabsf(p->x) * ex + fabsf(p->y) * ey + fabsf(p->z) * ez;
+		if (d + r < 0)
+		{
+			return OCTREE_OUTSIDE;
+		}
+		if (d - r < 0)
+		{
+			result = OCTREE_INTERSECT;
+		}
+	}
+	return result;
+}
+
+unsigned int OctreeQueryAABB(Octree *tree, AABB box, unsigned int *handles,
+		unsigned int max)
+{
+	return QueryOctree(tree, ClassifyAABB, &box, handles, max);
+}
+
+unsigned int OctreeQuerySphere(Octree *tree, Vector3D center, float radius,
+		unsigned int *handles, unsigned int max)
+{
+	SphereQuery q;
+	q.center = center;
+	q.radius = radius;
+	return QueryOctree(tree, ClassifySphere, &q, handles, max);
+}
+
+unsigned int OctreeQueryFrustum(Octree *tree, const Frustum *frustum,
+		unsigned int *handles, unsigned int max)
+{
+	return QueryOctree(tree, ClassifyFrustum, frustum, handles, max);
+}
+
+void FreeOctree(Octree *tree)
+{
+	free(tree->nodes);
+	free(tree->objects);
+	memset(tree, 0, sizeof(Octree));
+	tree->node_free = OCTREE_NONE;
+	tree->object_free = OCTREE_NONE;
+}
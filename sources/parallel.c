@@ -0,0 +1,327 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <ansic3d/parallel.h>
+#include <stdlib.h>
+
+#ifndef ANSIC3D_NO_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define MAX_THREADS 256
+
+static int thread_count = 0;
+static ThreadPool *default_pool = NULL;
+
+#ifndef ANSIC3D_NO_THREADS
+
+#if defined(__GNUC__)
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+// Set while the thread runs a body, nested ParallelFor calls run serially
+static THREAD_LOCAL int inside_job = 0;
+
+struct _ThreadPool
+{
+	int size;
+	pthread_t threads[MAX_THREADS];
+	int started;
+	pthread_mutex_t lock;
+	pthread_mutex_t submit;
+	pthread_cond_t wake;
+	pthread_cond_t idle;
+	unsigned long generation;
+	int busy;
+	int shutdown;
+	// The current job
+	ParallelBody body;
+	void *context;
+	unsigned int n;
+	unsigned int grain;
+	unsigned int chunks;
+	unsigned int next;
+};
+
+// Take chunks of the current job until there is none left
+static void RunChunks(ThreadPool *pool)
+{
+	unsigned int chunk, begin, end;
+	inside_job = 1;
+	for (;;)
+	{
+		chunk = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+		if (chunk >= pool->chunks)
+		{
+			break;
+		}
+		begin = chunk * pool->grain;
+		end = pool->n - begin > pool->grain ? begin + pool->grain : pool->n;
+		pool->body(begin, end, pool->context);
+	}
+	inside_job = 0;
+}
+
+static void *PoolWorker(void *arg)
+{
+	ThreadPool *pool = arg;
+	unsigned long seen = 0;
+	pthread_mutex_lock(&pool->lock);
+	for (;;)
+	{
+		while (pool->generation == seen && !pool->shutdown)
+		{
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		}
+		if (pool->shutdown)
+		{
+			break;
+		}
+		seen = pool->generation;
+		pool->busy++;
+		pthread_mutex_unlock(&pool->lock);
+		RunChunks(pool);
+		pthread_mutex_lock(&pool->lock);
+		pool->busy--;
+		if (pool->busy == 0)
+		{
+			pthread_cond_broadcast(&pool->idle);
+		}
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+ThreadPool *CreateThreadPool(int threads)
+{
+	ThreadPool *pool;
+	if (threads < 1)
+	{
+		threads = 1;
+	}
+	if (threads > MAX_THREADS)
+	{
+		threads = MAX_THREADS;
+	}
+	pool = calloc(1, sizeof(ThreadPool));
+	if (pool == NULL)
+	{
+		return NULL;
+	}
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_mutex_init(&pool->submit, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	pthread_cond_init(&pool->idle, NULL);
+	// Threads that can not be started are left out of the pool
+	for (pool->started = 0; pool->started < threads - 1; pool->started++)
+	{
+		if (pthread_create(&pool->threads[pool->started], NULL, PoolWorker,
+					pool) != 0)
+		{
+			break;
+		}
+	}
+	pool->size = pool->started + 1;
+	return pool;
+}
+
+void DestroyThreadPool(ThreadPool *pool)
+{
+	int i;
+	if (pool == NULL)
+	{
+		return;
+	}
+	pthread_mutex_lock(&pool->lock);
+	pool->shutdown = 1;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+	for (i = 0; i < pool->started; i++)
+	{
+		pthread_join(pool->threads[i], NULL);
+	}
+	pthread_mutex_destroy(&pool->lock);
+	pthread_mutex_destroy(&pool->submit);
+	pthread_cond_destroy(&pool->wake);
+	pthread_cond_destroy(&pool->idle);
+	free(pool);
+}
+
+void ParallelForPool(ThreadPool *pool, unsigned int n, unsigned int grain,
+		ParallelBody body, void *context)
+{
+	if (n == 0)
+	{
+		return;
+	}
+	if (grain == 0)
+	{
+		grain = 1;
+	}
+	if (pool == NULL || pool->size < 2 || n / grain < 2 || inside_job ||
+			pthread_mutex_trylock(&pool->submit) != 0)
+	{
+		body(0, n, context);
+		return;
+	}
+	pthread_mutex_lock(&pool->lock);
+	// Workers late for the previous job must leave it before it changes
+	while (pool->busy > 0)
+	{
+		pthread_cond_wait(&pool->idle, &pool->lock);
+	}
+	pool->body = body;
+	pool->context = context;
+	pool->n = n;
+	pool->grain = grain;
+	pool->chunks = n / grain + (n % grain != 0);
+	pool->next = 0;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	RunChunks(pool);
+
+	// Every chunk is taken, wait for the workers still running one
+	pthread_mutex_lock(&pool->lock);
+	while (pool->busy > 0)
+	{
+		pthread_cond_wait(&pool->idle, &pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	pthread_mutex_unlock(&pool->submit);
+}
+
+#else
+
+struct _ThreadPool
+{
+	int size;
+};
+
+ThreadPool *CreateThreadPool(int threads)
+{
+	ThreadPool *pool = malloc(sizeof(ThreadPool));
+	(void) threads;
+	if (pool != NULL)
+	{
+		pool->size = 1;
+	}
+	return pool;
+}
+
+void DestroyThreadPool(ThreadPool *pool)
+{
+	free(pool);
+}
+
+void ParallelForPool(ThreadPool *pool, unsigned int n, unsigned int grain,
+		ParallelBody body, void *context)
+{
+	(void) pool;
+	(void) grain;
+	if (n > 0)
+	{
+		body(0, n, context);
+	}
+}
+
+#endif
+
+int ThreadPoolSize(ThreadPool *pool)
+{
+	return pool->size;
+}
+
+int GetThreadCount(void)
+{
+	const char *env;
+	if (thread_count > 0)
+	{
+		return thread_count;
+	}
+	env = getenv(THREADS_ENV);
+	if (env != NULL && atoi(env) > 0)
+	{
+		return SetThreadCount(atoi(env));
+	}
+#ifndef ANSIC3D_NO_THREADS
+	return SetThreadCount((int)sysconf(_SC_NPROCESSORS_ONLN));
+#else
+	return SetThreadCount(1);
+#endif
+}
+
+int SetThreadCount(int count)
+{
+	if (count < 1)
+	{
+		count = 1;
+	}
+	if (count > MAX_THREADS)
+	{
+		count = MAX_THREADS;
+	}
+#ifdef ANSIC3D_NO_THREADS
+	count = 1;
+#endif
+	if (count != thread_count && default_pool != NULL)
+	{
+		DestroyThreadPool(default_pool);
+		default_pool = NULL;
+	}
+	thread_count = count;
+	return thread_count;
+}
+
+ThreadPool *GetDefaultThreadPool(void)
+{
+#ifndef ANSIC3D_NO_THREADS
+	static pthread_mutex_t create = PTHREAD_MUTEX_INITIALIZER;
+	pthread_mutex_lock(&create);
+#endif
+	if (default_pool == NULL)
+	{
+		default_pool = CreateThreadPool(GetThreadCount());
+	}
+#ifndef ANSIC3D_NO_THREADS
+	pthread_mutex_unlock(&create);
+#endif
+	return default_pool;
+}
+
+void ParallelFor(unsigned int n, unsigned int grain, ParallelBody body,
+		void *context)
+{
+	if (grain == 0)
+	{
+		grain = 1;
+	}
+	// Small jobs do not need the pool, so it is not started for them
+	if (n / grain < 2 || GetThreadCount() < 2)
+	{
+		if (n > 0)
+		{
+			body(0, n, context);
+		}
+		return;
+	}
+	ParallelForPool(GetDefaultThreadPool(), n, grain, body, context);
+}
@@ -0,0 +1,693 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ansic3d/pointcloud.h>
+
+#define PLY_ASCII 0
+#define PLY_BINARY_LITTLE_ENDIAN 1
+#define PLY_BINARY_BIG_ENDIAN 2
+
+/**
+ * Elements declared before (and including) the vertex element
+ */
+#define PLY_MAX_ELEMENTS 16
+
+#define PLY_CHAR 0
+#define PLY_UCHAR 1
+#define PLY_SHORT 2
+#define PLY_USHORT 3
+#define PLY_INT 4
+#define PLY_UINT 5
+#define PLY_FLOAT 6
+#define PLY_DOUBLE 7
+#define PLY_TYPES 8
+
+static const char *ply_type_names[PLY_TYPES] = {"char", "uchar", "short",
+	"ushort", "int", "uint", "float", "double"};
+static const char *ply_type_aliases[PLY_TYPES] = {"int8", "uint8", "int16",
+	"uint16", "int32", "uint32", "float32", "float64"};
+static const int ply_type_sizes[PLY_TYPES] = {1, 1, 2, 2, 4, 4, 4, 8};
+
+// Powers of ten exactly representable as double
+static const double powers_of_ten[] = {1E0, 1E1, 1E2, 1E3, 1E4, 1E5, 1E6,
+	1E7, 1E8, 1E9, 1E10, 1E11, 1E12, 1E13, 1E14, 1E15, 1E16, 1E17, 1E18,
+	1E19, 1E20, 1E21, 1E22};
+
+typedef struct _PlyElement
+{
+	char name[64];
+	unsigned long count;
+	int properties;
+	int types[PLY_MAX_PROPERTIES];
+	int offsets[PLY_MAX_PROPERTIES];
+	int stride;
+	int has_list;
+	int x, y, z;
+} PlyElement;
+
+typedef struct _PointReader
+{
+	FILE *file;
+	char *buffer;
+	size_t begin;
+	size_t end;
+	int eof;
+	Vector3D *chunk;
+	unsigned int n;
+	PointCloudCallback callback;
+	void *context;
+	VectorList *reserve;
+	long count;
+	int stop;
+} PointReader;
+
+// Move the unread bytes to the start of the buffer and read more after
+// them. Return count of bytes read
+static size_t FillReader(PointReader *r)
+{
+	size_t left = r->end - r->begin;
+	size_t got = 0;
+	memmove(r->buffer, r->buffer + r->begin, left);
+	r->begin = 0;
+	r->end = left;
+	if (!r->eof)
+	{
+		got = fread(r->buffer + left, 1, POINTCLOUD_BUFFER_SIZE - left,
+				r->file);
+		if (got == 0)
+		{
+			r->eof = 1;
+		}
+	}
+	r->end += got;
+	r->buffer[r->end] = '\0';
+	return got;
+}
+
+// Return the next line without the new line character, NULL at the end
+// of the file. The line is valid until the next read.
+static char *ReadLine(PointReader *r)
+{
+	char *line, *newline;
+	for (;;)
+	{
+		line = r->buffer + r->begin;
+		newline = memchr(line, '\n', r->end - r->begin);
+		if (newline != NULL)
+		{
+			*newline = '\0';
+			r->begin = newline - r->buffer + 1;
+			return line;
+		}
+		// Last line of the file or a line longer than the buffer
+		if (r->eof || r->end - r->begin >= POINTCLOUD_BUFFER_SIZE)
+		{
+			if (r->begin == r->end)
+			{
+				return NULL;
+			}
+			r->buffer[r->end] = '\0';
+			r->begin = r->end;
+			return line;
+		}
+		FillReader(r);
+	}
+}
+
+static void FlushPoints(PointReader *r)
+{
+	if (r->n == 0)
+	{
+		return;
+	}
+	r->count += r->n;
+	if (!r->callback(r->chunk, r->n, r->context))
+	{
+		r->stop = 1;
+	}
+	r->n = 0;
+}
+
+static void AddPoint(PointReader *r, float x, float y, float z)
+{
+	Vector3D *v = &r->chunk[r->n];
+	v->x = x;
+	v->y = y;
+	v->z = z;
+	v->w = 1;
+	r->n++;
+	if (r->n == POINTCLOUD_CHUNK)
+	{
+		FlushPoints(r);
+	}
+}
+
+static int IsSeparator(char c)
+{
+	return c == ' ' || c == '\t' || c == ',' || c == '\r';
+}
+
+static int IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+// Parse the next number after the separators at cursor and move the
+// cursor after it. Numbers of up to 19 significant digits with small
+// exponents are converted exactly without strtod.
+// Return 1 on success, 0 if there is no number
+static int ParseFloat(char **cursor, float *value)
+{
+	char *p = *cursor;
+	char *start, *end;
+	uint64_t mantissa = 0;
+	int digits = 0, seen = 0, exponent = 0, negative = 0, e = 0;
+	int e_negative = 0;
+	double d;
+
+	while (IsSeparator(*p))
+	{
+		p++;
+	}
+	start = p;
+	if (*p == '-' || *p == '+')
+	{
+		negative = *p == '-';
+		p++;
+	}
+	for (; IsDigit(*p); p++)
+	{
+		seen = 1;
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			digits += mantissa != 0;
+		}
+		else
+		{
+			exponent++;
+		}
+	}
+	if (*p == '.')
+	{
+		for (p++; IsDigit(*p); p++)
+		{
+			seen = 1;
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				digits += mantissa != 0;
+				exponent--;
+			}
+		}
+	}
+	if (!seen)
+	{
+		// nan, inf and friends
+		d = strtod(start, &end);
+		if (end == start)
+		{
+			return 0;
+		}
+		*value = (float) d;
+		*cursor = end;
+		return 1;
+	}
+	if ((*p == 'e' || *p == 'E') &&
+			(IsDigit(p[1]) || ((p[1] == '-' || p[1] == '+') && IsDigit(p[2]))))
+	{
+		p++;
+		if (*p == '-' || *p == '+')
+		{
+			e_negative = *p == '-';
+			p++;
+		}
+		for (; IsDigit(*p); p++)
+		{
+			if (e < 100000)
+			{
+				e = e * 10 + (*p - '0');
+			}
+		}
+		exponent += e_negative ? -e : e;
+	}
+	if (exponent >= -22 && exponent <= 22 && mantissa <= (1ULL << 53))
+	{
+		d = (double) mantissa;
+		d = exponent < 0 ? d / powers_of_ten[-exponent] :
+			d * powers_of_ten[exponent];
+		*value = (float) (negative ? -d : d);
+	}
+	else
+	{
+		*value = (float) strtod(start, NULL);
+	}
+	*cursor = p;
+	return 1;
+}
+
+static void ReadXYZ(PointReader *r)
+{
+	char *line;
+	float x, y, z;
+	while (!r->stop && (line = ReadLine(r)) != NULL)
+	{
+		if (ParseFloat(&line, &x) && ParseFloat(&line, &y) &&
+				ParseFloat(&line, &z))
+		{
+			AddPoint(r, x, y, z);
+		}
+	}
+}
+
+static int PlyType(const char *name)
+{
+	int i;
+	for (i = 0; i < PLY_TYPES; i++)
+	{
+		if (strcmp(name, ply_type_names[i]) == 0 ||
+				strcmp(name, ply_type_aliases[i]) == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+static int AddPlyProperty(PlyElement *e, const char *line)
+{
+	char type[32], name[64];
+	int t;
+	if (strncmp(line, "property list", 13) == 0)
+	{
+		e->has_list = 1;
+		return 1;
+	}
+	if (sscanf(line, "property %31s %63s", type, name) != 2)
+	{
+		return 0;
+	}
+	t = PlyType(type);
+	if (t < 0 || e->properties == PLY_MAX_PROPERTIES)
+	{
+		return 0;
+	}
+	if (strcmp(name, "x") == 0)
+	{
+		e->x = e->properties;
+	}
+	else if (strcmp(name, "y") == 0)
+	{
+		e->y = e->properties;
+	}
+	else if (strcmp(name, "z") == 0)
+	{
+		e->z = e->properties;
+	}
+	e->types[e->properties] = t;
+	e->offsets[e->properties] = e->stride;
+	e->stride += ply_type_sizes[t];
+	e->properties++;
+	return 1;
+}
+
+// Read the header up to end_header, the elements up to the vertex element
+// are stored. Return count of elements stored, -1 if the header is invalid
+static int ReadPlyHeader(PointReader *r, int *format, PlyElement *elements)
+{
+	char word[32], value[32];
+	char *line;
+	int n = 0, done = 0;
+	size_t length;
+	*format = -1;
+	while ((line = ReadLine(r)) != NULL)
+	{
+		length = strlen(line);
+		if (length > 0 && line[length - 1] == '\r')
+		{
+			line[length - 1] = '\0';
+		}
+		if (sscanf(line, "%31s", word) != 1)
+		{
+			continue;
+		}
+		if (strcmp(word, "end_header") == 0)
+		{
+			return *format < 0 ? -1 : n;
+		}
+		if (strcmp(word, "format") == 0)
+		{
+			if (sscanf(line, "format %31s", value) != 1)
+			{
+				return -1;
+			}
+			if (strcmp(value, "ascii") == 0)
+			{
+				*format = PLY_ASCII;
+			}
+			else if (strcmp(value, "binary_little_endian") == 0)
+			{
+				*format = PLY_BINARY_LITTLE_ENDIAN;
+			}
+			else if (strcmp(value, "binary_big_endian") == 0)
+			{
+				*format = PLY_BINARY_BIG_ENDIAN;
+			}
+			else
+			{
+				return -1;
+			}
+		}
+		else if (strcmp(word, "element") == 0)
+		{
+			// Elements after the vertex element are not read
+			if (done || (n > 0 && strcmp(elements[n - 1].name, "vertex") == 0))
+			{
+				done = 1;
+				continue;
+			}
+			if (n == PLY_MAX_ELEMENTS)
+			{
+				return -1;
+			}
+			memset(&elements[n], 0, sizeof(PlyElement));
+			elements[n].x = elements[n].y = elements[n].z = -1;
+			if (sscanf(line, "element %63s %lu", elements[n].name,
+						&elements[n].count) != 2)
+			{
+				return -1;
+			}
+			n++;
+		}
+		else if (strcmp(word, "property") == 0 && !done && n > 0)
+		{
+			if (!AddPlyProperty(&elements[n - 1], line))
+			{
+				return -1;
+			}
+		}
+	}
+	return -1;
+}
+
+static int IsLittleEndian(void)
+{
+	uint16_t one = 1;
+	return *(unsigned char *) &one == 1;
+}
+
+static float PlyValue(const unsigned char *p, int type, int swap)
+{
+	unsigned char b[8];
+	int8_t c;
+	uint8_t uc;
+	int16_t s;
+	uint16_t us;
+	int32_t i;
+	uint32_t ui;
+	float f;
+	double d;
+	int k, size = ply_type_sizes[type];
+	for (k = 0; k < size; k++)
+	{
+		b[k] = swap ? p[size - 1 - k] : p[k];
+	}
+	switch (type)
+	{
+		case PLY_CHAR:
+			memcpy(&c, b, 1);
+			return c;
+		case PLY_UCHAR:
+			memcpy(&uc, b, 1);
+			return uc;
+		case PLY_SHORT:
+			memcpy(&s, b, 2);
+			return s;
+		case PLY_USHORT:
+			memcpy(&us, b, 2);
+			return us;
+		case PLY_INT:
+			memcpy(&i, b, 4);
+			return i;
+		case PLY_UINT:
+			memcpy(&ui, b, 4);
+			return ui;
+		case PLY_FLOAT:
+			memcpy(&f, b, 4);
+			return f;
+		default:
+			memcpy(&d, b, 8);
+			return (float) d;
+	}
+}
+
+// Skip n bytes of binary data. Return 0 if the file ends before
+static int SkipBytes(PointReader *r, uint64_t n)
+{
+	size_t available;
+	while (n > 0)
+	{
+		if (r->begin == r->end && FillReader(r) == 0)
+		{
+			return 0;
+		}
+		available = r->end - r->begin;
+		if (available > n)
+		{
+			available = n;
+		}
+		r->begin += available;
+		n -= available;
+	}
+	return 1;
+}
+
+static void ReadPlyBinary(PointReader *r, PlyElement *e, int swap)
+{
+	unsigned long remaining = e->count;
+	size_t available, i;
+	const unsigned char *p;
+	float x, y, z;
+	// Native float coordinates are copied without conversion
+	int fast = !swap && e->types[e->x] == PLY_FLOAT &&
+		e->types[e->y] == PLY_FLOAT && e->types[e->z] == PLY_FLOAT;
+	int ox = e->offsets[e->x], oy = e->offsets[e->y], oz = e->offsets[e->z];
+
+	while (remaining > 0 && !r->stop)
+	{
+		available = (r->end - r->begin) / e->stride;
+		if (available == 0)
+		{
+			if (FillReader(r) == 0)
+			{
+				// Truncated file
+				return;
+			}
+			continue;
+		}
+		if (available > remaining)
+		{
+			available = remaining;
+		}
+		p = (const unsigned char *) r->buffer + r->begin;
+		for (i = 0; i < available && !r->stop; i++, p += e->stride)
+		{
+			if (fast)
+			{
+				memcpy(&x, p + ox, sizeof(float));
+				memcpy(&y, p + oy, sizeof(float));
+				memcpy(&z, p + oz, sizeof(float));
+			}
+			else
+			{
+				x = PlyValue(p + ox, e->types[e->x], swap);
+				y = PlyValue(p + oy, e->types[e->y], swap);
+				z = PlyValue(p + oz, e->types[e->z], swap);
+			}
+			AddPoint(r, x, y, z);
+		}
+		r->begin += available * e->stride;
+		remaining -= available;
+	}
+}
+
+static void ReadPlyAscii(PointReader *r, PlyElement *e)
+{
+	float values[PLY_MAX_PROPERTIES];
+	unsigned long i;
+	int j, last;
+	char *line;
+	last = e->x > e->y ? e->x : e->y;
+	last = e->z > last ? e->z : last;
+	for (i = 0; i < e->count && !r->stop; i++)
+	{
+		line = ReadLine(r);
+		if (line == NULL)
+		{
+			return;
+		}
+		for (j = 0; j <= last; j++)
+		{
+			if (!ParseFloat(&line, &values[j]))
+			{
+				break;
+			}
+		}
+		if (j > last)
+		{
+			AddPoint(r, values[e->x], values[e->y], values[e->z]);
+		}
+	}
+}
+
+// Return 1 on success, 0 if the file is not a PLY file we can read
+static int ReadPly(PointReader *r)
+{
+	PlyElement elements[PLY_MAX_ELEMENTS];
+	PlyElement *vertex;
+	unsigned long i;
+	int format, n, k;
+
+	n = ReadPlyHeader(r, &format, elements);
+	if (n < 0)
+	{
+		return 0;
+	}
+	if (n == 0 || strcmp(elements[n - 1].name, "vertex") != 0)
+	{
+		// No vertices
+		return 1;
+	}
+	vertex = &elements[n - 1];
+	if (vertex->x < 0 || vertex->y < 0 || vertex->z < 0 ||
+			(vertex->has_list && format != PLY_ASCII))
+	{
+		return 0;
+	}
+	if (r->reserve != NULL && vertex->count <= (unsigned int) -1 -
+			r->reserve->count)
+	{
+		ReserveVectorList(r->reserve, r->reserve->count + vertex->count);
+	}
+
+	// Skip the elements before the vertex element
+	for (k = 0; k < n - 1; k++)
+	{
+		if (format == PLY_ASCII)
+		{
+			for (i = 0; i < elements[k].count; i++)
+			{
+				if (ReadLine(r) == NULL)
+				{
+					return 1;
+				}
+			}
+		}
+		else if (elements[k].has_list)
+		{
+			return 0;
+		}
+		else if (!SkipBytes(r, (uint64_t) elements[k].count *
+					elements[k].stride))
+		{
+			return 1;
+		}
+	}
+
+	if (format == PLY_ASCII)
+	{
+		ReadPlyAscii(r, vertex);
+	}
+	else
+	{
+		ReadPlyBinary(r, vertex, (format == PLY_BINARY_LITTLE_ENDIAN) !=
+				IsLittleEndian());
+	}
+	return 1;
+}
+
+static long ReadPointCloud(const char *path, PointCloudCallback callback,
+		void *context, VectorList *reserve)
+{
+	PointReader r;
+	int ok = 1;
+
+	memset(&r, 0, sizeof(r));
+	r.callback = callback;
+	r.context = context;
+	r.reserve = reserve;
+	r.file = fopen(path, "rb");
+	if (r.file == NULL)
+	{
+		return -1;
+	}
+	r.buffer = malloc(POINTCLOUD_BUFFER_SIZE + 1);
+	r.chunk = malloc(POINTCLOUD_CHUNK * sizeof(Vector3D));
+	if (r.buffer == NULL || r.chunk == NULL)
+	{
+		ok = 0;
+	}
+	else
+	{
+		FillReader(&r);
+		if (r.end >= 3 && memcmp(r.buffer, "ply", 3) == 0 &&
+				(r.buffer[3] == '\n' || r.buffer[3] == '\r'))
+		{
+			ReadLine(&r);
+			ok = ReadPly(&r);
+		}
+		else
+		{
+			ReadXYZ(&r);
+		}
+		if (ok && !r.stop)
+		{
+			FlushPoints(&r);
+		}
+	}
+	free(r.buffer);
+	free(r.chunk);
+	fclose(r.file);
+	return ok ? r.count : -1;
+}
+
+long StreamPointCloud(const char *path, PointCloudCallback callback,
+		void *context)
+{
+	return ReadPointCloud(path, callback, context, NULL);
+}
+
+static int PushPointChunk(const Vector3D *points, unsigned int n,
+		void *context)
+{
+	return PushVectors(points, n, (VectorList *) context) != 0;
+}
+
+long LoadPointCloud(const char *path, VectorList *list)
+{
+	unsigned int before = list->count;
+	long count = ReadPointCloud(path, PushPointChunk, list, list);
+	if (count < 0 || list->count - before != (unsigned long) count)
+	{
+		return -1;
+	}
+	return count;
+}
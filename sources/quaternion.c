@@ -0,0 +1,208 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <ansic3d/quaternion.h>
+#include <ansic3d/trig.h>
+
+// Above this dot product slerp falls back to nlerp, sin(theta) gets too
+// small to divide by
+#define SLERP_THRESHOLD 0.9995f
+
+void IdentityQuaternion(Quaternion *target)
+{
+	target->x = 0;
+	target->y = 0;
+	target->z = 0;
+	target->w = 1;
+}
+
+void AxisAngleQuaternion(Vector3D axis, float angle, Quaternion *target)
+{
+	float s, c;
+	NormalizeVector(&axis);
+	SinCos(angle * 0.5f, &s, &c);
+	target->x = axis.x * s;
+	target->y = axis.y * s;
+	target->z = axis.z * s;
+	target->w = c;
+}
+
+void MultiplyQuaternion(Quaternion q1, Quaternion q2, Quaternion *target)
+{
+	target->x = q1.w * q2.x + q1.x * q2.w + q1.y * q2.z - q1.z * q2.y;
+	target->y = q1.w * q2.y - q1.x * q2.z + q1.y * q2.w + q1.z * q2.x;
+	target->z = q1.w * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.w;
+	target->w = q1.w * q2.w - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z;
+}
+
+void NormalizeQuaternion(Quaternion *target)
+{
+	float invlen;
+	float len = sqrtf(QuaternionDot(*target, *target));
+	if (len != 0)
+	{
+		invlen = 1 / len;
+		target->x *= invlen;
+		target->y *= invlen;
+		target->z *= invlen;
+		target->w *= invlen;
+	}
+}
+
+void ConjugateQuaternion(Quaternion *target)
+{
+	target->x = -target->x;
+	target->y = -target->y;
+	target->z = -target->z;
+}
+
+float QuaternionDot(Quaternion q1, Quaternion q2)
+{
+	return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+}
+
+void NlerpQuaternion(Quaternion q1, Quaternion q2, float t,
+		Quaternion *target)
+{
+	float t1 = 1 - t;
+	// q and -q are the same rotation, take the shortest arc
+	if (QuaternionDot(q1, q2) < 0)
+	{
+		t = -t;
+	}
+	target->x = q1.x * t1 + q2.x * t;
+	target->y = q1.y * t1 + q2.y * t;
+	target->z = q1.z * t1 + q2.z * t;
+	target->w = q1.w * t1 + q2.w * t;
+	NormalizeQuaternion(target);
+}
+
+void SlerpQuaternion(Quaternion q1, Quaternion q2, float t,
+		Quaternion *target)
+{
+	float dot, theta, sine, s1, s2;
+	dot = QuaternionDot(q1, q2);
+	if (dot < 0)
+	{
+		dot = -dot;
+		q2.x = -q2.x;
+		q2.y = -q2.y;
+		q2.z = -q2.z;
+		q2.w = -q2.w;
+	}
+	if (dot > SLERP_THRESHOLD)
+	{
+		NlerpQuaternion(q1, q2, t, target);
+		return;
+	}
+	theta = acosf(dot);
+	sine = sinf(theta);
+	s1 = sinf((1 - t) * theta) / sine;
+	s2 = sinf(t * theta) / sine;
+	target->x = q1.x * s1 + q2.x * s2;
+	target->y = q1.y * s1 + q2.y * s2;
+	target->z = q1.z * s1 + q2.z * s2;
+	target->w = q1.w * s1 + q2.w * s2;
+}
+
+void QuaternionToMatrix(Quaternion q, Matrix3D *target)
+{
+	float xx, yy, zz, xy, xz, yz, wx, wy, wz;
+	xx = 2 * q.x * q.x;
+	yy = 2 * q.y * q.y;
+	zz = 2 * q.z * q.z;
+	xy = 2 * q.x * q.y;
+	xz = 2 * q.x * q.z;
+	yz = 2 * q.y * q.z;
+	wx = 2 * q.w * q.x;
+	wy = 2 * q.w * q.y;
+	wz = 2 * q.w * q.z;
+	SetVector(1 - yy - zz, xy - wz, xz + wy, 0, &target->X);
+	SetVector(xy + wz, 1 - xx - zz, yz - wx, 0, &target->Y);
+	SetVector(xz - wy, yz + wx, 1 - xx - yy, 0, &target->Z);
+	SetVector(0, 0, 0, 1, &target->W);
+}
+
+void MatrixToQuaternion(Matrix3D *matrix, Quaternion *target)
+{
+	float s, trace;
+	trace = matrix->X.x + matrix->Y.y + matrix->Z.z;
+	// Pick the largest of w, x, y, z to divide by for stability
+	if (trace > 0)
+	{
+		s = sqrtf(trace + 1) * 2;
+		target->w = 0.25f * s;
+		target->x = (matrix->Z.y - matrix->Y.z) / s;
+		target->y = (matrix->X.z - matrix->Z.x) / s;
+		target->z = (matrix->Y.x - matrix->X.y) / s;
+	}
+	else if (matrix->X.x > matrix->Y.y && matrix->X.x > matrix->Z.z)
+	{
+		s = sqrtf(1 + matrix->X.x - matrix->Y.y - matrix->Z.z) * 2;
+		target->w = (matrix->Z.y - matrix->Y.z) / s;
+		target->x = 0.25f * s;
+		target->y = (matrix->X.y + matrix->Y.x) / s;
+		target->z = (matrix->X.z + matrix->Z.x) / s;
+	}
+	else if (matrix->Y.y > matrix->Z.z)
+	{
+		s = sqrtf(1 + matrix->Y.y - matrix->X.x - matrix->Z.z) * 2;
+		target->w = (matrix->X.z - matrix->Z.x) / s;
+		target->x = (matrix->X.y + matrix->Y.x) / s;
+		target->y = 0.25f * s;
+		target->z = (matrix->Y.z + matrix->Z.y) / s;
+	}
+	else
+	{
+		s = sqrtf(1 + matrix->Z.z - matrix->X.x - matrix->Y.y) * 2;
+		target->w = (matrix->Y.x - matrix->X.y) / s;
+		target->x = (matrix->X.z + matrix->Z.x) / s;
+		target->y = (matrix->Y.z + matrix->Z.y) / s;
+		target->z = 0.25f * s;
+	}
+}
+
+void QuaternionRotateVector(Quaternion q, Vector3D *target)
+{
+	Vector3D u, t, c;
+	// VectorTransform multiplies row vectors, which rotates by the
+	// conjugate. v' = v + w * t + u x t with u = -q.xyz, t = 2 * (u x v)
+	SetVector(-q.x, -q.y, -q.z, 0, &u);
+	CrossProduct(u, *target, &t);
+	t.x *= 2;
+	t.y *= 2;
+	t.z *= 2;
+	CrossProduct(u, t, &c);
+	target->x += q.w * t.x + c.x;
+	target->y += q.w * t.y + c.y;
+	target->z += q.w * t.z + c.z;
+}
+
+void QuaternionRotateVectorList(Quaternion q, VectorList *list)
+{
+	Matrix3D matrix;
+	// 9 multiplications per vector on the SIMD transform kernel, cheaper
+	// than the 15 of QuaternionRotateVector
+	QuaternionToMatrix(q, &matrix);
+	TransformVectorListInPlace(&matrix, list);
+}
+
+int QuaternionEquals(Quaternion q1, Quaternion q2)
+{
+	return fabsf(q1.x - q2.x) < PRECISION && fabsf(q1.y - q2.y) < PRECISION &&
+		fabsf(q1.z - q2.z) < PRECISION && fabsf(q1.w - q2.w) < PRECISION;
+}
@@ -0,0 +1,389 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <math.h>
+#include <stdlib.h>
+#include <ansic3d/ray.h>
+#include <ansic3d/parallel.h>
+#include <ansic3d/cpu.h>
+
+#ifdef ANSIC3D_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/**
+ * Packets of rays per parallel chunk of IntersectRays
+ */
+#define RAY_PACKET_GRAIN 16
+
+/**
+ * Triangle as v0 and its two edges, 9 floats broadcast by the kernels
+ */
+typedef struct _RayTriangleData
+{
+	float v0x, v0y, v0z;
+	float e1x, e1y, e1z;
+	float e2x, e2y, e2z;
+} RayTriangleData;
+
+typedef struct _RayJob
+{
+	const Ray *rays;
+	unsigned int ray_count;
+	const RayTriangleData *triangles;
+	unsigned int triangle_count;
+	RayHit *hits;
+} RayJob;
+
+static void PrepareTriangle(const Vector3D *v0, const Vector3D *v1,
+		const Vector3D *v2, RayTriangleData *tri)
+{
+	tri->v0x = v0->x;
+	tri->v0y = v0->y;
+	tri->v0z = v0->z;
+	tri->e1x = v1->x - v0->x;
+	tri->e1y = v1->y - v0->y;
+	tri->e1z = v1->z - v0->z;
+	tri->e2x = v2->x - v0->x;
+	tri->e2y = v2->y - v0->y;
+	tri->e2z = v2->z - v0->z;
+}
+
+// Moller-Trumbore, the SIMD kernels repeat every operation in this order
+static int RayTriangleCore(float ox, float oy, float oz, float dx, float dy,
+		float dz, const RayTriangleData *tri, float t_max, float *t, float *u,
+		float *v)
+{
+	float px, py, pz, qx, qy, qz, sx, sy, sz, det, inv, hu, hv, ht;
+	px = dy * tri->e2z - dz * tri->e2y;
+	py = dz * tri->e2x - dx * tri->e2z;
+	pz = dx * tri->e2y - dy * tri->e2x;
+	det = tri->e1x * px + tri->e1y * py + tri->e1z * pz;
+	if (!(fabsf(det) >= RAY_EPSILON))
+	{
+		return 0;
+	}
+	inv = 1 / det;
+	sx = ox - tri->v0x;
+	sy = oy - tri->v0y;
+	sz = oz - tri->v0z;
+	hu = (sx * px + sy * py + sz * pz) * inv;
+	qx = sy * tri->e1z - sz * tri->e1y;
+	qy = sz * tri->e1x - sx * tri->e1z;
+	qz = sx * tri->e1y - sy * tri->e1x;
+	hv = (dx * qx + dy * qy + dz * qz) * inv;
+	ht = (tri->e2x * qx + tri->e2y * qy + tri->e2z * qz) * inv;
+	if (!(hu >= 0 && hv >= 0 && hu + hv <= 1 && ht > 0 && ht < t_max))
+	{
+		return 0;
+	}
+	*t = ht;
+	*u = hu;
+	*v = hv;
+	return 1;
+}
+
+void SetRay(Vector3D origin, Vector3D direction, Ray *ray)
+{
+	ray->origin = origin;
+	ray->direction = direction;
+	ray->t_max = INFINITY;
+}
+
+int IntersectRayTriangle(const Ray *ray, Vector3D v0, Vector3D v1,
+		Vector3D v2, float *t, float *u, float *v)
+{
+	RayTriangleData tri;
+	PrepareTriangle(&v0, &v1, &v2, &tri);
+	return RayTriangleCore(ray->origin.x, ray->origin.y, ray->origin.z,
+			ray->direction.x, ray->direction.y, ray->direction.z, &tri,
+			ray->t_max, t, u, v);
+}
+
+void LoadRayPacket(const Ray *rays, unsigned int count, RayPacket *packet)
+{
+	unsigned int i;
+	for (i = 0; i < RAY_PACKET_SIZE; i++)
+	{
+		if (i < count)
+		{
+			packet->ox[i] = rays[i].origin.x;
+			packet->oy[i] = rays[i].origin.y;
+			packet->oz[i] = rays[i].origin.z;
+			packet->dx[i] = rays[i].direction.x;
+			packet->dy[i] = rays[i].direction.y;
+			packet->dz[i] = rays[i].direction.z;
+			packet->t[i] = rays[i].t_max;
+		}
+		else
+		{
+			// t < t_max fails for every t > 0
+			packet->ox[i] = packet->oy[i] = packet->oz[i] = 0;
+			packet->dx[i] = packet->dy[i] = packet->dz[i] = 0;
+			packet->t[i] = 0;
+		}
+		packet->u[i] = packet->v[i] = 0;
+		packet->triangle[i] = RAY_NO_HIT;
+	}
+	packet->count = count < RAY_PACKET_SIZE ? count : RAY_PACKET_SIZE;
+}
+
+void StoreRayPacket(const RayPacket *packet, RayHit *hits)
+{
+	unsigned int i;
+	for (i = 0; i < packet->count; i++)
+	{
+		hits[i].t = packet->t[i];
+		hits[i].u = packet->u[i];
+		hits[i].v = packet->v[i];
+		hits[i].triangle = packet->triangle[i];
+	}
+}
+
+static unsigned int PacketTriangleScalar(RayPacket *p,
+		const RayTriangleData *tri, unsigned int triangle)
+{
+	unsigned int i, mask = 0;
+	for (i = 0; i < RAY_PACKET_SIZE; i++)
+	{
+		if (RayTriangleCore(p->ox[i], p->oy[i], p->oz[i], p->dx[i], p->dy[i],
+					p->dz[i], tri, p->t[i], &p->t[i], &p->u[i], &p->v[i]))
+		{
+			p->triangle[i] = triangle;
+			mask |= 1U << i;
+		}
+	}
+	return mask;
+}
+
+#ifdef ANSIC3D_X86_SIMD
+// 4 rays of the packet starting at lane
+__attribute__((target("sse2")))
+static unsigned int PacketTriangleSSE(RayPacket *p, unsigned int lane,
+		const RayTriangleData *tri, unsigned int triangle)
+{
+	__m128 dx, dy, dz, sx, sy, sz, px, py, pz, qx, qy, qz;
+	__m128 e1x, e1y, e1z, e2x, e2y, e2z, det, inv, u, v, t, hit, zero;
+	__m128 sign = _mm_set1_ps(-0.0f);
+	__m128i index;
+	zero = _mm_setzero_ps();
+	e1x = _mm_set1_ps(tri->e1x);
+	e1y = _mm_set1_ps(tri->e1y);
+	e1z = _mm_set1_ps(tri->e1z);
+	e2x = _mm_set1_ps(tri->e2x);
+	e2y = _mm_set1_ps(tri->e2y);
+	e2z = _mm_set1_ps(tri->e2z);
+	dx = _mm_loadu_ps(&p->dx[lane]);
+	dy = _mm_loadu_ps(&p->dy[lane]);
+	dz = _mm_loadu_ps(&p->dz[lane]);
+	px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+	py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+	pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+	det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)),
+			_mm_mul_ps(e1z, pz));
+	hit = _mm_cmpge_ps(_mm_andnot_ps(sign, det), _mm_set1_ps(RAY_EPSILON));
+	if (_mm_movemask_ps(hit) == 0)
+	{
+		return 0;
+	}
+	inv = _mm_div_ps(_mm_set1_ps(1), det);
+	sx = _mm_sub_ps(_mm_loadu_ps(&p->ox[lane]), _mm_set1_ps(tri->v0x));
+	sy = _mm_sub_ps(_mm_loadu_ps(&p->oy[lane]), _mm_set1_ps(tri->v0y));
+	sz = _mm_sub_ps(_mm_loadu_ps(&p->oz[lane]), _mm_set1_ps(tri->v0z));
+	u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px),
+					_mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inv);
+	qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+	qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+	qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+	v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx),
+					_mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv);
+	t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx),
+					_mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv);
+	hit = _mm_and_ps(hit, _mm_cmpge_ps(u, zero));
+	hit = _mm_and_ps(hit, _mm_cmpge_ps(v, zero));
+	hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1)));
+	hit = _mm_and_ps(hit, _mm_cmpgt_ps(t, zero));
+	hit = _mm_and_ps(hit, _mm_cmplt_ps(t, _mm_loadu_ps(&p->t[lane])));
+	if (_mm_movemask_ps(hit) == 0)
+	{
+		return 0;
+	}
+	_mm_storeu_ps(&p->t[lane], _mm_or_ps(_mm_and_ps(hit, t),
+				_mm_andnot_ps(hit, _mm_loadu_ps(&p->t[lane]))));
+	_mm_storeu_ps(&p->u[lane], _mm_or_ps(_mm_and_ps(hit, u),
+				_mm_andnot_ps(hit, _mm_loadu_ps(&p->u[lane]))));
+	_mm_storeu_ps(&p->v[lane], _mm_or_ps(_mm_and_ps(hit, v),
+				_mm_andnot_ps(hit, _mm_loadu_ps(&p->v[lane]))));
+	index = _mm_castps_si128(hit);
+	_mm_storeu_si128((__m128i *) &p->triangle[lane], _mm_or_si128(
+				_mm_and_si128(index, _mm_set1_epi32((int) triangle)),
+				_mm_andnot_si128(index,
+					_mm_loadu_si128((__m128i *) &p->triangle[lane]))));
+	return (unsigned int) _mm_movemask_ps(hit);
+}
+
+__attribute__((target("avx")))
+static unsigned int PacketTriangleAVX(RayPacket *p,
+		const RayTriangleData *tri, unsigned int triangle)
+{
+	__m256 dx, dy, dz, sx, sy, sz, px, py, pz, qx, qy, qz;
+	__m256 e1x, e1y, e1z, e2x, e2y, e2z, det, inv, u, v, t, hit, zero;
+	__m256 sign = _mm256_set1_ps(-0.0f);
+	unsigned int mask;
+	zero = _mm256_setzero_ps();
+	e1x = _mm256_set1_ps(tri->e1x);
+	e1y = _mm256_set1_ps(tri->e1y);
+	e1z = _mm256_set1_ps(tri->e1z);
+	e2x = _mm256_set1_ps(tri->e2x);
+	e2y = _mm256_set1_ps(tri->e2y);
+	e2z = _mm256_set1_ps(tri->e2z);
+	dx = _mm256_loadu_ps(p->dx);
+	dy = _mm256_loadu_ps(p->dy);
+	dz = _mm256_loadu_ps(p->dz);
+	px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+	py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+	pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+	det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px),
+				_mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz));
+	hit = _mm256_cmp_ps(_mm256_andnot_ps(sign, det),
+			_mm256_set1_ps(RAY_EPSILON), _CMP_GE_OQ);
+	if (_mm256_movemask_ps(hit) == 0)
+	{
+		_mm256_zeroupper();
+		return 0;
+	}
+	inv = _mm256_div_ps(_mm256_set1_ps(1), det);
+	sx = _mm256_sub_ps(_mm256_loadu_ps(p->ox), _mm256_set1_ps(tri->v0x));
+	sy = _mm256_sub_ps(_mm256_loadu_ps(p->oy), _mm256_set1_ps(tri->v0y));
+	sz = _mm256_sub_ps(_mm256_loadu_ps(p->oz), _mm256_set1_ps(tri->v0z));
+	u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, px),
+					_mm256_mul_ps(sy, py)), _mm256_mul_ps(sz, pz)), inv);
+	qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+	qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+	qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+	v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx),
+					_mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)), inv);
+	t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx),
+					_mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), inv);
+	hit = _mm256_and_ps(hit, _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+	hit = _mm256_and_ps(hit, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+	hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_add_ps(u, v),
+				_mm256_set1_ps(1), _CMP_LE_OQ));
+	hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, zero, _CMP_GT_OQ));
+	hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, _mm256_loadu_ps(p->t),
+				_CMP_LT_OQ));
+	mask = (unsigned int) _mm256_movemask_ps(hit);
+	if (mask == 0)
+	{
+		_mm256_zeroupper();
+		return 0;
+	}
+	_mm256_storeu_ps(p->t, _mm256_blendv_ps(_mm256_loadu_ps(p->t), t, hit));
+	_mm256_storeu_ps(p->u, _mm256_blendv_ps(_mm256_loadu_ps(p->u), u, hit));
+	_mm256_storeu_ps(p->v, _mm256_blendv_ps(_mm256_loadu_ps(p->v), v, hit));
+	_mm256_storeu_ps((float *) p->triangle, _mm256_blendv_ps(
+				_mm256_loadu_ps((float *) p->triangle),
+				_mm256_castsi256_ps(_mm256_set1_epi32((int) triangle)), hit));
+	_mm256_zeroupper();
+	return mask;
+}
+#endif
+
+static unsigned int PacketTriangle(RayPacket *packet,
+		const RayTriangleData *tri, unsigned int triangle)
+{
+#ifdef ANSIC3D_X86_SIMD
+	if (GetSIMDLevel() >= SIMD_AVX)
+	{
+		return PacketTriangleAVX(packet, tri, triangle);
+	}
+	if (GetSIMDLevel() >= SIMD_SSE)
+	{
+		return PacketTriangleSSE(packet, 0, tri, triangle) |
+			PacketTriangleSSE(packet, 4, tri, triangle) << 4;
+	}
+#endif
+	return PacketTriangleScalar(packet, tri, triangle);
+}
+
+unsigned int IntersectRayPacketTriangle(RayPacket *packet, Vector3D v0,
+		Vector3D v1, Vector3D v2, unsigned int triangle)
+{
+	RayTriangleData tri;
+	PrepareTriangle(&v0, &v1, &v2, &tri);
+	return PacketTriangle(packet, &tri, triangle);
+}
+
+static void IntersectPackets(unsigned int begin, unsigned int end,
+		void *context)
+{
+	RayJob *job = context;
+	RayPacket packet;
+	unsigned int k, i, first;
+	for (k = begin; k < end; k++)
+	{
+		first = k * RAY_PACKET_SIZE;
+		LoadRayPacket(&job->rays[first], job->ray_count - first, &packet);
+		for (i = 0; i < job->triangle_count; i++)
+		{
+			PacketTriangle(&packet, &job->triangles[i], i);
+		}
+		StoreRayPacket(&packet, &job->hits[first]);
+	}
+}
+
+unsigned int IntersectRays(const Ray *rays, unsigned int ray_count,
+		const Vector3D *vertices, const unsigned int *indices,
+		unsigned int triangle_count, RayHit *hits)
+{
+	RayJob job;
+	RayTriangleData *triangles;
+	unsigned int i, hit_count = 0;
+	triangles = malloc((triangle_count > 0 ? triangle_count : 1) *
+			sizeof(RayTriangleData));
+	if (triangles == NULL)
+	{
+		return 0;
+	}
+	for (i = 0; i < triangle_count; i++)
+	{
+		if (indices != NULL)
+		{
+			PrepareTriangle(&vertices[indices[3 * i]],
+					&vertices[indices[3 * i + 1]],
+					&vertices[indices[3 * i + 2]], &triangles[i]);
+		}
+		else
+		{
+			PrepareTriangle(&vertices[3 * i], &vertices[3 * i + 1],
+					&vertices[3 * i + 2], &triangles[i]);
+		}
+	}
+	job.rays = rays;
+	job.ray_count = ray_count;
+	job.triangles = triangles;
+	job.triangle_count = triangle_count;
+	job.hits = hits;
+	ParallelFor((ray_count + RAY_PACKET_SIZE - 1) / RAY_PACKET_SIZE,
+			RAY_PACKET_GRAIN, IntersectPackets, &job);
+	free(triangles);
+	for (i = 0; i < ray_count; i++)
+	{
+		hit_count += hits[i].triangle != RAY_NO_HIT;
+	}
+	return hit_count;
+}
@@ -0,0 +1,385 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ansic3d/spatialhash.h>
+#include <ansic3d/parallel.h>
+#include <ansic3d/inline.h>
+
+/**
+ * Minimum number of points per rebuild chunk
+ */
+#define SPATIALHASH_GRAIN 16384
+
+typedef struct _HashBuild
+{
+	SpatialHash *hash;
+	const Vector3D *points;
+	unsigned int grain;
+} HashBuild;
+
+typedef void (*HashVisitor)(unsigned int index, float distance,
+		void *context);
+
+typedef struct _HashQuery
+{
+	unsigned int *indices;
+	unsigned int max;
+	unsigned int found;
+	unsigned int first;
+	SpatialPairCallback callback;
+	void *context;
+} HashQuery;
+
+static unsigned int NextPowerOfTwo(unsigned int n)
+{
+	unsigned int p = 1;
+	while (p < n && p < (1U << 31))
+	{
+		p <<= 1;
+	}
+	return p;
+}
+
+static int CellCoord(float v, float inv_cell_size)
+{
+	return (int) floorf(v * inv_cell_size);
+}
+
+static unsigned int HashCell(int x, int y, int z, unsigned int table_size)
+{
+	return (((unsigned int) x * 73856093U) ^ ((unsigned int) y * 19349663U) ^
+			((unsigned int) z * 83492791U)) & (table_size - 1);
+}
+
+static unsigned int HashPoint(SpatialHash *hash, const Vector3D *v)
+{
+	return HashCell(CellCoord(v->x, hash->inv_cell_size),
+			CellCoord(v->y, hash->inv_cell_size),
+			CellCoord(v->z, hash->inv_cell_size), hash->table_size);
+}
+
+void InitSpatialHash(SpatialHash *hash, float cell_size,
+		unsigned int table_size)
+{
+	memset(hash, 0, sizeof(SpatialHash));
+	hash->cell_size = cell_size;
+	hash->inv_cell_size = 1 / cell_size;
+	hash->fixed_size = table_size > 0 ? NextPowerOfTwo(table_size) : 0;
+}
+
+// Resize *p to n unsigned ints. Return 0 if fails
+static int ResizeArray(unsigned int **p, size_t n)
+{
+	void *q = realloc(*p, (n > 0 ? n : 1) * sizeof(unsigned int));
+	if (q == NULL)
+	{
+		return 0;
+	}
+	*p = q;
+	return 1;
+}
+
+// Keys of [begin, end) and the histogram of the chunks they belong to.
+// Ranges are cut at chunk boundaries, so any split of the work (also the
+// serial fallback of ParallelFor) gives the same histograms.
+static void HashKeysRange(unsigned int begin, unsigned int end,
+		void *context)
+{
+	HashBuild *b = context;
+	SpatialHash *hash = b->hash;
+	unsigned int i, key, *counts;
+	for (i = begin; i < end; i++)
+	{
+		counts = &hash->histogram[(size_t) (i / b->grain) * hash->table_size];
+		key = HashPoint(hash, &b->points[i]);
+		hash->keys[i] = key;
+		counts[key]++;
+	}
+}
+
+static void HashScatterRange(unsigned int begin, unsigned int end,
+		void *context)
+{
+	HashBuild *b = context;
+	SpatialHash *hash = b->hash;
+	unsigned int i, *offsets;
+	for (i = begin; i < end; i++)
+	{
+		offsets = &hash->histogram[(size_t) (i / b->grain) * hash->table_size];
+		hash->entries[offsets[hash->keys[i]]++] = i;
+	}
+}
+
+int RebuildSpatialHash(SpatialHash *hash, VectorList *list)
+{
+	HashBuild b;
+	unsigned int n = list->count, chunks, table, k, c, running, t;
+
+	table = hash->fixed_size > 0 ? hash->fixed_size : NextPowerOfTwo(n);
+	chunks = n / SPATIALHASH_GRAIN;
+	if (chunks > (unsigned int) GetThreadCount())
+	{
+		chunks = GetThreadCount();
+	}
+	if (chunks > SPATIALHASH_MAX_CHUNKS)
+	{
+		chunks = SPATIALHASH_MAX_CHUNKS;
+	}
+	if (chunks < 1)
+	{
+		chunks = 1;
+	}
+	if (hash->start == NULL || table != hash->table_size)
+	{
+		if (!ResizeArray(&hash->start, (size_t) table + 1) ||
+				!ResizeArray(&hash->pending_head, table))
+		{
+			return 0;
+		}
+	}
+	if (hash->entries == NULL || n > hash->capacity)
+	{
+		if (!ResizeArray(&hash->entries, n) || !ResizeArray(&hash->keys, n))
+		{
+			return 0;
+		}
+		hash->capacity = n;
+	}
+	if (hash->histogram == NULL || chunks * table > hash->histogram_capacity)
+	{
+		if (!ResizeArray(&hash->histogram, (size_t) chunks * table))
+		{
+			return 0;
+		}
+		hash->histogram_capacity = chunks * table;
+	}
+	hash->table_size = table;
+	hash->list = list;
+	hash->count = hash->built = n;
+	hash->pending_count = 0;
+	for (k = 0; k < table; k++)
+	{
+		hash->pending_head[k] = SPATIALHASH_NONE;
+	}
+	memset(hash->histogram, 0, (size_t) chunks * table * sizeof(unsigned int));
+
+	b.hash = hash;
+	b.points = list->vectors;
+	b.grain = (n + chunks - 1) / chunks;
+	if (b.grain == 0)
+	{
+		b.grain = 1;
+	}
+	ParallelFor(n, b.grain, HashKeysRange, &b);
+	// Exclusive prefix sum, bucket major then chunk, keeps the points of a
+	// bucket in index order
+	running = 0;
+	for (k = 0; k < table; k++)
+	{
+		hash->start[k] = running;
+		for (c = 0; c < chunks; c++)
+		{
+			t = hash->histogram[(size_t) c * table + k];
+			hash->histogram[(size_t) c * table + k] = running;
+			running += t;
+		}
+	}
+	hash->start[table] = running;
+	ParallelFor(n, b.grain, HashScatterRange, &b);
+	return n;
+}
+
+int InsertSpatialHash(SpatialHash *hash, unsigned int index)
+{
+	unsigned int key, capacity;
+	if (hash->list == NULL || hash->table_size == 0 ||
+			index >= hash->list->count)
+	{
+		return 0;
+	}
+	if (hash->pending_count >= hash->pending_capacity)
+	{
+		capacity = hash->pending_capacity > 0 ? hash->pending_capacity * 2 : 64;
+		if (!ResizeArray(&hash->pending_index, capacity) ||
+				!ResizeArray(&hash->pending_next, capacity))
+		{
+			return 0;
+		}
+		hash->pending_capacity = capacity;
+	}
+	key = HashPoint(hash, &hash->list->vectors[index]);
+	hash->pending_index[hash->pending_count] = index;
+	hash->pending_next[hash->pending_count] = hash->pending_head[key];
+	hash->pending_head[key] = hash->pending_count;
+	hash->pending_count++;
+	hash->count++;
+	return hash->count;
+}
+
+static void VisitBucket(SpatialHash *hash, unsigned int bucket,
+		const Vector3D *query, float r2, HashVisitor visitor, void *context)
+{
+	const Vector3D *points = hash->list->vectors;
+	unsigned int e, i;
+	float d2;
+	for (e = hash->start[bucket]; e < hash->start[bucket + 1]; e++)
+	{
+		i = hash->entries[e];
+		d2 = VectorDistanceSquaredInline(&points[i], query);
+		if (d2 <= r2)
+		{
+			visitor(i, d2, context);
+		}
+	}
+	for (e = hash->pending_head[bucket]; e != SPATIALHASH_NONE;
+			e = hash->pending_next[e])
+	{
+		i = hash->pending_index[e];
+		d2 = VectorDistanceSquaredInline(&points[i], query);
+		if (d2 <= r2)
+		{
+			visitor(i, d2, context);
+		}
+	}
+}
+
+// Visit every point within radius of query. Buckets shared by several
+// cells through hash collisions are scanned once.
+static void VisitRadius(SpatialHash *hash, const Vector3D *query,
+		float radius, HashVisitor visitor, void *context)
+{
+	unsigned int visited[SPATIALHASH_MAX_QUERY_CELLS];
+	unsigned int visited_count = 0, bucket, k;
+	int x0, y0, z0, x1, y1, z1, x, y, z;
+	double cells;
+	float inv = hash->inv_cell_size, r2 = radius * radius;
+
+	if (hash->table_size == 0 || hash->list == NULL || !(radius >= 0))
+	{
+		return;
+	}
+	x0 = CellCoord(query->x - radius, inv);
+	y0 = CellCoord(query->y - radius, inv);
+	z0 = CellCoord(query->z - radius, inv);
+	x1 = CellCoord(query->x + radius, inv);
+	y1 = CellCoord(query->y + radius, inv);
+	z1 = CellCoord(query->z + radius, inv);
+	cells = ((double) x1 - x0 + 1) * ((double) y1 - y0 + 1) *
+		((double) z1 - z0 + 1);
+	if (cells > SPATIALHASH_MAX_QUERY_CELLS || cells > hash->table_size)
+	{
+		for (bucket = 0; bucket < hash->table_size; bucket++)
+		{
+			VisitBucket(hash, bucket, query, r2, visitor, context);
+		}
+		return;
+	}
+	for (x = x0; x <= x1; x++)
+	{
+		for (y = y0; y <= y1; y++)
+		{
+			for (z = z0; z <= z1; z++)
+			{
+				bucket = HashCell(x, y, z, hash->table_size);
+				for (k = 0; k < visited_count; k++)
+				{
+					if (visited[k] == bucket)
+					{
+						break;
+					}
+				}
+				if (k < visited_count)
+				{
+					continue;
+				}
+				visited[visited_count++] = bucket;
+				VisitBucket(hash, bucket, query, r2, visitor, context);
+			}
+		}
+	}
+}
+
+static void CollectRadius(unsigned int index, float distance, void *context)
+{
+	HashQuery *q = context;
+	(void) distance;
+	if (q->found < q->max)
+	{
+		q->indices[q->found] = index;
+	}
+	q->found++;
+}
+
+unsigned int SpatialHashRadius(SpatialHash *hash, Vector3D query,
+		float radius, unsigned int *indices, unsigned int max)
+{
+	HashQuery q;
+	q.indices = indices;
+	q.max = indices != NULL ? max : 0;
+	q.found = 0;
+	VisitRadius(hash, &query, radius, CollectRadius, &q);
+	return q.found;
+}
+
+static void CollectPair(unsigned int index, float distance, void *context)
+{
+	HashQuery *q = context;
+	if (index > q->first)
+	{
+		if (q->callback != NULL)
+		{
+			q->callback(q->first, index, distance, q->context);
+		}
+		q->found++;
+	}
+}
+
+unsigned int SpatialHashPairs(SpatialHash *hash, float radius,
+		SpatialPairCallback callback, void *context)
+{
+	HashQuery q;
+	unsigned int i, p;
+	q.found = 0;
+	q.callback = callback;
+	q.context = context;
+	if (hash->list == NULL)
+	{
+		return 0;
+	}
+	for (i = 0; i < hash->built + hash->pending_count; i++)
+	{
+		p = i < hash->built ? i : hash->pending_index[i - hash->built];
+		q.first = p;
+		VisitRadius(hash, &hash->list->vectors[p], radius, CollectPair, &q);
+	}
+	return q.found;
+}
+
+void FreeSpatialHash(SpatialHash *hash)
+{
+	free(hash->start);
+	free(hash->entries);
+	free(hash->keys);
+	free(hash->histogram);
+	free(hash->pending_head);
+	free(hash->pending_index);
+	free(hash->pending_next);
+	InitSpatialHash(hash, hash->cell_size, hash->fixed_size);
+}
@@ -0,0 +1,253 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <ansic3d/trig.h>
+#include <ansic3d/cpu.h>
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef ANSIC3D_X86_SIMD
+#include <immintrin.h>
+#endif
+
+// Coefficients from Cephes sinf/cosf. pi/4 is split in three parts so
+// y * DP1 and y * DP2 are exact for the reduction.
+#define FOPI 1.27323954473516f
+#define DP1 0.78515625f
+#define DP2 2.4187564849853515625e-4f
+#define DP3 3.77489497744594108e-8f
+#define SIN_P0 -1.9515295891e-4f
+#define SIN_P1 8.3321608736e-3f
+#define SIN_P2 -1.6666654611e-1f
+#define COS_P0 2.443315711809948e-5f
+#define COS_P1 -1.388731625493765e-3f
+#define COS_P2 4.166664568298827e-2f
+
+#ifdef ANSIC3D_FAST_TRIG
+static int fast_trig = 1;
+#else
+static int fast_trig = 0;
+#endif
+
+void FastSinCos(float angle, float *s, float *c)
+{
+	float x, y, z, ps, pc;
+	uint32_t bits, bs, bc, swap;
+	int j;
+	if (!(fabsf(angle) <= FAST_TRIG_RANGE))
+	{
+		*s = sinf(angle);
+		*c = cosf(angle);
+		return;
+	}
+	x = fabsf(angle);
+	// Octant, rounded up to an even one so x ends up in [-pi/4, pi/4]
+	j = (int)(x * FOPI);
+	j = (j + 1) & ~1;
+	y = (float)j;
+	x = ((x - y * DP1) - y * DP2) - y * DP3;
+	z = x * x;
+	ps = ((SIN_P0 * z + SIN_P1) * z + SIN_P2) * z * x + x;
+	pc = ((COS_P0 * z + COS_P1) * z + COS_P2) * z * z - 0.5f * z + 1;
+	// Octant swap and signs as bit masks, the octant is unpredictable so
+	// branches on it cost more than the polynomials
+	memcpy(&bits, &angle, sizeof(bits));
+	memcpy(&bs, &ps, sizeof(bs));
+	memcpy(&bc, &pc, sizeof(bc));
+	swap = (0U - ((uint32_t)j >> 1 & 1)) & (bs ^ bc);
+	bs ^= swap;
+	bc ^= swap;
+	bs ^= ((uint32_t)j << 29 & 0x80000000U) ^ (bits & 0x80000000U);
+	bc ^= ~((uint32_t)j - 2) << 29 & 0x80000000U;
+	memcpy(s, &bs, sizeof(bs));
+	memcpy(c, &bc, sizeof(bc));
+}
+
+#ifdef ANSIC3D_X86_SIMD
+// Branch free FastSinCos, same steps with the octant handled by masks
+__attribute__((target("sse2")))
+static void SinCosSSE(__m128 angle, __m128 *s, __m128 *c)
+{
+	__m128 x, y, z, ps, pc, swap, sign_s, sign_c, sign_bit;
+	__m128i j;
+	sign_bit = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000));
+	x = _mm_andnot_ps(sign_bit, angle);
+	j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(FOPI)));
+	j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)),
+			_mm_set1_epi32(~1));
+	y = _mm_cvtepi32_ps(j);
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP1)));
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP2)));
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP3)));
+	z = _mm_mul_ps(x, x);
+	ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_P0), z), _mm_set1_ps(SIN_P1));
+	ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(SIN_P2));
+	ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), x), x);
+	pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_P0), z), _mm_set1_ps(COS_P1));
+	pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(COS_P2));
+	pc = _mm_mul_ps(_mm_mul_ps(pc, z), z);
+	pc = _mm_add_ps(_mm_sub_ps(pc, _mm_mul_ps(_mm_set1_ps(0.5f), z)),
+			_mm_set1_ps(1));
+	swap = _mm_castsi128_ps(_mm_cmpeq_epi32(
+				_mm_and_si128(j, _mm_set1_epi32(2)), _mm_set1_epi32(2)));
+	sign_s = _mm_xor_ps(_mm_and_ps(angle, sign_bit), _mm_castsi128_ps(
+				_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29)));
+	sign_c = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(
+					_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+	*s = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps)),
+			sign_s);
+	*c = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc)),
+			sign_c);
+}
+
+__attribute__((target("avx2,fma")))
+static void SinCosAVX2(__m256 angle, __m256 *s, __m256 *c)
+{
+	__m256 x, y, z, ps, pc, swap, sign_s, sign_c, sign_bit;
+	__m256i j;
+	sign_bit = _mm256_castsi256_ps(_mm256_set1_epi32((int)0x80000000));
+	x = _mm256_andnot_ps(sign_bit, angle);
+	j = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(FOPI)));
+	j = _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(1)),
+			_mm256_set1_epi32(~1));
+	y = _mm256_cvtepi32_ps(j);
+	x = _mm256_fnmadd_ps(y, _mm256_set1_ps(DP1), x);
+	x = _mm256_fnmadd_ps(y, _mm256_set1_ps(DP2), x);
+	x = _mm256_fnmadd_ps(y, _mm256_set1_ps(DP3), x);
+	z = _mm256_mul_ps(x, x);
+	ps = _mm256_fmadd_ps(_mm256_set1_ps(SIN_P0), z, _mm256_set1_ps(SIN_P1));
+	ps = _mm256_fmadd_ps(ps, z, _mm256_set1_ps(SIN_P2));
+	ps = _mm256_fmadd_ps(_mm256_mul_ps(ps, z), x, x);
+	pc = _mm256_fmadd_ps(_mm256_set1_ps(COS_P0), z, _mm256_set1_ps(COS_P1));
+	pc = _mm256_fmadd_ps(pc, z, _mm256_set1_ps(COS_P2));
+	pc = _mm256_mul_ps(_mm256_mul_ps(pc, z), z);
+	pc = _mm256_add_ps(_mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, pc),
+			_mm256_set1_ps(1));
+	swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+				_mm256_and_si256(j, _mm256_set1_epi32(2)),
+				_mm256_set1_epi32(2)));
+	sign_s = _mm256_xor_ps(_mm256_and_ps(angle, sign_bit),
+			_mm256_castsi256_ps(_mm256_slli_epi32(
+					_mm256_and_si256(j, _mm256_set1_epi32(4)), 29)));
+	sign_c = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(
+					_mm256_sub_epi32(j, _mm256_set1_epi32(2)),
+					_mm256_set1_epi32(4)), 29));
+	*s = _mm256_xor_ps(_mm256_blendv_ps(ps, pc, swap), sign_s);
+	*c = _mm256_xor_ps(_mm256_blendv_ps(pc, ps, swap), sign_c);
+}
+
+// Return how many angles were done, lanes out of range are left to the
+// scalar loop which falls back to libm
+__attribute__((target("sse2")))
+static unsigned int SinCosArraySSE(const float *angles, float *s, float *c,
+		unsigned int n)
+{
+	unsigned int i;
+	__m128 a, vs, vc, range;
+	range = _mm_set1_ps(FAST_TRIG_RANGE);
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		a = _mm_loadu_ps(&angles[i]);
+		if (_mm_movemask_ps(_mm_cmple_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), a),
+							range)) != 0xF)
+		{
+			break;
+		}
+		SinCosSSE(a, &vs, &vc);
+		_mm_storeu_ps(&s[i], vs);
+		_mm_storeu_ps(&c[i], vc);
+	}
+	return i;
+}
+
+__attribute__((target("avx2,fma")))
+static unsigned int SinCosArrayAVX2(const float *angles, float *s, float *c,
+		unsigned int n)
+{
+	unsigned int i;
+	__m256 a, vs, vc, range;
+	range = _mm256_set1_ps(FAST_TRIG_RANGE);
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		a = _mm256_loadu_ps(&angles[i]);
+		if (_mm256_movemask_ps(_mm256_cmp_ps(_mm256_andnot_ps(
+							_mm256_set1_ps(-0.0f), a), range, _CMP_LE_OQ)) != 0xFF)
+		{
+			break;
+		}
+		SinCosAVX2(a, &vs, &vc);
+		_mm256_storeu_ps(&s[i], vs);
+		_mm256_storeu_ps(&c[i], vc);
+	}
+	_mm256_zeroupper();
+	return i;
+}
+#endif
+
+void FastSinCosArray(const float *angles, float *s, float *c, unsigned int n)
+{
+	unsigned int i = 0, done;
+#ifdef ANSIC3D_X86_SIMD
+	int level = GetSIMDLevel();
+	while (i < n && level >= SIMD_SSE)
+	{
+		if (level >= SIMD_AVX2)
+		{
+			done = SinCosArrayAVX2(&angles[i], &s[i], &c[i], n - i);
+		}
+		else
+		{
+			done = SinCosArraySSE(&angles[i], &s[i], &c[i], n - i);
+		}
+		i += done;
+		// Tail or a block with an angle out of range, step over it
+		if (i < n)
+		{
+			FastSinCos(angles[i], &s[i], &c[i]);
+			i++;
+		}
+	}
+#else
+	(void)done;
+#endif
+	for (; i < n; i++)
+	{
+		FastSinCos(angles[i], &s[i], &c[i]);
+	}
+}
+
+void SinCos(float angle, float *s, float *c)
+{
+	if (fast_trig)
+	{
+		FastSinCos(angle, s, c);
+		return;
+	}
+	*s = sinf(angle);
+	*c = cosf(angle);
+}
+
+void SetFastTrig(int enable)
+{
+	fast_trig = enable != 0;
+}
+
+int GetFastTrig(void)
+{
+	return fast_trig;
+}
@@ -16,142 +16,87 @@
    along with this program.  If not, see <https://www.gnu.org/licenses/>.
    */
 #include <ansic3d/vector3d.h>
+#include <ansic3d/trig.h>
+#include <ansic3d/inline.h>
 
 void CloneVector(Vector3D from, Vector3D *to)
 {
-	SetVector(from.x, from.y, from.z, from.w, to);
+	CloneVectorInline(&from, to);
 }
 
 void AddVector(Vector3D p1, Vector3D p2, Vector3D *target)
 {
-	target->x = p1.x + p2.x;
-	target->y = p1.y + p2.y;
-	target->z = p1.z + p2.z;
+	AddVectorInline(&p1, &p2, target);
 }
 
 void SubVector(Vector3D p1, Vector3D p2, Vector3D *target)
 {
-	target->x = p1.x - p2.x;
-	target->y = p1.y - p2.y;
-	target->z = p1.z - p2.z;
+	SubVectorInline(&p1, &p2, target);
 }
 
 void ScaleVector(Vector3D *target, float factor)
 {
-	target->x *= factor;
-	target->y *= factor;
-	target->z *= factor;
-	target->w *= factor;
+	ScaleVectorInline(target, factor);
 }
 
 void CrossProduct(Vector3D v1, Vector3D v2, Vector3D *target)
 {
-	target->x = v1.y * v2.z - v1.z * v2.y;
-	target->y = v1.z * v2.x - v1.x * v2.z;
-	target->z = v1.x * v2.y - v1.y * v2.x;
+	CrossProductInline(&v1, &v2, target);
 }
 
 void NormalizeVector(Vector3D *target)
 {
-	float invlen;
-	float vn;
-	vn = VectorNorm(*target);
-	if (vn != 0)
-	{
-		invlen = 1 / vn;
-		target->x = target->x * invlen;
-		target->y = target->y * invlen;
-		target->z = target->z * invlen;
-		target->w = 0;
-	}
+	NormalizeVectorInline(target);
 }
 
 void DivideVector(Vector3D *vector, Vector3D divider)
 {
-	vector->x = vector->x / divider.x;
-	vector->y = vector->y / divider.y;
-	vector->z = vector->z / divider.z;
+	DivideVectorInline(vector, &divider);
 }
 
 void PerpendicularVector(Vector3D v1, Vector3D v2, Vector3D *target)
 {
-	float dot = DotProduct(v1, v2);
-	target->x = v1.x - dot * v2.x;
-	target->y = v1.y - dot * v2.y;
-	target->z = v1.z - dot * v2.z;
+	PerpendicularVectorInline(&v1, &v2, target);
 }
 
 void RotateAroundX(Vector3D *target, float angle)
 {
-	Vector3D org;
-	float s, c;
-	s = sin(angle);
-	c = cos(angle);
-	org.x = target->x;
-	org.y = target->y;
-	org.z = target->z;
-	target->y = c * org.y + s * org.z;
-	target->z = c * org.z - s * org.y;
+	RotateAroundXInline(target, angle);
 }
 
 void RotateAroundY(Vector3D *target, float angle)
 {
-	Vector3D org;
-	float s, c;
-	s = sin(angle);
-	c = cos(angle);
-	org.x = target->x;
-	org.y = target->y;
-	org.z = target->z;
-	target->x = c * org.x + s * org.z;
-	target->z = c * org.z - s * org.x;
+	RotateAroundYInline(target, angle);
 }
 
 void RotateAroundZ(Vector3D *target, float angle)
 {
-	Vector3D org;
-	float s, c;
-	s = sin(angle);
-	c = cos(angle);
-	org.x = target->x;
-	org.y = target->y;
-	org.z = target->z;
-	target->x = c * org.x + s * org.y;
-	target->y = c * org.y - s * org.x;
+	RotateAroundZInline(target, angle);
 }
 
 void SetVector(float x, float y, float z, float w, Vector3D *target)
 {
-	target->x = x;
-	target->y = y;
-	target->z = z;
-	target->w = w;
+	SetVectorInline(x, y, z, w, target);
 }
 
 float VectorLength(Vector3D vector)
 {
-	return sqrtf((vector.x * vector.x) +
-			(vector.y * vector.y) +
-			(vector.z * vector.z));
+	return VectorLengthInline(&vector);
 }
 
 float DotProduct(Vector3D v1, Vector3D v2)
 {
-	return (v1.x * v2.x) + (v1.y * v2.y) + (v1.z * v2.z);
+	return DotProductInline(&v1, &v2);
 }
 
 float VectorNorm(Vector3D vector)
 {
-	return sqrtf((vector.x * vector.x) + 
-			(vector.y * vector.y) +
-			(vector.z * vector.z));
+	return VectorNormInline(&vector);
 }
 
 float VectorDistance(Vector3D v1, Vector3D v2)
 {
-	return sqrt(pow(v2.x - v1.x, 2) +
-			pow(v2.y - v1.y, 2) +
-			pow(v2.z - v1.z, 2));
+	return VectorDistanceInline(&v1, &v2);
 }
 
 float rsqrt(float n)
@@ -161,11 +106,7 @@ float rsqrt(float n)
 
 int VectorEquals(Vector3D v1, Vector3D v2)
 {
-	float x, y, z;
-	x = fabsf(v1.x - v2.x);
-	y = fabsf(v1.y - v2.y);
-	z = fabsf(v1.z - v2.z);
-	return (x < PRECISION && y < PRECISION && z < PRECISION);
+	return VectorEqualsInline(&v1, &v2);
 }
 
 void PrintVector(Vector3D v)
@@ -175,9 +116,5 @@ void PrintVector(Vector3D v)
 
 void PlaneNormal(Vector3D v1, Vector3D v2, Vector3D v3, Vector3D *result)
 {
-	Vector3D t1, t2;
-	SubVector(v2, v1, &t1);
-	SubVector(v3, v1, &t2);
-	CrossProduct(t1, t2, result);
-	NormalizeVector(result);
+	PlaneNormalInline(&v1, &v2, &v3, result);
 }
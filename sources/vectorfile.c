@@ -0,0 +1,164 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <ansic3d/vectorfile.h>
+
+// Mapped lists can not grow and own no memory
+static void *MappedAlloc(size_t size, void *context)
+{
+	(void) size;
+	(void) context;
+	return NULL;
+}
+
+static void *MappedRealloc(void *p, size_t old_size, size_t size,
+		void *context)
+{
+	(void) p;
+	(void) old_size;
+	(void) size;
+	(void) context;
+	return NULL;
+}
+
+static void MappedFree(void *p, size_t size, void *context)
+{
+	(void) p;
+	(void) size;
+	(void) context;
+}
+
+static Allocator mapped_allocator = {MappedAlloc, MappedRealloc, MappedFree,
+	NULL};
+
+int SaveVectorListFile(VectorList *list, const char *path)
+{
+	VectorFileHeader header;
+	Vector3D min, max;
+	FILE *f;
+	int ok;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, VECTORFILE_MAGIC, sizeof(header.magic));
+	header.version = VECTORFILE_VERSION;
+	header.endian = VECTORFILE_ENDIAN;
+	header.layout = VECTORFILE_LAYOUT_XYZW;
+	header.stride = sizeof(Vector3D);
+	header.count = list->count;
+	if (VectorListBounds(list, &min, &max) > 0)
+	{
+		header.min[0] = min.x;
+		header.min[1] = min.y;
+		header.min[2] = min.z;
+		header.max[0] = max.x;
+		header.max[1] = max.y;
+		header.max[2] = max.z;
+	}
+
+	f = fopen(path, "wb");
+	if (f == NULL)
+	{
+		return 0;
+	}
+	ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+		fwrite(list->vectors, sizeof(Vector3D), list->count, f) ==
+		list->count;
+	if (fclose(f) != 0)
+	{
+		ok = 0;
+	}
+	return ok;
+}
+
+static int ValidVectorFileHeader(VectorFileHeader *header, size_t size)
+{
+	if (memcmp(header->magic, VECTORFILE_MAGIC, sizeof(header->magic)) != 0 ||
+			header->version != VECTORFILE_VERSION ||
+			header->endian != VECTORFILE_ENDIAN ||
+			header->layout != VECTORFILE_LAYOUT_XYZW ||
+			header->stride != sizeof(Vector3D))
+	{
+		return 0;
+	}
+	// The list count is an unsigned int
+	if (header->count > (unsigned int) -1 ||
+			header->count > (size - VECTORFILE_HEADER_SIZE) / header->stride)
+	{
+		return 0;
+	}
+	return 1;
+}
+
+int MapVectorListFile(const char *path, VectorFile *file)
+{
+	struct stat st;
+	void *map;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return 0;
+	}
+	if (fstat(fd, &st) != 0 || st.st_size < VECTORFILE_HEADER_SIZE)
+	{
+		close(fd);
+		return 0;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file
+	close(fd);
+	if (map == MAP_FAILED)
+	{
+		return 0;
+	}
+	memcpy(&file->header, map, sizeof(VectorFileHeader));
+	if (!ValidVectorFileHeader(&file->header, st.st_size))
+	{
+		munmap(map, st.st_size);
+		return 0;
+	}
+	file->map = map;
+	file->size = st.st_size;
+	file->list.vectors = (Vector3D *) ((unsigned char *) map +
+			VECTORFILE_HEADER_SIZE);
+	file->list.count = file->header.count;
+	file->list.capacity = file->header.count;
+	file->list.index = (int) file->header.count - 1;
+	file->list.allocator = &mapped_allocator;
+	return 1;
+}
+
+void UnmapVectorListFile(VectorFile *file)
+{
+	if (file->map != NULL)
+	{
+		munmap(file->map, file->size);
+	}
+	file->map = NULL;
+	file->size = 0;
+	file->list.vectors = NULL;
+	file->list.count = 0;
+	file->list.capacity = 0;
+	file->list.index = -1;
+}
@@ -16,10 +16,26 @@
    along with this program.  If not, see <https://www.gnu.org/licenses/>.
    */
 #include <ansic3d/vectorlist.h>
+#include <ansic3d/parallel.h>
+#include <ansic3d/inline.h>
+#include <ansic3d/cpu.h>
+
+#ifdef ANSIC3D_X86_SIMD
+#include <immintrin.h>
+#endif
+
+static float growth_factor = VECTORLIST_GROWTH_FACTOR;
 
 void InitVectorList(VectorList *list, int capacity)
 {
-	void *p = malloc(capacity * sizeof(Vector3D));
+	InitVectorListAllocator(list, capacity, NULL);
+}
+
+void InitVectorListAllocator(VectorList *list, int capacity,
+		Allocator *allocator)
+{
+	void *p = AllocatorAlloc(allocator, capacity * sizeof(Vector3D));
+	list->allocator = allocator;
 	list->vectors = p;
 	if (p == NULL)
 	{
@@ -30,27 +46,85 @@ void InitVectorList(VectorList *list, int capacity)
 	list->capacity = capacity;
 }
 
-int PushVector(Vector3D v, VectorList *list)
+float SetVectorListGrowthFactor(float factor)
 {
-	if (list->capacity > list->count)
+	if (factor > 1)
 	{
-		list->index++;
-		CloneVector(v, &list->vectors[list->index]);
-		list->count++;
-		return list->index;
+		growth_factor = factor;
 	}
+	return growth_factor;
+}
 
-	list->capacity++;
-	void *p = realloc(list->vectors,
-			list->capacity * sizeof(Vector3D));
+int ReserveVectorList(VectorList *list, unsigned int capacity)
+{
+	void *p;
+	if (capacity <= list->capacity)
+	{
+		return list->capacity;
+	}
+	p = AllocatorRealloc(list->allocator, list->vectors,
+			list->capacity * sizeof(Vector3D), capacity * sizeof(Vector3D));
 	if (p == NULL)
 	{
-		list->capacity--;
 		return 0;
 	}
-	else
+	list->vectors = p;
+	list->capacity = capacity;
+	return list->capacity;
+}
+
+int ShrinkVectorList(VectorList *list, unsigned int capacity)
+{
+	void *p;
+	if (capacity < list->count)
 	{
-		list->vectors = p;
+		capacity = list->count;
+	}
+	if (capacity == 0)
+	{
+		// Keep a valid buffer, realloc(p, 0) may free it
+		capacity = 1;
+	}
+	if (capacity >= list->capacity)
+	{
+		return list->capacity;
+	}
+	p = AllocatorRealloc(list->allocator, list->vectors,
+			list->capacity * sizeof(Vector3D), capacity * sizeof(Vector3D));
+	if (p == NULL)
+	{
+		return 0;
+	}
+	list->vectors = p;
+	list->capacity = capacity;
+	return list->capacity;
+}
+
+// Grow the list geometrically so it can hold at least needed vectors
+static int GrowVectorList(VectorList *list, unsigned int needed)
+{
+	unsigned int capacity;
+	if (needed <= list->capacity)
+	{
+		return 1;
+	}
+	capacity = (unsigned int)(list->capacity * growth_factor);
+	if (capacity < 4)
+	{
+		capacity = 4;
+	}
+	if (capacity < needed)
+	{
+		capacity = needed;
+	}
+	return ReserveVectorList(list, capacity) != 0;
+}
+
+int PushVector(Vector3D v, VectorList *list)
+{
+	if (!GrowVectorList(list, list->count + 1))
+	{
+		return 0;
 	}
 	list->index++;
 	CloneVector(v, &list->vectors[list->index]);
@@ -58,9 +132,34 @@ int PushVector(Vector3D v, VectorList *list)
 	return list->count;
 }
 
+int PushVectors(const Vector3D *v, unsigned int n, VectorList *list)
+{
+	size_t offset = 0;
+	int own = list->vectors != NULL && v >= list->vectors &&
+		v < list->vectors + list->capacity;
+	// v may point into the list itself, growing can move the buffer
+	if (own)
+	{
+		offset = (size_t) (v - list->vectors);
+	}
+	if (!GrowVectorList(list, list->count + n))
+	{
+		return 0;
+	}
+	if (own)
+	{
+		v = &list->vectors[offset];
+	}
+	memmove(&list->vectors[list->count], v, n * sizeof(Vector3D));
+	list->count += n;
+	list->index = list->count - 1;
+	return list->count;
+}
+
 void FreeVectorList(VectorList *list)
 {
-	free(list->vectors);
+	AllocatorFree(list->allocator, list->vectors,
+			list->capacity * sizeof(Vector3D));
 	list->vectors = NULL;
 	list->count = 0;
 	list->capacity = 0;
@@ -92,47 +191,343 @@ void RemoveLastVector(VectorList *list)
 
 int RemoveVectorIndex(VectorList *list, int index)
 {
-	int i, j;
-	if ((int) list->count <= index)
+	if (index < 0 || (int) list->count <= index)
 	{
 		return 0;
 	}
+	memmove(&list->vectors[index], &list->vectors[index + 1],
+			(list->count - index - 1) * sizeof(Vector3D));
+	list->count--;
+	list->index--;
+	return list->count;
+}
 
-	Vector3D *temp = malloc((list->capacity) * sizeof(Vector3D));
-	if (temp == NULL)
+int SwapRemoveVectorIndex(VectorList *list, int index)
+{
+	if (index < 0 || (int) list->count <= index)
 	{
 		return 0;
 	}
-	j = 0;
-	for (i = 0; i < list->index; i++)
+	list->vectors[index] = list->vectors[list->index];
+	list->count--;
+	list->index--;
+	return list->count;
+}
+
+int RemoveVectorIndices(VectorList *list, const unsigned int *indices,
+		unsigned int n)
+{
+	unsigned int i, to, current, next, run;
+	if (n == 0 || indices[0] >= list->count)
+	{
+		return list->count;
+	}
+	// Move the runs between removed indices down in one pass
+	i = 0;
+	to = indices[0];
+	while (i < n && indices[i] < list->count)
 	{
-		if (i != index)
+		current = indices[i];
+		// Skip duplicates and out of order entries, a smaller next index
+		// would wrap the run length below
+		while (i < n && indices[i] <= current)
 		{
-			CloneVector(list->vectors[i], &temp[j++]);
+			i++;
 		}
+		next = (i < n && indices[i] < list->count) ?
+			indices[i] : list->count;
+		run = next - current - 1;
+		memmove(&list->vectors[to], &list->vectors[current + 1],
+				run * sizeof(Vector3D));
+		to += run;
 	}
-	free(list->vectors);
-	list->vectors = temp;
-	list->count--;
-	list->index--;
+	list->count = to;
+	list->index = to - 1;
+	return list->count;
+}
+
+int RemoveVectorsIf(VectorList *list, VectorPredicate predicate,
+		void *context)
+{
+	unsigned int i, kept = 0;
+	for (i = 0; i < list->count; i++)
+	{
+		if (predicate(&list->vectors[i], context))
+		{
+			continue;
+		}
+		if (kept != i)
+		{
+			list->vectors[kept] = list->vectors[i];
+		}
+		kept++;
+	}
+	list->count = kept;
+	list->index = kept - 1;
 	return list->count;
 }
 
 int TrimVectorList(VectorList *list)
 {
+	if (ShrinkVectorList(list, list->count) == 0)
+	{
+		return 0;
+	}
+	return list->count;
+}
+
+typedef struct _VectorListJob
+{
+	Matrix3D *matrix;
+	Vector3D *src;
+	Vector3D *dst;
+	float factor;
+	Vector3D *bounds;
+} VectorListJob;
+
+static void TransformVectorListRange(unsigned int begin, unsigned int end,
+		void *context)
+{
+	VectorListJob *job = context;
+	TransformVectors(job->matrix, &job->src[begin], &job->dst[begin],
+			end - begin);
+}
+
+int TransformVectorList(Matrix3D *matrix, VectorList *src, VectorList *dst)
+{
+	VectorListJob job;
+	if (src->count == 0)
+	{
+		dst->count = 0;
+		dst->index = -1;
+		return 0;
+	}
+	if (ReserveVectorList(dst, src->count) == 0)
+	{
+		return 0;
+	}
+	job.matrix = matrix;
+	job.src = src->vectors;
+	job.dst = dst->vectors;
+	ParallelFor(src->count, VECTORLIST_GRAIN, TransformVectorListRange, &job);
+	dst->count = src->count;
+	dst->index = src->count - 1;
+	return dst->count;
+}
+
+void TransformVectorListInPlace(Matrix3D *matrix, VectorList *list)
+{
+	VectorListJob job;
+	job.matrix = matrix;
+	job.src = list->vectors;
+	job.dst = list->vectors;
+	ParallelFor(list->count, VECTORLIST_GRAIN, TransformVectorListRange, &job);
+}
+
+static void NormalizeVectorListRange(unsigned int begin, unsigned int end,
+		void *context)
+{
+	VectorListJob *job = context;
 	unsigned int i;
-	Vector3D *temp = malloc((list->count) * sizeof(Vector3D));
-	if (temp == NULL)
+	for (i = begin; i < end; i++)
+	{
+		NormalizeVectorInline(&job->dst[i]);
+	}
+}
+
+void NormalizeVectorList(VectorList *list)
+{
+	VectorListJob job;
+	job.dst = list->vectors;
+	ParallelFor(list->count, VECTORLIST_GRAIN, NormalizeVectorListRange, &job);
+}
+
+static void ScaleVectorListRange(unsigned int begin, unsigned int end,
+		void *context)
+{
+	VectorListJob *job = context;
+	unsigned int i;
+	for (i = begin; i < end; i++)
+	{
+		ScaleVectorInline(&job->dst[i], job->factor);
+	}
+}
+
+void ScaleVectorList(VectorList *list, float factor)
+{
+	VectorListJob job;
+	job.dst = list->vectors;
+	job.factor = factor;
+	ParallelFor(list->count, VECTORLIST_GRAIN, ScaleVectorListRange, &job);
+}
+
+static void ExpandBounds(Vector3D *min, Vector3D *max, const Vector3D *lo,
+		const Vector3D *hi)
+{
+	min->x = lo->x < min->x ? lo->x : min->x;
+	min->y = lo->y < min->y ? lo->y : min->y;
+	min->z = lo->z < min->z ? lo->z : min->z;
+	max->x = hi->x > max->x ? hi->x : max->x;
+	max->y = hi->y > max->y ? hi->y : max->y;
+	max->z = hi->z > max->z ? hi->z : max->z;
+}
+
+#ifdef ANSIC3D_X86_SIMD
+// min/max take the second operand when either is NaN, like the scalar
+// comparisons, so NaN vectors are skipped by every kernel
+__attribute__((target("sse2")))
+static void ExpandBoundsSSE(const Vector3D *v, unsigned int n, Vector3D *min,
+		Vector3D *max)
+{
+	__m128 lo0, lo1, hi0, hi1, a, b;
+	Vector3D lo, hi;
+	unsigned int i;
+	lo0 = lo1 = _mm_setr_ps(min->x, min->y, min->z, 0);
+	hi0 = hi1 = _mm_setr_ps(max->x, max->y, max->z, 0);
+	for (i = 0; i + 2 <= n; i += 2)
+	{
+		a = _mm_loadu_ps(&v[i].x);
+		b = _mm_loadu_ps(&v[i + 1].x);
+		lo0 = _mm_min_ps(a, lo0);
+		hi0 = _mm_max_ps(a, hi0);
+		lo1 = _mm_min_ps(b, lo1);
+		hi1 = _mm_max_ps(b, hi1);
+	}
+	if (i < n)
+	{
+		a = _mm_loadu_ps(&v[i].x);
+		lo0 = _mm_min_ps(a, lo0);
+		hi0 = _mm_max_ps(a, hi0);
+	}
+	_mm_storeu_ps(&lo.x, _mm_min_ps(lo1, lo0));
+	_mm_storeu_ps(&hi.x, _mm_max_ps(hi1, hi0));
+	min->x = lo.x;
+	min->y = lo.y;
+	min->z = lo.z;
+	max->x = hi.x;
+	max->y = hi.y;
+	max->z = hi.z;
+}
+
+// Two vectors per __m256, four accumulators to hide the latency
+__attribute__((target("avx")))
+static void ExpandBoundsAVX(const Vector3D *v, unsigned int n, Vector3D *min,
+		Vector3D *max)
+{
+	__m256 lo0, lo1, hi0, hi1, a, b;
+	__m128 lo, hi;
+	Vector3D l, h;
+	unsigned int i;
+	lo0 = lo1 = _mm256_setr_ps(min->x, min->y, min->z, 0,
+			min->x, min->y, min->z, 0);
+	hi0 = hi1 = _mm256_setr_ps(max->x, max->y, max->z, 0,
+			max->x, max->y, max->z, 0);
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		a = _mm256_loadu_ps(&v[i].x);
+		b = _mm256_loadu_ps(&v[i + 2].x);
+		lo0 = _mm256_min_ps(a, lo0);
+		hi0 = _mm256_max_ps(a, hi0);
+		lo1 = _mm256_min_ps(b, lo1);
+		hi1 = _mm256_max_ps(b, hi1);
+	}
+	lo0 = _mm256_min_ps(lo1, lo0);
+	hi0 = _mm256_max_ps(hi1, hi0);
+	lo = _mm_min_ps(_mm256_extractf128_ps(lo0, 1),
+			_mm256_castps256_ps128(lo0));
+	hi = _mm_max_ps(_mm256_extractf128_ps(hi0, 1),
+			_mm256_castps256_ps128(hi0));
+	_mm_storeu_ps(&l.x, lo);
+	_mm_storeu_ps(&h.x, hi);
+	min->x = l.x;
+	min->y = l.y;
+	min->z = l.z;
+	max->x = h.x;
+	max->y = h.y;
+	max->z = h.z;
+	_mm256_zeroupper();
+	if (i < n)
+	{
+		ExpandBoundsSSE(&v[i], n - i, min, max);
+	}
+}
+#endif
+
+// Expand min/max (x, y, z) to contain the n vectors
+static void ExpandBoundsVectors(const Vector3D *v, unsigned int n,
+		Vector3D *min, Vector3D *max)
+{
+	unsigned int i;
+#ifdef ANSIC3D_X86_SIMD
+	int level = GetSIMDLevel();
+	if (level >= SIMD_AVX)
+	{
+		ExpandBoundsAVX(v, n, min, max);
+		return;
+	}
+	if (level >= SIMD_SSE)
+	{
+		ExpandBoundsSSE(v, n, min, max);
+		return;
+	}
+#endif
+	for (i = 0; i < n; i++)
+	{
+		ExpandBounds(min, max, &v[i], &v[i]);
+	}
+}
+
+// Merge the bounds of [begin, end) into job->bounds[2 * chunk] (min) and
+// job->bounds[2 * chunk + 1] (max)
+static void VectorListBoundsRange(unsigned int begin, unsigned int end,
+		void *context)
+{
+	VectorListJob *job = context;
+	Vector3D *min = &job->bounds[2 * (begin / VECTORLIST_GRAIN)];
+	ExpandBoundsVectors(&job->src[begin], end - begin, min, min + 1);
+}
+
+int VectorListBounds(VectorList *list, Vector3D *min, Vector3D *max)
+{
+	VectorListJob job;
+	Vector3D single[2];
+	unsigned int chunks, i;
+	if (list->count == 0)
 	{
 		return 0;
 	}
-	list->capacity = list->count;
-	list->index = list->count - 1;
-	for (i = 0; i < list->count; i++)
+	// A bounds pair per chunk, the serial fallback only fills the first
+	chunks = (list->count + VECTORLIST_GRAIN - 1) / VECTORLIST_GRAIN;
+	job.bounds = chunks > 1 ? malloc(2 * chunks * sizeof(Vector3D)) : NULL;
+	if (job.bounds == NULL)
+	{
+		job.bounds = single;
+		chunks = 1;
+	}
+	for (i = 0; i < chunks; i++)
+	{
+		SetVector(INFINITY, INFINITY, INFINITY, 1, &job.bounds[2 * i]);
+		SetVector(-INFINITY, -INFINITY, -INFINITY, 1, &job.bounds[2 * i + 1]);
+	}
+	job.src = list->vectors;
+	if (chunks > 1)
+	{
+		ParallelFor(list->count, VECTORLIST_GRAIN, VectorListBoundsRange,
+				&job);
+	}
+	else
+	{
+		VectorListBoundsRange(0, list->count, &job);
+	}
+	*min = job.bounds[0];
+	*max = job.bounds[1];
+	for (i = 1; i < chunks; i++)
+	{
+		ExpandBounds(min, max, &job.bounds[2 * i], &job.bounds[2 * i + 1]);
+	}
+	if (job.bounds != single)
 	{
-		CloneVector(list->vectors[i], &temp[i]);
+		free(job.bounds);
 	}
-	free(list->vectors);
-	list->vectors = temp;
 	return list->count;
 }
@@ -0,0 +1,566 @@
+/*
+   AnsiC3D - 3D Math Library
+   Copyright (C) 2018  Sinan ISLEKDEMIR - sinan@islekdemir.com
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+   */
+#include <ansic3d/vectorlistsoa.h>
+#include <ansic3d/cpu.h>
+
+#ifdef ANSIC3D_X86_SIMD
+#include <immintrin.h>
+#endif
+
+static float *AllocComponent(unsigned int capacity)
+{
+	void *p = NULL;
+	if (capacity == 0)
+	{
+		capacity = 1;
+	}
+	if (posix_memalign(&p, SOA_ALIGNMENT, capacity * sizeof(float)) != 0)
+	{
+		return NULL;
+	}
+	return p;
+}
+
+int InitVectorListSoA(VectorListSoA *list, unsigned int capacity, int with_w)
+{
+	list->count = 0;
+	list->capacity = 0;
+	list->w = NULL;
+	list->x = AllocComponent(capacity);
+	list->y = AllocComponent(capacity);
+	list->z = AllocComponent(capacity);
+	if (with_w)
+	{
+		list->w = AllocComponent(capacity);
+	}
+	if (list->x == NULL || list->y == NULL || list->z == NULL ||
+			(with_w && list->w == NULL))
+	{
+		FreeVectorListSoA(list);
+		return 0;
+	}
+	list->capacity = capacity;
+	return 1;
+}
+
+int ReserveVectorListSoA(VectorListSoA *list, unsigned int capacity)
+{
+	float *fresh[4] = {NULL, NULL, NULL, NULL};
+	float **component[4];
+	int i, n;
+	if (capacity <= list->capacity)
+	{
+		return 1;
+	}
+	component[0] = &list->x;
+	component[1] = &list->y;
+	component[2] = &list->z;
+	component[3] = &list->w;
+	n = list->w != NULL ? 4 : 3;
+	// Allocate everything first so a failure leaves the list untouched
+	for (i = 0; i < n; i++)
+	{
+		fresh[i] = AllocComponent(capacity);
+		if (fresh[i] == NULL)
+		{
+			while (i-- > 0)
+			{
+				free(fresh[i]);
+			}
+			return 0;
+		}
+	}
+	for (i = 0; i < n; i++)
+	{
+		if (list->count > 0)
+		{
+			memcpy(fresh[i], *component[i], list->count * sizeof(float));
+		}
+		free(*component[i]);
+		*component[i] = fresh[i];
+	}
+	list->capacity = capacity;
+	return 1;
+}
+
+void FreeVectorListSoA(VectorListSoA *list)
+{
+	free(list->x);
+	free(list->y);
+	free(list->z);
+	free(list->w);
+	list->x = NULL;
+	list->y = NULL;
+	list->z = NULL;
+	list->w = NULL;
+	list->count = 0;
+	list->capacity = 0;
+}
+
+int PushVectorSoA(Vector3D v, VectorListSoA *list)
+{
+	unsigned int capacity;
+	if (list->count == list->capacity)
+	{
+		capacity = list->capacity < 8 ? 8 : list->capacity * 2;
+		if (!ReserveVectorListSoA(list, capacity))
+		{
+			return 0;
+		}
+	}
+	list->x[list->count] = v.x;
+	list->y[list->count] = v.y;
+	list->z[list->count] = v.z;
+	if (list->w != NULL)
+	{
+		list->w[list->count] = v.w;
+	}
+	list->count++;
+	return list->count;
+}
+
+void GetVectorSoA(VectorListSoA *list, unsigned int index, Vector3D *target)
+{
+	SetVector(list->x[index], list->y[index], list->z[index],
+			list->w != NULL ? list->w[index] : 1, target);
+}
+
+int VectorListToSoA(VectorList *list, VectorListSoA *target)
+{
+	unsigned int i;
+	if (!ReserveVectorListSoA(target, list->count))
+	{
+		return 0;
+	}
+	for (i = 0; i < list->count; i++)
+	{
+		target->x[i] = list->vectors[i].x;
+		target->y[i] = list->vectors[i].y;
+		target->z[i] = list->vectors[i].z;
+	}
+	if (target->w != NULL)
+	{
+		for (i = 0; i < list->count; i++)
+		{
+			target->w[i] = list->vectors[i].w;
+		}
+	}
+	target->count = list->count;
+	return target->count;
+}
+
+int SoAToVectorList(VectorListSoA *list, VectorList *target)
+{
+	unsigned int i;
+	if (ReserveVectorList(target, list->count) == 0)
+	{
+		return 0;
+	}
+	for (i = 0; i < list->count; i++)
+	{
+		GetVectorSoA(list, i, &target->vectors[i]);
+	}
+	target->count = list->count;
+	target->index = list->count - 1;
+	return target->count;
+}
+
+// Array kernels. Component arrays are aligned by SOA_ALIGNMENT so the SIMD
+// loops can use aligned loads, the remaining tail is done in scalar.
+// The SSE kernels return how many elements they did.
+
+#ifdef ANSIC3D_X86_SIMD
+__attribute__((target("sse2")))
+static unsigned int AddArraySSE(const float *a, const float *b, float *t,
+		unsigned int n, int sub)
+{
+	unsigned int i;
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		_mm_store_ps(&t[i], sub ?
+				_mm_sub_ps(_mm_load_ps(&a[i]), _mm_load_ps(&b[i])) :
+				_mm_add_ps(_mm_load_ps(&a[i]), _mm_load_ps(&b[i])));
+	}
+	return i;
+}
+
+__attribute__((target("sse2")))
+static unsigned int ScaleArraySSE(float *t, float factor, unsigned int n)
+{
+	unsigned int i;
+	__m128 f = _mm_set1_ps(factor);
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		_mm_store_ps(&t[i], _mm_mul_ps(_mm_load_ps(&t[i]), f));
+	}
+	return i;
+}
+
+__attribute__((target("sse2")))
+static unsigned int DotProductSSE(VectorListSoA *a, VectorListSoA *b,
+		float *target)
+{
+	unsigned int i, n = a->count;
+	__m128 d;
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		d = _mm_mul_ps(_mm_load_ps(&a->x[i]), _mm_load_ps(&b->x[i]));
+		d = _mm_add_ps(d, _mm_mul_ps(_mm_load_ps(&a->y[i]),
+					_mm_load_ps(&b->y[i])));
+		d = _mm_add_ps(d, _mm_mul_ps(_mm_load_ps(&a->z[i]),
+					_mm_load_ps(&b->z[i])));
+		_mm_storeu_ps(&target[i], d);
+	}
+	return i;
+}
+
+__attribute__((target("sse2")))
+static unsigned int CrossProductSSE(VectorListSoA *a, VectorListSoA *b,
+		VectorListSoA *target)
+{
+	unsigned int i, n = a->count;
+	__m128 ax, ay, az, bx, by, bz;
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		ax = _mm_load_ps(&a->x[i]);
+		ay = _mm_load_ps(&a->y[i]);
+		az = _mm_load_ps(&a->z[i]);
+		bx = _mm_load_ps(&b->x[i]);
+		by = _mm_load_ps(&b->y[i]);
+		bz = _mm_load_ps(&b->z[i]);
+		_mm_store_ps(&target->x[i], _mm_sub_ps(_mm_mul_ps(ay, bz),
+					_mm_mul_ps(az, by)));
+		_mm_store_ps(&target->y[i], _mm_sub_ps(_mm_mul_ps(az, bx),
+					_mm_mul_ps(ax, bz)));
+		_mm_store_ps(&target->z[i], _mm_sub_ps(_mm_mul_ps(ax, by),
+					_mm_mul_ps(ay, bx)));
+	}
+	return i;
+}
+
+__attribute__((target("sse2")))
+static unsigned int NormalizeSSE(VectorListSoA *target)
+{
+	unsigned int i, n = target->count;
+	__m128 x, y, z, len, nonzero, inv;
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		x = _mm_load_ps(&target->x[i]);
+		y = _mm_load_ps(&target->y[i]);
+		z = _mm_load_ps(&target->z[i]);
+		len = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+				_mm_mul_ps(z, z));
+		len = _mm_sqrt_ps(len);
+		// Zero length vectors are left untouched
+		nonzero = _mm_cmpneq_ps(len, _mm_setzero_ps());
+		inv = _mm_div_ps(_mm_set1_ps(1), len);
+		inv = _mm_or_ps(_mm_and_ps(nonzero, inv),
+				_mm_andnot_ps(nonzero, _mm_set1_ps(1)));
+		_mm_store_ps(&target->x[i], _mm_mul_ps(x, inv));
+		_mm_store_ps(&target->y[i], _mm_mul_ps(y, inv));
+		_mm_store_ps(&target->z[i], _mm_mul_ps(z, inv));
+		if (target->w != NULL)
+		{
+			_mm_store_ps(&target->w[i], _mm_andnot_ps(nonzero,
+						_mm_load_ps(&target->w[i])));
+		}
+	}
+	return i;
+}
+
+__attribute__((target("sse2")))
+static unsigned int VectorLengthSSE(VectorListSoA *list, float *target)
+{
+	unsigned int i, n = list->count;
+	__m128 x, y, z;
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		x = _mm_load_ps(&list->x[i]);
+		y = _mm_load_ps(&list->y[i]);
+		z = _mm_load_ps(&list->z[i]);
+		_mm_storeu_ps(&target[i], _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(
+							_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+						_mm_mul_ps(z, z))));
+	}
+	return i;
+}
+#endif
+
+static void AddArray(const float *a, const float *b, float *t, unsigned int n,
+		int sub)
+{
+	unsigned int i = 0;
+#ifdef ANSIC3D_X86_SIMD
+	if (GetSIMDLevel() >= SIMD_SSE)
+	{
+		i = AddArraySSE(a, b, t, n, sub);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		t[i] = sub ? a[i] - b[i] : a[i] + b[i];
+	}
+}
+
+static void ScaleArray(float *t, float factor, unsigned int n)
+{
+	unsigned int i = 0;
+#ifdef ANSIC3D_X86_SIMD
+	if (GetSIMDLevel() >= SIMD_SSE)
+	{
+		i = ScaleArraySSE(t, factor, n);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		t[i] *= factor;
+	}
+}
+
+// Overwrite target->w with a->w, or 1 when a has no w column
+static void CopyW(VectorListSoA *a, VectorListSoA *target)
+{
+	unsigned int i;
+	if (target->w == NULL || target->w == a->w)
+	{
+		return;
+	}
+	for (i = 0; i < a->count; i++)
+	{
+		target->w[i] = a->w != NULL ? a->w[i] : 1;
+	}
+}
+
+static int AddOrSubVectorSoA(VectorListSoA *a, VectorListSoA *b,
+		VectorListSoA *target, int sub)
+{
+	if (a->count != b->count || !ReserveVectorListSoA(target, a->count))
+	{
+		return 0;
+	}
+	AddArray(a->x, b->x, target->x, a->count, sub);
+	AddArray(a->y, b->y, target->y, a->count, sub);
+	AddArray(a->z, b->z, target->z, a->count, sub);
+	CopyW(a, target);
+	target->count = a->count;
+	return target->count;
+}
+
+int AddVectorSoA(VectorListSoA *a, VectorListSoA *b, VectorListSoA *target)
+{
+	return AddOrSubVectorSoA(a, b, target, 0);
+}
+
+int SubVectorSoA(VectorListSoA *a, VectorListSoA *b, VectorListSoA *target)
+{
+	return AddOrSubVectorSoA(a, b, target, 1);
+}
+
+void ScaleVectorSoA(VectorListSoA *target, float factor)
+{
+	ScaleArray(target->x, factor, target->count);
+	ScaleArray(target->y, factor, target->count);
+	ScaleArray(target->z, factor, target->count);
+	if (target->w != NULL)
+	{
+		ScaleArray(target->w, factor, target->count);
+	}
+}
+
+int DotProductSoA(VectorListSoA *a, VectorListSoA *b, float *target)
+{
+	unsigned int i = 0, n = a->count;
+	if (a->count != b->count)
+	{
+		return 0;
+	}
+#ifdef ANSIC3D_X86_SIMD
+	if (GetSIMDLevel() >= SIMD_SSE)
+	{
+		i = DotProductSSE(a, b, target);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		target[i] = a->x[i] * b->x[i] + a->y[i] * b->y[i] +
+			a->z[i] * b->z[i];
+	}
+	return n;
+}
+
+int CrossProductSoA(VectorListSoA *a, VectorListSoA *b,
+		VectorListSoA *target)
+{
+	unsigned int i = 0, n = a->count;
+	float x, y, z;
+	if (a->count != b->count || !ReserveVectorListSoA(target, a->count))
+	{
+		return 0;
+	}
+#ifdef ANSIC3D_X86_SIMD
+	if (GetSIMDLevel() >= SIMD_SSE)
+	{
+		i = CrossProductSSE(a, b, target);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		x = a->y[i] * b->z[i] - a->z[i] * b->y[i];
+		y = a->z[i] * b->x[i] - a->x[i] * b->z[i];
+		z = a->x[i] * b->y[i] - a->y[i] * b->x[i];
+		target->x[i] = x;
+		target->y[i] = y;
+		target->z[i] = z;
+	}
+	CopyW(a, target);
+	target->count = n;
+	return n;
+}
+
+void NormalizeVectorSoA(VectorListSoA *target)
+{
+	unsigned int i = 0, n = target->count;
+	float vn, invlen;
+#ifdef ANSIC3D_X86_SIMD
+	if (GetSIMDLevel() >= SIMD_SSE)
+	{
+		i = NormalizeSSE(target);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		vn = sqrtf(target->x[i] * target->x[i] +
+				target->y[i] * target->y[i] +
+				target->z[i] * target->z[i]);
+		if (vn != 0)
+		{
+			invlen = 1 / vn;
+			target->x[i] *= invlen;
+			target->y[i] *= invlen;
+			target->z[i] *= invlen;
+			if (target->w != NULL)
+			{
+				target->w[i] = 0;
+			}
+		}
+	}
+}
+
+void VectorLengthSoA(VectorListSoA *list, float *target)
+{
+	unsigned int i = 0, n = list->count;
+#ifdef ANSIC3D_X86_SIMD
+	if (GetSIMDLevel() >= SIMD_SSE)
+	{
+		i = VectorLengthSSE(list, target);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		target[i] = sqrtf(list->x[i] * list->x[i] +
+				list->y[i] * list->y[i] +
+				list->z[i] * list->z[i]);
+	}
+}
+
+#ifdef ANSIC3D_X86_SIMD
+// 8 vectors per iteration, every matrix element is broadcast once
+__attribute__((target("avx2,fma")))
+static unsigned int TransformSoAAVX2(Matrix3D *m, VectorListSoA *src,
+		VectorListSoA *dst)
+{
+	unsigned int i, n = src->count;
+	__m256 x, y, z, w, one;
+	__m256 xx, xy, xz, xw, yx, yy, yz, yw, zx, zy, zz, zw, wx, wy, wz, ww;
+	xx = _mm256_set1_ps(m->X.x);
+	xy = _mm256_set1_ps(m->X.y);
+	xz = _mm256_set1_ps(m->X.z);
+	xw = _mm256_set1_ps(m->X.w);
+	yx = _mm256_set1_ps(m->Y.x);
+	yy = _mm256_set1_ps(m->Y.y);
+	yz = _mm256_set1_ps(m->Y.z);
+	yw = _mm256_set1_ps(m->Y.w);
+	zx = _mm256_set1_ps(m->Z.x);
+	zy = _mm256_set1_ps(m->Z.y);
+	zz = _mm256_set1_ps(m->Z.z);
+	zw = _mm256_set1_ps(m->Z.w);
+	wx = _mm256_set1_ps(m->W.x);
+	wy = _mm256_set1_ps(m->W.y);
+	wz = _mm256_set1_ps(m->W.z);
+	ww = _mm256_set1_ps(m->W.w);
+	one = _mm256_set1_ps(1);
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		x = _mm256_load_ps(&src->x[i]);
+		y = _mm256_load_ps(&src->y[i]);
+		z = _mm256_load_ps(&src->z[i]);
+		w = src->w != NULL ? _mm256_load_ps(&src->w[i]) : one;
+		_mm256_store_ps(&dst->x[i], _mm256_fmadd_ps(x, xx,
+					_mm256_fmadd_ps(y, yx, _mm256_fmadd_ps(z, zx,
+							_mm256_mul_ps(w, wx)))));
+		_mm256_store_ps(&dst->y[i], _mm256_fmadd_ps(x, xy,
+					_mm256_fmadd_ps(y, yy, _mm256_fmadd_ps(z, zy,
+							_mm256_mul_ps(w, wy)))));
+		_mm256_store_ps(&dst->z[i], _mm256_fmadd_ps(x, xz,
+					_mm256_fmadd_ps(y, yz, _mm256_fmadd_ps(z, zz,
+							_mm256_mul_ps(w, wz)))));
+		if (dst->w != NULL)
+		{
+			_mm256_store_ps(&dst->w[i], _mm256_fmadd_ps(x, xw,
+						_mm256_fmadd_ps(y, yw, _mm256_fmadd_ps(z, zw,
+								_mm256_mul_ps(w, ww)))));
+		}
+	}
+	_mm256_zeroupper();
+	return i;
+}
+#endif
+
+int TransformVectorSoA(Matrix3D *matrix, VectorListSoA *src,
+		VectorListSoA *dst)
+{
+	unsigned int i = 0;
+	float x, y, z, w;
+	Matrix3D m = *matrix;
+	if (!ReserveVectorListSoA(dst, src->count))
+	{
+		return 0;
+	}
+#ifdef ANSIC3D_X86_SIMD
+	if (GetSIMDLevel() >= SIMD_AVX2)
+	{
+		i = TransformSoAAVX2(&m, src, dst);
+	}
+#endif
+	for (; i < src->count; i++)
+	{
+		x = src->x[i];
+		y = src->y[i];
+		z = src->z[i];
+		w = src->w != NULL ? src->w[i] : 1;
+		dst->x[i] = x * m.X.x + y * m.Y.x + z * m.Z.x + w * m.W.x;
+		dst->y[i] = x * m.X.y + y * m.Y.y + z * m.Z.y + w * m.W.y;
+		dst->z[i] = x * m.X.z + y * m.Y.z + z * m.Z.z + w * m.W.z;
+		if (dst->w != NULL)
+		{
+			dst->w[i] = x * m.X.w + y * m.Y.w + z * m.Z.w + w * m.W.w;
+		}
+	}
+	dst->count = src->count;
+	return dst->count;
+}
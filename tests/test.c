@@ -1,8 +1,28 @@
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 #include <ansic3d/matrix3d.h>
 #include <ansic3d/vector3d.h>
 #include <ansic3d/vectorlist.h>
+#include <ansic3d/vectorlistsoa.h>
+#include <ansic3d/cpu.h>
+#include <ansic3d/parallel.h>
+#include <ansic3d/quaternion.h>
+#include <ansic3d/trig.h>
+#include <ansic3d/inline.h>
+#include <ansic3d/allocator.h>
+#include <ansic3d/vectorfile.h>
+#include <ansic3d/pointcloud.h>
+#include <ansic3d/bounds.h>
+#include <ansic3d/kdtree.h>
+#include <ansic3d/spatialhash.h>
+#include <ansic3d/octree.h>
+#include <ansic3d/frustum.h>
+#include <ansic3d/camera.h>
+#include <ansic3d/hierarchy.h>
+#include <ansic3d/ray.h>
+#include <ansic3d/bvh.h>
+#include <ansic3d/mesh.h>
 
 #define NORMAL "\x1B[0m"
 #define RED "\x1B[31m"
@@ -220,7 +240,8 @@ int TestPushVector()
 	{
 		return 0;
 	}
-	if (list.capacity != 16)
+	// Capacity grows geometrically
+	if (list.capacity < 16)
 	{
 		return 0;
 	}
@@ -609,6 +630,2931 @@ int TestCastFloat()
 	return 1;
 }
 
+int TestTransformVectorList()
+{
+	Matrix3D matrix;
+	VectorList src, dst;
+	Vector3D vector, axis;
+	unsigned int i;
+	int level, result;
+	result = 1;
+	SetVector(1, 2, 3, 0, &axis);
+	CreateRotationMatrix(axis, degtorad(30), &matrix);
+	SetVector(0.5, -0.25, 1.5, 1, &matrix.W);
+	InitVectorList(&src, 4);
+	for (i = 0; i < 37; i++)
+	{
+		SetVector(i * 0.1, 1 - i * 0.05, 0.3, 1, &vector);
+		PushVector(vector, &src);
+	}
+	for (level = SIMD_SCALAR; level <= DetectSIMDLevel(); level++)
+	{
+		SetSIMDLevel(level);
+		InitVectorList(&dst, 1);
+		if (TransformVectorList(&matrix, &src, &dst) != 37)
+		{
+			result = 0;
+		}
+		for (i = 0; i < src.count; i++)
+		{
+			CloneVector(src.vectors[i], &vector);
+			VectorTransform(&matrix, &vector);
+			if (!VectorEquals(vector, dst.vectors[i]))
+			{
+				result = 0;
+			}
+		}
+		TransformVectorListInPlace(&matrix, &dst);
+		TransformVectorList(&matrix, &src, &src);
+		TransformVectorList(&matrix, &src, &src);
+		for (i = 0; i < src.count; i++)
+		{
+			if (!VectorEquals(src.vectors[i], dst.vectors[i]))
+			{
+				result = 0;
+			}
+		}
+		InvertMatrix(&matrix);
+		TransformVectorListInPlace(&matrix, &src);
+		TransformVectorListInPlace(&matrix, &src);
+		InvertMatrix(&matrix);
+		FreeVectorList(&dst);
+	}
+	SetSIMDLevel(DetectSIMDLevel());
+	// An empty source still replaces the content of dst
+	InitVectorList(&dst, 1);
+	if (TransformVectorList(&matrix, &dst, &src) != 0 || src.count != 0 ||
+			src.index != -1)
+	{
+		result = 0;
+	}
+	FreeVectorList(&dst);
+	FreeVectorList(&src);
+	return result;
+}
+
+int TestVectorListSoA()
+{
+	VectorList list, back;
+	VectorListSoA soa;
+	Vector3D vector;
+	unsigned int i;
+	int result = 1;
+	InitVectorList(&list, 10);
+	InitVectorList(&back, 1);
+	for (i = 0; i < 21; i++)
+	{
+		SetVector(i, i * 2, i * 3, 1, &vector);
+		PushVector(vector, &list);
+	}
+	InitVectorListSoA(&soa, 4, 1);
+	if (VectorListToSoA(&list, &soa) != 21 || soa.capacity < 21)
+	{
+		result = 0;
+	}
+	if (((size_t)soa.x % SOA_ALIGNMENT) != 0)
+	{
+		result = 0;
+	}
+	if (SoAToVectorList(&soa, &back) != 21)
+	{
+		result = 0;
+	}
+	for (i = 0; i < 21; i++)
+	{
+		if (!VectorEquals(list.vectors[i], back.vectors[i]) ||
+				back.vectors[i].w != 1)
+		{
+			result = 0;
+		}
+	}
+	PushVectorSoA(vector, &soa);
+	GetVectorSoA(&soa, 21, &vector);
+	if (soa.count != 22 || vector.z != 60)
+	{
+		result = 0;
+	}
+	FreeVectorListSoA(&soa);
+	FreeVectorList(&list);
+	FreeVectorList(&back);
+	return result;
+}
+
+int TestVectorSoAOps()
+{
+	VectorListSoA a, b, t;
+	Vector3D v1, v2, expect, got;
+	Matrix3D matrix;
+	float dots[19], lengths[19];
+	unsigned int i;
+	int level, result = 1;
+	CreateRotationMatrixZ(degtorad(-90), &matrix);
+	SetVector(1, 2, 3, 1, &matrix.W);
+	for (level = SIMD_SCALAR; level <= DetectSIMDLevel(); level++)
+	{
+		SetSIMDLevel(level);
+		InitVectorListSoA(&a, 0, 0);
+		InitVectorListSoA(&b, 0, 0);
+		InitVectorListSoA(&t, 0, 1);
+		for (i = 0; i < 19; i++)
+		{
+			SetVector(i * 0.25, 1, -0.5 * i, 1, &v1);
+			SetVector(0.5, i * 0.1, 2, 1, &v2);
+			PushVectorSoA(v1, &a);
+			PushVectorSoA(v2, &b);
+		}
+		DotProductSoA(&a, &b, dots);
+		for (i = 0; i < 19; i++)
+		{
+			GetVectorSoA(&a, i, &v1);
+			GetVectorSoA(&b, i, &v2);
+			if (fabsf(dots[i] - DotProduct(v1, v2)) > PRECISION)
+			{
+				result = 0;
+			}
+		}
+		AddVectorSoA(&a, &b, &t);
+		CrossProductSoA(&t, &b, &t);
+		SubVectorSoA(&t, &a, &t);
+		ScaleVectorSoA(&t, 0.5);
+		for (i = 0; i < 19; i++)
+		{
+			GetVectorSoA(&a, i, &v1);
+			GetVectorSoA(&b, i, &v2);
+			AddVector(v1, v2, &expect);
+			CrossProduct(expect, v2, &expect);
+			SubVector(expect, v1, &expect);
+			ScaleVector(&expect, 0.5);
+			GetVectorSoA(&t, i, &got);
+			if (!VectorEquals(expect, got))
+			{
+				result = 0;
+			}
+		}
+		VectorLengthSoA(&t, lengths);
+		NormalizeVectorSoA(&t);
+		for (i = 0; i < 19; i++)
+		{
+			GetVectorSoA(&t, i, &got);
+			if (lengths[i] != 0 && fabsf(VectorLength(got) - 1) > 1E-5)
+			{
+				result = 0;
+			}
+		}
+		TransformVectorSoA(&matrix, &a, &t);
+		for (i = 0; i < 19; i++)
+		{
+			GetVectorSoA(&a, i, &expect);
+			VectorTransform(&matrix, &expect);
+			GetVectorSoA(&t, i, &got);
+			if (!VectorEquals(expect, got) || fabsf(got.w - 1) > PRECISION)
+			{
+				result = 0;
+			}
+		}
+		FreeVectorListSoA(&a);
+		FreeVectorListSoA(&b);
+		FreeVectorListSoA(&t);
+	}
+	SetSIMDLevel(DetectSIMDLevel());
+	return result;
+}
+
+int TestReserveVectorList()
+{
+	VectorList list;
+	Vector3D vector;
+	unsigned int i;
+	SetVector(1, 2, 3, 1, &vector);
+	InitVectorList(&list, 2);
+	if (ReserveVectorList(&list, 100) != 100)
+	{
+		return 0;
+	}
+	// Reserve never shrinks
+	if (ReserveVectorList(&list, 10) != 100)
+	{
+		return 0;
+	}
+	for (i = 0; i < 5; i++)
+	{
+		PushVector(vector, &list);
+	}
+	if (ShrinkVectorList(&list, 8) != 8 || list.count != 5)
+	{
+		return 0;
+	}
+	if (ShrinkVectorList(&list, 0) != 5)
+	{
+		return 0;
+	}
+	if (!VectorEquals(list.vectors[4], vector))
+	{
+		return 0;
+	}
+	FreeVectorList(&list);
+	return 1;
+}
+
+int TestPushVectors()
+{
+	VectorList list;
+	Vector3D vectors[50];
+	unsigned int i;
+	for (i = 0; i < 50; i++)
+	{
+		SetVector(i, i + 1, i + 2, 1, &vectors[i]);
+	}
+	InitVectorList(&list, 1);
+	PushVector(vectors[0], &list);
+	if (PushVectors(vectors, 50, &list) != 51)
+	{
+		return 0;
+	}
+	if (list.index != 50 || list.capacity < 51)
+	{
+		return 0;
+	}
+	for (i = 0; i < 50; i++)
+	{
+		if (!VectorEquals(list.vectors[i + 1], vectors[i]))
+		{
+			return 0;
+		}
+	}
+	// Appending the list to itself has to survive the reallocation
+	TrimVectorList(&list);
+	if (PushVectors(list.vectors, 51, &list) != 102)
+	{
+		return 0;
+	}
+	for (i = 0; i < 50; i++)
+	{
+		if (!VectorEquals(list.vectors[i + 52], vectors[i]))
+		{
+			return 0;
+		}
+	}
+	FreeVectorList(&list);
+	return 1;
+}
+
+int TestRemoveVectorIndex()
+{
+	VectorList list;
+	Vector3D vector;
+	unsigned int i;
+	InitVectorList(&list, 10);
+	for (i = 0; i < 10; i++)
+	{
+		SetVector(i, 0, 0, 1, &vector);
+		PushVector(vector, &list);
+	}
+	if (RemoveVectorIndex(&list, 3) != 9 || list.index != 8)
+	{
+		return 0;
+	}
+	if (list.vectors[3].x != 4 || list.vectors[8].x != 9)
+	{
+		return 0;
+	}
+	// Last item
+	RemoveVectorIndex(&list, 8);
+	if (list.count != 8 || list.vectors[7].x != 8)
+	{
+		return 0;
+	}
+	if (SwapRemoveVectorIndex(&list, 0) != 7 || list.vectors[0].x != 8)
+	{
+		return 0;
+	}
+	if (RemoveVectorIndex(&list, 7) != 0 || SwapRemoveVectorIndex(&list, -1))
+	{
+		return 0;
+	}
+	FreeVectorList(&list);
+	return 1;
+}
+
+int IsNegativeX(Vector3D *v, void *context)
+{
+	(void)context;
+	return v->x < 0;
+}
+
+int TestRemoveVectorsBatch()
+{
+	VectorList list;
+	Vector3D vector;
+	unsigned int i;
+	unsigned int indices[] = {0, 2, 2, 3, 7, 9, 40};
+	unsigned int unsorted[] = {3, 1, 4, 0, 5};
+	float expect[] = {1, 4, 5, 6, 8};
+	InitVectorList(&list, 10);
+	for (i = 0; i < 10; i++)
+	{
+		SetVector(i, 0, 0, 1, &vector);
+		PushVector(vector, &list);
+	}
+	if (RemoveVectorIndices(&list, indices, 7) != 5 || list.index != 4)
+	{
+		return 0;
+	}
+	for (i = 0; i < 5; i++)
+	{
+		if (list.vectors[i].x != expect[i])
+		{
+			return 0;
+		}
+	}
+	list.vectors[1].x = -4;
+	list.vectors[4].x = -8;
+	if (RemoveVectorsIf(&list, IsNegativeX, NULL) != 3 || list.index != 2)
+	{
+		return 0;
+	}
+	if (list.vectors[0].x != 1 || list.vectors[1].x != 5 ||
+			list.vectors[2].x != 6)
+	{
+		return 0;
+	}
+	for (i = 7; i < 10; i++)
+	{
+		SetVector(i, 0, 0, 1, &vector);
+		PushVector(vector, &list);
+	}
+	if (RemoveVectorIndices(&list, unsorted, 5) != 3 || list.index != 2)
+	{
+		return 0;
+	}
+	if (list.vectors[0].x != 1 || list.vectors[1].x != 5 ||
+			list.vectors[2].x != 6)
+	{
+		return 0;
+	}
+	FreeVectorList(&list);
+	return 1;
+}
+
+int TestMultiplyMatrixSIMD()
+{
+	Matrix3D m1, m2, expect, target;
+	float a[16], b[16], e[16];
+	unsigned int i, j, k;
+	int level, result = 1;
+	for (i = 0; i < 16; i++)
+	{
+		a[i] = (i % 5) * 0.5 - 1;
+		b[i] = (i % 7) * 0.25 - 0.5;
+	}
+	for (i = 0; i < 4; i++)
+	{
+		for (j = 0; j < 4; j++)
+		{
+			e[i * 4 + j] = 0;
+			for (k = 0; k < 4; k++)
+			{
+				e[i * 4 + j] += a[i * 4 + k] * b[k * 4 + j];
+			}
+		}
+	}
+	SetVector(e[0], e[1], e[2], e[3], &expect.X);
+	SetVector(e[4], e[5], e[6], e[7], &expect.Y);
+	SetVector(e[8], e[9], e[10], e[11], &expect.Z);
+	SetVector(e[12], e[13], e[14], e[15], &expect.W);
+	for (level = SIMD_SCALAR; level <= DetectSIMDLevel(); level++)
+	{
+		if (SetSIMDLevel(level) != level)
+		{
+			result = 0;
+		}
+		SetVector(a[0], a[1], a[2], a[3], &m1.X);
+		SetVector(a[4], a[5], a[6], a[7], &m1.Y);
+		SetVector(a[8], a[9], a[10], a[11], &m1.Z);
+		SetVector(a[12], a[13], a[14], a[15], &m1.W);
+		SetVector(b[0], b[1], b[2], b[3], &m2.X);
+		SetVector(b[4], b[5], b[6], b[7], &m2.Y);
+		SetVector(b[8], b[9], b[10], b[11], &m2.Z);
+		SetVector(b[12], b[13], b[14], b[15], &m2.W);
+		MultiplyMatrixRestrict(&m1, &m2, &target);
+		if (!MatrixEquals(&target, &expect) ||
+				fabsf(target.W.w - expect.W.w) > PRECISION)
+		{
+			result = 0;
+		}
+		// target overlapping an operand
+		MultiplyMatrix(&m1, &m2, &m1);
+		if (!MatrixEquals(&m1, &expect))
+		{
+			result = 0;
+		}
+	}
+	SetSIMDLevel(DetectSIMDLevel());
+	if (strcmp(SIMDLevelName(SIMD_SSE41), "sse4.1") != 0)
+	{
+		result = 0;
+	}
+	return result;
+}
+
+// Float results of different but equivalent computations drift apart
+// by more than PRECISION on larger values
+int MatrixClose(Matrix3D *m1, Matrix3D *m2)
+{
+	float f1[16], f2[16];
+	unsigned int i;
+	CastFloat(m1, f1);
+	CastFloat(m2, f2);
+	for (i = 0; i < 16; i++)
+	{
+		if (fabsf(f1[i] - f2[i]) > 1E-4 * (1 + fabsf(f2[i])))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int TestInvertMatrixFast()
+{
+	Matrix3D rotation, translation, scale, rigid, affine, general, expect;
+	Matrix3D target;
+	Vector3D axis, offset, factor;
+	SetVector(1, 2, 3, 0, &axis);
+	SetVector(5, -10, 2, 1, &offset);
+	SetVector(2, 0.5, 4, 1, &factor);
+	CreateRotationMatrix(axis, degtorad(40), &rotation);
+	CreateTranslationMatrix(offset, &translation);
+	CreateScaleMatrix(factor, &scale);
+	MultiplyMatrix(&rotation, &translation, &rigid);
+	MultiplyMatrix(&scale, &rigid, &affine);
+	if (!IsRigidMatrix(&rigid) || IsRigidMatrix(&affine) ||
+			!IsAffineMatrix(&affine))
+	{
+		return 0;
+	}
+
+	expect = rigid;
+	InvertMatrix(&expect);
+	target = rigid;
+	InvertRigidMatrix(&target);
+	if (!MatrixClose(&target, &expect))
+	{
+		return 0;
+	}
+	target = rigid;
+	InvertMatrixFast(&target);
+	if (!MatrixClose(&target, &expect))
+	{
+		return 0;
+	}
+
+	expect = affine;
+	InvertMatrix(&expect);
+	target = affine;
+	InvertAffineMatrix(&target);
+	if (!MatrixClose(&target, &expect))
+	{
+		return 0;
+	}
+	target = affine;
+	InvertMatrixFast(&target);
+	if (!MatrixClose(&target, &expect) || target.W.w != 1)
+	{
+		return 0;
+	}
+
+	general = affine;
+	general.X.w = 0.5;
+	if (IsAffineMatrix(&general))
+	{
+		return 0;
+	}
+	expect = general;
+	InvertMatrix(&expect);
+	InvertMatrixFast(&general);
+	return MatrixClose(&general, &expect);
+}
+
+int TestMultiplyMatrixArray()
+{
+	Matrix3D *a, *b, *out, m, expect;
+	Vector3D axis;
+	unsigned int i, n = 5000;
+	int threads, result = 1;
+	a = malloc(n * sizeof(Matrix3D));
+	b = malloc(n * sizeof(Matrix3D));
+	out = malloc(n * sizeof(Matrix3D));
+	SetVector(1, 1, 0, 0, &axis);
+	CreateRotationMatrix(axis, 0.3, &m);
+	SetVector(1, 2, 3, 1, &m.W);
+	for (i = 0; i < n; i++)
+	{
+		CreateRotationMatrixZ(i * 0.01, &a[i]);
+		CreateRotationMatrixX(i * 0.02, &b[i]);
+		SetVector(i % 7, 1, -1, 1, &b[i].W);
+	}
+	threads = GetThreadCount();
+	SetThreadCount(4);
+	MultiplyMatrixArray(a, b, out, n);
+	for (i = 0; i < n; i++)
+	{
+		MultiplyMatrix(&a[i], &b[i], &expect);
+		if (!MatrixClose(&out[i], &expect))
+		{
+			result = 0;
+		}
+	}
+	MultiplyMatrixBroadcastLeft(&m, b, out, n);
+	for (i = 0; i < n; i++)
+	{
+		MultiplyMatrix(&m, &b[i], &expect);
+		if (!MatrixClose(&out[i], &expect))
+		{
+			result = 0;
+		}
+	}
+	MultiplyMatrixBroadcastRight(b, &m, out, n);
+	for (i = 0; i < n; i++)
+	{
+		MultiplyMatrix(&b[i], &m, &expect);
+		if (!MatrixClose(&out[i], &expect))
+		{
+			result = 0;
+		}
+	}
+	// In place
+	MultiplyMatrixBroadcastRight(b, &m, b, n);
+	for (i = 0; i < n; i++)
+	{
+		if (!MatrixClose(&out[i], &b[i]))
+		{
+			result = 0;
+		}
+	}
+	SetThreadCount(threads);
+	free(a);
+	free(b);
+	free(out);
+	return result;
+}
+
+int TestQuaternionMatrix()
+{
+	Quaternion q, back;
+	Matrix3D expect, target;
+	Vector3D axis;
+	SetVector(1, 2, 3, 0, &axis);
+	AxisAngleQuaternion(axis, degtorad(70), &q);
+	CreateRotationMatrix(axis, degtorad(70), &expect);
+	QuaternionToMatrix(q, &target);
+	if (!MatrixClose(&target, &expect))
+	{
+		return 0;
+	}
+	MatrixToQuaternion(&target, &back);
+	if (!QuaternionEquals(q, back))
+	{
+		return 0;
+	}
+	// Large rotation takes the non-trace branches
+	AxisAngleQuaternion(axis, degtorad(179), &q);
+	QuaternionToMatrix(q, &target);
+	MatrixToQuaternion(&target, &back);
+	return fabsf(fabsf(QuaternionDot(q, back)) - 1) < 1E-5;
+}
+
+int TestMultiplyQuaternion()
+{
+	Quaternion q1, q2, q;
+	Matrix3D m1, m2, expect, target;
+	Vector3D axis;
+	SetVector(0, 0, 1, 0, &axis);
+	AxisAngleQuaternion(axis, degtorad(30), &q1);
+	SetVector(1, 1, 0, 0, &axis);
+	AxisAngleQuaternion(axis, degtorad(50), &q2);
+	MultiplyQuaternion(q1, q2, &q);
+	QuaternionToMatrix(q1, &m1);
+	QuaternionToMatrix(q2, &m2);
+	MultiplyMatrix(&m1, &m2, &expect);
+	QuaternionToMatrix(q, &target);
+	if (!MatrixClose(&target, &expect))
+	{
+		return 0;
+	}
+	ConjugateQuaternion(&q2);
+	MultiplyQuaternion(q, q2, &q);
+	NormalizeQuaternion(&q);
+	return QuaternionEquals(q, q1);
+}
+
+int TestSlerpQuaternion()
+{
+	Quaternion q1, q2, target, expect;
+	Vector3D axis;
+	SetVector(0, 1, 0, 0, &axis);
+	AxisAngleQuaternion(axis, degtorad(20), &q1);
+	AxisAngleQuaternion(axis, degtorad(120), &q2);
+	AxisAngleQuaternion(axis, degtorad(45), &expect);
+	SlerpQuaternion(q1, q2, 0.25, &target);
+	if (!QuaternionEquals(target, expect))
+	{
+		return 0;
+	}
+	SlerpQuaternion(q1, q2, 1, &target);
+	if (!QuaternionEquals(target, q2))
+	{
+		return 0;
+	}
+	// Same rotation with flipped sign interpolates along the short arc
+	q2.x = -q2.x;
+	q2.y = -q2.y;
+	q2.z = -q2.z;
+	q2.w = -q2.w;
+	SlerpQuaternion(q1, q2, 0.25, &target);
+	if (!QuaternionEquals(target, expect))
+	{
+		return 0;
+	}
+	NlerpQuaternion(q1, q2, 0.5, &target);
+	AxisAngleQuaternion(axis, degtorad(70), &expect);
+	return QuaternionEquals(target, expect);
+}
+
+int TestQuaternionRotateVector()
+{
+	Quaternion q;
+	Matrix3D matrix;
+	Vector3D axis, vector, expect;
+	VectorList list;
+	unsigned int i;
+	SetVector(1, -1, 2, 0, &axis);
+	AxisAngleQuaternion(axis, degtorad(80), &q);
+	QuaternionToMatrix(q, &matrix);
+	InitVectorList(&list, 8);
+	for (i = 0; i < 13; i++)
+	{
+		SetVector(i * 0.1, 1, -0.3 * i, 1, &vector);
+		PushVector(vector, &list);
+	}
+	SetVector(1, 2, 3, 1, &vector);
+	SetVector(1, 2, 3, 1, &expect);
+	QuaternionRotateVector(q, &vector);
+	VectorTransform(&matrix, &expect);
+	if (!VectorEquals(vector, expect) || vector.w != 1)
+	{
+		return 0;
+	}
+	QuaternionRotateVectorList(q, &list);
+	for (i = 0; i < 13; i++)
+	{
+		SetVector(i * 0.1, 1, -0.3 * i, 1, &expect);
+		QuaternionRotateVector(q, &expect);
+		if (!VectorEquals(list.vectors[i], expect))
+		{
+			return 0;
+		}
+	}
+	FreeVectorList(&list);
+	return 1;
+}
+
+// Distance between two floats in units of the last place of expect
+float ULPError(float expect, float value)
+{
+	float magnitude = fabsf(expect);
+	if (magnitude < 1E-30)
+	{
+		magnitude = 1E-30;
+	}
+	return fabsf(expect - value) / (nextafterf(magnitude, 2) - magnitude);
+}
+
+int TestFastSinCos()
+{
+	float angles[2000], s[2000], c[2000];
+	float x, fs, fc, ls, lc, ulp, max_ulp = 0, max_abs = 0;
+	unsigned int i;
+	int level, result = 1;
+	for (x = -FAST_TRIG_RANGE; x <= FAST_TRIG_RANGE; x += 0.0173)
+	{
+		FastSinCos(x, &fs, &fc);
+		ls = sinf(x);
+		lc = cosf(x);
+		max_abs = fmaxf(max_abs, fmaxf(fabsf(fs - ls), fabsf(fc - lc)));
+		// Near the zeros only the absolute error is meaningful
+		ulp = fmaxf(fabsf(ls) >= 1.0 / 256 ? ULPError(ls, fs) : 0,
+				fabsf(lc) >= 1.0 / 256 ? ULPError(lc, fc) : 0);
+		max_ulp = fmaxf(max_ulp, ulp);
+	}
+	printf("FastSinCos max error against libm: %.0f ulp, %g absolute\n",
+			max_ulp, max_abs);
+	if (max_ulp > 2 || max_abs > 1E-7)
+	{
+		result = 0;
+	}
+	for (i = 0; i < 2000; i++)
+	{
+		angles[i] = (i - 1000.0) * 0.0421;
+	}
+	// Out of range angles fall back to libm
+	angles[13] = 1E6;
+	for (level = SIMD_SCALAR; level <= DetectSIMDLevel(); level++)
+	{
+		SetSIMDLevel(level);
+		FastSinCosArray(angles, s, c, 2000);
+		for (i = 0; i < 2000; i++)
+		{
+			if (fabsf(s[i] - sinf(angles[i])) > 1E-7 ||
+					fabsf(c[i] - cosf(angles[i])) > 1E-7)
+			{
+				result = 0;
+			}
+		}
+	}
+	SetSIMDLevel(DetectSIMDLevel());
+	return result;
+}
+
+int TestFastTrigRotation()
+{
+	int enabled, result;
+	enabled = GetFastTrig();
+	SetFastTrig(1);
+	result = GetFastTrig() && TestCreateRotationMatrixX() &&
+		TestCreateRotationMatrixY() && TestCreateRotationMatrixZ() &&
+		TestCreateRotationMatrix() && TestRotateAroundX() &&
+		TestRotateAroundY() && TestRotateAroundZ() &&
+		TestQuaternionMatrix();
+	SetFastTrig(enabled);
+	return result;
+}
+
+int TestInlineVector()
+{
+	Vector3D a, b, c, r1, r2;
+	SetVector(1.5, -2, 3, 1, &a);
+	SetVector(-4, 0.25, 2, 1, &b);
+	SetVector(0.5, 7, -1, 1, &c);
+
+	CrossProduct(a, b, &r1);
+	CrossProductInline(&a, &b, &r2);
+	if (!VectorEqualsInline(&r1, &r2))
+	{
+		return 0;
+	}
+	PlaneNormal(a, b, c, &r1);
+	PlaneNormalInline(&a, &b, &c, &r2);
+	if (!VectorEquals(r1, r2))
+	{
+		return 0;
+	}
+	CloneVectorInline(&a, &r1);
+	CloneVectorInline(&a, &r2);
+	RotateAroundY(&r1, 0.7);
+	RotateAroundYInline(&r2, 0.7);
+	if (!VectorEquals(r1, r2))
+	{
+		return 0;
+	}
+	return DotProduct(a, b) == DotProductInline(&a, &b) &&
+		fabs(VectorDistanceInline(&a, &b) - 6.0259854) < 1E-5 &&
+		fabs(VectorDistanceSquaredInline(&a, &b) - 36.3125) < 1E-5;
+}
+
+int TestInlineMatrix()
+{
+	Matrix3D m1, m2, r1, r2;
+	Vector3D v, t1, t2;
+	float f[16];
+	CreateRotationMatrixX(0.3, &m1);
+	m1.W.x = 4;
+	m1.W.y = -2;
+	CreateRotationMatrixZ(1.1, &m2);
+	m2.X.w = 0.5;
+
+	MultiplyMatrix(&m1, &m2, &r1);
+	MultiplyMatrixInline(&m1, &m2, &r2);
+	if (!MatrixEqualsInline(&r1, &r2))
+	{
+		return 0;
+	}
+	SetVector(1, 2, 3, 1, &v);
+	CloneVector(v, &t1);
+	VectorTransform(&r1, &t1);
+	VectorTransformInline(&r2, &v, &t2);
+	if (!VectorEquals(t1, t2) || t1.w != t2.w)
+	{
+		return 0;
+	}
+	TransposeMatrixInline(&r2);
+	CastFloatInline(&r2, f);
+	if (f[1] != r1.Y.x || f[12] != r1.X.w)
+	{
+		return 0;
+	}
+	return MatrixDeterminant(&r1) == MatrixDeterminantInline(&r1);
+}
+
+typedef struct _CountingContext
+{
+	int allocs;
+	int frees;
+} CountingContext;
+
+void *CountingAlloc(size_t size, void *context)
+{
+	((CountingContext *) context)->allocs++;
+	return malloc(size);
+}
+
+void *CountingRealloc(void *p, size_t old_size, size_t size, void *context)
+{
+	(void) old_size;
+	(void) context;
+	return realloc(p, size);
+}
+
+void CountingFree(void *p, size_t size, void *context)
+{
+	(void) size;
+	((CountingContext *) context)->frees++;
+	free(p);
+}
+
+int TestVectorListAllocator()
+{
+	VectorList list;
+	Vector3D vector;
+	CountingContext counts = {0, 0};
+	Allocator allocator;
+	int i;
+	allocator.alloc = CountingAlloc;
+	allocator.realloc = CountingRealloc;
+	allocator.free = CountingFree;
+	allocator.context = &counts;
+
+	InitVectorListAllocator(&list, 2, &allocator);
+	for (i = 0; i < 100; i++)
+	{
+		SetVector(i, 0, 0, 1, &vector);
+		PushVector(vector, &list);
+	}
+	TrimVectorList(&list);
+	if (list.count != 100 || list.vectors[99].x != 99)
+	{
+		return 0;
+	}
+	FreeVectorList(&list);
+	return counts.allocs == 1 && counts.frees == 1;
+}
+
+int TestFrameArena()
+{
+	FrameArena arena;
+	VectorList a, b;
+	Vector3D vector;
+	int i;
+	if (!InitFrameArena(&arena, 4096))
+	{
+		return 0;
+	}
+	InitVectorListAllocator(&a, 4, &arena.allocator);
+	InitVectorListAllocator(&b, 4, &arena.allocator);
+	for (i = 0; i < 40; i++)
+	{
+		SetVector(i, i, i, 1, &vector);
+		PushVector(vector, &a);
+		SetVector(-i, 0, 0, 1, &vector);
+		PushVector(vector, &b);
+	}
+	// a was moved when it grew behind b, b grows in place
+	for (i = 0; i < 40; i++)
+	{
+		if (a.vectors[i].x != i || b.vectors[i].x != -i)
+		{
+			return 0;
+		}
+	}
+	if (((size_t) a.vectors) % ARENA_ALIGNMENT != 0 ||
+			((size_t) b.vectors) % ARENA_ALIGNMENT != 0)
+	{
+		return 0;
+	}
+	// Arena is full
+	if (ReserveVectorList(&b, 1000) != 0 || b.count != 40)
+	{
+		return 0;
+	}
+	ResetFrameArena(&arena);
+	if (FrameArenaUsed(&arena) != 0)
+	{
+		return 0;
+	}
+	InitVectorListAllocator(&a, 256, &arena.allocator);
+	if (a.vectors != (Vector3D *) arena.buffer)
+	{
+		return 0;
+	}
+	FreeVectorList(&a);
+	i = FrameArenaUsed(&arena) == 0;
+	// An empty list must not share its block with the next one
+	ResetFrameArena(&arena);
+	InitVectorListAllocator(&a, 0, &arena.allocator);
+	InitVectorListAllocator(&b, 8, &arena.allocator);
+	SetVector(9, 9, 9, 1, &vector);
+	PushVector(vector, &b);
+	SetVector(1, 2, 3, 1, &vector);
+	PushVector(vector, &a);
+	PushVector(vector, &a);
+	if (a.vectors == b.vectors || b.vectors[0].x != 9 ||
+			a.vectors[1].z != 3)
+	{
+		i = 0;
+	}
+	FreeFrameArena(&arena);
+	return i;
+}
+
+int TestVectorListFile()
+{
+	VectorList list;
+	VectorFile file;
+	Vector3D vector;
+	const char *path = "test_vectors.bin";
+	FILE *f;
+	int i, ok = 1;
+	InitVectorList(&list, 1000);
+	for (i = 0; i < 1000; i++)
+	{
+		SetVector(i * 0.5f, -i, (i % 7) - 3, 1, &vector);
+		PushVector(vector, &list);
+	}
+	if (!SaveVectorListFile(&list, path) || !MapVectorListFile(path, &file))
+	{
+		return 0;
+	}
+	if (file.list.count != 1000 ||
+			memcmp(file.list.vectors, list.vectors,
+				1000 * sizeof(Vector3D)) != 0)
+	{
+		ok = 0;
+	}
+	if (file.header.min[0] != 0 || file.header.max[0] != 499.5f ||
+			file.header.min[1] != -999 || file.header.max[1] != 0 ||
+			file.header.min[2] != -3 || file.header.max[2] != 3)
+	{
+		ok = 0;
+	}
+	// Mapped lists can be changed in place but can not grow
+	file.list.vectors[0].x = 42;
+	if (PushVector(vector, &file.list) != 0 || file.list.count != 1000)
+	{
+		ok = 0;
+	}
+	FreeVectorList(&file.list);
+	UnmapVectorListFile(&file);
+	if (!MapVectorListFile(path, &file) || file.list.vectors[0].x != 0)
+	{
+		return 0;
+	}
+	UnmapVectorListFile(&file);
+
+	// Broken header
+	f = fopen(path, "r+b");
+	fseek(f, 8, SEEK_SET);
+	fputc('X', f);
+	fclose(f);
+	if (MapVectorListFile(path, &file))
+	{
+		ok = 0;
+	}
+	remove(path);
+	FreeVectorList(&list);
+	return ok;
+}
+
+int CountPointChunks(const Vector3D *points, unsigned int n, void *context)
+{
+	int *chunks = context;
+	(void) points;
+	(*chunks)++;
+	// Stop after the second chunk
+	return *chunks < 2 && n == POINTCLOUD_CHUNK;
+}
+
+int TestLoadPointCloudXYZ()
+{
+	VectorList list;
+	const char *path = "test_points.xyz";
+	FILE *f = fopen(path, "w");
+	char number[32];
+	float expected;
+	int i, chunks = 0, ok = 1;
+	fprintf(f, "# x y z r g b\n");
+	fprintf(f, "1.5 -2 3e2 255 0 0\n");
+	fprintf(f, "0.000123,4.5E-3,-.25\r\n");
+	fprintf(f, "not a point\n\n");
+	for (i = 0; i < 10000; i++)
+	{
+		fprintf(f, "%.9g\t%d %.6f\n", i * 0.37 - 1000, i, i / 7.0);
+	}
+	fprintf(f, "7 8 9");
+	fclose(f);
+
+	InitVectorList(&list, 1);
+	if (LoadPointCloud(path, &list) != 10003 || list.count != 10003)
+	{
+		return 0;
+	}
+	if (list.vectors[0].x != 1.5f || list.vectors[0].z != 300 ||
+			list.vectors[1].x != 0.000123f || list.vectors[1].y != 4.5E-3f ||
+			list.vectors[1].z != -0.25f || list.vectors[1].w != 1 ||
+			list.vectors[10002].z != 9)
+	{
+		ok = 0;
+	}
+	// Parsing matches strtof
+	for (i = 0; i < 10000; i++)
+	{
+		sprintf(number, "%.9g", i * 0.37 - 1000);
+		expected = strtof(number, NULL);
+		if (list.vectors[i + 2].x != expected || list.vectors[i + 2].y != i)
+		{
+			ok = 0;
+		}
+	}
+	// Callback can stop the stream
+	if (StreamPointCloud(path, CountPointChunks, &chunks) !=
+			2 * POINTCLOUD_CHUNK || chunks != 2)
+	{
+		ok = 0;
+	}
+	remove(path);
+	FreeVectorList(&list);
+	return ok && LoadPointCloud("missing.xyz", &list) == -1;
+}
+
+int IsBigEndianHost()
+{
+	unsigned short one = 1;
+	return *(unsigned char *) &one == 0;
+}
+
+int TestLoadPointCloudPLY()
+{
+	VectorList list;
+	const char *path = "test_points.ply";
+	unsigned char swapped[8];
+	double d;
+	float v[4];
+	short s = 7;
+	FILE *f;
+	int i, k, ok = 1;
+
+	// ascii
+	f = fopen(path, "w");
+	fprintf(f, "ply\nformat ascii 1.0\ncomment test\nelement vertex 2\n"
+			"property float y\nproperty float x\nproperty uchar red\n"
+			"property float z\nelement face 1\n"
+			"property list uchar int vertex_indices\nend_header\n"
+			"1 2 255 3\n4 5 0 6\n3 0 1 1\n");
+	fclose(f);
+	InitVectorList(&list, 1);
+	if (LoadPointCloud(path, &list) != 2 || list.vectors[0].x != 2 ||
+			list.vectors[0].y != 1 || list.vectors[1].z != 6)
+	{
+		ok = 0;
+	}
+
+	// binary, native float fast path after a fixed size element
+	f = fopen(path, "wb");
+	fprintf(f, "ply\r\nformat binary_little_endian 1.0\r\n"
+			"element camera 1\r\nproperty short id\r\n"
+			"element vertex 5000\r\nproperty float x\r\nproperty float y\r\n"
+			"property float z\r\nproperty float intensity\r\nend_header\r\n");
+	fwrite(&s, sizeof(s), 1, f);
+	for (i = 0; i < 5000; i++)
+	{
+		v[0] = i;
+		v[1] = -i;
+		v[2] = i * 0.5f;
+		v[3] = 1;
+		fwrite(v, sizeof(float), 4, f);
+	}
+	fclose(f);
+	list.count = 0;
+	list.index = -1;
+	if (LoadPointCloud(path, &list) != 5000 || list.vectors[4999].x != 4999 ||
+			list.vectors[4999].y != -4999 || list.vectors[10].z != 5)
+	{
+		ok = 0;
+	}
+
+	// binary, big endian doubles
+	f = fopen(path, "wb");
+	fprintf(f, "ply\nformat binary_big_endian 1.0\nelement vertex 3\n"
+			"property double x\nproperty double y\nproperty double z\n"
+			"end_header\n");
+	for (i = 0; i < 9; i++)
+	{
+		d = i * 1.25;
+		for (k = 0; k < 8; k++)
+		{
+			swapped[k] = ((unsigned char *) &d)[IsBigEndianHost() ? k : 7 - k];
+		}
+		fwrite(swapped, 1, 8, f);
+	}
+	fclose(f);
+	list.count = 0;
+	list.index = -1;
+	if (LoadPointCloud(path, &list) != 3 || list.vectors[2].x != 7.5f ||
+			list.vectors[2].z != 10)
+	{
+		ok = 0;
+	}
+	remove(path);
+	FreeVectorList(&list);
+	return ok;
+}
+
+typedef struct _PoolTestJob
+{
+	int *hits;
+	ThreadPool *pool;
+	int nested;
+} PoolTestJob;
+
+void CountHits(unsigned int begin, unsigned int end, void *context)
+{
+	PoolTestJob *job = context;
+	unsigned int i;
+	for (i = begin; i < end; i++)
+	{
+		job->hits[i]++;
+	}
+}
+
+void CountHitsNested(unsigned int begin, unsigned int end, void *context)
+{
+	PoolTestJob *job = context;
+	PoolTestJob inner = *job;
+	// Runs serially on the calling worker
+	inner.hits = &job->hits[begin];
+	ParallelForPool(job->pool, end - begin, 1, CountHits, &inner);
+}
+
+int TestThreadPool()
+{
+	PoolTestJob job;
+	unsigned int i, n = 100000;
+	int round, result = 1;
+	job.hits = calloc(n, sizeof(int));
+	job.pool = CreateThreadPool(4);
+	if (job.pool == NULL || ThreadPoolSize(job.pool) < 1)
+	{
+		return 0;
+	}
+	for (round = 0; round < 50; round++)
+	{
+		ParallelForPool(job.pool, n - round, 1000 + round, CountHits, &job);
+	}
+	ParallelForPool(job.pool, n, 4096, CountHitsNested, &job);
+	for (i = 0; i < n; i++)
+	{
+		if (job.hits[i] != 51 - (i >= n - 49 ? (int) (i - (n - 50)) : 0))
+		{
+			result = 0;
+		}
+	}
+	DestroyThreadPool(job.pool);
+	free(job.hits);
+	return result;
+}
+
+int TestParallelVectorList()
+{
+	VectorList list, serial, parallel;
+	Vector3D vector, min, max, pmin, pmax;
+	Matrix3D matrix;
+	unsigned int i, n = 100000;
+	int threads, result = 1;
+	InitVectorList(&list, n);
+	InitVectorList(&serial, 1);
+	InitVectorList(&parallel, 1);
+	for (i = 0; i < n; i++)
+	{
+		SetVector(sinf(i) * 100, cosf(i * 0.3f) * 50, (i % 1000) - 500.0f,
+				1, &vector);
+		PushVector(vector, &list);
+	}
+	CreateRotationMatrixY(0.4, &matrix);
+	SetVector(5, -3, 2, 1, &matrix.W);
+
+	threads = GetThreadCount();
+	SetThreadCount(1);
+	TransformVectorList(&matrix, &list, &serial);
+	NormalizeVectorList(&serial);
+	ScaleVectorList(&serial, 3);
+	VectorListBounds(&list, &min, &max);
+	SetThreadCount(4);
+	TransformVectorList(&matrix, &list, &parallel);
+	NormalizeVectorList(&parallel);
+	ScaleVectorList(&parallel, 3);
+	VectorListBounds(&list, &pmin, &pmax);
+	SetThreadCount(threads);
+
+	// Bit identical to the serial run
+	if (parallel.count != n || memcmp(serial.vectors, parallel.vectors,
+				n * sizeof(Vector3D)) != 0)
+	{
+		result = 0;
+	}
+	if (memcmp(&min, &pmin, sizeof(Vector3D)) != 0 ||
+			memcmp(&max, &pmax, sizeof(Vector3D)) != 0 ||
+			min.z != -500 || max.z != 499 || fabsf(max.x - 100) > 1E-2)
+	{
+		result = 0;
+	}
+	if (fabsf(VectorLength(parallel.vectors[7]) - 3) > 1E-5)
+	{
+		result = 0;
+	}
+	FreeVectorList(&list);
+	FreeVectorList(&serial);
+	FreeVectorList(&parallel);
+	return result;
+}
+
+int TestComputeAABB()
+{
+	VectorList list;
+	Vector3D vector;
+	AABB box, expect;
+	unsigned int i, n = 50001;
+	int level, result = 1;
+	InitVectorList(&list, n);
+	for (i = 0; i < n; i++)
+	{
+		SetVector(sinf(i * 0.1f) * 10, (i % 333) * 0.5f - 3, cosf(i) - i * 1E-3f,
+				i % 5, &vector);
+		PushVector(vector, &list);
+	}
+	SetSIMDLevel(SIMD_SCALAR);
+	ComputeAABB(&list, &expect);
+	for (level = SIMD_SCALAR; level <= DetectSIMDLevel(); level++)
+	{
+		SetSIMDLevel(level);
+		// Odd sub ranges hit the remainder loops
+		for (i = 0; i < 3; i++)
+		{
+			list.count = n - i;
+			ComputeAABB(&list, &box);
+		}
+		list.count = n;
+		ComputeAABB(&list, &box);
+		if (memcmp(&box, &expect, sizeof(AABB)) != 0)
+		{
+			result = 0;
+		}
+	}
+	SetSIMDLevel(DetectSIMDLevel());
+	if (expect.min.y != -3 || expect.max.y != 163 || expect.min.w != 1 ||
+			expect.max.w != 1 || fabsf(expect.min.z + 51) > 0.1)
+	{
+		result = 0;
+	}
+	list.count = 0;
+	if (ComputeAABB(&list, &box) != 0)
+	{
+		result = 0;
+	}
+	FreeVectorList(&list);
+	return result;
+}
+
+int TestComputeBoundingSphere()
+{
+	VectorList list;
+	Vector3D vector;
+	BoundingSphere sphere;
+	unsigned int i;
+	int result = 1;
+	InitVectorList(&list, 1000);
+	// Points on a sphere of radius 4 around (1, 2, 3)
+	for (i = 0; i < 1000; i++)
+	{
+		SetVector(sinf(i * 0.7f) * cosf(i * 1.3f), sinf(i * 0.7f) * sinf(i * 1.3f),
+				cosf(i * 0.7f), 1, &vector);
+		ScaleVector(&vector, 4);
+		vector.x += 1;
+		vector.y += 2;
+		vector.z += 3;
+		PushVector(vector, &list);
+	}
+	ComputeBoundingSphere(&list, &sphere);
+	for (i = 0; i < list.count; i++)
+	{
+		if (VectorDistance(list.vectors[i], sphere.center) >
+				sphere.radius * (1 + 1E-5))
+		{
+			result = 0;
+		}
+	}
+	if (sphere.radius < 4 - 1E-3 || sphere.radius > 4 * 1.05)
+	{
+		result = 0;
+	}
+	FreeVectorList(&list);
+	return result;
+}
+
+int TestComputeOBB()
+{
+	VectorList list;
+	Vector3D vector, axis, rotated_x;
+	Matrix3D rotation;
+	OBB box;
+	unsigned int i;
+	int result = 1;
+	InitVectorList(&list, 1000);
+	SetVector(1, 2, 0.5, 0, &axis);
+	CreateRotationMatrix(axis, 0.8, &rotation);
+	SetVector(7, -1, 2, 1, &rotation.W);
+	// Grid filling a box of 10 x 4 x 1 around the origin, rotated and moved
+	for (i = 0; i < 110; i++)
+	{
+		SetVector((i % 11) - 5.0f, ((i / 11) % 5) - 2.0f, (i % 2) - 0.5f, 1,
+				&vector);
+		VectorTransform(&rotation, &vector);
+		PushVector(vector, &list);
+	}
+	ComputeOBB(&list, &box);
+	SetVector(1, 0, 0, 0, &rotated_x);
+	VectorTransform(&rotation, &rotated_x);
+	if (fabsf(fabsf(DotProduct(box.axis[0], rotated_x)) - 1) > 1E-4 ||
+			fabsf(box.extents.x - 5) > 1E-3 || fabsf(box.extents.y - 2) > 1E-3 ||
+			fabsf(box.extents.z - 0.5f) > 1E-3)
+	{
+		result = 0;
+	}
+	if (fabsf(box.center.x - 7) > 1E-3 || fabsf(box.center.y + 1) > 1E-3 ||
+			fabsf(box.center.z - 2) > 1E-3)
+	{
+		result = 0;
+	}
+	if (fabsf(DotProduct(box.axis[0], box.axis[1])) > 1E-5 ||
+			fabsf(VectorLength(box.axis[2]) - 1) > 1E-5)
+	{
+		result = 0;
+	}
+	FreeVectorList(&list);
+	return result;
+}
+
+// Brute force k nearest of query by (squared distance, index)
+unsigned int BruteNearest(VectorList *list, Vector3D query, unsigned int k,
+		unsigned int *indices, float *distances)
+{
+	unsigned int i, j, found = 0;
+	float d;
+	for (i = 0; i < list->count; i++)
+	{
+		d = VectorDistanceSquaredInline(&list->vectors[i], &query);
+		for (j = found; j > 0 && distances[j - 1] > d; j--)
+		{
+			if (j < k)
+			{
+				distances[j] = distances[j - 1];
+				indices[j] = indices[j - 1];
+			}
+		}
+		if (j < k)
+		{
+			distances[j] = d;
+			indices[j] = i;
+			found += found < k;
+		}
+	}
+	return found;
+}
+
+int TestKDTree()
+{
+	VectorList list;
+	KDTree tree, parallel;
+	Vector3D vector, query;
+	unsigned int i, j, k = 8, n = 20000, count;
+	unsigned int indices[8], expect[8], *radius, *batch;
+	float distances[8], expect_d[8], *batch_d;
+	Vector3D queries[100];
+	int threads, result = 1;
+	InitVectorList(&list, n);
+	srand(7);
+	for (i = 0; i < n; i++)
+	{
+		SetVector(rand() % 1000 * 0.1f, rand() % 1000 * 0.05f,
+				rand() % 100 * 0.3f, 1, &vector);
+		PushVector(vector, &list);
+	}
+	if (BuildKDTree(&list, &tree) != (int) n)
+	{
+		return 0;
+	}
+	radius = malloc(n * sizeof(unsigned int));
+	for (i = 0; i < 100; i++)
+	{
+		SetVector(rand() % 1200 * 0.1f - 10, rand() % 1000 * 0.05f,
+				rand() % 100 * 0.3f, 1, &query);
+		queries[i] = query;
+		if (KDTreeNearest(&tree, query, k, indices, distances) != k ||
+				BruteNearest(&list, query, k, expect, expect_d) != k)
+		{
+			result = 0;
+		}
+		for (j = 0; j < k; j++)
+		{
+			if (distances[j] != expect_d[j])
+			{
+				result = 0;
+			}
+		}
+		// Radius search finds exactly the points within the radius
+		count = KDTreeRadius(&tree, query, 3, radius, NULL, n);
+		for (j = 0; j < count; j++)
+		{
+			if (VectorDistance(list.vectors[radius[j]], query) > 3 + 1E-4)
+			{
+				result = 0;
+			}
+		}
+		for (j = 0; j < n; j++)
+		{
+			count -= VectorDistanceSquaredInline(&list.vectors[j], &query) <= 9;
+		}
+		if (count != 0)
+		{
+			result = 0;
+		}
+	}
+	// Batches match single queries, missing neighbours are marked
+	batch = malloc(100 * 20001 * sizeof(unsigned int));
+	batch_d = malloc(100 * 20001 * sizeof(float));
+	KDTreeNearestBatch(&tree, queries, 100, k, batch, batch_d);
+	for (i = 0; i < 100; i++)
+	{
+		KDTreeNearest(&tree, queries[i], k, indices, distances);
+		if (memcmp(indices, &batch[i * k], sizeof(indices)) != 0)
+		{
+			result = 0;
+		}
+	}
+	KDTreeNearestBatch(&tree, queries, 2, n + 1, batch, batch_d);
+	if (batch[n] != KDTREE_NONE || batch_d[n] != INFINITY ||
+			batch[n + 1] == KDTREE_NONE || batch_d[n - 1] < batch_d[n - 2])
+	{
+		result = 0;
+	}
+	// The tree does not depend on the thread count
+	threads = GetThreadCount();
+	SetThreadCount(4);
+	list.count = 0;
+	list.index = -1;
+	for (i = 0; i < 70000; i++)
+	{
+		SetVector(sinf(i) * 100, cosf(i * 0.7f) * 100, i * 0.01f, 1, &vector);
+		PushVector(vector, &list);
+	}
+	BuildKDTree(&list, &parallel);
+	SetThreadCount(1);
+	FreeKDTree(&tree);
+	BuildKDTree(&list, &tree);
+	SetThreadCount(threads);
+	if (tree.node_count != parallel.node_count ||
+			memcmp(tree.nodes, parallel.nodes,
+				tree.node_count * sizeof(KDNode)) != 0 ||
+			memcmp(tree.indices, parallel.indices,
+				tree.count * sizeof(unsigned int)) != 0)
+	{
+		result = 0;
+	}
+	FreeKDTree(&tree);
+	FreeKDTree(&parallel);
+	FreeVectorList(&list);
+	free(radius);
+	free(batch);
+	free(batch_d);
+	return result;
+}
+
+void CountPairs(unsigned int a, unsigned int b, float distance,
+		void *context)
+{
+	unsigned int *last = context;
+	(void) distance;
+	// Pairs arrive grouped by their first index, a < b
+	if (a < last[0] || a >= b)
+	{
+		last[1] = 0;
+	}
+	last[0] = a;
+}
+
+int TestSpatialHash()
+{
+	VectorList list;
+	SpatialHash hash, parallel;
+	Vector3D vector, query;
+	unsigned int i, j, n = 5000, count, pairs, order[2] = {0, 1};
+	unsigned int *indices;
+	int threads, result = 1;
+	InitVectorList(&list, n);
+	srand(11);
+	for (i = 0; i < n; i++)
+	{
+		SetVector(rand() % 1000 * 0.05f - 25, rand() % 1000 * 0.05f - 25,
+				rand() % 100 * 0.1f, 1, &vector);
+		PushVector(vector, &list);
+	}
+	InitSpatialHash(&hash, 1.5f, 0);
+	if (RebuildSpatialHash(&hash, &list) != (int) n)
+	{
+		return 0;
+	}
+	indices = malloc((n + 100) * sizeof(unsigned int));
+	for (i = 0; i < 100; i++)
+	{
+		SetVector(rand() % 1200 * 0.05f - 30, rand() % 1000 * 0.05f - 25,
+				rand() % 100 * 0.1f, 1, &query);
+		// Radius 10 covers more cells than a query visits one by one
+		count = SpatialHashRadius(&hash, query, i % 2 ? 1.5f : 10, indices, n);
+		for (j = 0; j < count; j++)
+		{
+			if (VectorDistanceSquaredInline(&list.vectors[indices[j]],
+						&query) > (i % 2 ? 2.25f : 100))
+			{
+				result = 0;
+			}
+		}
+		for (j = 0; j < n; j++)
+		{
+			count -= VectorDistanceSquaredInline(&list.vectors[j], &query) <=
+				(i % 2 ? 2.25f : 100);
+		}
+		if (count != 0)
+		{
+			result = 0;
+		}
+	}
+	// Inserted points are found before the next rebuild
+	for (i = 0; i < 100; i++)
+	{
+		SetVector(i * 0.5f - 25, 0, 5, 1, &vector);
+		PushVector(vector, &list);
+		if (InsertSpatialHash(&hash, n + i) != (int) (n + i + 1))
+		{
+			result = 0;
+		}
+	}
+	n += 100;
+	SetVector(0, 0, 5, 1, &query);
+	count = SpatialHashRadius(&hash, query, 1.5f, indices, n);
+	for (j = 0; j < n; j++)
+	{
+		count -= VectorDistanceSquaredInline(&list.vectors[j], &query) <=
+			2.25f;
+	}
+	if (count != 0)
+	{
+		result = 0;
+	}
+	pairs = 0;
+	for (i = 0; i < n; i++)
+	{
+		for (j = i + 1; j < n; j++)
+		{
+			pairs += VectorDistanceSquaredInline(&list.vectors[i],
+					&list.vectors[j]) <= 0.5f * 0.5f;
+		}
+	}
+	if (SpatialHashPairs(&hash, 0.5f, CountPairs, order) != pairs ||
+			order[1] != 1)
+	{
+		result = 0;
+	}
+	// The rebuild does not depend on the thread count
+	threads = GetThreadCount();
+	list.count = 0;
+	list.index = -1;
+	for (i = 0; i < 70000; i++)
+	{
+		SetVector(sinf(i) * 100, cosf(i * 0.7f) * 100, i * 0.01f, 1, &vector);
+		PushVector(vector, &list);
+	}
+	SetThreadCount(4);
+	InitSpatialHash(&parallel, 1.5f, 0);
+	RebuildSpatialHash(&parallel, &list);
+	SetThreadCount(1);
+	RebuildSpatialHash(&hash, &list);
+	SetThreadCount(threads);
+	if (hash.table_size != parallel.table_size ||
+			memcmp(hash.start, parallel.start,
+				(hash.table_size + 1) * sizeof(unsigned int)) != 0 ||
+			memcmp(hash.entries, parallel.entries,
+				hash.count * sizeof(unsigned int)) != 0)
+	{
+		result = 0;
+	}
+	FreeSpatialHash(&hash);
+	FreeSpatialHash(&parallel);
+	FreeVectorList(&list);
+	free(indices);
+	return result;
+}
+
+float RandomRange(float min, float max)
+{
+	return min + rand() / (float) RAND_MAX * (max - min);
+}
+
+void RandomBox(AABB *box)
+{
+	Vector3D c;
+	float e = rand() % 20 == 0 ? RandomRange(10, 80) : RandomRange(0, 4);
+	SetVector(RandomRange(-70, 70), RandomRange(-70, 70),
+			RandomRange(-70, 70), 1, &c);
+	SetVector(c.x - e, c.y - e * 0.5f, c.z - e * 0.25f, 1, &box->min);
+	SetVector(c.x + e, c.y + e * 0.5f, c.z + e * 0.25f, 1, &box->max);
+}
+
+int BoxOutsideFrustum(const AABB *box, const Frustum *f)
+{
+	float cx, cy, cz, ex, ey, ez;
+	int k;
+	cx = (box->min.x + box->max.x) * 0.5f;
+	cy = (box->min.y + box->max.y) * 0.5f;
+	cz = (box->min.z + box->max.z) * 0.5f;
+	ex = (box->max.x - box->min.x) * 0.5f;
+	ey = (box->max.y - box->min.y) * 0.5f;
+	ez = (box->max.z - box->min.z) * 0.5f;
+	for (k = 0; k < 6; k++)
+	{
+		if (f->planes[k].x * cx + f->planes[k].y * cy + f->planes[k].z * cz +
+				f->planes[k].w + fabsf(f->planes[k].x) * ex +
+				fabsf(f->planes[k].y) * ey + fabsf(f->planes[k].z) * ez < 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// Compare the three queries of the tree with brute force over boxes
+int CheckOctreeQueries(Octree *tree, AABB *boxes, unsigned char *live,
+		unsigned int n)
+{
+	AABB query;
+	Frustum frustum;
+	Vector3D center;
+	unsigned int *found, i, j, count, expect;
+	unsigned char *hit;
+	float dx, dy, dz, radius;
+	int q, result = 1;
+	found = malloc(n * sizeof(unsigned int));
+	hit = malloc(n);
+	for (q = 0; q < 60; q++)
+	{
+		RandomBox(&query);
+		SetVector(RandomRange(-60, 60), RandomRange(-60, 60),
+				RandomRange(-60, 60), 1, &center);
+		radius = RandomRange(0, 30);
+		// Axis aligned slab cut by a tilted plane
+		memset(&frustum, 0, sizeof(Frustum));
+		SetVector(1, 0, 0, 40 - q, &frustum.planes[0]);
+		SetVector(-1, 0, 0, 10 + q, &frustum.planes[1]);
+		SetVector(0, 1, 0, 30, &frustum.planes[2]);
+		SetVector(0, -1, 0, 30, &frustum.planes[3]);
+		SetVector(0, 0.6f, 0.8f, 20, &frustum.planes[4]);
+		SetVector(0, 0, -1, 50, &frustum.planes[5]);
+		if (q % 3 == 0)
+		{
+			count = OctreeQueryAABB(tree, query, found, n);
+		}
+		else if (q % 3 == 1)
+		{
+			count = OctreeQuerySphere(tree, center, radius, found, n);
+		}
+		else
+		{
+			count = OctreeQueryFrustum(tree, &frustum, found, n);
+		}
+		memset(hit, 0, n);
+		for (i = 0; i < count; i++)
+		{
+			if (found[i] >= n || !live[found[i]] || hit[found[i]])
+			{
+				result = 0;
+			}
+			else
+			{
+				hit[found[i]] = 1;
+			}
+		}
+		expect = 0;
+		for (j = 0; j < n; j++)
+		{
+			if (!live[j])
+			{
+				continue;
+			}
+			if (q % 3 == 0)
+			{
+				i = !(boxes[j].min.x > query.max.x ||
+						boxes[j].max.x < query.min.x ||
+						boxes[j].min.y > query.max.y ||
+						boxes[j].max.y < query.min.y ||
+						boxes[j].min.z > query.max.z ||
+						boxes[j].max.z < query.min.z);
+			}
+			else if (q % 3 == 1)
+			{
+				dx = fmaxf(fmaxf(boxes[j].min.x - center.x, 0),
+						center.x - boxes[j].max.x);
+				dy = fmaxf(fmaxf(boxes[j].min.y - center.y, 0),
+						center.y - boxes[j].max.y);
+				dz = fmaxf(fmaxf(boxes[j].min.z - center.z, 0),
+						center.z - boxes[j].max.z);
+				i = dx * dx + dy * dy + dz * dz <= radius * radius;
+			}
+			else
+			{
+				i = !BoxOutsideFrustum(&boxes[j], &frustum);
+			}
+			if (i != (unsigned int) hit[j])
+			{
+				result = 0;
+			}
+			expect += i;
+		}
+		if (count != expect)
+		{
+			result = 0;
+		}
+	}
+	free(found);
+	free(hit);
+	return result;
+}
+
+int TestOctree()
+{
+	Octree tree;
+	Vector3D center;
+	VectorList list;
+	AABB *boxes, box;
+	unsigned char *live;
+	unsigned int i, n = 3000, handle, count;
+	unsigned int handles[100], found[64];
+	float d;
+	unsigned int round;
+	int result = 1;
+	boxes = malloc(n * sizeof(AABB));
+	live = calloc(n, 1);
+	SetVector(0, 0, 0, 1, &center);
+	if (!InitOctree(&tree, center, 64, 8))
+	{
+		return 0;
+	}
+	srand(19);
+	for (i = 0; i < 2000; i++)
+	{
+		RandomBox(&boxes[i]);
+		if (InsertOctree(&tree, boxes[i]) != i)
+		{
+			result = 0;
+		}
+		live[i] = 1;
+	}
+	result &= CheckOctreeQueries(&tree, boxes, live, n);
+	// Small moves mostly stay in their node, teleports relink
+	for (round = 0; round < 3; round++)
+	{
+		for (i = 0; i < 2000; i++)
+		{
+			if (i % 4 == round)
+			{
+				RandomBox(&boxes[i]);
+			}
+			else
+			{
+				d = RandomRange(-1, 1);
+				boxes[i].min.x += d;
+				boxes[i].max.x += d;
+				boxes[i].min.z -= d;
+				boxes[i].max.z -= d;
+			}
+			if (!MoveOctree(&tree, i, boxes[i]))
+			{
+				result = 0;
+			}
+		}
+		result &= CheckOctreeQueries(&tree, boxes, live, n);
+	}
+	// Removed handles are reused
+	for (i = 0; i < 2000; i += 3)
+	{
+		result &= RemoveOctree(&tree, i);
+		live[i] = 0;
+	}
+	if (RemoveOctree(&tree, 0) || MoveOctree(&tree, 3, boxes[3]) ||
+			tree.count != 1333)
+	{
+		result = 0;
+	}
+	for (i = 0; i < 700; i++)
+	{
+		RandomBox(&box);
+		handle = InsertOctree(&tree, box);
+		if (handle >= n || live[handle])
+		{
+			result = 0;
+			break;
+		}
+		boxes[handle] = box;
+		live[handle] = 1;
+	}
+	result &= CheckOctreeQueries(&tree, boxes, live, n);
+	// Points of a list are boxes around the vectors
+	InitVectorList(&list, 100);
+	for (i = 0; i < 100; i++)
+	{
+		SetVector(i - 50.0f, 0, 0, 1, &center);
+		PushVector(center, &list);
+	}
+	if (InsertOctreeList(&tree, &list, 0.25f, handles) != 100)
+	{
+		result = 0;
+	}
+	count = OctreeQuerySphere(&tree, center, 0.1f, found, 64);
+	for (i = 0; i < count && i < 64 && found[i] != handles[99]; i++)
+	{
+	}
+	if (i == count || i == 64 || tree.objects[handles[99]].box.max.x != 49.25f)
+	{
+		result = 0;
+	}
+	FreeVectorList(&list);
+	// Empty nodes go back to the pool
+	for (i = 0; i < tree.object_used; i++)
+	{
+		RemoveOctree(&tree, i);
+	}
+	if (tree.count != 0 || tree.node_count != 1)
+	{
+		result = 0;
+	}
+	FreeOctree(&tree);
+	free(boxes);
+	free(live);
+	return result;
+}
+
+// Perspective projection for row vectors, fov 90 degrees, aspect 1.5,
+// looking down -z. zero_to_one selects the clip depth range.
+void TestProjection(float n, float f, int zero_to_one, Matrix3D *m)
+{
+	EmptyMatrix(m);
+	m->X.x = 1 / 1.5f;
+	m->Y.y = 1;
+	m->Z.w = -1;
+	if (zero_to_one)
+	{
+		m->Z.z = f / (n - f);
+		m->W.z = f * n / (n - f);
+	}
+	else
+	{
+		m->Z.z = (f + n) / (n - f);
+		m->W.z = 2 * f * n / (n - f);
+	}
+}
+
+// Camera at (2, 1, 8) turned 30 degrees around y
+void TestViewProjection(int zero_to_one, Matrix3D *m)
+{
+	Matrix3D view, projection;
+	CreateRotationMatrixY(degtorad(-30), &view);
+	SetVector(0, 0, 0, 1, &view.W);
+	TransposeMatrix(&view);
+	SetVector(-2, -1, -8, 1, &view.W);
+	VectorTransform(&view, &view.W);
+	TestProjection(0.5f, 40, zero_to_one, &projection);
+	MultiplyMatrix(&view, &projection, m);
+}
+
+int TestExtractFrustum()
+{
+	Matrix3D m;
+	Frustum frustum;
+	BoundingSphere sphere;
+	Vector3D clip;
+	float margin;
+	int i, range, inside, result = 1;
+	srand(20);
+	for (range = FRUSTUM_DEPTH_NEGATIVE_ONE; range <= FRUSTUM_DEPTH_ZERO_ONE;
+			range++)
+	{
+		TestViewProjection(range, &m);
+		ExtractFrustum(&m, range, &frustum);
+		for (i = 0; i < 6; i++)
+		{
+			if (fabs(VectorLength(frustum.planes[i]) - 1) > 1E-5)
+			{
+				result = 0;
+			}
+		}
+		// The planes agree with the clip space test of the matrix
+		sphere.radius = 0;
+		for (i = 0; i < 20000; i++)
+		{
+			SetVector(rand() % 1000 * 0.1f - 50, rand() % 1000 * 0.1f - 50,
+					rand() % 1000 * 0.1f - 50, 1, &sphere.center);
+			clip = sphere.center;
+			VectorTransform(&m, &clip);
+			margin = fminf(clip.w - fabsf(clip.x), clip.w - fabsf(clip.y));
+			margin = fminf(margin, clip.w - clip.z);
+			margin = fminf(margin, range == FRUSTUM_DEPTH_ZERO_ONE ? clip.z :
+					clip.w + clip.z);
+			if (fabsf(margin) < 1E-3f * fabsf(clip.w) + 1E-4f)
+			{
+				continue;
+			}
+			inside = margin > 0 && clip.w > 0;
+			if (SphereInFrustum(&frustum, &sphere) != inside)
+			{
+				result = 0;
+			}
+		}
+		// A sphere reaching into the frustum is kept
+		SetVector(2, 1, 8 - 0.25f, 1, &sphere.center);
+		sphere.radius = 0.3f;
+		if (!SphereInFrustum(&frustum, &sphere))
+		{
+			result = 0;
+		}
+	}
+	return result;
+}
+
+int TestCullFrustum()
+{
+	Matrix3D m;
+	Frustum frustum;
+	VectorListSoA min, max, spheres;
+	AABB box;
+	BoundingSphere sphere;
+	Vector3D vector, extent;
+	unsigned int i, n = 70013, count, expect, *mask, *mask2, *indices;
+	int level, threads, visible, result = 1;
+	TestViewProjection(0, &m);
+	ExtractFrustum(&m, FRUSTUM_DEPTH_NEGATIVE_ONE, &frustum);
+	InitVectorListSoA(&min, n, 0);
+	InitVectorListSoA(&max, n, 0);
+	InitVectorListSoA(&spheres, n, 1);
+	srand(21);
+	for (i = 0; i < n; i++)
+	{
+		SetVector(rand() % 1000 * 0.1f - 50, rand() % 1000 * 0.1f - 50,
+				rand() % 1000 * 0.1f - 50, 1, &vector);
+		SetVector(rand() % 100 * 0.05f, rand() % 100 * 0.05f,
+				rand() % 100 * 0.05f, 0, &extent);
+		SubVector(vector, extent, &box.min);
+		AddVector(vector, extent, &box.max);
+		PushVectorSoA(box.min, &min);
+		PushVectorSoA(box.max, &max);
+		vector.w = extent.x;
+		PushVectorSoA(vector, &spheres);
+	}
+	mask = malloc((n + 31) / 32 * sizeof(unsigned int));
+	mask2 = malloc((n + 31) / 32 * sizeof(unsigned int));
+	indices = malloc(n * sizeof(unsigned int));
+	// Every kernel matches the scalar tests, tails included
+	for (level = SIMD_SCALAR; level <= DetectSIMDLevel(); level++)
+	{
+		SetSIMDLevel(level);
+		min.count = max.count = spheres.count = level % 2 ? n : 1013;
+		count = CullAABBs(&frustum, &min, &max, mask, indices);
+		expect = 0;
+		for (i = 0; i < min.count; i++)
+		{
+			GetVectorSoA(&min, i, &box.min);
+			GetVectorSoA(&max, i, &box.max);
+			visible = AABBInFrustum(&frustum, &box);
+			if (visible != (int) ((mask[i / 32] >> (i % 32)) & 1) ||
+					(visible && (expect >= count || indices[expect] != i)))
+			{
+				result = 0;
+			}
+			expect += visible;
+		}
+		if (count != expect || expect == 0 || expect == min.count ||
+				CullAABBs(&frustum, &min, &max, NULL, NULL) != count)
+		{
+			result = 0;
+		}
+		count = CullSpheres(&frustum, &spheres, mask, indices);
+		expect = 0;
+		for (i = 0; i < spheres.count; i++)
+		{
+			GetVectorSoA(&spheres, i, &sphere.center);
+			sphere.radius = sphere.center.w;
+			visible = SphereInFrustum(&frustum, &sphere);
+			if (visible != (int) ((mask[i / 32] >> (i % 32)) & 1) ||
+					(visible && (expect >= count || indices[expect] != i)))
+			{
+				result = 0;
+			}
+			expect += visible;
+		}
+		if (count != expect || expect == 0)
+		{
+			result = 0;
+		}
+	}
+	SetSIMDLevel(DetectSIMDLevel());
+	// The mask does not depend on the thread count
+	min.count = max.count = n;
+	threads = GetThreadCount();
+	SetThreadCount(4);
+	CullAABBs(&frustum, &min, &max, mask, NULL);
+	SetThreadCount(1);
+	CullAABBs(&frustum, &min, &max, mask2, NULL);
+	SetThreadCount(threads);
+	if (memcmp(mask, mask2, (n + 31) / 32 * sizeof(unsigned int)) != 0)
+	{
+		result = 0;
+	}
+	FreeVectorListSoA(&min);
+	FreeVectorListSoA(&max);
+	FreeVectorListSoA(&spheres);
+	free(mask);
+	free(mask2);
+	free(indices);
+	return result;
+}
+
+// Depth of view space point (0, 0, z) after the projection and the divide
+float ProjectedDepth(Matrix3D *m, float z)
+{
+	Vector3D v;
+	SetVector(0.1f, -0.2f, z, 1, &v);
+	VectorTransform(m, &v);
+	return v.z / v.w;
+}
+
+int TestProjectionMatrix()
+{
+	Matrix3D m;
+	Vector3D v;
+	int result = 1;
+	CreatePerspectiveMatrix(degtorad(90), 2, 0.5f, 100, &m);
+	result &= fabsf(ProjectedDepth(&m, -0.5f) + 1) < 1E-5;
+	result &= fabsf(ProjectedDepth(&m, -100) - 1) < 1E-5;
+	// 45 degrees up from the axis is the top edge
+	SetVector(0, 3, -3, 1, &v);
+	VectorTransform(&m, &v);
+	result &= fabsf(v.y / v.w - 1) < 1E-5 && fabsf(m.X.x - 0.5f) < 1E-6;
+	CreateInfinitePerspectiveMatrix(degtorad(90), 2, 0.5f, &m);
+	result &= fabsf(ProjectedDepth(&m, -0.5f) + 1) < 1E-5;
+	result &= ProjectedDepth(&m, -1E6) < 1 && ProjectedDepth(&m, -1E6) > 0.999f;
+	CreateReversedZPerspectiveMatrix(degtorad(90), 2, 0.5f, 100, &m);
+	result &= fabsf(ProjectedDepth(&m, -0.5f) - 1) < 1E-5;
+	result &= fabsf(ProjectedDepth(&m, -100)) < 1E-5;
+	CreateReversedZPerspectiveMatrix(degtorad(90), 2, 0.5f, INFINITY, &m);
+	result &= fabsf(ProjectedDepth(&m, -0.5f) - 1) < 1E-5;
+	result &= ProjectedDepth(&m, -1E6) > 0 && ProjectedDepth(&m, -1E6) < 1E-6;
+	CreateOrthographicMatrix(-4, 2, -1, 3, 1, 11, &m);
+	SetVector(-4, 3, -1, 1, &v);
+	VectorTransform(&m, &v);
+	result &= fabsf(v.x + 1) < 1E-6 && fabsf(v.y - 1) < 1E-6 &&
+		fabsf(v.z + 1) < 1E-6 && v.w == 1;
+	result &= fabsf(ProjectedDepth(&m, -11) - 1) < 1E-6;
+	CreateReversedZOrthographicMatrix(-4, 2, -1, 3, 1, 11, &m);
+	result &= fabsf(ProjectedDepth(&m, -1) - 1) < 1E-6;
+	result &= fabsf(ProjectedDepth(&m, -11)) < 1E-6;
+	return result;
+}
+
+int TestCamera()
+{
+	Camera camera;
+	Matrix3D view, projection, m, identity;
+	Frustum frustum;
+	BoundingSphere sphere;
+	Vector3D eye, target, up, origin, direction;
+	int i, result = 1;
+	SetVector(3, 4, 5, 1, &eye);
+	SetVector(-1, 0, 2, 1, &target);
+	SetVector(0, 1, 0, 0, &up);
+	InitCamera(&camera);
+	SetCameraLookAt(&camera, eye, target, up);
+	SetCameraPerspective(&camera, degtorad(70), 1.5f, 0.1f, 50, 0);
+	LookAtMatrix(eye, target, up, &view);
+	CreatePerspectiveMatrix(degtorad(70), 1.5f, 0.1f, 50, &projection);
+	MultiplyMatrix(&view, &projection, &m);
+	if (!MatrixClose((Matrix3D *) CameraViewProjection(&camera), &m) ||
+			camera.dirty != (CAMERA_INVERSE_VIEW | CAMERA_INVERSE_PROJECTION |
+				CAMERA_INVERSE_VIEW_PROJECTION))
+	{
+		result = 0;
+	}
+	// Resizing keeps the view and its inverse
+	CameraInverseViewProjection(&camera);
+	SetCameraAspect(&camera, 2);
+	if (camera.dirty != (CAMERA_PROJECTION | CAMERA_VIEW_PROJECTION |
+				CAMERA_INVERSE_PROJECTION | CAMERA_INVERSE_VIEW_PROJECTION))
+	{
+		result = 0;
+	}
+	// Every mode inverts back to the identity
+	HomogeneousMatrix(&identity);
+	for (i = 0; i < 5; i++)
+	{
+		if (i < 4)
+		{
+			SetCameraPerspective(&camera, degtorad(70), 2, 0.1f,
+					i % 2 ? INFINITY : 50, i / 2);
+		}
+		else
+		{
+			SetCameraOrthographic(&camera, 10, 2, 0.1f, 50, 1);
+		}
+		MultiplyMatrix((Matrix3D *) CameraViewProjection(&camera),
+				(Matrix3D *) CameraInverseViewProjection(&camera), &m);
+		if (!MatrixClose(&m, &identity) || camera.dirty != 0)
+		{
+			result = 0;
+		}
+		CameraFrustum(&camera, &frustum);
+		sphere.center = target;
+		sphere.radius = 0;
+		result &= SphereInFrustum(&frustum, &sphere);
+		SubVector(eye, target, &sphere.center);
+		AddVector(eye, sphere.center, &sphere.center);
+		result &= !SphereInFrustum(&frustum, &sphere);
+		// The center of the viewport looks at the target
+		CameraRay(&camera, 0, 0, &origin, &direction);
+		SubVector(target, eye, &up);
+		NormalizeVector(&up);
+		if (VectorDistance(direction, up) > 1E-4 || direction.w != 0 ||
+				fabs(VectorDistance(origin, eye) - 0.1) > 1E-3)
+		{
+			result = 0;
+		}
+	}
+	// A view matrix set directly is not replaced by the look at
+	SetCameraView(&camera, &view);
+	if (!MatrixEquals((Matrix3D *) CameraView(&camera), &view))
+	{
+		result = 0;
+	}
+	return result;
+}
+
+// World matrix of input node i by walking up to its root
+void BruteWorld(const unsigned int *parents, const Matrix3D *locals,
+		unsigned int i, Matrix3D *world)
+{
+	*world = locals[i];
+	for (i = parents[i]; i != TRANSFORM_NONE; i = parents[i])
+	{
+		MultiplyMatrix(world, (Matrix3D *) &locals[i], world);
+	}
+}
+
+int TestTransformHierarchy()
+{
+	TransformHierarchy h, parallel;
+	Matrix3D *locals, world, m;
+	Vector3D axis;
+	unsigned int *parents, *order, *shuffle, *moved;
+	unsigned int i, j, k, n = 70000, expect, bad[2] = {1, 0};
+	int threads, result = 1;
+	parents = malloc(n * sizeof(unsigned int));
+	order = malloc(n * sizeof(unsigned int));
+	shuffle = malloc(n * sizeof(unsigned int));
+	moved = calloc(n, sizeof(unsigned int));
+	locals = malloc(n * sizeof(Matrix3D));
+	// Wide random tree, node i of the tree is input shuffle[i]
+	srand(22);
+	for (i = 0; i < n; i++)
+	{
+		shuffle[i] = i;
+	}
+	for (i = n - 1; i > 0; i--)
+	{
+		j = rand() % (i + 1);
+		k = shuffle[i];
+		shuffle[i] = shuffle[j];
+		shuffle[j] = k;
+	}
+	for (i = 0; i < n; i++)
+	{
+		parents[shuffle[i]] = i < 3 ? TRANSFORM_NONE :
+			shuffle[rand() % (i / 4 + 1)];
+		SetVector(rand() % 10 + 1, rand() % 10, rand() % 10, 0, &axis);
+		CreateRotationMatrix(axis, (rand() % 100) * 0.01f, &locals[i]);
+		SetVector(rand() % 10 * 0.1f, 1, 0, 1, &locals[i].W);
+	}
+	if (BuildTransformHierarchy(&h, parents, locals, n, order) != (int) n ||
+			UpdateTransforms(&h) != n || UpdateTransforms(&h) != 0)
+	{
+		result = 0;
+	}
+	for (i = 0; i < n; i++)
+	{
+		if (h.parent[i] != TRANSFORM_NONE && h.parent[i] >= i)
+		{
+			result = 0;
+		}
+	}
+	for (i = 0; i < n; i += 97)
+	{
+		BruteWorld(parents, locals, order[i], &world);
+		if (!MatrixClose(&world, &h.world[i]))
+		{
+			result = 0;
+		}
+	}
+	// Only the subtrees of the changed nodes are recomputed
+	for (k = 0; k < 5; k++)
+	{
+		i = rand() % n;
+		CreateRotationMatrixZ(k * 0.3f, &m);
+		SetLocalTransform(&h, i, &m);
+		locals[order[i]] = m;
+		moved[i] = 1;
+	}
+	expect = 0;
+	for (i = 0; i < n; i++)
+	{
+		if (h.parent[i] != TRANSFORM_NONE && moved[h.parent[i]])
+		{
+			moved[i] = 1;
+		}
+		expect += moved[i];
+	}
+	if (UpdateTransforms(&h) != expect || expect == 0)
+	{
+		result = 0;
+	}
+	for (i = 0; i < n; i++)
+	{
+		BruteWorld(parents, locals, order[i], &world);
+		if (moved[i] && !MatrixClose(&world, &h.world[i]))
+		{
+			result = 0;
+		}
+	}
+	// Levels split across threads give the same matrices
+	threads = GetThreadCount();
+	SetThreadCount(4);
+	BuildTransformHierarchy(&parallel, parents, locals, n, NULL);
+	UpdateTransforms(&parallel);
+	SetThreadCount(threads);
+	for (i = 0; i < n; i++)
+	{
+		MarkTransformDirty(&h, i);
+	}
+	UpdateTransforms(&h);
+	if (memcmp(h.world, parallel.world, n * sizeof(Matrix3D)) != 0)
+	{
+		result = 0;
+	}
+	// Cycles and parents out of range are rejected
+	FreeTransformHierarchy(&parallel);
+	if (BuildTransformHierarchy(&parallel, bad, locals, 2, NULL) != 0)
+	{
+		result = 0;
+	}
+	bad[0] = 2;
+	bad[1] = TRANSFORM_NONE;
+	if (BuildTransformHierarchy(&parallel, bad, locals, 2, NULL) != 0)
+	{
+		result = 0;
+	}
+	FreeTransformHierarchy(&h);
+	free(parents);
+	free(order);
+	free(shuffle);
+	free(moved);
+	free(locals);
+	return result;
+}
+
+int TestIntersectRayTriangle()
+{
+	Ray ray;
+	Vector3D origin, direction, v0, v1, v2;
+	float t, u, v;
+	int result = 1;
+	SetVector(0, 0, 0, 1, &v0);
+	SetVector(1, 0, 0, 1, &v1);
+	SetVector(0, 1, 0, 1, &v2);
+	SetVector(0.2f, 0.3f, 2, 1, &origin);
+	SetVector(0, 0, -2, 0, &direction);
+	SetRay(origin, direction, &ray);
+	if (!IntersectRayTriangle(&ray, v0, v1, v2, &t, &u, &v) ||
+			fabsf(t - 1) > PRECISION || fabsf(u - 0.2f) > PRECISION ||
+			fabsf(v - 0.3f) > PRECISION)
+	{
+		result = 0;
+	}
+	// The back side is hit too, the hit must be within t_max
+	SetVector(0.2f, 0.3f, -2, 1, &ray.origin);
+	SetVector(0, 0, 1, 0, &ray.direction);
+	result &= IntersectRayTriangle(&ray, v0, v1, v2, &t, &u, &v);
+	ray.t_max = 1.5f;
+	result &= !IntersectRayTriangle(&ray, v0, v1, v2, &t, &u, &v);
+	// Behind the origin, outside of the edges and parallel rays miss
+	SetRay(origin, direction, &ray);
+	ray.direction.z = 2;
+	result &= !IntersectRayTriangle(&ray, v0, v1, v2, &t, &u, &v);
+	ray.direction.z = -2;
+	ray.origin.x = 0.8f;
+	result &= !IntersectRayTriangle(&ray, v0, v1, v2, &t, &u, &v);
+	SetVector(1, 0, 0, 0, &ray.direction);
+	ray.origin.z = 0;
+	result &= !IntersectRayTriangle(&ray, v0, v1, v2, &t, &u, &v);
+	return result;
+}
+
+int TestIntersectRays()
+{
+	Ray *rays;
+	RayHit *hits, *threaded;
+	RayPacket packet;
+	Vector3D *vertices, v;
+	unsigned int i, j, n = 403, triangles = 300, count, expect_count;
+	unsigned int *indices, expect;
+	float t, u, w, best_t, best_u, best_w;
+	int level, threads, result = 1;
+	rays = malloc(n * sizeof(Ray));
+	hits = malloc(n * sizeof(RayHit));
+	threaded = malloc(n * sizeof(RayHit));
+	vertices = malloc(3 * triangles * sizeof(Vector3D));
+	indices = malloc(3 * triangles * sizeof(unsigned int));
+	srand(23);
+	for (i = 0; i < 3 * triangles; i++)
+	{
+		if (i % 3 == 0)
+		{
+			SetVector(rand() % 200 * 0.1f - 10, rand() % 200 * 0.1f - 10,
+					rand() % 200 * 0.1f - 10, 1, &v);
+		}
+		SetVector(v.x + rand() % 40 * 0.1f - 2, v.y + rand() % 40 * 0.1f - 2,
+				v.z + rand() % 40 * 0.1f - 2, 1, &vertices[i]);
+		indices[i] = 3 * triangles - 1 - i;
+	}
+	for (i = 0; i < n; i++)
+	{
+		SetVector(rand() % 100 * 0.1f - 5, rand() % 100 * 0.1f - 5, -20, 1,
+				&rays[i].origin);
+		SetVector(rand() % 100 * 0.01f - 0.5f, rand() % 100 * 0.01f - 0.5f, 1,
+				0, &rays[i].direction);
+		rays[i].t_max = i % 5 == 0 ? 25 : INFINITY;
+	}
+	for (level = SIMD_SCALAR; level <= DetectSIMDLevel(); level++)
+	{
+		SetSIMDLevel(level);
+		count = IntersectRays(rays, n, vertices, indices, triangles, hits);
+		expect_count = 0;
+		for (i = 0; i < n; i++)
+		{
+			expect = RAY_NO_HIT;
+			best_t = rays[i].t_max;
+			best_u = best_w = 0;
+			for (j = 0; j < triangles; j++)
+			{
+				if (IntersectRayTriangle(&rays[i], vertices[indices[3 * j]],
+							vertices[indices[3 * j + 1]],
+							vertices[indices[3 * j + 2]], &t, &u, &w) && t < best_t)
+				{
+					best_t = t;
+					best_u = u;
+					best_w = w;
+					expect = j;
+				}
+			}
+			if (hits[i].triangle != expect || hits[i].t != best_t ||
+					hits[i].u != best_u || hits[i].v != best_w)
+			{
+				result = 0;
+			}
+			expect_count += expect != RAY_NO_HIT;
+		}
+		if (count != expect_count || count == 0 || count == n)
+		{
+			result = 0;
+		}
+		// A packet fed triangle by triangle finds the same hits
+		LoadRayPacket(rays + 8, 5, &packet);
+		for (j = 0; j < triangles; j++)
+		{
+			IntersectRayPacketTriangle(&packet, vertices[indices[3 * j]],
+					vertices[indices[3 * j + 1]], vertices[indices[3 * j + 2]], j);
+		}
+		StoreRayPacket(&packet, threaded);
+		if (memcmp(threaded, hits + 8, 5 * sizeof(RayHit)) != 0 ||
+				packet.triangle[5] != RAY_NO_HIT)
+		{
+			result = 0;
+		}
+	}
+	SetSIMDLevel(DetectSIMDLevel());
+	threads = GetThreadCount();
+	SetThreadCount(4);
+	IntersectRays(rays, n, vertices, NULL, triangles, threaded);
+	SetThreadCount(1);
+	IntersectRays(rays, n, vertices, NULL, triangles, hits);
+	SetThreadCount(threads);
+	if (memcmp(threaded, hits, n * sizeof(RayHit)) != 0)
+	{
+		result = 0;
+	}
+	free(rays);
+	free(hits);
+	free(threaded);
+	free(vertices);
+	free(indices);
+	return result;
+}
+
+// Closest and any hits of the BVH against the brute force IntersectRays
+int CheckBVHHits(BVH *bvh, const Ray *rays, unsigned int n,
+		const unsigned int *indices, unsigned int triangles)
+{
+	RayHit *hits, *expect;
+	unsigned int i, count;
+	int result = 1;
+	hits = malloc(n * sizeof(RayHit));
+	expect = malloc(n * sizeof(RayHit));
+	count = IntersectRays(rays, n, bvh->vertices->vectors, indices,
+			triangles, expect);
+	if (BVHClosestHitBatch(bvh, rays, n, hits) != count || count == 0 ||
+			count == n)
+	{
+		result = 0;
+	}
+	for (i = 0; i < n; i++)
+	{
+		// Exact ties may pick another triangle, the distance is the same
+		if (hits[i].t != expect[i].t ||
+				(hits[i].triangle == RAY_NO_HIT) !=
+				(expect[i].triangle == RAY_NO_HIT) ||
+				BVHAnyHit(bvh, &rays[i]) != (expect[i].triangle != RAY_NO_HIT))
+		{
+			result = 0;
+		}
+	}
+	free(hits);
+	free(expect);
+	return result;
+}
+
+int TestBVH()
+{
+	VectorList list;
+	BVH bvh, serial;
+	BVHNode *nodes;
+	Ray *rays;
+	RayHit hit;
+	Vector3D *vertices, v;
+	unsigned int i, j, k, n = 500, triangles = 20000, first;
+	unsigned int *indices, *seen;
+	float *min, *max;
+	int threads, result = 1;
+	rays = malloc(n * sizeof(Ray));
+	vertices = malloc(3 * triangles * sizeof(Vector3D));
+	indices = malloc(3 * triangles * sizeof(unsigned int));
+	seen = calloc(triangles, sizeof(unsigned int));
+	srand(24);
+	for (i = 0; i < 3 * triangles; i++)
+	{
+		// The last triangles share one centroid, no SAH split separates them
+		if (i % 3 == 0 && i < 3 * (triangles - 100))
+		{
+			SetVector(rand() % 2000 * 0.01f - 10, rand() % 2000 * 0.01f - 10,
+					rand() % 2000 * 0.01f - 10, 1, &v);
+		}
+		SetVector(v.x + rand() % 40 * 0.01f - 0.2f,
+				v.y + rand() % 40 * 0.01f - 0.2f,
+				v.z + rand() % 40 * 0.01f - 0.2f, 1, &vertices[i]);
+		if (i >= 3 * (triangles - 100))
+		{
+			vertices[i] = vertices[3 * (triangles - 100) + i % 3];
+		}
+		indices[i] = 3 * triangles - 1 - i;
+	}
+	for (i = 0; i < n; i++)
+	{
+		SetVector(rand() % 100 * 0.1f - 5, rand() % 100 * 0.1f - 5, -20, 1,
+				&rays[i].origin);
+		SetVector(rand() % 100 * 0.01f - 0.5f, rand() % 100 * 0.01f - 0.5f, 1,
+				0, &rays[i].direction);
+		rays[i].t_max = i % 5 == 0 ? 22 : INFINITY;
+	}
+	InitVectorList(&list, 3 * triangles);
+	PushVectors(vertices, 3 * triangles, &list);
+
+	threads = GetThreadCount();
+	SetThreadCount(4);
+	if (BuildBVH(&list, indices, triangles, &bvh) != (int) triangles)
+	{
+		result = 0;
+	}
+	SetThreadCount(1);
+	BuildBVH(&list, indices, triangles, &serial);
+	SetThreadCount(threads);
+	if (bvh.node_count != serial.node_count || bvh.node_count == 0 ||
+			memcmp(bvh.nodes, serial.nodes,
+				bvh.node_count * sizeof(BVHNode)) != 0 ||
+			memcmp(bvh.triangles, serial.triangles,
+				triangles * sizeof(unsigned int)) != 0)
+	{
+		result = 0;
+	}
+	FreeBVH(&serial);
+
+	// Leaves hold every triangle once and children fit in their parent
+	for (i = 0; i < bvh.node_count; i++)
+	{
+		if (bvh.nodes[i].count > BVH_LEAF_SIZE)
+		{
+			result = 0;
+		}
+		if (bvh.nodes[i].count > 0)
+		{
+			for (j = 0; j < bvh.nodes[i].count; j++)
+			{
+				first = bvh.triangles[bvh.nodes[i].first + j];
+				seen[first]++;
+				for (k = 0; k < 3; k++)
+				{
+					v = vertices[indices[3 * first + k]];
+					if (v.x < bvh.nodes[i].min[0] || v.x > bvh.nodes[i].max[0] ||
+							v.y < bvh.nodes[i].min[1] || v.y > bvh.nodes[i].max[1] ||
+							v.z < bvh.nodes[i].min[2] || v.z > bvh.nodes[i].max[2])
+					{
+						result = 0;
+					}
+				}
+			}
+			continue;
+		}
+		if (bvh.nodes[i].first <= i + 1 || bvh.nodes[i].first >= bvh.node_count)
+		{
+			result = 0;
+			break;
+		}
+		min = bvh.nodes[i].min;
+		max = bvh.nodes[i].max;
+		for (k = 0; k < 3; k++)
+		{
+			if (bvh.nodes[i + 1].min[k] < min[k] ||
+					bvh.nodes[i + 1].max[k] > max[k] ||
+					bvh.nodes[bvh.nodes[i].first].min[k] < min[k] ||
+					bvh.nodes[bvh.nodes[i].first].max[k] > max[k])
+			{
+				result = 0;
+			}
+		}
+	}
+	for (i = 0; i < triangles; i++)
+	{
+		if (seen[i] != 1)
+		{
+			result = 0;
+		}
+	}
+	if (!CheckBVHHits(&bvh, rays, n, indices, triangles))
+	{
+		result = 0;
+	}
+
+	// Refitting an unchanged mesh gives the built bounds back
+	nodes = malloc(bvh.node_count * sizeof(BVHNode));
+	memcpy(nodes, bvh.nodes, bvh.node_count * sizeof(BVHNode));
+	RefitBVH(&bvh);
+	if (memcmp(nodes, bvh.nodes, bvh.node_count * sizeof(BVHNode)) != 0)
+	{
+		result = 0;
+	}
+	// Deform and refit, the hits follow the mesh
+	for (i = 0; i < list.count; i++)
+	{
+		list.vectors[i].x += sinf(list.vectors[i].y);
+		list.vectors[i].z *= 1.5f;
+	}
+	RefitBVH(&bvh);
+	if (!CheckBVHHits(&bvh, rays, n, indices, triangles))
+	{
+		result = 0;
+	}
+	FreeBVH(&bvh);
+
+	// Without indices triangle i is vertices 3i, 3i + 1 and 3i + 2
+	BuildBVH(&list, NULL, triangles, &bvh);
+	if (!CheckBVHHits(&bvh, rays, n, NULL, triangles))
+	{
+		result = 0;
+	}
+	FreeBVH(&bvh);
+	if (BuildBVH(&list, NULL, 0, &bvh) != 0 ||
+			BVHClosestHit(&bvh, &rays[0], &hit) != 0 ||
+			BVHAnyHit(&bvh, &rays[0]) != 0)
+	{
+		result = 0;
+	}
+	FreeBVH(&bvh);
+	FreeVectorList(&list);
+	free(nodes);
+	free(rays);
+	free(vertices);
+	free(indices);
+	free(seen);
+	return result;
+}
+
+// Unit UV sphere with rings * segments quads, seam and pole vertices are
+// duplicated. uvs is filled when not NULL
+void SphereMesh(unsigned int rings, unsigned int segments, Mesh *mesh,
+		float *uvs)
+{
+	Vector3D *positions;
+	unsigned int *indices, r, s, a, t = 0;
+	float theta, phi;
+	positions = malloc((rings + 1) * (segments + 1) * sizeof(Vector3D));
+	indices = malloc(6 * rings * segments * sizeof(unsigned int));
+	for (r = 0; r <= rings; r++)
+	{
+		for (s = 0; s <= segments; s++)
+		{
+			theta = 3.14159265f * r / rings;
+			phi = 2 * 3.14159265f * s / segments;
+			SetVector(sinf(theta) * cosf(phi), sinf(theta) * sinf(phi),
+					cosf(theta), 1, &positions[r * (segments + 1) + s]);
+			if (r == 0 || r == rings)
+			{
+				// Exact poles, their triangles have no area
+				SetVector(0, 0, r == 0 ? 1 : -1, 1,
+						&positions[r * (segments + 1) + s]);
+			}
+			if (uvs != NULL)
+			{
+				uvs[2 * (r * (segments + 1) + s)] = (float) s / segments;
+				uvs[2 * (r * (segments + 1) + s) + 1] = (float) r / rings;
+			}
+		}
+	}
+	for (r = 0; r < rings; r++)
+	{
+		for (s = 0; s < segments; s++)
+		{
+			a = r * (segments + 1) + s;
+			indices[t++] = a;
+			indices[t++] = a + segments + 1;
+			indices[t++] = a + 1;
+			indices[t++] = a + 1;
+			indices[t++] = a + segments + 1;
+			indices[t++] = a + segments + 2;
+		}
+	}
+	InitMesh(mesh);
+	SetMesh(mesh, positions, (rings + 1) * (segments + 1), indices,
+			2 * rings * segments);
+	free(positions);
+	free(indices);
+}
+
+int TestMeshNormals()
+{
+	Mesh mesh, cube;
+	Vector3D *faces, *normals, *p, expect;
+	unsigned int i, j, bad = 0;
+	int level, threads, result = 1;
+	// Corners of the unit cube, two triangles per side
+	Vector3D corners[8] = {{0, 0, 0, 1}, {1, 0, 0, 1}, {1, 1, 0, 1},
+		{0, 1, 0, 1}, {0, 0, 1, 1}, {1, 0, 1, 1}, {1, 1, 1, 1}, {0, 1, 1, 1}};
+	unsigned int quads[24] = {0, 3, 2, 1, 4, 5, 6, 7, 0, 1, 5, 4,
+		2, 3, 7, 6, 1, 2, 6, 5, 0, 4, 7, 3};
+	unsigned int cube_indices[36];
+	SphereMesh(48, 96, &mesh, NULL);
+	if (mesh.triangle_count != 2 * 48 * 96 ||
+			ComputeMeshNormals(&mesh, MESH_WEIGHT_AREA) !=
+			(int) mesh.positions.count || mesh.normals.count != 49 * 97)
+	{
+		result = 0;
+	}
+	// Pole triangles have no area
+	if (mesh.face_normals[0].x != 0 || mesh.face_normals[0].w != 0)
+	{
+		result = 0;
+	}
+	for (i = 0; i < mesh.triangle_count; i++)
+	{
+		if (mesh.face_normals[i].w == 0)
+		{
+			continue;
+		}
+		p = &mesh.positions.vectors[mesh.indices[3 * i]];
+		PlaneNormal(p[0], mesh.positions.vectors[mesh.indices[3 * i + 1]],
+				mesh.positions.vectors[mesh.indices[3 * i + 2]], &expect);
+		if (fabsf(expect.x - mesh.face_normals[i].x) > 1E-5 ||
+				fabsf(expect.y - mesh.face_normals[i].y) > 1E-5 ||
+				fabsf(expect.z - mesh.face_normals[i].z) > 1E-5 ||
+				DotProduct(expect, *p) <= 0)
+		{
+			bad++;
+		}
+	}
+	// Smooth normals of the sphere point away from its center. Pole
+	// vertices only have the triangles of one segment
+	for (i = 97; i < 48 * 97; i++)
+	{
+		p = &mesh.normals.vectors[i];
+		if (fabsf(VectorLength(*p) - 1) > 1E-5 ||
+				DotProduct(*p, mesh.positions.vectors[i]) < 0.99f)
+		{
+			bad++;
+		}
+	}
+
+	// Every SIMD level and thread count gives the same bits
+	faces = malloc(mesh.triangle_count * sizeof(Vector3D));
+	normals = malloc(mesh.positions.count * sizeof(Vector3D));
+	memcpy(faces, mesh.face_normals, mesh.triangle_count * sizeof(Vector3D));
+	for (j = MESH_WEIGHT_AREA; j <= MESH_WEIGHT_ANGLE; j++)
+	{
+		ComputeMeshNormals(&mesh, j);
+		memcpy(normals, mesh.normals.vectors,
+				mesh.positions.count * sizeof(Vector3D));
+		threads = GetThreadCount();
+		for (level = SIMD_SCALAR; level <= DetectSIMDLevel(); level++)
+		{
+			SetSIMDLevel(level);
+			SetThreadCount(level % 2 == 0 ? 4 : 1);
+			ComputeMeshNormals(&mesh, j);
+			if (memcmp(faces, mesh.face_normals,
+						mesh.triangle_count * sizeof(Vector3D)) != 0 ||
+					memcmp(normals, mesh.normals.vectors,
+						mesh.positions.count * sizeof(Vector3D)) != 0)
+			{
+				result = 0;
+			}
+		}
+		SetSIMDLevel(DetectSIMDLevel());
+		SetThreadCount(threads);
+	}
+
+	// A deformed mesh keeps its adjacency, only the normals move
+	for (i = 0; i < mesh.positions.count; i++)
+	{
+		mesh.positions.vectors[i].z *= 3;
+	}
+	ComputeMeshNormals(&mesh, MESH_WEIGHT_ANGLE);
+	for (i = 97; i < 48 * 97; i++)
+	{
+		p = &mesh.positions.vectors[i];
+		// Ellipsoid gradient (x, y, z / 9)
+		SetVector(p->x, p->y, p->z / 9, 0, &expect);
+		NormalizeVector(&expect);
+		if (DotProduct(expect, mesh.normals.vectors[i]) < 0.99f)
+		{
+			bad++;
+		}
+	}
+
+	// At the cube corners one side has two triangles and the others one,
+	// the angle weighted normal is still the diagonal
+	for (i = 0; i < 6; i++)
+	{
+		cube_indices[6 * i] = quads[4 * i];
+		cube_indices[6 * i + 1] = quads[4 * i + 1];
+		cube_indices[6 * i + 2] = quads[4 * i + 2];
+		cube_indices[6 * i + 3] = quads[4 * i];
+		cube_indices[6 * i + 4] = quads[4 * i + 2];
+		cube_indices[6 * i + 5] = quads[4 * i + 3];
+	}
+	InitMesh(&cube);
+	cube_indices[0] = 8;
+	if (SetMesh(&cube, corners, 8, cube_indices, 12) != 0)
+	{
+		result = 0;
+	}
+	cube_indices[0] = 0;
+	SetMesh(&cube, corners, 8, cube_indices, 12);
+	ComputeMeshNormals(&cube, MESH_WEIGHT_ANGLE);
+	for (i = 0; i < 8; i++)
+	{
+		SetVector(corners[i].x - 0.5f, corners[i].y - 0.5f,
+				corners[i].z - 0.5f, 0, &expect);
+		NormalizeVector(&expect);
+		if (DotProduct(expect, cube.normals.vectors[i]) < 1 - 1E-6f)
+		{
+			result = 0;
+		}
+	}
+	// Corner 6 is in both triangles of two sides but one of the third
+	ComputeMeshNormals(&cube, MESH_WEIGHT_AREA);
+	SetVector(1, 1, 1, 0, &expect);
+	NormalizeVector(&expect);
+	if (DotProduct(expect, cube.normals.vectors[6]) > 0.999f)
+	{
+		result = 0;
+	}
+	if (bad > 0)
+	{
+		result = 0;
+	}
+	FreeMesh(&cube);
+	FreeMesh(&mesh);
+	free(faces);
+	free(normals);
+	return result;
+}
+
+int TestMeshTangents()
+{
+	Mesh mesh;
+	Vector3D *t, *n, quad[4] = {{0, 0, 0, 1}, {1, 0, 0, 1}, {1, 1, 0, 1},
+		{0, 1, 0, 1}};
+	unsigned int indices[6] = {0, 1, 2, 0, 2, 3}, i, bad = 0;
+	float uvs[2 * 49 * 97], mirrored[8] = {0, 0, -1, 0, -1, 1, 0, 1};
+	float flat[8] = {0, 0, 1, 0, 1, 1, 0, 1};
+	int result = 1;
+	// u along x gives the x axis, mirrored u flips tangent and handedness
+	InitMesh(&mesh);
+	SetMesh(&mesh, quad, 4, indices, 2);
+	if (ComputeMeshTangents(&mesh, flat) != 4 || mesh.normals.count != 4)
+	{
+		result = 0;
+	}
+	for (i = 0; i < 4; i++)
+	{
+		t = &mesh.tangents.vectors[i];
+		if (fabsf(t->x - 1) > 1E-6 || fabsf(t->y) > 1E-6 ||
+				fabsf(t->z) > 1E-6 || t->w != 1)
+		{
+			result = 0;
+		}
+	}
+	ComputeMeshTangents(&mesh, mirrored);
+	for (i = 0; i < 4; i++)
+	{
+		t = &mesh.tangents.vectors[i];
+		if (fabsf(t->x + 1) > 1E-6 || t->w != -1)
+		{
+			result = 0;
+		}
+	}
+	FreeMesh(&mesh);
+
+	// On the sphere tangents are unit length, orthogonal to the normal
+	// and follow the segments
+	SphereMesh(48, 96, &mesh, uvs);
+	ComputeMeshNormals(&mesh, MESH_WEIGHT_ANGLE);
+	if (ComputeMeshTangents(&mesh, uvs) != 49 * 97)
+	{
+		result = 0;
+	}
+	for (i = 0; i < mesh.positions.count; i++)
+	{
+		t = &mesh.tangents.vectors[i];
+		n = &mesh.normals.vectors[i];
+		if (fabsf(VectorLength(*t) - 1) > 1E-5 ||
+				fabsf(DotProduct(*t, *n)) > 1E-5 ||
+				(t->w != 1 && t->w != -1))
+		{
+			bad++;
+		}
+		// Away from the poles u grows around z
+		if (i > 97 && i < 48 * 97 &&
+				t->x * -mesh.positions.vectors[i].y +
+				t->y * mesh.positions.vectors[i].x < 0.9f *
+				sqrtf(n->x * n->x + n->y * n->y))
+		{
+			bad++;
+		}
+	}
+	if (bad > 0)
+	{
+		result = 0;
+	}
+	FreeMesh(&mesh);
+	return result;
+}
+
 int main()
 {
 	if (TestCloneVector())
@@ -927,5 +3873,333 @@ int main()
 	{
 		printFAIL("TestCastFloat");
 	}
+	if (TestTransformVectorList())
+	{
+		printOK("TestTransformVectorList");
+	}
+	else
+	{
+		printFAIL("TestTransformVectorList");
+	}
+	if (TestVectorListSoA())
+	{
+		printOK("TestVectorListSoA");
+	}
+	else
+	{
+		printFAIL("TestVectorListSoA");
+	}
+	if (TestVectorSoAOps())
+	{
+		printOK("TestVectorSoAOps");
+	}
+	else
+	{
+		printFAIL("TestVectorSoAOps");
+	}
+	if (TestReserveVectorList())
+	{
+		printOK("TestReserveVectorList");
+	}
+	else
+	{
+		printFAIL("TestReserveVectorList");
+	}
+	if (TestPushVectors())
+	{
+		printOK("TestPushVectors");
+	}
+	else
+	{
+		printFAIL("TestPushVectors");
+	}
+	if (TestRemoveVectorIndex())
+	{
+		printOK("TestRemoveVectorIndex");
+	}
+	else
+	{
+		printFAIL("TestRemoveVectorIndex");
+	}
+	if (TestRemoveVectorsBatch())
+	{
+		printOK("TestRemoveVectorsBatch");
+	}
+	else
+	{
+		printFAIL("TestRemoveVectorsBatch");
+	}
+	if (TestMultiplyMatrixSIMD())
+	{
+		printOK("TestMultiplyMatrixSIMD");
+	}
+	else
+	{
+		printFAIL("TestMultiplyMatrixSIMD");
+	}
+	if (TestInvertMatrixFast())
+	{
+		printOK("TestInvertMatrixFast");
+	}
+	else
+	{
+		printFAIL("TestInvertMatrixFast");
+	}
+	if (TestMultiplyMatrixArray())
+	{
+		printOK("TestMultiplyMatrixArray");
+	}
+	else
+	{
+		printFAIL("TestMultiplyMatrixArray");
+	}
+	if (TestQuaternionMatrix())
+	{
+		printOK("TestQuaternionMatrix");
+	}
+	else
+	{
+		printFAIL("TestQuaternionMatrix");
+	}
+	if (TestMultiplyQuaternion())
+	{
+		printOK("TestMultiplyQuaternion");
+	}
+	else
+	{
+		printFAIL("TestMultiplyQuaternion");
+	}
+	if (TestSlerpQuaternion())
+	{
+		printOK("TestSlerpQuaternion");
+	}
+	else
+	{
+		printFAIL("TestSlerpQuaternion");
+	}
+	if (TestQuaternionRotateVector())
+	{
+		printOK("TestQuaternionRotateVector");
+	}
+	else
+	{
+		printFAIL("TestQuaternionRotateVector");
+	}
+	if (TestFastSinCos())
+	{
+		printOK("TestFastSinCos");
+	}
+	else
+	{
+		printFAIL("TestFastSinCos");
+	}
+	if (TestFastTrigRotation())
+	{
+		printOK("TestFastTrigRotation");
+	}
+	else
+	{
+		printFAIL("TestFastTrigRotation");
+	}
+	if (TestInlineVector())
+	{
+		printOK("TestInlineVector");
+	}
+	else
+	{
+		printFAIL("TestInlineVector");
+	}
+	if (TestInlineMatrix())
+	{
+		printOK("TestInlineMatrix");
+	}
+	else
+	{
+		printFAIL("TestInlineMatrix");
+	}
+	if (TestVectorListAllocator())
+	{
+		printOK("TestVectorListAllocator");
+	}
+	else
+	{
+		printFAIL("TestVectorListAllocator");
+	}
+	if (TestFrameArena())
+	{
+		printOK("TestFrameArena");
+	}
+	else
+	{
+		printFAIL("TestFrameArena");
+	}
+	if (TestVectorListFile())
+	{
+		printOK("TestVectorListFile");
+	}
+	else
+	{
+		printFAIL("TestVectorListFile");
+	}
+	if (TestLoadPointCloudXYZ())
+	{
+		printOK("TestLoadPointCloudXYZ");
+	}
+	else
+	{
+		printFAIL("TestLoadPointCloudXYZ");
+	}
+	if (TestLoadPointCloudPLY())
+	{
+		printOK("TestLoadPointCloudPLY");
+	}
+	else
+	{
+		printFAIL("TestLoadPointCloudPLY");
+	}
+	if (TestThreadPool())
+	{
+		printOK("TestThreadPool");
+	}
+	else
+	{
+		printFAIL("TestThreadPool");
+	}
+	if (TestParallelVectorList())
+	{
+		printOK("TestParallelVectorList");
+	}
+	else
+	{
+		printFAIL("TestParallelVectorList");
+	}
+	if (TestComputeAABB())
+	{
+		printOK("TestComputeAABB");
+	}
+	else
+	{
+		printFAIL("TestComputeAABB");
+	}
+	if (TestComputeBoundingSphere())
+	{
+		printOK("TestComputeBoundingSphere");
+	}
+	else
+	{
+		printFAIL("TestComputeBoundingSphere");
+	}
+	if (TestComputeOBB())
+	{
+		printOK("TestComputeOBB");
+	}
+	else
+	{
+		printFAIL("TestComputeOBB");
+	}
+	if (TestKDTree())
+	{
+		printOK("TestKDTree");
+	}
+	else
+	{
+		printFAIL("TestKDTree");
+	}
+	if (TestSpatialHash())
+	{
+		printOK("TestSpatialHash");
+	}
+	else
+	{
+		printFAIL("TestSpatialHash");
+	}
+	if (TestOctree())
+	{
+		printOK("TestOctree");
+	}
+	else
+	{
+		printFAIL("TestOctree");
+	}
+	if (TestExtractFrustum())
+	{
+		printOK("TestExtractFrustum");
+	}
+	else
+	{
+		printFAIL("TestExtractFrustum");
+	}
+	if (TestCullFrustum())
+	{
+		printOK("TestCullFrustum");
+	}
+	else
+	{
+		printFAIL("TestCullFrustum");
+	}
+	if (TestProjectionMatrix())
+	{
+		printOK("TestProjectionMatrix");
+	}
+	else
+	{
+		printFAIL("TestProjectionMatrix");
+	}
+	if (TestCamera())
+	{
+		printOK("TestCamera");
+	}
+	else
+	{
+		printFAIL("TestCamera");
+	}
+	if (TestTransformHierarchy())
+	{
+		printOK("TestTransformHierarchy");
+	}
+	else
+	{
+		printFAIL("TestTransformHierarchy");
+	}
+	if (TestIntersectRayTriangle())
+	{
+		printOK("TestIntersectRayTriangle");
+	}
+	else
+	{
+		printFAIL("TestIntersectRayTriangle");
+	}
+	if (TestIntersectRays())
+	{
+		printOK("TestIntersectRays");
+	}
+	else
+	{
+		printFAIL("TestIntersectRays");
+	}
+	if (TestBVH())
+	{
+		printOK("TestBVH");
+	}
+	else
+	{
+		printFAIL("TestBVH");
+	}
+	if (TestMeshNormals())
+	{
+		printOK("TestMeshNormals");
+	}
+	else
+	{
+		printFAIL("TestMeshNormals");
+	}
+	if (TestMeshTangents())
+	{
+		printOK("TestMeshTangents");
+	}
+	else
+	{
+		printFAIL("TestMeshTangents");
+	}
 	return 0;
 }